@@ -0,0 +1,305 @@
+// Command bench runs cmd/server and cmd/client on loopback for every
+// transport × protocol × flow combination and reports throughput, latency,
+// CPU and allocation figures as JSON, so transport changes can be compared
+// end to end instead of per package.
+//
+// Run it from the ewp-core module root:
+//
+//	go run ./cmd/bench -o results.json
+//	go run ./cmd/bench -only ws,xhttp-stream-one -bulk 512
+//
+// For each case the bench writes a server and client config, starts both
+// processes, and drives traffic through the client's SOCKS5 inbound to
+// local target servers:
+//
+//	tcp_upload / tcp_download  one connection moving -bulk MiB each way
+//	tcp_rr                     -rr sequential 64-byte round trips
+//	tcp_connect                -conns fresh connections, setup to first byte
+//	udp_rr                     -udp sequential 512-byte datagrams
+//
+// CPU is user+system time of both processes over their whole life,
+// including startup. Allocations come from the client's /runtime endpoint
+// around the traffic phase; the server has no equivalent endpoint, so its
+// allocations are not reported.
+package main
+
+import (
+	"encoding/json"
+	"flag"
+	"fmt"
+	"os"
+	"path/filepath"
+	"strings"
+	"time"
+)
+
+type options struct {
+	serverBin string
+	clientBin string
+	filter    []string
+	bulkBytes uint64
+	rrCount   int
+	connCount int
+	udpCount  int
+	keep      bool
+}
+
+// result is one entry of the JSON report.
+type result struct {
+	Case      string `json:"case"`
+	Transport string `json:"transport"`
+	Protocol  string `json:"protocol"`
+	Flow      bool   `json:"flow"`
+	Error     string `json:"error,omitempty"`
+
+	UploadMbps   float64      `json:"tcp_upload_mbps"`
+	DownloadMbps float64      `json:"tcp_download_mbps"`
+	RR           latencyStats `json:"tcp_rr"`
+	Connect      latencyStats `json:"tcp_connect"`
+	UDP          latencyStats `json:"udp_rr"`
+	UDPLost      int          `json:"udp_lost"`
+
+	ClientCPUSec float64 `json:"client_cpu_s"`
+	ServerCPUSec float64 `json:"server_cpu_s"`
+	CPUSecPerGB  float64 `json:"cpu_s_per_gb"`
+
+	ClientAllocBytesPerGB float64 `json:"client_alloc_bytes_per_gb"`
+	ClientMallocsPerGB    float64 `json:"client_mallocs_per_gb"`
+}
+
+type report struct {
+	Time      time.Time `json:"time"`
+	BulkBytes uint64    `json:"bulk_bytes"`
+	RR        int       `json:"rr"`
+	Conns     int       `json:"conns"`
+	UDP       int       `json:"udp"`
+	Results   []result  `json:"results"`
+}
+
+func main() {
+	var opts options
+	var only, output string
+	var bulkMiB uint64
+	flag.StringVar(&opts.serverBin, "server-bin", "", "server binary (default: go build ./cmd/server)")
+	flag.StringVar(&opts.clientBin, "client-bin", "", "client binary (default: go build ./cmd/client)")
+	flag.StringVar(&only, "only", "", "comma-separated transports, protocols or case names to run")
+	flag.Uint64Var(&bulkMiB, "bulk", 256, "MiB per bulk transfer direction")
+	flag.IntVar(&opts.rrCount, "rr", 2000, "TCP request/response round trips")
+	flag.IntVar(&opts.connCount, "conns", 100, "TCP connections for setup latency")
+	flag.IntVar(&opts.udpCount, "udp", 1000, "UDP round trips")
+	flag.StringVar(&output, "o", "", "write the JSON report to this file instead of stdout")
+	flag.BoolVar(&opts.keep, "keep", false, "keep generated configs and process logs")
+	flag.Parse()
+	opts.bulkBytes = bulkMiB << 20
+	if only != "" {
+		opts.filter = strings.Split(only, ",")
+	}
+
+	cases := buildMatrix(opts.filter)
+	if len(cases) == 0 {
+		fatalf("no cases match -only %q", only)
+	}
+
+	workDir, err := os.MkdirTemp("", "ewp-bench-")
+	if err != nil {
+		fatalf("%v", err)
+	}
+	if opts.keep {
+		logf("work directory: %s", workDir)
+	} else {
+		defer os.RemoveAll(workDir)
+	}
+
+	if opts.serverBin == "" || opts.clientBin == "" {
+		server, client, err := buildBinaries(workDir)
+		if err != nil {
+			fatalf("%v", err)
+		}
+		if opts.serverBin == "" {
+			opts.serverBin = server
+		}
+		if opts.clientBin == "" {
+			opts.clientBin = client
+		}
+	}
+
+	certFile, keyFile, err := writeCert(workDir)
+	if err != nil {
+		fatalf("certificate: %v", err)
+	}
+	tgt, err := startTargets()
+	if err != nil {
+		fatalf("targets: %v", err)
+	}
+	defer tgt.Close()
+
+	rep := report{
+		Time:      time.Now().UTC(),
+		BulkBytes: opts.bulkBytes,
+		RR:        opts.rrCount,
+		Conns:     opts.connCount,
+		UDP:       opts.udpCount,
+	}
+	for i, c := range cases {
+		logf("[%d/%d] %s", i+1, len(cases), c.Name())
+		dir := filepath.Join(workDir, strings.NewReplacer("/", "_", "+", "_").Replace(c.Name()))
+		res := runCase(c, &opts, dir, certFile, keyFile, tgt)
+		if res.Error != "" {
+			logf("  error: %s", res.Error)
+		} else {
+			logf("  up %.0f Mbps, down %.0f Mbps, rr p50 %.3f ms p99 %.3f ms, udp p50 %.3f ms (%d lost)",
+				res.UploadMbps, res.DownloadMbps, res.RR.P50Ms, res.RR.P99Ms, res.UDP.P50Ms, res.UDPLost)
+		}
+		rep.Results = append(rep.Results, res)
+	}
+
+	out := os.Stdout
+	if output != "" {
+		f, err := os.Create(output)
+		if err != nil {
+			fatalf("%v", err)
+		}
+		defer f.Close()
+		out = f
+	}
+	enc := json.NewEncoder(out)
+	enc.SetIndent("", "  ")
+	if err := enc.Encode(rep); err != nil {
+		fatalf("%v", err)
+	}
+}
+
+// caseRun holds the processes of one case so they can be stopped however
+// the case ends.
+type caseRun struct {
+	server *process
+	client *process
+	ctl    control
+}
+
+// runCase starts a server/client pair for c, runs every test through it and
+// stops both. Failures are recorded in the result so one broken transport
+// does not abort the matrix.
+func runCase(c benchCase, opts *options, dir, certFile, keyFile string, tgt *targets) result {
+	res := result{
+		Case:      c.Name(),
+		Transport: c.Transport.Name,
+		Protocol:  c.Protocol,
+		Flow:      c.Flow,
+	}
+	var run caseRun
+	err := run.drive(c, opts, dir, certFile, keyFile, tgt, &res)
+
+	// CPU is only known once both processes have exited.
+	var clientCPU, serverCPU time.Duration
+	if run.client != nil {
+		clientCPU = run.client.stop(run.ctl)
+	}
+	if run.server != nil {
+		serverCPU = run.server.stop(control{})
+	}
+	res.ClientCPUSec = clientCPU.Seconds()
+	res.ServerCPUSec = serverCPU.Seconds()
+
+	if err != nil {
+		res.Error = err.Error()
+	} else if gb := transferredGB(opts); gb > 0 {
+		res.CPUSecPerGB = (clientCPU + serverCPU).Seconds() / gb
+	}
+	return res
+}
+
+// transferredGB is the bulk volume of one case in decimal gigabytes, the
+// denominator of the per-GB figures.
+func transferredGB(opts *options) float64 {
+	return float64(2*opts.bulkBytes) / 1e9
+}
+
+func (run *caseRun) drive(c benchCase, opts *options, dir, certFile, keyFile string, tgt *targets, res *result) error {
+	if err := os.MkdirAll(dir, 0o700); err != nil {
+		return err
+	}
+	serverPort, err := freePort()
+	if err != nil {
+		return err
+	}
+	mixedPort, err := freePort()
+	if err != nil {
+		return err
+	}
+	serverCfg := filepath.Join(dir, "server.json")
+	clientCfg := filepath.Join(dir, "client.json")
+	if err := writeJSON(serverCfg, serverConfig(c, serverPort, certFile, keyFile)); err != nil {
+		return err
+	}
+	if err := writeJSON(clientCfg, clientConfig(c, serverPort, mixedPort)); err != nil {
+		return err
+	}
+
+	if run.server, err = startProcess(opts.serverBin, serverCfg, filepath.Join(dir, "server.log")); err != nil {
+		return fmt.Errorf("start server: %w", err)
+	}
+	if err := run.server.waitListening(hostPort("127.0.0.1", serverPort)); err != nil {
+		return fmt.Errorf("server: %w", err)
+	}
+	if run.client, err = startProcess(opts.clientBin, clientCfg, filepath.Join(dir, "client.log")); err != nil {
+		return fmt.Errorf("start client: %w", err)
+	}
+	if run.ctl, err = run.client.waitControl(); err != nil {
+		return fmt.Errorf("client: %w", err)
+	}
+	proxy := hostPort("127.0.0.1", mixedPort)
+	if err := run.client.waitListening(proxy); err != nil {
+		return fmt.Errorf("client: %w", err)
+	}
+
+	// The first tunnelled connection pays for the transport handshake;
+	// keep it out of the measurements.
+	if _, err := requestResponse(proxy, tgt.tcpAddr(), 1); err != nil {
+		return fmt.Errorf("warm-up: %w", err)
+	}
+
+	before, err := fetchRuntime(run.ctl)
+	if err != nil {
+		return err
+	}
+	if res.UploadMbps, err = bulkUpload(proxy, tgt.tcpAddr(), opts.bulkBytes); err != nil {
+		return fmt.Errorf("tcp upload: %w", err)
+	}
+	if res.DownloadMbps, err = bulkDownload(proxy, tgt.tcpAddr(), opts.bulkBytes); err != nil {
+		return fmt.Errorf("tcp download: %w", err)
+	}
+	samples, err := requestResponse(proxy, tgt.tcpAddr(), opts.rrCount)
+	if err != nil {
+		return fmt.Errorf("tcp rr: %w", err)
+	}
+	res.RR = summarize(samples)
+	if samples, err = connectLatency(proxy, tgt.tcpAddr(), opts.connCount); err != nil {
+		return fmt.Errorf("tcp connect: %w", err)
+	}
+	res.Connect = summarize(samples)
+	samples, res.UDPLost, err = udpRoundTrips(proxy, tgt.udpAddr(), opts.udpCount)
+	if err != nil {
+		return fmt.Errorf("udp: %w", err)
+	}
+	res.UDP = summarize(samples)
+	after, err := fetchRuntime(run.ctl)
+	if err != nil {
+		return err
+	}
+
+	if gb := transferredGB(opts); gb > 0 {
+		res.ClientAllocBytesPerGB = float64(after.TotalAlloc-before.TotalAlloc) / gb
+		res.ClientMallocsPerGB = float64(after.Mallocs-before.Mallocs) / gb
+	}
+	return nil
+}
+
+func logf(format string, args ...any) {
+	fmt.Fprintf(os.Stderr, format+"\n", args...)
+}
+
+func fatalf(format string, args ...any) {
+	logf(format, args...)
+	os.Exit(1)
+}
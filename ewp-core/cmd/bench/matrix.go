@@ -0,0 +1,151 @@
+package main
+
+import (
+	"fmt"
+	"strings"
+
+	"ewp-core/option"
+)
+
+const (
+	benchUUID     = "d342d11e-d424-4583-b36e-524ab1f0afa4"
+	benchPassword = "ewp-bench"
+)
+
+// transportSpec pairs a client transport with the server listener mode that
+// serves it. xhttp appears once per client mode.
+type transportSpec struct {
+	Name       string
+	ServerMode string
+	ClientType string
+	XHTTPMode  string
+}
+
+var transports = []transportSpec{
+	{Name: "ws", ServerMode: "ws", ClientType: "ws"},
+	{Name: "grpc", ServerMode: "grpc", ClientType: "grpc"},
+	{Name: "xhttp-auto", ServerMode: "xhttp", ClientType: "xhttp", XHTTPMode: "auto"},
+	{Name: "xhttp-stream-one", ServerMode: "xhttp", ClientType: "xhttp", XHTTPMode: "stream-one"},
+	{Name: "xhttp-stream-down", ServerMode: "xhttp", ClientType: "xhttp", XHTTPMode: "stream-down"},
+	{Name: "h3grpc", ServerMode: "h3", ClientType: "h3grpc"},
+	{Name: "masque", ServerMode: "masque", ClientType: "masque"},
+}
+
+// benchCase is one cell of the matrix.
+type benchCase struct {
+	Transport transportSpec
+	Protocol  string // ewp, trojan
+	Flow      bool   // EWP Vision flow control
+}
+
+func (c benchCase) Name() string {
+	name := c.Transport.Name + "/" + c.Protocol
+	if c.Flow {
+		name += "+flow"
+	}
+	return name
+}
+
+// buildMatrix enumerates every supported transport × protocol × flow
+// combination. Flow only exists for EWP, and the MASQUE server only
+// authenticates EWP UUIDs, so Trojan over MASQUE is left out. A non-empty
+// filter keeps the cases whose transport, protocol or full name matches one
+// of its entries.
+func buildMatrix(filter []string) []benchCase {
+	var cases []benchCase
+	for _, t := range transports {
+		for _, c := range []benchCase{
+			{Transport: t, Protocol: "ewp"},
+			{Transport: t, Protocol: "ewp", Flow: true},
+			{Transport: t, Protocol: "trojan"},
+		} {
+			if c.Protocol == "trojan" && t.ClientType == "masque" {
+				continue
+			}
+			if matchesFilter(c, filter) {
+				cases = append(cases, c)
+			}
+		}
+	}
+	return cases
+}
+
+func matchesFilter(c benchCase, filter []string) bool {
+	if len(filter) == 0 {
+		return true
+	}
+	for _, f := range filter {
+		f = strings.TrimSpace(f)
+		if f == c.Transport.Name || f == c.Protocol || f == c.Name() {
+			return true
+		}
+	}
+	return false
+}
+
+// serverConfig builds the config-mode server config for c. Every case runs
+// over TLS with the generated loopback certificate so TCP and QUIC
+// transports pay the same handshake and record costs.
+func serverConfig(c benchCase, port int, certFile, keyFile string) *option.ServerConfig {
+	cfg := option.DefaultServerConfig()
+	cfg.Log = option.LogConfig{Level: "warn"}
+	cfg.Listener.Port = port
+	cfg.Listener.Address = "127.0.0.1"
+	cfg.Listener.Modes = []string{c.Transport.ServerMode}
+	cfg.Listener.MasqueHost = "127.0.0.1"
+	cfg.Protocol = option.ProtocolConfig{Type: c.Protocol, EnableFlow: c.Flow}
+	if c.Protocol == "trojan" {
+		cfg.Protocol.Password = benchPassword
+	} else {
+		cfg.Protocol.UUID = benchUUID
+	}
+	cfg.TLS = &option.ServerTLSConfig{
+		Enabled:  true,
+		CertFile: certFile,
+		KeyFile:  keyFile,
+		ALPN:     []string{"h3", "h2", "http/1.1"},
+	}
+	return cfg
+}
+
+// clientConfig builds a client with one mixed inbound on mixedPort routed to
+// the loopback server. ECH stays off: it needs a DoH lookup of a public
+// config domain and would measure the network instead of the tunnel.
+func clientConfig(c benchCase, serverPort, mixedPort int) *option.RootConfig {
+	cfg := option.DefaultRootConfig()
+	cfg.Log = option.LogConfig{Level: "warn"}
+	cfg.Inbounds[0].Listen = fmt.Sprintf("127.0.0.1:%d", mixedPort)
+
+	out := option.OutboundConfig{
+		Type:       c.Protocol,
+		Tag:        "proxy-out",
+		Server:     "127.0.0.1",
+		ServerPort: serverPort,
+		Transport: &option.TransportConfig{
+			Type: c.Transport.ClientType,
+			Mode: c.Transport.XHTTPMode,
+		},
+		TLS: &option.TLSConfig{
+			Enabled:    true,
+			ServerName: "localhost",
+			Insecure:   true,
+		},
+	}
+	switch c.Transport.ClientType {
+	case "ws":
+		out.Transport.Path = "/"
+	case "xhttp":
+		out.Transport.Path = "/xhttp"
+	case "grpc", "h3grpc":
+		out.Transport.ServiceName = "ProxyService"
+	}
+	if c.Protocol == "trojan" {
+		out.Password = benchPassword
+	} else {
+		out.UUID = benchUUID
+		out.Flow = &option.FlowConfig{Enabled: c.Flow}
+	}
+	cfg.Outbounds = []option.OutboundConfig{out}
+	cfg.Route = &option.RouteConfig{Final: "proxy-out"}
+	return cfg
+}
@@ -0,0 +1,98 @@
+package main
+
+import (
+	"encoding/json"
+	"testing"
+	"time"
+
+	"ewp-core/option"
+)
+
+func TestBuildMatrix(t *testing.T) {
+	cases := buildMatrix(nil)
+	// Three variants per transport, minus Trojan over MASQUE.
+	if want := 3*len(transports) - 1; len(cases) != want {
+		t.Fatalf("got %d cases, want %d", len(cases), want)
+	}
+	seen := make(map[string]bool)
+	for _, c := range cases {
+		if seen[c.Name()] {
+			t.Errorf("duplicate case %s", c.Name())
+		}
+		seen[c.Name()] = true
+		if c.Flow && c.Protocol != "ewp" {
+			t.Errorf("%s: flow enabled for %s", c.Name(), c.Protocol)
+		}
+	}
+	if seen["masque/trojan"] {
+		t.Error("masque/trojan should be skipped")
+	}
+
+	got := buildMatrix([]string{"ws", "trojan"})
+	for _, c := range got {
+		if c.Transport.Name != "ws" && c.Protocol != "trojan" {
+			t.Errorf("filter kept %s", c.Name())
+		}
+	}
+	if len(got) != 3+len(transports)-2 {
+		t.Errorf("filter kept %d cases", len(got))
+	}
+}
+
+// TestGeneratedConfigsValidate round-trips every generated config through
+// JSON and the same validation the binaries run at startup.
+func TestGeneratedConfigsValidate(t *testing.T) {
+	certFile, keyFile, err := writeCert(t.TempDir())
+	if err != nil {
+		t.Fatal(err)
+	}
+	for _, c := range buildMatrix(nil) {
+		var server option.ServerConfig
+		roundTrip(t, serverConfig(c, 20000, certFile, keyFile), &server)
+		if err := server.Validate(); err != nil {
+			t.Errorf("%s: server: %v", c.Name(), err)
+		}
+
+		var client option.RootConfig
+		roundTrip(t, clientConfig(c, 20000, 20001), &client)
+		if err := client.Validate(); err != nil {
+			t.Errorf("%s: client: %v", c.Name(), err)
+		}
+		if tls := client.Outbounds[0].TLS; tls.ECH != nil {
+			t.Errorf("%s: ECH configured", c.Name())
+		}
+	}
+}
+
+func roundTrip(t *testing.T, in, out any) {
+	t.Helper()
+	data, err := json.Marshal(in)
+	if err != nil {
+		t.Fatal(err)
+	}
+	if err := json.Unmarshal(data, out); err != nil {
+		t.Fatal(err)
+	}
+}
+
+func TestPercentile(t *testing.T) {
+	var samples []time.Duration
+	for i := 100; i >= 1; i-- {
+		samples = append(samples, time.Duration(i)*time.Millisecond)
+	}
+	if got := percentile(samples, 50); got != 50*time.Millisecond {
+		t.Errorf("p50 = %v", got)
+	}
+	if got := percentile(samples, 99); got != 99*time.Millisecond {
+		t.Errorf("p99 = %v", got)
+	}
+	if samples[0] != 100*time.Millisecond {
+		t.Error("percentile reordered its input")
+	}
+	if got := percentile(nil, 99); got != 0 {
+		t.Errorf("empty p99 = %v", got)
+	}
+	if got := percentile(samples[:1], 1); got != 100*time.Millisecond {
+		t.Errorf("single-sample p1 = %v", got)
+	}
+}
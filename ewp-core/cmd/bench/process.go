@@ -0,0 +1,273 @@
+package main
+
+import (
+	"bufio"
+	"crypto/ecdsa"
+	"crypto/elliptic"
+	"crypto/rand"
+	"crypto/x509"
+	"crypto/x509/pkix"
+	"encoding/json"
+	"encoding/pem"
+	"errors"
+	"fmt"
+	"io"
+	"math/big"
+	"net"
+	"net/http"
+	"os"
+	"os/exec"
+	"path/filepath"
+	"strings"
+	"time"
+)
+
+const (
+	startTimeout = 15 * time.Second
+	stopTimeout  = 5 * time.Second
+)
+
+// buildBinaries compiles cmd/server and cmd/client into dir. It must run
+// from the ewp-core module root.
+func buildBinaries(dir string) (server, client string, err error) {
+	server = filepath.Join(dir, "ewp-server"+exeSuffix())
+	client = filepath.Join(dir, "ewp-client"+exeSuffix())
+	for bin, pkg := range map[string]string{server: "./cmd/server", client: "./cmd/client"} {
+		cmd := exec.Command("go", "build", "-o", bin, pkg)
+		cmd.Stdout, cmd.Stderr = os.Stderr, os.Stderr
+		if err := cmd.Run(); err != nil {
+			return "", "", fmt.Errorf("go build %s: %w", pkg, err)
+		}
+	}
+	return server, client, nil
+}
+
+func exeSuffix() string {
+	if filepath.Separator == '\\' {
+		return ".exe"
+	}
+	return ""
+}
+
+// writeCert generates a self-signed ECDSA certificate for localhost and
+// 127.0.0.1. Clients run with insecure TLS, so only the handshake cost
+// matters.
+func writeCert(dir string) (certFile, keyFile string, err error) {
+	key, err := ecdsa.GenerateKey(elliptic.P256(), rand.Reader)
+	if err != nil {
+		return "", "", err
+	}
+	tmpl := &x509.Certificate{
+		SerialNumber: big.NewInt(1),
+		Subject:      pkix.Name{CommonName: "localhost"},
+		DNSNames:     []string{"localhost"},
+		IPAddresses:  []net.IP{net.IPv4(127, 0, 0, 1)},
+		NotBefore:    time.Now().Add(-time.Hour),
+		NotAfter:     time.Now().Add(24 * time.Hour),
+		KeyUsage:     x509.KeyUsageDigitalSignature,
+		ExtKeyUsage:  []x509.ExtKeyUsage{x509.ExtKeyUsageServerAuth},
+	}
+	der, err := x509.CreateCertificate(rand.Reader, tmpl, tmpl, &key.PublicKey, key)
+	if err != nil {
+		return "", "", err
+	}
+	keyDER, err := x509.MarshalECPrivateKey(key)
+	if err != nil {
+		return "", "", err
+	}
+
+	certFile = filepath.Join(dir, "cert.pem")
+	keyFile = filepath.Join(dir, "key.pem")
+	if err := os.WriteFile(certFile, pem.EncodeToMemory(&pem.Block{Type: "CERTIFICATE", Bytes: der}), 0o600); err != nil {
+		return "", "", err
+	}
+	if err := os.WriteFile(keyFile, pem.EncodeToMemory(&pem.Block{Type: "EC PRIVATE KEY", Bytes: keyDER}), 0o600); err != nil {
+		return "", "", err
+	}
+	return certFile, keyFile, nil
+}
+
+// freePort asks the kernel for an unused loopback port. QUIC transports
+// listen on the same number over UDP, which is free in practice on loopback.
+func freePort() (int, error) {
+	ln, err := net.Listen("tcp", "127.0.0.1:0")
+	if err != nil {
+		return 0, err
+	}
+	defer ln.Close()
+	return ln.Addr().(*net.TCPAddr).Port, nil
+}
+
+func writeJSON(path string, v any) error {
+	data, err := json.MarshalIndent(v, "", "  ")
+	if err != nil {
+		return err
+	}
+	return os.WriteFile(path, data, 0o600)
+}
+
+// process is a running server or client. Output goes to a log file next to
+// its config so failed cases can be inspected.
+type process struct {
+	cmd  *exec.Cmd
+	done chan struct{}
+	log  *os.File
+
+	// ctl is the client control server, parsed from stdout.
+	ctl chan control
+}
+
+// control is a client's control server: its address and the per-launch
+// token every request must carry.
+type control struct {
+	addr, token string
+}
+
+// do sends a control request with the token attached.
+func (c control) do(method, path string) (*http.Response, error) {
+	req, err := http.NewRequest(method, "http://"+c.addr+path, nil)
+	if err != nil {
+		return nil, err
+	}
+	req.Header.Set("Authorization", "Bearer "+c.token)
+	return http.DefaultClient.Do(req)
+}
+
+func startProcess(bin, config, logFile string) (*process, error) {
+	lf, err := os.Create(logFile)
+	if err != nil {
+		return nil, err
+	}
+	cmd := exec.Command(bin, "-c", config)
+	cmd.Stderr = lf
+	stdout, err := cmd.StdoutPipe()
+	if err != nil {
+		lf.Close()
+		return nil, err
+	}
+	if err := cmd.Start(); err != nil {
+		lf.Close()
+		return nil, err
+	}
+
+	p := &process{
+		cmd:  cmd,
+		done: make(chan struct{}),
+		log:  lf,
+		ctl:  make(chan control, 1),
+	}
+	go func() {
+		// The token is printed before the address.
+		var token string
+		sc := bufio.NewScanner(stdout)
+		for sc.Scan() {
+			line := sc.Text()
+			if t, ok := strings.CutPrefix(line, "CONTROL_TOKEN="); ok {
+				token = t
+				continue // kept out of the log file
+			}
+			if addr, ok := strings.CutPrefix(line, "CONTROL_ADDR="); ok {
+				select {
+				case p.ctl <- control{addr: addr, token: token}:
+				default:
+				}
+			}
+			fmt.Fprintln(lf, line)
+		}
+		io.Copy(io.Discard, stdout)
+		cmd.Wait()
+		lf.Close()
+		close(p.done)
+	}()
+	return p, nil
+}
+
+func (p *process) exited() bool {
+	select {
+	case <-p.done:
+		return true
+	default:
+		return false
+	}
+}
+
+// stop asks the process to exit, via POST /quit when it has a control
+// server and SIGINT otherwise, and kills it after stopTimeout. It returns
+// the user+system CPU time the process consumed over its whole life.
+func (p *process) stop(ctl control) time.Duration {
+	if !p.exited() {
+		var err error
+		if ctl.addr != "" {
+			var resp *http.Response
+			resp, err = ctl.do(http.MethodPost, "/quit")
+			if err == nil {
+				resp.Body.Close()
+			}
+		} else {
+			err = p.cmd.Process.Signal(os.Interrupt)
+		}
+		if err != nil {
+			p.cmd.Process.Kill()
+		}
+		select {
+		case <-p.done:
+		case <-time.After(stopTimeout):
+			p.cmd.Process.Kill()
+			<-p.done
+		}
+	}
+	if p.cmd.ProcessState == nil {
+		return 0
+	}
+	return p.cmd.ProcessState.UserTime() + p.cmd.ProcessState.SystemTime()
+}
+
+// waitListening polls addr until it accepts TCP connections or the process
+// exits.
+func (p *process) waitListening(addr string) error {
+	deadline := time.Now().Add(startTimeout)
+	for time.Now().Before(deadline) {
+		if p.exited() {
+			return errors.New("process exited during startup")
+		}
+		conn, err := net.DialTimeout("tcp", addr, 200*time.Millisecond)
+		if err == nil {
+			conn.Close()
+			return nil
+		}
+		time.Sleep(50 * time.Millisecond)
+	}
+	return fmt.Errorf("%s not listening after %v", addr, startTimeout)
+}
+
+func (p *process) waitControl() (control, error) {
+	select {
+	case ctl := <-p.ctl:
+		return ctl, nil
+	case <-p.done:
+		return control{}, errors.New("process exited during startup")
+	case <-time.After(startTimeout):
+		return control{}, errors.New("no CONTROL_ADDR on stdout")
+	}
+}
+
+// clientRuntime is the subset of the client's /runtime snapshot the bench
+// uses to attribute allocations to the traffic it generated.
+type clientRuntime struct {
+	TotalAlloc uint64 `json:"total_alloc"`
+	Mallocs    uint64 `json:"mallocs"`
+}
+
+func fetchRuntime(ctl control) (clientRuntime, error) {
+	var rt clientRuntime
+	resp, err := ctl.do(http.MethodGet, "/runtime")
+	if err != nil {
+		return rt, err
+	}
+	defer resp.Body.Close()
+	if resp.StatusCode != http.StatusOK {
+		return rt, fmt.Errorf("/runtime: %s", resp.Status)
+	}
+	err = json.NewDecoder(resp.Body).Decode(&rt)
+	return rt, err
+}
@@ -0,0 +1,453 @@
+package main
+
+import (
+	"encoding/binary"
+	"errors"
+	"fmt"
+	"io"
+	"math"
+	"net"
+	"slices"
+	"strconv"
+	"time"
+)
+
+// The target side of every test is a local server reached through the
+// client's SOCKS5 inbound. A TCP connection starts with one command byte:
+//
+//	'U' <n uint64>  upload: the target reads n bytes, then replies one byte
+//	'D' <n uint64>  download: the target writes n bytes
+//	'E'             echo until the connection closes
+//
+// Lengths are framed instead of relying on half-close, which not every
+// transport propagates. The UDP target echoes each datagram.
+const (
+	cmdUpload   = 'U'
+	cmdDownload = 'D'
+	cmdEcho     = 'E'
+
+	rrMessageSize  = 64
+	udpPayloadSize = 512
+	udpTimeout     = time.Second
+)
+
+type targets struct {
+	tcp net.Listener
+	udp net.PacketConn
+}
+
+func startTargets() (*targets, error) {
+	tcp, err := net.Listen("tcp", "127.0.0.1:0")
+	if err != nil {
+		return nil, err
+	}
+	udp, err := net.ListenPacket("udp", "127.0.0.1:0")
+	if err != nil {
+		tcp.Close()
+		return nil, err
+	}
+	t := &targets{tcp: tcp, udp: udp}
+	go t.serveTCP()
+	go t.serveUDP()
+	return t, nil
+}
+
+func (t *targets) Close() {
+	t.tcp.Close()
+	t.udp.Close()
+}
+
+func (t *targets) tcpAddr() string { return t.tcp.Addr().String() }
+func (t *targets) udpAddr() string { return t.udp.LocalAddr().String() }
+
+func (t *targets) serveTCP() {
+	for {
+		conn, err := t.tcp.Accept()
+		if err != nil {
+			return
+		}
+		go handleTarget(conn)
+	}
+}
+
+func handleTarget(conn net.Conn) {
+	defer conn.Close()
+	var cmd [1]byte
+	if _, err := io.ReadFull(conn, cmd[:]); err != nil {
+		return
+	}
+	switch cmd[0] {
+	case cmdUpload:
+		n, err := readLength(conn)
+		if err != nil {
+			return
+		}
+		if _, err := io.CopyN(io.Discard, conn, int64(n)); err != nil {
+			return
+		}
+		conn.Write(cmd[:])
+	case cmdDownload:
+		n, err := readLength(conn)
+		if err != nil {
+			return
+		}
+		writeBulk(conn, n)
+	case cmdEcho:
+		io.Copy(conn, conn)
+	}
+}
+
+func (t *targets) serveUDP() {
+	buf := make([]byte, 65535)
+	for {
+		n, addr, err := t.udp.ReadFrom(buf)
+		if err != nil {
+			return
+		}
+		t.udp.WriteTo(buf[:n], addr)
+	}
+}
+
+func readLength(r io.Reader) (uint64, error) {
+	var b [8]byte
+	if _, err := io.ReadFull(r, b[:]); err != nil {
+		return 0, err
+	}
+	return binary.BigEndian.Uint64(b[:]), nil
+}
+
+var bulkChunk = make([]byte, 64*1024)
+
+func writeBulk(w io.Writer, n uint64) error {
+	for n > 0 {
+		chunk := bulkChunk
+		if uint64(len(chunk)) > n {
+			chunk = chunk[:n]
+		}
+		if _, err := w.Write(chunk); err != nil {
+			return err
+		}
+		n -= uint64(len(chunk))
+	}
+	return nil
+}
+
+// bulkUpload sends n bytes through the proxy and returns the throughput in
+// megabits per second, measured until the target acknowledges the last byte.
+func bulkUpload(proxy, target string, n uint64) (float64, error) {
+	conn, err := socksConnect(proxy, target)
+	if err != nil {
+		return 0, err
+	}
+	defer conn.Close()
+
+	start := time.Now()
+	if _, err := conn.Write(frame(cmdUpload, n)); err != nil {
+		return 0, err
+	}
+	if err := writeBulk(conn, n); err != nil {
+		return 0, err
+	}
+	var ack [1]byte
+	if _, err := io.ReadFull(conn, ack[:]); err != nil {
+		return 0, fmt.Errorf("upload ack: %w", err)
+	}
+	return mbps(n, time.Since(start)), nil
+}
+
+// bulkDownload receives n bytes through the proxy and returns the
+// throughput in megabits per second.
+func bulkDownload(proxy, target string, n uint64) (float64, error) {
+	conn, err := socksConnect(proxy, target)
+	if err != nil {
+		return 0, err
+	}
+	defer conn.Close()
+
+	start := time.Now()
+	if _, err := conn.Write(frame(cmdDownload, n)); err != nil {
+		return 0, err
+	}
+	if _, err := io.CopyN(io.Discard, conn, int64(n)); err != nil {
+		return 0, err
+	}
+	return mbps(n, time.Since(start)), nil
+}
+
+func frame(cmd byte, n uint64) []byte {
+	b := make([]byte, 9)
+	b[0] = cmd
+	binary.BigEndian.PutUint64(b[1:], n)
+	return b
+}
+
+func mbps(n uint64, d time.Duration) float64 {
+	return float64(n) * 8 / d.Seconds() / 1e6
+}
+
+// requestResponse runs count sequential 64-byte round trips on one tunnelled
+// connection and returns their latencies.
+func requestResponse(proxy, target string, count int) ([]time.Duration, error) {
+	conn, err := socksConnect(proxy, target)
+	if err != nil {
+		return nil, err
+	}
+	defer conn.Close()
+	if _, err := conn.Write([]byte{cmdEcho}); err != nil {
+		return nil, err
+	}
+
+	msg := make([]byte, rrMessageSize)
+	reply := make([]byte, rrMessageSize)
+	samples := make([]time.Duration, 0, count)
+	for i := 0; i < count; i++ {
+		binary.BigEndian.PutUint64(msg, uint64(i))
+		start := time.Now()
+		if _, err := conn.Write(msg); err != nil {
+			return samples, err
+		}
+		if _, err := io.ReadFull(conn, reply); err != nil {
+			return samples, err
+		}
+		samples = append(samples, time.Since(start))
+	}
+	return samples, nil
+}
+
+// connectLatency opens count fresh tunnelled connections and measures each
+// from the SOCKS5 handshake to the first echoed byte, which covers the
+// transport's stream (or connection) setup and the protocol handshake.
+func connectLatency(proxy, target string, count int) ([]time.Duration, error) {
+	samples := make([]time.Duration, 0, count)
+	for i := 0; i < count; i++ {
+		start := time.Now()
+		conn, err := socksConnect(proxy, target)
+		if err != nil {
+			return samples, err
+		}
+		_, err = conn.Write([]byte{cmdEcho, 0})
+		if err == nil {
+			var b [1]byte
+			_, err = io.ReadFull(conn, b[:])
+		}
+		conn.Close()
+		if err != nil {
+			return samples, err
+		}
+		samples = append(samples, time.Since(start))
+	}
+	return samples, nil
+}
+
+// udpRoundTrips sends count sequential datagrams through a SOCKS5 UDP
+// association and returns the round-trip latencies of the ones that came
+// back within udpTimeout, plus the number lost.
+func udpRoundTrips(proxy, target string, count int) ([]time.Duration, int, error) {
+	assoc, err := socksUDPAssociate(proxy)
+	if err != nil {
+		return nil, 0, err
+	}
+	defer assoc.Close()
+
+	dst, err := net.ResolveUDPAddr("udp", target)
+	if err != nil {
+		return nil, 0, err
+	}
+	header := socksUDPHeader(dst)
+	packet := make([]byte, len(header)+udpPayloadSize)
+	copy(packet, header)
+	payload := packet[len(header):]
+	buf := make([]byte, 65535)
+
+	samples := make([]time.Duration, 0, count)
+	lost := 0
+	for i := 0; i < count; i++ {
+		seq := uint64(i)
+		binary.BigEndian.PutUint64(payload, seq)
+		start := time.Now()
+		if _, err := assoc.relay.Write(packet); err != nil {
+			return samples, lost, err
+		}
+		assoc.relay.SetReadDeadline(start.Add(udpTimeout))
+		for {
+			n, err := assoc.relay.Read(buf)
+			if err != nil {
+				var ne net.Error
+				if errors.As(err, &ne) && ne.Timeout() {
+					lost++
+					break
+				}
+				return samples, lost, err
+			}
+			data, ok := socksUDPPayload(buf[:n])
+			// Late replies to earlier datagrams are skipped.
+			if ok && len(data) >= 8 && binary.BigEndian.Uint64(data) == seq {
+				samples = append(samples, time.Since(start))
+				break
+			}
+		}
+	}
+	return samples, lost, nil
+}
+
+// latencyStats summarises one latency test.
+type latencyStats struct {
+	Samples int     `json:"samples"`
+	P50Ms   float64 `json:"p50_ms"`
+	P99Ms   float64 `json:"p99_ms"`
+}
+
+func summarize(samples []time.Duration) latencyStats {
+	return latencyStats{
+		Samples: len(samples),
+		P50Ms:   durationMs(percentile(samples, 50)),
+		P99Ms:   durationMs(percentile(samples, 99)),
+	}
+}
+
+// percentile returns the nearest-rank p-th percentile of samples, 0 if
+// there are none.
+func percentile(samples []time.Duration, p float64) time.Duration {
+	if len(samples) == 0 {
+		return 0
+	}
+	sorted := slices.Clone(samples)
+	slices.Sort(sorted)
+	rank := int(math.Ceil(p / 100 * float64(len(sorted))))
+	return sorted[min(max(rank, 1), len(sorted))-1]
+}
+
+func durationMs(d time.Duration) float64 {
+	return math.Round(float64(d)/float64(time.Microsecond)) / 1000
+}
+
+// Minimal SOCKS5 client (RFC 1928), no authentication.
+
+func socksHandshake(proxy string, cmd byte, addr *net.TCPAddr) (net.Conn, *net.UDPAddr, error) {
+	conn, err := net.DialTimeout("tcp", proxy, 5*time.Second)
+	if err != nil {
+		return nil, nil, err
+	}
+	fail := func(err error) (net.Conn, *net.UDPAddr, error) {
+		conn.Close()
+		return nil, nil, err
+	}
+
+	if _, err := conn.Write([]byte{5, 1, 0}); err != nil {
+		return fail(err)
+	}
+	var method [2]byte
+	if _, err := io.ReadFull(conn, method[:]); err != nil {
+		return fail(err)
+	}
+	if method[0] != 5 || method[1] != 0 {
+		return fail(fmt.Errorf("socks5: method %d refused", method[1]))
+	}
+
+	req := []byte{5, cmd, 0, 1, 0, 0, 0, 0, 0, 0}
+	if addr != nil {
+		copy(req[4:8], addr.IP.To4())
+		binary.BigEndian.PutUint16(req[8:], uint16(addr.Port))
+	}
+	if _, err := conn.Write(req); err != nil {
+		return fail(err)
+	}
+
+	var head [4]byte
+	if _, err := io.ReadFull(conn, head[:]); err != nil {
+		return fail(err)
+	}
+	if head[1] != 0 {
+		return fail(fmt.Errorf("socks5: request failed with reply %d", head[1]))
+	}
+	var ipLen int
+	switch head[3] {
+	case 1:
+		ipLen = net.IPv4len
+	case 4:
+		ipLen = net.IPv6len
+	default:
+		return fail(fmt.Errorf("socks5: unexpected bind address type %d", head[3]))
+	}
+	bind := make([]byte, ipLen+2)
+	if _, err := io.ReadFull(conn, bind); err != nil {
+		return fail(err)
+	}
+	bound := &net.UDPAddr{
+		IP:   net.IP(bind[:ipLen]),
+		Port: int(binary.BigEndian.Uint16(bind[ipLen:])),
+	}
+	return conn, bound, nil
+}
+
+func socksConnect(proxy, target string) (net.Conn, error) {
+	addr, err := net.ResolveTCPAddr("tcp4", target)
+	if err != nil {
+		return nil, err
+	}
+	conn, _, err := socksHandshake(proxy, 1, addr)
+	return conn, err
+}
+
+type udpAssociation struct {
+	control net.Conn
+	relay   *net.UDPConn
+}
+
+func (a *udpAssociation) Close() {
+	a.relay.Close()
+	a.control.Close()
+}
+
+func socksUDPAssociate(proxy string) (*udpAssociation, error) {
+	control, bound, err := socksHandshake(proxy, 3, nil)
+	if err != nil {
+		return nil, err
+	}
+	if bound.IP.IsUnspecified() {
+		host, _, _ := net.SplitHostPort(proxy)
+		bound.IP = net.ParseIP(host)
+	}
+	relay, err := net.DialUDP("udp", nil, bound)
+	if err != nil {
+		control.Close()
+		return nil, err
+	}
+	return &udpAssociation{control: control, relay: relay}, nil
+}
+
+func socksUDPHeader(dst *net.UDPAddr) []byte {
+	h := []byte{0, 0, 0, 1, 0, 0, 0, 0, 0, 0}
+	copy(h[4:8], dst.IP.To4())
+	binary.BigEndian.PutUint16(h[8:], uint16(dst.Port))
+	return h
+}
+
+func socksUDPPayload(b []byte) ([]byte, bool) {
+	if len(b) < 4 || b[2] != 0 {
+		return nil, false
+	}
+	switch b[3] {
+	case 1:
+		return trimHeader(b, 4+net.IPv4len+2)
+	case 4:
+		return trimHeader(b, 4+net.IPv6len+2)
+	case 3:
+		if len(b) < 5 {
+			return nil, false
+		}
+		return trimHeader(b, 4+1+int(b[4])+2)
+	}
+	return nil, false
+}
+
+func trimHeader(b []byte, n int) ([]byte, bool) {
+	if len(b) < n {
+		return nil, false
+	}
+	return b[n:], true
+}
+
+func hostPort(host string, port int) string {
+	return net.JoinHostPort(host, strconv.Itoa(port))
+}
@@ -0,0 +1,396 @@
+package main
+
+import (
+	"context"
+	"crypto/rand"
+	"crypto/subtle"
+	"encoding/hex"
+	"encoding/json"
+	"fmt"
+	"net"
+	"net/http"
+	"net/http/pprof"
+	"runtime"
+	"strconv"
+	"strings"
+	"sync"
+	"time"
+
+	"ewp-core/common/quicresume"
+	"ewp-core/common/tls"
+	"ewp-core/log"
+	"ewp-core/transport"
+	"ewp-core/transport/conntrack"
+)
+
+// The control server is a loopback-only HTTP endpoint for the GUI. At
+// startup it prints a random per-launch token as "CONTROL_TOKEN=..." and
+// then its address as "CONTROL_ADDR=host:port" on stdout. Every request
+// must carry the token as "Authorization: Bearer <token>": in TUN mode the
+// core runs as root or Administrator, and loopback alone would let any
+// local user quit it, close flows or dump its memory.
+//
+//	POST   /quit               graceful shutdown (same path as SIGTERM)
+//	GET    /health             liveness probe for the GUI supervisor
+//	GET    /connections        NDJSON stream of conntrack.Diff, one per second;
+//	                           the first line lists every live flow as "added"
+//	DELETE /connections/{id}   close one flow
+//	GET    /stats              NDJSON stream of statsSample, one per second
+//	GET    /runtime            one runtimeStats snapshot (Go runtime metrics)
+//	GET    /edges              server IP ranking of the TUN bypass resolver
+//	                           (transport.EdgeStats array; empty outside TUN)
+//	GET    /probe/direct?addr=host:port
+//	                           TCP connect around the tunnel: 204 if it
+//	                           succeeds, 502 with the error otherwise
+//	GET    /debug/pprof/...    net/http/pprof: profile?seconds=N, trace?seconds=N,
+//	                           heap, goroutine, mutex?seconds=N, ...
+
+const (
+	connectionsInterval = time.Second
+	statsInterval       = time.Second
+
+	// mutexProfileRate samples 1/n contention events while a mutex profile
+	// is being captured.
+	mutexProfileRate = 5
+
+	directProbeTimeout = 5 * time.Second
+)
+
+var (
+	quitRequested = make(chan struct{})
+	quitOnce      sync.Once
+	startedAt     = time.Now()
+
+	mutexProfileMu      sync.Mutex
+	mutexProfileCapture int
+)
+
+func startControlServer() {
+	var key [16]byte
+	if _, err := rand.Read(key[:]); err != nil {
+		log.Warn("Control server disabled: %v", err)
+		return
+	}
+	token := hex.EncodeToString(key[:])
+	ln, err := net.Listen("tcp", "127.0.0.1:0")
+	if err != nil {
+		log.Warn("Control server disabled: %v", err)
+		return
+	}
+
+	mux := http.NewServeMux()
+	mux.HandleFunc("/quit", handleQuit)
+	mux.HandleFunc("/health", handleHealth)
+	mux.HandleFunc("/connections", handleConnections)
+	mux.HandleFunc("/connections/", handleCloseConnection)
+	mux.HandleFunc("/stats", handleStats)
+	mux.HandleFunc("/runtime", handleRuntime)
+	mux.HandleFunc("/edges", handleEdges)
+	mux.HandleFunc("/probe/direct", handleDirectProbe)
+	mux.HandleFunc("/debug/pprof/", pprof.Index)
+	mux.HandleFunc("/debug/pprof/profile", pprof.Profile)
+	mux.HandleFunc("/debug/pprof/trace", pprof.Trace)
+	mux.HandleFunc("/debug/pprof/mutex", handleMutexProfile)
+
+	go func() {
+		if err := http.Serve(ln, requireToken(token, mux)); err != nil {
+			log.Warn("Control server stopped: %v", err)
+		}
+	}()
+	fmt.Printf("CONTROL_TOKEN=%s\n", token)
+	fmt.Printf("CONTROL_ADDR=%s\n", ln.Addr())
+}
+
+// requireToken rejects requests that do not carry the control token.
+func requireToken(token string, next http.Handler) http.Handler {
+	want := []byte("Bearer " + token)
+	return http.HandlerFunc(func(w http.ResponseWriter, r *http.Request) {
+		if subtle.ConstantTimeCompare([]byte(r.Header.Get("Authorization")), want) != 1 {
+			http.Error(w, "unauthorized", http.StatusUnauthorized)
+			return
+		}
+		next.ServeHTTP(w, r)
+	})
+}
+
+func handleQuit(w http.ResponseWriter, r *http.Request) {
+	if r.Method != http.MethodPost {
+		http.Error(w, "method not allowed", http.StatusMethodNotAllowed)
+		return
+	}
+	w.WriteHeader(http.StatusNoContent)
+	quitOnce.Do(func() { close(quitRequested) })
+}
+
+// handleHealth answers the supervisor heartbeat. It goes through the
+// conntrack registry lock, so a core wedged on it misses heartbeats instead
+// of looking alive.
+func handleHealth(w http.ResponseWriter, r *http.Request) {
+	if r.Method != http.MethodGet {
+		http.Error(w, "method not allowed", http.StatusMethodNotAllowed)
+		return
+	}
+	w.Header().Set("Content-Type", "application/json")
+	json.NewEncoder(w).Encode(map[string]any{
+		"uptime_s": int64(time.Since(startedAt).Seconds()),
+		"active":   conntrack.GetTotals().Active,
+	})
+}
+
+func handleConnections(w http.ResponseWriter, r *http.Request) {
+	if r.Method != http.MethodGet {
+		http.Error(w, "method not allowed", http.StatusMethodNotAllowed)
+		return
+	}
+	flusher, ok := w.(http.Flusher)
+	if !ok {
+		http.Error(w, "streaming unsupported", http.StatusInternalServerError)
+		return
+	}
+	w.Header().Set("Content-Type", "application/x-ndjson")
+	w.Header().Set("Cache-Control", "no-cache")
+
+	enc := json.NewEncoder(w)
+	var watcher conntrack.Watcher
+	ticker := time.NewTicker(connectionsInterval)
+	defer ticker.Stop()
+
+	// The first diff is always sent, even when empty, so the client knows
+	// the stream is live.
+	first := true
+	now := time.Now()
+	for {
+		if d := watcher.Next(now); first || !d.Empty() {
+			if err := enc.Encode(d); err != nil {
+				return
+			}
+			flusher.Flush()
+			first = false
+		}
+		select {
+		case now = <-ticker.C:
+		case <-r.Context().Done():
+			return
+		}
+	}
+}
+
+func handleCloseConnection(w http.ResponseWriter, r *http.Request) {
+	if r.Method != http.MethodDelete {
+		http.Error(w, "method not allowed", http.StatusMethodNotAllowed)
+		return
+	}
+	id, err := strconv.ParseUint(strings.TrimPrefix(r.URL.Path, "/connections/"), 10, 64)
+	if err != nil {
+		http.Error(w, "invalid connection id", http.StatusBadRequest)
+		return
+	}
+	if !conntrack.Close(id) {
+		http.NotFound(w, r)
+		return
+	}
+	log.Info("Connection %d closed by controller", id)
+	w.WriteHeader(http.StatusNoContent)
+}
+
+// statsSample is one line of the /stats stream. Rates are bytes per second
+// over the last interval; setup_ms is the mean tunnel setup latency (dial +
+// connect) of the flows opened in that interval, 0 if none were. tls and
+// quic hold the session resumption and 0-RTT counters since process start.
+type statsSample struct {
+	Time     int64      `json:"time"` // unix seconds
+	Upload   int64      `json:"upload"`
+	Download int64      `json:"download"`
+	UpRate   int64      `json:"up_rate"`
+	DownRate int64      `json:"down_rate"`
+	Active   int        `json:"active"`
+	SetupMs  float64    `json:"setup_ms"`
+	TLS      tlsSample  `json:"tls"`
+	QUIC     quicSample `json:"quic"`
+}
+
+type tlsSample struct {
+	Handshakes  int64 `json:"handshakes"`
+	Resumed     int64 `json:"resumed"`
+	CacheHits   int64 `json:"cache_hits"`
+	CacheMisses int64 `json:"cache_misses"`
+	Cached      int   `json:"cached"`
+	Loaded      int   `json:"loaded"` // restored from disk at startup
+}
+
+type quicSample struct {
+	Dials         int64 `json:"dials"`
+	Resumed       int64 `json:"resumed"`
+	Attempted0RTT int64 `json:"attempted_0rtt"`
+	Accepted0RTT  int64 `json:"accepted_0rtt"`
+	Rejected0RTT  int64 `json:"rejected_0rtt"`
+}
+
+func sampleQUIC() quicSample {
+	st := quicresume.GetStats()
+	return quicSample{
+		Dials:         st.Dials,
+		Resumed:       st.Resumed,
+		Attempted0RTT: st.Attempted0RTT,
+		Accepted0RTT:  st.Accepted0RTT,
+		Rejected0RTT:  st.Rejected0RTT,
+	}
+}
+
+func sampleTLS() tlsSample {
+	st := tls.GetSessionStats()
+	return tlsSample{
+		Handshakes:  st.Handshakes,
+		Resumed:     st.Resumed,
+		CacheHits:   st.CacheHits,
+		CacheMisses: st.CacheMisses,
+		Cached:      st.Entries,
+		Loaded:      st.Loaded,
+	}
+}
+
+func handleStats(w http.ResponseWriter, r *http.Request) {
+	if r.Method != http.MethodGet {
+		http.Error(w, "method not allowed", http.StatusMethodNotAllowed)
+		return
+	}
+	flusher, ok := w.(http.Flusher)
+	if !ok {
+		http.Error(w, "streaming unsupported", http.StatusInternalServerError)
+		return
+	}
+	w.Header().Set("Content-Type", "application/x-ndjson")
+	w.Header().Set("Cache-Control", "no-cache")
+
+	enc := json.NewEncoder(w)
+	ticker := time.NewTicker(statsInterval)
+	defer ticker.Stop()
+
+	prev := conntrack.GetTotals()
+	last := time.Now()
+	for {
+		select {
+		case now := <-ticker.C:
+			cur := conntrack.GetTotals()
+			elapsed := now.Sub(last).Seconds()
+			sample := statsSample{
+				Time:     now.Unix(),
+				Upload:   cur.Upload,
+				Download: cur.Download,
+				UpRate:   int64(float64(max(cur.Upload-prev.Upload, 0)) / elapsed),
+				DownRate: int64(float64(max(cur.Download-prev.Download, 0)) / elapsed),
+				Active:   cur.Active,
+				SetupMs:  float64(conntrack.TakeSetupLatency()) / float64(time.Millisecond),
+				TLS:      sampleTLS(),
+				QUIC:     sampleQUIC(),
+			}
+			prev, last = cur, now
+			if err := enc.Encode(sample); err != nil {
+				return
+			}
+			flusher.Flush()
+		case <-r.Context().Done():
+			return
+		}
+	}
+}
+
+// runtimeStats is the /runtime response. The GUI polls it at a low rate
+// next to /proc/<pid> to spot goroutine or heap leaks in long-running cores;
+// cmd/bench diffs the cumulative allocation counters around a workload.
+type runtimeStats struct {
+	Goroutines   int     `json:"goroutines"`
+	HeapAlloc    uint64  `json:"heap_alloc"`
+	HeapSys      uint64  `json:"heap_sys"`
+	TotalAlloc   uint64  `json:"total_alloc"`
+	Mallocs      uint64  `json:"mallocs"`
+	NumGC        uint32  `json:"num_gc"`
+	LastPauseMs  float64 `json:"last_pause_ms"`
+	PauseTotalMs float64 `json:"pause_total_ms"`
+	ActiveFlows  int     `json:"active_flows"`
+}
+
+func handleRuntime(w http.ResponseWriter, r *http.Request) {
+	if r.Method != http.MethodGet {
+		http.Error(w, "method not allowed", http.StatusMethodNotAllowed)
+		return
+	}
+	var ms runtime.MemStats
+	runtime.ReadMemStats(&ms)
+	stats := runtimeStats{
+		Goroutines:   runtime.NumGoroutine(),
+		HeapAlloc:    ms.HeapAlloc,
+		HeapSys:      ms.HeapSys,
+		TotalAlloc:   ms.TotalAlloc,
+		Mallocs:      ms.Mallocs,
+		NumGC:        ms.NumGC,
+		PauseTotalMs: float64(ms.PauseTotalNs) / float64(time.Millisecond),
+		ActiveFlows:  conntrack.GetTotals().Active,
+	}
+	if ms.NumGC > 0 {
+		stats.LastPauseMs = float64(ms.PauseNs[(ms.NumGC+255)%256]) / float64(time.Millisecond)
+	}
+	w.Header().Set("Content-Type", "application/json")
+	json.NewEncoder(w).Encode(stats)
+}
+
+func handleEdges(w http.ResponseWriter, r *http.Request) {
+	if r.Method != http.MethodGet {
+		http.Error(w, "method not allowed", http.StatusMethodNotAllowed)
+		return
+	}
+	edges := transport.GetEdgeStats()
+	if edges == nil {
+		edges = []transport.EdgeStats{}
+	}
+	w.Header().Set("Content-Type", "application/json")
+	json.NewEncoder(w).Encode(edges)
+}
+
+// handleDirectProbe connects to addr without going through the tunnel, so
+// the supervisor can tell a broken tunnel, which a restart may fix, from a
+// broken uplink, which it cannot.
+func handleDirectProbe(w http.ResponseWriter, r *http.Request) {
+	if r.Method != http.MethodGet {
+		http.Error(w, "method not allowed", http.StatusMethodNotAllowed)
+		return
+	}
+	addr := r.URL.Query().Get("addr")
+	if _, _, err := net.SplitHostPort(addr); err != nil {
+		http.Error(w, "invalid addr", http.StatusBadRequest)
+		return
+	}
+	ctx, cancel := context.WithTimeout(r.Context(), directProbeTimeout)
+	defer cancel()
+	conn, err := transport.DialDirect(ctx, addr)
+	if err != nil {
+		http.Error(w, err.Error(), http.StatusBadGateway)
+		return
+	}
+	conn.Close()
+	w.WriteHeader(http.StatusNoContent)
+}
+
+// handleMutexProfile serves the pprof mutex profile, turning contention
+// sampling on for the duration of a ?seconds=N delta capture. It stays off
+// otherwise because it adds cost to every contended Unlock.
+func handleMutexProfile(w http.ResponseWriter, r *http.Request) {
+	if r.URL.Query().Get("seconds") != "" {
+		mutexProfileMu.Lock()
+		if mutexProfileCapture == 0 {
+			runtime.SetMutexProfileFraction(mutexProfileRate)
+		}
+		mutexProfileCapture++
+		mutexProfileMu.Unlock()
+
+		defer func() {
+			mutexProfileMu.Lock()
+			mutexProfileCapture--
+			if mutexProfileCapture == 0 {
+				runtime.SetMutexProfileFraction(0)
+			}
+			mutexProfileMu.Unlock()
+		}()
+	}
+	pprof.Handler("mutex").ServeHTTP(w, r)
+}
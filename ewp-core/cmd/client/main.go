@@ -1,34 +1,62 @@
 package main
 
 import (
+	"encoding/hex"
+	"errors"
 	"fmt"
 	"net"
 	"os"
 	"os/signal"
 	"syscall"
+	"time"
 
+	commonnet "ewp-core/common/net"
+	"ewp-core/common/quicresume"
 	"ewp-core/common/tls"
 	"ewp-core/log"
 	"ewp-core/option"
 	"ewp-core/protocol"
 	"ewp-core/protocol/socks5"
 	"ewp-core/transport"
+	"ewp-core/transport/group"
 	"ewp-core/transport/grpc"
 	"ewp-core/transport/h3grpc"
 	masquetransport "ewp-core/transport/masque"
+	"ewp-core/transport/mux"
 	"ewp-core/transport/websocket"
 	"ewp-core/transport/xhttp"
 	"ewp-core/tun"
 	"ewp-core/tun/util"
 )
 
+// exitConfig is the exit status for errors a restart cannot fix: a bad
+// configuration or missing privileges. It is EX_CONFIG from sysexits.h;
+// the GUI supervisor reports it to the user instead of restarting the core.
+const exitConfig = 78
+
+// configFatalf logs a configuration error and exits with exitConfig.
+func configFatalf(format string, v ...interface{}) {
+	log.Error(format, v...)
+	os.Exit(exitConfig)
+}
+
+// configError marks an outbound setup error caused by the configuration
+// itself. Other setup errors (an ECH config fetch over DoH, say) may pass
+// on a retry, so they exit with an ordinary status and the supervisor
+// restarts the core with backoff.
+type configError struct{ error }
+
+func configErrorf(format string, v ...interface{}) error {
+	return configError{fmt.Errorf(format, v...)}
+}
+
 func main() {
 	// Load configuration (will parse flags internally)
 	cfg, err := option.LoadConfigWithFallback()
 	if err != nil {
 		fmt.Fprintf(os.Stderr, "Failed to load configuration: %v\n", err)
 		fmt.Fprintf(os.Stderr, "Usage: %s -c config.json\n", os.Args[0])
-		os.Exit(1)
+		os.Exit(exitConfig)
 	}
 
 	// Setup logging
@@ -37,44 +65,152 @@ func main() {
 	log.Info("EWP-Core Client")
 	log.Info("Config: Inbounds=%d, Outbounds=%d", len(cfg.Inbounds), len(cfg.Outbounds))
 
-	// Get the first outbound (primary proxy)
-	if len(cfg.Outbounds) == 0 {
-		log.Fatalf("No outbound configured")
+	if cfg.Cache != nil && cfg.Cache.TLSSessionFile != "" {
+		enableSessionPersistence(cfg.Cache.TLSSessionFile)
 	}
 
-	outbound := cfg.Outbounds[0]
-	log.Info("Outbound: tag=%s, type=%s, server=%s:%d",
-		outbound.Tag, outbound.Type, outbound.Server, outbound.ServerPort)
-
-	// Create transport
-	trans, err := createTransport(outbound, cfg)
-	if err != nil {
-		log.Fatalf("Failed to create transport: %v", err)
+	if len(cfg.Outbounds) == 0 {
+		configFatalf("No outbound configured")
 	}
-
-	// Determine inbound type
 	if len(cfg.Inbounds) == 0 {
-		log.Fatalf("No inbound configured")
+		configFatalf("No inbound configured")
 	}
 
-	inbound := cfg.Inbounds[0]
-	log.Info("Inbound: tag=%s, type=%s", inbound.Tag, inbound.Type)
+	// Lets the GUI shut down gracefully and watch live connections
+	startControlServer()
 
-	// Start based on inbound type
+	// Start based on the first inbound's type
+	outbounds := newOutboundSet(cfg)
+	inbound := cfg.Inbounds[0]
 	switch inbound.Type {
 	case "tun":
-		startTunMode(inbound, trans, cfg)
+		log.Info("Inbound: tag=%s, type=%s", inbound.Tag, inbound.Type)
+		if len(cfg.Inbounds) > 1 {
+			// The TUN bypass dialer is only installed on the TUN outbound;
+			// other transports would loop back through the TUN device.
+			log.Warn("TUN mode: ignoring %d additional inbound(s)", len(cfg.Inbounds)-1)
+		}
+		startTunMode(inbound, outbounds, cfg)
 	case "mixed", "socks", "http":
-		startProxyMode(inbound, trans, cfg)
+		startProxyMode(cfg, outbounds)
 	default:
-		log.Fatalf("Unsupported inbound type: %s", inbound.Type)
+		configFatalf("Unsupported inbound type: %s", inbound.Type)
 	}
 }
 
+// outboundSet creates each outbound transport once, so inbounds and groups
+// that reference the same outbound share its connection pools and session
+// state.
+type outboundSet struct {
+	cfg   *option.RootConfig
+	byTag map[string]transport.Transport
+	all   []transport.Transport // creation order, for stats
+}
+
+func newOutboundSet(cfg *option.RootConfig) *outboundSet {
+	return &outboundSet{cfg: cfg, byTag: make(map[string]transport.Transport)}
+}
+
+func (s *outboundSet) mustGet(tag string) transport.Transport {
+	trans, err := s.get(tag)
+	if errors.As(err, new(configError)) {
+		configFatalf("Failed to create transport: %v", err)
+	}
+	if err != nil {
+		log.Fatalf("Failed to create transport: %v", err)
+	}
+	return trans
+}
+
+func (s *outboundSet) get(tag string) (transport.Transport, error) {
+	if trans, ok := s.byTag[tag]; ok {
+		return trans, nil
+	}
+	outbound := findOutbound(s.cfg, tag)
+	if outbound == nil {
+		return nil, configErrorf("unknown outbound %s", tag)
+	}
+	if outbound.IsGroup() {
+		log.Info("Outbound: tag=%s, type=%s, members=%v", outbound.Tag, outbound.Type, outbound.Outbounds)
+	} else {
+		log.Info("Outbound: tag=%s, type=%s, server=%s:%d",
+			outbound.Tag, outbound.Type, outbound.Server, outbound.ServerPort)
+	}
+
+	trans, err := s.create(*outbound)
+	if err != nil {
+		return nil, fmt.Errorf("outbound %s: %w", tag, err)
+	}
+	s.byTag[tag] = trans
+	s.all = append(s.all, trans)
+	return trans, nil
+}
+
+// create builds the transport for a node outbound, or a urltest / fallback /
+// balancer group over the member outbounds it references.
+func (s *outboundSet) create(outbound option.OutboundConfig) (transport.Transport, error) {
+	if !outbound.IsGroup() {
+		return createTransport(outbound, s.cfg)
+	}
+
+	mode, err := group.ParseMode(outbound.Type)
+	if err != nil {
+		return nil, configError{err}
+	}
+	opts := group.Options{
+		URL:       outbound.URL,
+		Tolerance: time.Duration(outbound.Tolerance) * time.Millisecond,
+	}
+	if outbound.Interval != "" {
+		opts.Interval, _ = time.ParseDuration(outbound.Interval)
+	}
+	if opts.Strategy, err = group.ParseStrategy(outbound.Strategy); err != nil {
+		return nil, configError{err}
+	}
+
+	var members []group.Member
+	for _, tag := range outbound.Outbounds {
+		trans, err := s.get(tag)
+		if err != nil {
+			return nil, fmt.Errorf("group %s: member %s: %w", outbound.Tag, tag, err)
+		}
+		members = append(members, group.Member{Tag: tag, Transport: trans, Weight: outbound.Weights[tag]})
+	}
+	g, err := group.New(outbound.Tag, mode, members, opts)
+	if err != nil {
+		return nil, configError{err}
+	}
+	return g, nil
+}
+
+func findOutbound(cfg *option.RootConfig, tag string) *option.OutboundConfig {
+	for i := range cfg.Outbounds {
+		if cfg.Outbounds[i].Tag == tag {
+			return &cfg.Outbounds[i]
+		}
+	}
+	return nil
+}
+
+// primaryServer returns the server of the given outbound (the first member
+// for a group); TUN mode uses it to find the physical interface.
+func primaryServer(cfg *option.RootConfig, tag string) string {
+	outbound := findOutbound(cfg, tag)
+	if outbound == nil {
+		return ""
+	}
+	if outbound.IsGroup() && len(outbound.Outbounds) > 0 {
+		if member := findOutbound(cfg, outbound.Outbounds[0]); member != nil {
+			return member.Server
+		}
+	}
+	return outbound.Server
+}
+
 func createTransport(outbound option.OutboundConfig, cfg *option.RootConfig) (transport.Transport, error) {
 	// Validate outbound
 	if outbound.Type != "ewp" && outbound.Type != "trojan" {
-		return nil, fmt.Errorf("unsupported outbound type: %s", outbound.Type)
+		return nil, configErrorf("unsupported outbound type: %s", outbound.Type)
 	}
 
 	// Determine server address
@@ -124,7 +260,7 @@ func createTransport(outbound option.OutboundConfig, cfg *option.RootConfig) (tr
 
 	// Get transport config
 	if outbound.Transport == nil {
-		return nil, fmt.Errorf("transport configuration is required")
+		return nil, configErrorf("transport configuration is required")
 	}
 
 	transportType := outbound.Transport.Type
@@ -145,7 +281,7 @@ func createTransport(outbound option.OutboundConfig, cfg *option.RootConfig) (tr
 		if path == "" {
 			path = "/"
 		}
-		trans, err = websocket.NewWithProtocol(
+		wsTrans, err := websocket.NewWithProtocol(
 			serverAddr, uuid, password,
 			useECH, useMozillaCA, enableFlow, enablePQC, useTrojan,
 			path, echMgr,
@@ -153,6 +289,11 @@ func createTransport(outbound option.OutboundConfig, cfg *option.RootConfig) (tr
 		if err != nil {
 			return nil, err
 		}
+		if outbound.Transport.MaxEarlyData > 0 {
+			wsTrans.SetEarlyData(outbound.Transport.MaxEarlyData, outbound.Transport.EarlyDataHeaderName)
+			log.Info("WebSocket early data: up to %d bytes", outbound.Transport.MaxEarlyData)
+		}
+		trans = wsTrans
 
 	case "grpc":
 		serviceName := outbound.Transport.ServiceName
@@ -225,7 +366,7 @@ func createTransport(outbound option.OutboundConfig, cfg *option.RootConfig) (tr
 		trans = mTrans
 
 	default:
-		return nil, fmt.Errorf("unsupported transport type: %s", transportType)
+		return nil, configErrorf("unsupported transport type: %s", transportType)
 	}
 
 	// Apply Host override (HTTP Host header / gRPC authority)
@@ -267,15 +408,45 @@ func createTransport(outbound option.OutboundConfig, cfg *option.RootConfig) (tr
 		}
 	}
 
+	// TCP Fast Open (TCP transports only)
+	if outbound.TCPFastOpen {
+		switch t := trans.(type) {
+		case *websocket.Transport:
+			t.SetTCPFastOpen(true)
+		case *grpc.Transport:
+			t.SetTCPFastOpen(true)
+		case *xhttp.Transport:
+			t.SetTCPFastOpen(true)
+		default:
+			log.Warn("TCP Fast Open only applies to ws/grpc/xhttp transports, ignored")
+		}
+	}
+
+	// Trojan multiplex: wrap the transport so each Dial() opens an smux stream
+	// over a pooled tunnel instead of a fresh TLS + transport handshake.
+	if outbound.Multiplex != nil && outbound.Multiplex.Enabled {
+		if !useTrojan {
+			log.Warn("Multiplex is only supported for trojan outbounds, ignored")
+		} else if transportType == "masque" {
+			log.Warn("Multiplex is not supported over masque, ignored")
+		} else {
+			if outbound.Multiplex.Padding {
+				log.Warn("Multiplex padding is not supported by the smux wire format, ignored")
+			}
+			trans = mux.New(trans, outbound.Multiplex.Concurrency)
+		}
+	}
+
 	log.Info("Transport created: %s", trans.Name())
 	return trans, nil
 }
 
-func startTunMode(inbound option.InboundConfig, trans transport.Transport, cfg *option.RootConfig) {
+func startTunMode(inbound option.InboundConfig, outbounds *outboundSet, cfg *option.RootConfig) {
 	log.Info("Starting TUN mode...")
+	trans := outbounds.mustGet(cfg.OutboundForInbound(inbound.Tag))
 
 	if !util.IsAdmin() {
-		log.Fatalf("TUN mode requires administrator privileges")
+		configFatalf("TUN mode requires administrator privileges")
 	}
 
 	// Parse TUN address
@@ -310,6 +481,11 @@ func startTunMode(inbound option.InboundConfig, trans transport.Transport, cfg *
 
 	log.Info("TUN DNS: IPv4=%s, IPv6=%s", dnsServer, dns6Server)
 
+	routeExclude, err := inbound.ExcludePrefixes()
+	if err != nil {
+		configFatalf("TUN route exclusion: %v", err)
+	}
+
 	tunCfg := &tun.Config{
 		IP:              tunIP,
 		DNS:             dnsServer,
@@ -318,9 +494,13 @@ func startTunMode(inbound option.InboundConfig, trans transport.Transport, cfg *
 		MTU:             mtu,
 		Stack:           inbound.Stack,
 		Transport:       trans,
-		ServerAddr:      cfg.Outbounds[0].Server,
+		ServerAddr:      primaryServer(cfg, cfg.OutboundForInbound(inbound.Tag)),
 		TunnelDoHServer: inbound.TunnelDoHServer,
 		DisableFakeIP:   inbound.DisableFakeIP,
+		DisableOffload:  inbound.DisableOffload,
+		Queues:          inbound.Queues,
+		RouteExclude:    routeExclude,
+		RedundantUDP:    redundantUDP(inbound.RedundantUDP, outbounds),
 	}
 
 	tunDev, err := tun.New(tunCfg)
@@ -342,8 +522,17 @@ func startTunMode(inbound option.InboundConfig, trans transport.Transport, cfg *
 	signal.Notify(sigChan, syscall.SIGINT, syscall.SIGTERM)
 	defer signal.Stop(sigChan)
 	go func() {
-		<-sigChan
+		select {
+		case <-sigChan:
+		case <-quitRequested:
+		}
 		log.Info("Received exit signal, shutting down TUN...")
+		logSessionStats(outbounds.all...)
+		if rs := tun.GetRedundantUDPStats(); rs.Flows+rs.Degraded > 0 {
+			log.Info("Redundant UDP: %d flows (%d single-path), %d datagrams, secondary first %d, %d duplicates dropped",
+				rs.Flows+rs.Degraded, rs.Degraded, rs.Delivered, rs.SecondaryFirst, rs.Duplicates)
+		}
+		tls.FlushSessionCache()
 		tunDev.Close()
 	}()
 
@@ -352,14 +541,29 @@ func startTunMode(inbound option.InboundConfig, trans transport.Transport, cfg *
 	}
 }
 
-func startProxyMode(inbound option.InboundConfig, trans transport.Transport, cfg *option.RootConfig) {
-	listenAddr := inbound.Listen
-	if listenAddr == "" {
-		listenAddr = "127.0.0.1:1080"
+// redundantUDP resolves the dual-path UDP outbounds of a TUN inbound.
+func redundantUDP(r *option.RedundantUDPConfig, outbounds *outboundSet) *tun.RedundantUDPConfig {
+	if r == nil {
+		return nil
 	}
+	out := &tun.RedundantUDPConfig{
+		Primary:   outbounds.mustGet(r.Primary),
+		Secondary: outbounds.mustGet(r.Secondary),
+	}
+	for _, p := range r.Port {
+		out.Ports = append(out.Ports, tun.PortRange{From: uint16(p), To: uint16(p)})
+	}
+	for _, pr := range r.PortRange {
+		from, to, _ := option.ParsePortRange(pr) // validated on load
+		out.Ports = append(out.Ports, tun.PortRange{From: from, To: to})
+	}
+	log.Info("Redundant UDP: %s + %s (%d port rule(s), 0 = all flows)", r.Primary, r.Secondary, len(out.Ports))
+	return out
+}
 
-	log.Info("Starting %s proxy on %s", inbound.Type, listenAddr)
-
+// startProxyMode runs every mixed / socks / http inbound in this process,
+// each routed to its own outbound (see RootConfig.OutboundForInbound).
+func startProxyMode(cfg *option.RootConfig, outbounds *outboundSet) {
 	// Determine DNS server for protocol module
 	// Use IP address to avoid DNS dependency (Alibaba Cloud DNS)
 	dnsServer := "https://223.5.5.5/dns-query"
@@ -372,26 +576,101 @@ func startProxyMode(inbound option.InboundConfig, trans transport.Transport, cfg
 		}
 	}
 
-	// Build user auth map from inbound config.
-	var users socks5.Users
-	if len(inbound.Users) > 0 {
-		users = make(socks5.Users, len(inbound.Users))
-		for _, u := range inbound.Users {
-			users[u.Username] = u.Password
+	var servers []*protocol.Server
+	for _, inbound := range cfg.Inbounds {
+		if inbound.Type == "tun" {
+			log.Warn("Proxy mode: ignoring TUN inbound %s (must be the first inbound)", inbound.Tag)
+			continue
+		}
+		listenAddr := inbound.Listen
+		if listenAddr == "" {
+			listenAddr = "127.0.0.1:1080"
 		}
-		log.Info("SOCKS5 auth enabled (%d user(s))", len(users))
+		outboundTag := cfg.OutboundForInbound(inbound.Tag)
+		log.Info("Inbound: tag=%s, type=%s, listen=%s -> outbound %s", inbound.Tag, inbound.Type, listenAddr, outboundTag)
+		trans := outbounds.mustGet(outboundTag)
+
+		// Build user auth map from inbound config.
+		var users socks5.Users
+		if len(inbound.Users) > 0 {
+			users = make(socks5.Users, len(inbound.Users))
+			for _, u := range inbound.Users {
+				users[u.Username] = u.Password
+			}
+			log.Info("SOCKS5 auth enabled on %s (%d user(s))", inbound.Tag, len(users))
+		}
+
+		server := protocol.NewServer(listenAddr, trans, dnsServer, users, inbound.MaxConnections)
+		server.SetTag(inbound.Tag)
+		servers = append(servers, server)
 	}
 
 	sigChan := make(chan os.Signal, 1)
 	signal.Notify(sigChan, syscall.SIGINT, syscall.SIGTERM)
 	go func() {
-		<-sigChan
+		select {
+		case <-sigChan:
+		case <-quitRequested:
+		}
 		log.Info("Received exit signal, shutting down...")
+		logSessionStats(outbounds.all...)
+		tls.FlushSessionCache()
 		os.Exit(0)
 	}()
 
-	server := protocol.NewServer(listenAddr, trans, dnsServer, users, inbound.MaxConnections)
-	log.Fatalf("Proxy server stopped: %v", server.Run())
+	// A listener that fails to start takes the process down, as with a
+	// single inbound: the GUI treats a running core as fully listening.
+	errCh := make(chan error, len(servers))
+	for _, server := range servers {
+		go func(server *protocol.Server) {
+			errCh <- server.Run()
+		}(server)
+	}
+	log.Fatalf("Proxy server stopped: %v", <-errCh)
+}
+
+// sessionKeyEnv carries the hex session cache key from the launcher (the
+// GUI), so the key never sits on disk next to the tickets it protects.
+const sessionKeyEnv = "EWP_TLS_SESSION_KEY"
+
+func enableSessionPersistence(path string) {
+	hexKey := os.Getenv(sessionKeyEnv)
+	os.Unsetenv(sessionKeyEnv)
+	if hexKey == "" {
+		log.Warn("TLS session cache kept in memory only: %s not set", sessionKeyEnv)
+		return
+	}
+	key, err := hex.DecodeString(hexKey)
+	if err == nil {
+		err = tls.EnableSessionPersistence(path, key)
+	}
+	if err != nil {
+		log.Warn("TLS session cache kept in memory only: %v", err)
+	}
+}
+
+func logSessionStats(transports ...transport.Transport) {
+	for _, trans := range transports {
+		g, ok := trans.(*group.Group)
+		if !ok {
+			continue
+		}
+		for _, m := range g.Status() {
+			log.Info("Group member %s: healthy=%v, %d active / %d total connections, %d failures, up %d / down %d bytes",
+				m.Tag, m.Healthy, m.Active, m.Total, m.Failures, m.Upload, m.Download)
+		}
+	}
+	st := tls.GetSessionStats()
+	log.Info("TLS sessions: %d handshakes, %d resumed (%.0f%%), cache %d hit / %d miss, %d cached",
+		st.Handshakes, st.Resumed, st.ResumptionRate()*100, st.CacheHits, st.CacheMisses, st.Entries)
+	if qs := quicresume.GetStats(); qs.Dials > 0 {
+		log.Info("QUIC: %d connections, %d resumed, 0-RTT %d attempted / %d accepted / %d rejected",
+			qs.Dials, qs.Resumed, qs.Attempted0RTT, qs.Accepted0RTT, qs.Rejected0RTT)
+	}
+	if fs := commonnet.GetTFOStats(); fs.Attempts > 0 {
+		log.Info("TCP Fast Open: %d attempts, %d SYN data acked, %d fallbacks, %d destinations disabled",
+			fs.Attempts, fs.Succeeded, fs.Fallbacks, fs.Disabled)
+	}
 }
 
 func setupLogging(cfg *option.RootConfig) {
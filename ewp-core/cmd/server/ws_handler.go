@@ -18,18 +18,25 @@ func isWebSocketRequest(r *http.Request) bool {
 	return strings.ToLower(r.Header.Get("Upgrade")) == "websocket"
 }
 
+// earlyDataHeader names the request header that carries WebSocket early data
+// ("" = second Sec-WebSocket-Protocol value). Must match the client's
+// early_data_header_name.
+var earlyDataHeader = getEnv("EARLY_DATA_HEADER", "")
+
 func wsHandler(w http.ResponseWriter, r *http.Request) {
-	proto := r.Header.Get("Sec-WebSocket-Protocol")
+	expected := uuid
 	if trojanMode {
-		if proto != password {
-			disguiseHandler(w, r)
-			return
-		}
-	} else {
-		if proto != uuid {
-			disguiseHandler(w, r)
-			return
-		}
+		expected = password
+	}
+
+	proto, earlyData, ok := wstransport.ParseEarlyDataHeader(r.Header, earlyDataHeader)
+	if proto != expected && r.Header.Get("Sec-WebSocket-Protocol") == expected {
+		// Auth token containing a comma, no early data.
+		proto, earlyData, ok = expected, nil, true
+	}
+	if !ok || proto != expected {
+		disguiseHandler(w, r)
+		return
 	}
 
 	if !isWebSocketRequest(r) {
@@ -54,10 +61,15 @@ func wsHandler(w http.ResponseWriter, r *http.Request) {
 
 	go socket.ReadLoop()
 
-	firstMsg, err := adapter.ReadFirst()
-	if err != nil {
-		log.Warn("WebSocket: failed to read first message: %v", err)
-		return
+	// Early data already holds the first message; otherwise wait for it.
+	firstMsg := earlyData
+	if firstMsg == nil {
+		var err error
+		firstMsg, err = adapter.ReadFirst()
+		if err != nil {
+			log.Warn("WebSocket: failed to read first message: %v", err)
+			return
+		}
 	}
 
 	if trojanMode {
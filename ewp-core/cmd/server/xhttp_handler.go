@@ -224,6 +224,18 @@ func xhttpStreamOneHandler(w http.ResponseWriter, r *http.Request) {
 
 	log.Info("[XHTTP] stream-one: %s (user: %s) -> %s", clientIP, result.UserID, result.Target)
 
+	if result.IsMux {
+		log.Info("[XHTTP] stream-one mux mode")
+		flusher := setStreamResponseHeaders(w, "application/octet-stream")
+		if flusher == nil {
+			return
+		}
+		transport := xhttptransport.NewServerAdapter(r.Body, w, flusher)
+		server.HandleTrojanMux(context.Background(), transport, result.UserID, 10*time.Second)
+		log.Info("[XHTTP] stream-one mux closed: %s", clientIP)
+		return
+	}
+
 	if result.IsUDP {
 		log.Info("[XHTTP] stream-one UDP mode")
 		flusher := setStreamResponseHeaders(w, "application/octet-stream")
@@ -3,12 +3,49 @@ package net
 import (
 	"context"
 	"net"
+	"sync"
+	"sync/atomic"
 	"syscall"
 	"time"
 
 	"ewp-core/log"
 )
 
+const (
+	// defaultDialTimeout applies when the caller's dialer has no timeout.
+	defaultDialTimeout = 10 * time.Second
+
+	// A destination whose SYN data goes unacknowledged tfoMaxMisses times in
+	// a row (Fast Open option stripped or SYN data dropped by a middlebox) is
+	// dialled without Fast Open for tfoRetryAfter. The first dial to a server
+	// only fetches the cookie, so a single miss is normal.
+	tfoMaxMisses  = 3
+	tfoRetryAfter = 10 * time.Minute
+)
+
+// TFOStats reports client-side TCP Fast Open effectiveness since process start.
+type TFOStats struct {
+	Attempts  int64 // dials with client Fast Open enabled
+	Succeeded int64 // ... whose SYN data the server acknowledged
+	Fallbacks int64 // ... that completed a regular handshake (no cookie yet, or stripped)
+	Disabled  int   // destinations currently dialled without Fast Open
+}
+
+var (
+	tfoAttempts    atomic.Int64
+	tfoSucceeded   atomic.Int64
+	tfoFallbacks   atomic.Int64
+	tfoUnsupported atomic.Bool // kernel rejected the socket option; stop trying
+
+	tfoPathsMu sync.Mutex
+	tfoPaths   = make(map[string]*tfoPath)
+)
+
+type tfoPath struct {
+	misses        int
+	disabledUntil time.Time
+}
+
 // DialTFO establishes a TCP connection with TCP Fast Open enabled
 func DialTFO(network, address string, timeout time.Duration) (net.Conn, error) {
 	return DialTFOContext(context.Background(), network, address, timeout)
@@ -16,48 +53,147 @@ func DialTFO(network, address string, timeout time.Duration) (net.Conn, error) {
 
 // DialTFOContext establishes a TCP connection with TCP Fast Open enabled and context support
 func DialTFOContext(ctx context.Context, network, address string, timeout time.Duration) (net.Conn, error) {
-	// Parse address
-	tcpAddr, err := net.ResolveTCPAddr(network, address)
-	if err != nil {
-		return nil, err
+	return DialTCP(ctx, &net.Dialer{Timeout: timeout}, network, address, true)
+}
+
+// DialTCP dials address with d (nil = default dialer). With tfo set the socket
+// opts into client-side TCP Fast Open: once the kernel holds a cookie for the
+// server, connect returns immediately and the first Write (the TLS
+// ClientHello) is carried in the SYN. Destinations where Fast Open keeps
+// failing are dialled normally for a while.
+func DialTCP(ctx context.Context, d *net.Dialer, network, address string, tfo bool) (net.Conn, error) {
+	dialer := net.Dialer{}
+	if d != nil {
+		dialer = *d
+	}
+	if dialer.Timeout == 0 {
+		dialer.Timeout = defaultDialTimeout
+	}
+	if !tfo || tfoUnsupported.Load() || tfoDisabled(address) {
+		return dialer.DialContext(ctx, network, address)
+	}
+
+	// Control may run concurrently for dual-stack (Happy Eyeballs) dials.
+	var optErr atomic.Value
+	control := dialer.Control
+	dialer.Control = func(network, address string, c syscall.RawConn) error {
+		if control != nil {
+			if err := control(network, address, c); err != nil {
+				return err
+			}
+		}
+		var syscallErr error
+		if err := c.Control(func(fd uintptr) {
+			syscallErr = enableTFO(int(fd))
+		}); err != nil {
+			return err
+		}
+		if syscallErr != nil {
+			optErr.Store(syscallErr)
+		}
+		return syscallErr
 	}
 
-	// Create socket with TFO support
-	conn, err := dialTCPWithTFO(ctx, tcpAddr, timeout)
+	conn, err := dialer.DialContext(ctx, network, address)
 	if err != nil {
-		// Fallback to standard dial if TFO fails
-		log.V("[TFO] Failed to enable TCP Fast Open, falling back to standard dial: %v", err)
+		if optErr.Load() == nil {
+			return nil, err
+		}
+		// Fallback to standard dial if the kernel lacks client TFO support
+		log.V("[TFO] Failed to enable TCP Fast Open, falling back to standard dial: %v", optErr.Load())
+		tfoUnsupported.Store(true)
+		dialer.Control = control
+		return dialer.DialContext(ctx, network, address)
+	}
 
-		if timeout > 0 {
-			return net.DialTimeout(network, address, timeout)
+	tfoAttempts.Add(1)
+	return &tfoConn{Conn: conn, addr: address}, nil
+}
+
+// SmoothedRTT returns the kernel's smoothed round-trip time for an
+// established connection from DialTCP, or 0 where it is not observable.
+// Unlike timing DialTCP itself, it is a real RTT with Fast Open too, where
+// connect returns before the SYN is answered.
+func SmoothedRTT(conn net.Conn) time.Duration {
+	if tc, ok := conn.(*tfoConn); ok {
+		conn = tc.Conn
+	}
+	return tcpRTT(conn)
+}
+
+// tfoConn checks on the first Read whether the server acknowledged the SYN
+// data. Any reply implies the handshake is complete, so TCP_INFO is final.
+type tfoConn struct {
+	net.Conn
+	addr    string
+	checked sync.Once
+}
+
+func (c *tfoConn) Read(b []byte) (int, error) {
+	n, err := c.Conn.Read(b)
+	c.checked.Do(func() {
+		if acked, known := synDataAcked(c.Conn); known {
+			recordTFO(c.addr, acked)
+		} else if n == 0 && err != nil {
+			// No TCP_INFO on this platform: only a connection that dies
+			// before any reply hints at dropped SYN data.
+			recordTFO(c.addr, false)
 		}
+	})
+	return n, err
+}
+
+func recordTFO(address string, acked bool) {
+	tfoPathsMu.Lock()
+	defer tfoPathsMu.Unlock()
 
-		d := &net.Dialer{}
-		return d.DialContext(ctx, network, address)
+	p := tfoPaths[address]
+	if acked {
+		tfoSucceeded.Add(1)
+		if p != nil {
+			p.misses = 0
+		}
+		return
 	}
 
-	return conn, nil
+	tfoFallbacks.Add(1)
+	if p == nil {
+		p = &tfoPath{}
+		tfoPaths[address] = p
+	}
+	p.misses++
+	if p.misses >= tfoMaxMisses {
+		p.misses = 0
+		p.disabledUntil = time.Now().Add(tfoRetryAfter)
+		log.V("[TFO] %s: SYN data not acknowledged %d times, disabled for %v", address, tfoMaxMisses, tfoRetryAfter)
+	}
 }
 
-// dialTCPWithTFO creates a TCP connection with Fast Open enabled
-func dialTCPWithTFO(ctx context.Context, addr *net.TCPAddr, timeout time.Duration) (net.Conn, error) {
-	// Create dialer with TFO-specific configuration
-	d := &net.Dialer{
-		Timeout: timeout,
-		Control: func(network, address string, c syscall.RawConn) error {
-			var syscallErr error
-			err := c.Control(func(fd uintptr) {
-				// Enable TCP Fast Open on the socket
-				syscallErr = enableTFO(int(fd))
-			})
-			if err != nil {
-				return err
-			}
-			return syscallErr
-		},
+func tfoDisabled(address string) bool {
+	tfoPathsMu.Lock()
+	defer tfoPathsMu.Unlock()
+	p := tfoPaths[address]
+	return p != nil && time.Now().Before(p.disabledUntil)
+}
+
+// GetTFOStats returns a snapshot of the client Fast Open counters.
+func GetTFOStats() TFOStats {
+	tfoPathsMu.Lock()
+	disabled := 0
+	now := time.Now()
+	for _, p := range tfoPaths {
+		if now.Before(p.disabledUntil) {
+			disabled++
+		}
 	}
+	tfoPathsMu.Unlock()
 
-	return d.DialContext(ctx, "tcp", addr.String())
+	return TFOStats{
+		Attempts:  tfoAttempts.Load(),
+		Succeeded: tfoSucceeded.Load(),
+		Fallbacks: tfoFallbacks.Load(),
+		Disabled:  disabled,
+	}
 }
 
 // ListenTFO creates a TCP listener with TCP Fast Open enabled
@@ -3,7 +3,9 @@
 package net
 
 import (
+	"net"
 	"syscall"
+	"time"
 
 	"golang.org/x/sys/unix"
 )
@@ -19,3 +21,13 @@ func enableTFO(fd int) error {
 func enableTFOListener(fd int) error {
 	return unix.SetsockoptInt(fd, unix.IPPROTO_TCP, TCP_FASTOPEN, 1)
 }
+
+// synDataAcked is not observable on this platform.
+func synDataAcked(conn net.Conn) (acked, known bool) {
+	return false, false
+}
+
+// tcpRTT is not observable on this platform.
+func tcpRTT(conn net.Conn) time.Duration {
+	return 0
+}
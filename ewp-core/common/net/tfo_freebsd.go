@@ -3,7 +3,9 @@
 package net
 
 import (
+	"net"
 	"syscall"
+	"time"
 
 	"ewp-core/log"
 )
@@ -31,3 +33,13 @@ func enableTFOListener(fd int) error {
 	log.V("[TFO] TCP Fast Open enabled on listener socket %d (queue=128)", fd)
 	return nil
 }
+
+// synDataAcked is not observable on this platform.
+func synDataAcked(conn net.Conn) (acked, known bool) {
+	return false, false
+}
+
+// tcpRTT is not observable on this platform.
+func tcpRTT(conn net.Conn) time.Duration {
+	return 0
+}
@@ -4,20 +4,28 @@
 package net
 
 import (
+	"net"
 	"syscall"
+	"time"
 
 	"ewp-core/log"
+
+	"golang.org/x/sys/unix"
 )
 
 const (
-	TCP_FASTOPEN = 23 // TCP_FASTOPEN socket option for Linux
+	TCP_FASTOPEN         = 23 // TCP_FASTOPEN socket option for Linux
+	TCP_FASTOPEN_CONNECT = 30 // client-side Fast Open with implicit connect (Linux 4.11+)
+
+	tcpiOptSynData = 0x20 // TCPI_OPT_SYN_DATA: SYN-ACK acknowledged data in SYN
 )
 
-// enableTFO enables TCP Fast Open on a socket (Linux implementation)
+// enableTFO enables client-side TCP Fast Open on a socket (Linux implementation)
 func enableTFO(fd int) error {
-	// Linux kernel 3.7+ supports TCP Fast Open
-	// Set TCP_FASTOPEN socket option with queue length
-	err := syscall.SetsockoptInt(fd, syscall.IPPROTO_TCP, TCP_FASTOPEN, 5)
+	// With TCP_FASTOPEN_CONNECT connect() returns immediately when a cookie is
+	// cached and the first write goes out in the SYN; without a cookie the
+	// kernel does a normal handshake and requests one.
+	err := syscall.SetsockoptInt(fd, syscall.IPPROTO_TCP, TCP_FASTOPEN_CONNECT, 1)
 	if err != nil {
 		log.V("[TFO] Failed to enable TCP Fast Open on Linux: %v", err)
 		return err
@@ -27,6 +35,42 @@ func enableTFO(fd int) error {
 	return nil
 }
 
+// synDataAcked reports whether the server acknowledged the data sent in the SYN.
+func synDataAcked(conn net.Conn) (acked, known bool) {
+	info := tcpInfo(conn)
+	if info == nil {
+		return false, false
+	}
+	return info.Options&tcpiOptSynData != 0, true
+}
+
+// tcpRTT returns the connection's smoothed RTT from TCP_INFO.
+func tcpRTT(conn net.Conn) time.Duration {
+	if info := tcpInfo(conn); info != nil {
+		return time.Duration(info.Rtt) * time.Microsecond
+	}
+	return 0
+}
+
+func tcpInfo(conn net.Conn) *unix.TCPInfo {
+	sc, ok := conn.(syscall.Conn)
+	if !ok {
+		return nil
+	}
+	raw, err := sc.SyscallConn()
+	if err != nil {
+		return nil
+	}
+	var info *unix.TCPInfo
+	raw.Control(func(fd uintptr) {
+		info, err = unix.GetsockoptTCPInfo(int(fd), unix.IPPROTO_TCP, unix.TCP_INFO)
+	})
+	if err != nil {
+		return nil
+	}
+	return info
+}
+
 // enableTFOListener enables TCP Fast Open on a listener socket (Linux implementation)
 func enableTFOListener(fd int) error {
 	// Linux kernel 3.7+ supports TCP Fast Open for server sockets
@@ -0,0 +1,79 @@
+package net
+
+import (
+	"context"
+	"io"
+	"net"
+	"testing"
+)
+
+func TestDialTCPFastOpenRoundTrip(t *testing.T) {
+	ln, err := ListenTFO("tcp", "127.0.0.1:0")
+	if err != nil {
+		t.Fatalf("listen: %v", err)
+	}
+	defer ln.Close()
+	go func() {
+		for {
+			c, err := ln.Accept()
+			if err != nil {
+				return
+			}
+			go func() {
+				io.Copy(c, c)
+				c.Close()
+			}()
+		}
+	}()
+
+	// The first dial only fetches the cookie; later ones may carry SYN data.
+	for i := 0; i < 3; i++ {
+		conn, err := DialTCP(context.Background(), nil, "tcp", ln.Addr().String(), true)
+		if err != nil {
+			t.Fatalf("dial %d: %v", i, err)
+		}
+		if _, err := conn.Write([]byte("hello")); err != nil {
+			t.Fatalf("write %d: %v", i, err)
+		}
+		buf := make([]byte, 5)
+		if _, err := io.ReadFull(conn, buf); err != nil || string(buf) != "hello" {
+			t.Fatalf("echo %d: %q %v", i, buf, err)
+		}
+		conn.Close()
+	}
+}
+
+func TestTFOFallbackAfterRepeatedMisses(t *testing.T) {
+	const addr = "192.0.2.1:443"
+	defer func() {
+		tfoPathsMu.Lock()
+		delete(tfoPaths, addr)
+		tfoPathsMu.Unlock()
+	}()
+
+	for i := 0; i < tfoMaxMisses-1; i++ {
+		recordTFO(addr, false)
+	}
+	if tfoDisabled(addr) {
+		t.Fatalf("disabled after %d misses, want %d", tfoMaxMisses-1, tfoMaxMisses)
+	}
+
+	// A success resets the streak.
+	recordTFO(addr, true)
+	for i := 0; i < tfoMaxMisses-1; i++ {
+		recordTFO(addr, false)
+	}
+	if tfoDisabled(addr) {
+		t.Fatal("success must reset the miss streak")
+	}
+
+	recordTFO(addr, false)
+	if !tfoDisabled(addr) {
+		t.Fatalf("not disabled after %d consecutive misses", tfoMaxMisses)
+	}
+	if GetTFOStats().Disabled < 1 {
+		t.Fatal("stats must report the disabled destination")
+	}
+}
+
+var _ net.Conn = (*tfoConn)(nil)
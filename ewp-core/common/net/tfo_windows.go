@@ -4,7 +4,9 @@
 package net
 
 import (
+	"net"
 	"syscall"
+	"time"
 
 	"ewp-core/log"
 )
@@ -40,3 +42,13 @@ func enableTFOListener(fd int) error {
 	log.V("[TFO] TCP Fast Open enabled on listener socket %d", fd)
 	return nil
 }
+
+// synDataAcked is not observable on this platform.
+func synDataAcked(conn net.Conn) (acked, known bool) {
+	return false, false
+}
+
+// tcpRTT is not observable on this platform.
+func tcpRTT(conn net.Conn) time.Duration {
+	return 0
+}
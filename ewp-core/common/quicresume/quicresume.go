@@ -0,0 +1,99 @@
+// Package quicresume holds the client-side QUIC state shared by the H3gRPC and
+// MASQUE transports so reconnects can skip round trips:
+//
+//   - TLS session tickets come from commontls.DefaultSessionCache (persisted to
+//     disk when cache.tls_session_file is set) under its QUIC namespace (see
+//     commontls.QUICSessionCache); quic-go stores its transport parameters in
+//     the ticket, which is what makes 0-RTT possible.
+//   - Address-validation tokens (NEW_TOKEN) are kept in one process-wide
+//     TokenStore so a reconnect after idle timeout avoids a Retry round trip.
+//   - Track records whether each connection resumed and whether the server
+//     accepted 0-RTT.
+//
+// Replay safety is the caller's job: only send data that is safe to replay
+// before HandshakeComplete() (see the MASQUE Connect gate).
+package quicresume
+
+import (
+	"sync/atomic"
+
+	"github.com/quic-go/quic-go"
+)
+
+// Token store sizing: one entry per server, a few tokens each (tokens are
+// single-use; quic-go pops one per dial).
+const (
+	tokenStoreServers   = 64
+	tokenStorePerServer = 4
+)
+
+var tokenStore = quic.NewLRUTokenStore(tokenStoreServers, tokenStorePerServer)
+
+// TokenStore returns the process-wide address-token store. quic.ClientToken is
+// opaque, so tokens live for the process lifetime (they survive transport
+// re-initialisation and idle reconnects, not core restarts).
+func TokenStore() quic.TokenStore {
+	return tokenStore
+}
+
+// Stats reports QUIC resumption effectiveness since process start.
+type Stats struct {
+	Dials         int64 // client connections that completed the handshake
+	Resumed       int64 // handshakes that resumed a TLS session
+	Attempted0RTT int64 // connections usable before the handshake completed
+	Accepted0RTT  int64 // ... where the server accepted the 0-RTT data
+	Rejected0RTT  int64 // ... where the server rejected it (data was retransmitted in 1-RTT)
+}
+
+var (
+	statDials     atomic.Int64
+	statResumed   atomic.Int64
+	statAttempted atomic.Int64
+	statAccepted  atomic.Int64
+	statRejected  atomic.Int64
+)
+
+// Track records resumption and 0-RTT outcome for conn once its handshake
+// completes. Call it right after Dial/DialEarly returns; it does not block.
+func Track(conn *quic.Conn) {
+	early := false
+	select {
+	case <-conn.HandshakeComplete():
+	default:
+		// DialEarly only returns before the handshake completes when
+		// 0-RTT keys are available, i.e. a 0-RTT attempt.
+		early = true
+	}
+
+	go func() {
+		select {
+		case <-conn.HandshakeComplete():
+		case <-conn.Context().Done():
+			return
+		}
+		cs := conn.ConnectionState()
+		statDials.Add(1)
+		if cs.TLS.DidResume {
+			statResumed.Add(1)
+		}
+		if early {
+			statAttempted.Add(1)
+			if cs.Used0RTT {
+				statAccepted.Add(1)
+			} else {
+				statRejected.Add(1)
+			}
+		}
+	}()
+}
+
+// GetStats returns a snapshot of the counters.
+func GetStats() Stats {
+	return Stats{
+		Dials:         statDials.Load(),
+		Resumed:       statResumed.Load(),
+		Attempted0RTT: statAttempted.Load(),
+		Accepted0RTT:  statAccepted.Load(),
+		Rejected0RTT:  statRejected.Load(),
+	}
+}
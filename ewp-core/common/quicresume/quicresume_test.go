@@ -0,0 +1,178 @@
+package quicresume
+
+// End-to-end 0-RTT test against a local quic-go listener: the first
+// connection stores a ticket in a persisted commontls.SessionCache, a fresh
+// cache loaded from the same file (a simulated core restart) then dials with
+// DialAddrEarly and must get 0-RTT accepted.
+//
+// Run:
+//   go test -count=1 ./common/quicresume/...
+
+import (
+	"context"
+	"crypto/ecdsa"
+	"crypto/elliptic"
+	"crypto/rand"
+	"crypto/tls"
+	"crypto/x509"
+	"crypto/x509/pkix"
+	"io"
+	"math/big"
+	"path/filepath"
+	"testing"
+	"time"
+
+	commontls "ewp-core/common/tls"
+
+	"github.com/quic-go/quic-go"
+)
+
+const testALPN = "quicresume-test"
+
+func TestZeroRTTAfterRestart(t *testing.T) {
+	ln := listenEcho(t)
+	defer ln.Close()
+	addr := ln.Addr().String()
+	cachePath := filepath.Join(t.TempDir(), "tls-sessions.bin")
+	key := make([]byte, commontls.SessionKeySize)
+	rand.Read(key)
+
+	// First run: full handshake, ticket persisted.
+	cache := commontls.NewSessionCache(0)
+	if err := cache.EnablePersistence(cachePath, key); err != nil {
+		t.Fatalf("enable persistence: %v", err)
+	}
+	conn := dial(t, addr, commontls.QUICSessionCache(cache))
+	roundTrip(t, conn, "hello")
+	waitFor(t, "session ticket", func() bool { return cache.Len() > 0 })
+	if conn.ConnectionState().TLS.DidResume {
+		t.Fatal("first connection must not resume")
+	}
+	conn.CloseWithError(0, "")
+	cache.Flush()
+
+	// Second run: new cache restored from disk.
+	before := GetStats()
+	restored := commontls.NewSessionCache(0)
+	if err := restored.EnablePersistence(cachePath, key); err != nil {
+		t.Fatalf("reload persistence: %v", err)
+	}
+	conn = dial(t, addr, commontls.QUICSessionCache(restored))
+	defer conn.CloseWithError(0, "")
+
+	select {
+	case <-conn.HandshakeComplete():
+		t.Fatal("DialAddrEarly returned after the handshake: no 0-RTT attempted")
+	default:
+	}
+	roundTrip(t, conn, "early")
+
+	<-conn.HandshakeComplete()
+	cs := conn.ConnectionState()
+	if !cs.TLS.DidResume || !cs.Used0RTT {
+		t.Fatalf("resumed=%v used0RTT=%v, want both", cs.TLS.DidResume, cs.Used0RTT)
+	}
+	waitFor(t, "0-RTT stats", func() bool {
+		return GetStats().Accepted0RTT > before.Accepted0RTT
+	})
+}
+
+func dial(t *testing.T, addr string, cache tls.ClientSessionCache) *quic.Conn {
+	t.Helper()
+	ctx, cancel := context.WithTimeout(context.Background(), 5*time.Second)
+	defer cancel()
+	conn, err := quic.DialAddrEarly(ctx, addr, &tls.Config{
+		ServerName:         "localhost",
+		InsecureSkipVerify: true,
+		NextProtos:         []string{testALPN},
+		ClientSessionCache: cache,
+	}, &quic.Config{TokenStore: TokenStore()})
+	if err != nil {
+		t.Fatalf("dial: %v", err)
+	}
+	Track(conn)
+	return conn
+}
+
+func roundTrip(t *testing.T, conn *quic.Conn, msg string) {
+	t.Helper()
+	str, err := conn.OpenStream()
+	if err != nil {
+		t.Fatalf("open stream: %v", err)
+	}
+	if _, err := str.Write([]byte(msg)); err != nil {
+		t.Fatalf("write: %v", err)
+	}
+	str.Close()
+	got, err := io.ReadAll(str)
+	if err != nil {
+		t.Fatalf("read: %v", err)
+	}
+	if string(got) != msg {
+		t.Fatalf("echo: got %q want %q", got, msg)
+	}
+}
+
+func waitFor(t *testing.T, what string, cond func() bool) {
+	t.Helper()
+	deadline := time.Now().Add(5 * time.Second)
+	for !cond() {
+		if time.Now().After(deadline) {
+			t.Fatalf("timed out waiting for %s", what)
+		}
+		time.Sleep(10 * time.Millisecond)
+	}
+}
+
+// listenEcho starts a 0-RTT enabled listener that echoes every stream.
+func listenEcho(t *testing.T) *quic.EarlyListener {
+	t.Helper()
+	ln, err := quic.ListenAddrEarly("127.0.0.1:0", &tls.Config{
+		Certificates: []tls.Certificate{selfSignedCert(t)},
+		NextProtos:   []string{testALPN},
+	}, &quic.Config{Allow0RTT: true})
+	if err != nil {
+		t.Fatalf("listen: %v", err)
+	}
+	go func() {
+		for {
+			conn, err := ln.Accept(context.Background())
+			if err != nil {
+				return
+			}
+			go func() {
+				for {
+					str, err := conn.AcceptStream(context.Background())
+					if err != nil {
+						return
+					}
+					go func() {
+						io.Copy(str, str)
+						str.Close()
+					}()
+				}
+			}()
+		}
+	}()
+	return ln
+}
+
+func selfSignedCert(t *testing.T) tls.Certificate {
+	t.Helper()
+	key, err := ecdsa.GenerateKey(elliptic.P256(), rand.Reader)
+	if err != nil {
+		t.Fatal(err)
+	}
+	tmpl := &x509.Certificate{
+		SerialNumber: big.NewInt(1),
+		Subject:      pkix.Name{CommonName: "localhost"},
+		DNSNames:     []string{"localhost"},
+		NotBefore:    time.Now().Add(-time.Hour),
+		NotAfter:     time.Now().Add(time.Hour),
+	}
+	der, err := x509.CreateCertificate(rand.Reader, tmpl, tmpl, &key.PublicKey, key)
+	if err != nil {
+		t.Fatal(err)
+	}
+	return tls.Certificate{Certificate: [][]byte{der}, PrivateKey: key}
+}
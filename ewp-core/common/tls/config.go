@@ -46,6 +46,10 @@ func NewSTDConfig(serverName string, useMozillaCA bool, enablePQC bool) *STDConf
 		MinVersion: tls.VersionTLS13,
 		ServerName: serverName,
 		RootCAs:    roots,
+		// Shared (optionally persistent) ticket cache: reconnects and core
+		// restarts resume instead of paying a full handshake.
+		ClientSessionCache: defaultSessionCache,
+		VerifyConnection:   recordHandshake,
 	}
 
 	if enablePQC {
@@ -101,6 +105,7 @@ type STDECHConfig struct {
 func NewSTDECHConfig(serverName string, useMozillaCA bool, echList []byte, enablePQC bool) *STDECHConfig {
 	cfg := NewSTDConfig(serverName, useMozillaCA, enablePQC)
 	cfg.config.EncryptedClientHelloConfigList = echList
+	cfg.config.ClientSessionCache = defaultSessionCache.Namespace(echSessionNamespace(echList))
 	cfg.config.EncryptedClientHelloRejectionVerify = func(cs tls.ConnectionState) error {
 		return errors.New("server rejected ECH")
 	}
@@ -113,6 +118,7 @@ func (c *STDECHConfig) ECHConfigList() []byte {
 
 func (c *STDECHConfig) SetECHConfigList(echList []byte) {
 	c.config.EncryptedClientHelloConfigList = echList
+	c.config.ClientSessionCache = defaultSessionCache.Namespace(echSessionNamespace(echList))
 }
 
 func (c *STDECHConfig) Clone() Config {
@@ -0,0 +1,414 @@
+package tls
+
+import (
+	"container/list"
+	"crypto/aes"
+	"crypto/cipher"
+	"crypto/rand"
+	"crypto/sha256"
+	"crypto/tls"
+	"encoding/hex"
+	"encoding/json"
+	"errors"
+	"fmt"
+	"os"
+	"path/filepath"
+	"sync"
+	"sync/atomic"
+	"time"
+
+	"ewp-core/log"
+)
+
+const (
+	// defaultSessionCacheSize bounds the number of cached tickets (one per
+	// SNI / ECH config / QUIC server, so a few hundred is plenty).
+	defaultSessionCacheSize = 256
+
+	// sessionMaxAge drops persisted tickets older than the TLS 1.3 maximum
+	// ticket lifetime (RFC 8446 §4.6.1); the server would reject them anyway.
+	sessionMaxAge = 7 * 24 * time.Hour
+
+	// sessionSaveDelay coalesces bursts of new tickets into one disk write.
+	sessionSaveDelay = 2 * time.Second
+)
+
+// SessionKeySize is the length of the session cache file key.
+const SessionKeySize = 32
+
+// SessionCache is the tls.ClientSessionCache shared by every client TLS
+// config built in this package. Tickets live in an in-memory LRU; after
+// EnableSessionPersistence they are also mirrored to an AES-GCM encrypted
+// file, so a restarted core resumes instead of doing a full handshake.
+type SessionCache struct {
+	mu       sync.Mutex
+	capacity int
+	entries  map[string]*list.Element
+	order    *list.List // front = most recently used
+
+	path      string
+	aead      cipher.AEAD
+	saveTimer *time.Timer
+}
+
+type sessionEntry struct {
+	key     string
+	ticket  []byte
+	state   []byte // tls.SessionState.Bytes(), for persistence
+	created time.Time
+	session *tls.ClientSessionState
+}
+
+// persistedSession is the on-disk form of one entry.
+type persistedSession struct {
+	Key     string `json:"k"`
+	Ticket  []byte `json:"t"`
+	State   []byte `json:"s"`
+	Created int64  `json:"c"`
+}
+
+// SessionStats reports TLS resumption effectiveness since process start.
+type SessionStats struct {
+	Handshakes  int64 // completed client handshakes (full + resumed)
+	Resumed     int64 // handshakes that resumed a cached session
+	CacheHits   int64 // Get() found a ticket
+	CacheMisses int64 // Get() found nothing
+	Entries     int   // tickets currently cached
+	Loaded      int   // tickets restored from disk at startup
+}
+
+var (
+	statHandshakes  atomic.Int64
+	statResumed     atomic.Int64
+	statCacheHits   atomic.Int64
+	statCacheMisses atomic.Int64
+	statLoaded      atomic.Int64
+
+	defaultSessionCache = NewSessionCache(defaultSessionCacheSize)
+)
+
+// NewSessionCache returns an in-memory LRU session cache.
+func NewSessionCache(capacity int) *SessionCache {
+	if capacity <= 0 {
+		capacity = defaultSessionCacheSize
+	}
+	return &SessionCache{
+		capacity: capacity,
+		entries:  make(map[string]*list.Element),
+		order:    list.New(),
+	}
+}
+
+// DefaultSessionCache returns the process-wide cache installed on every
+// client TLS config built by NewClient / NewSTDConfig.
+func DefaultSessionCache() *SessionCache {
+	return defaultSessionCache
+}
+
+// Get implements tls.ClientSessionCache.
+func (c *SessionCache) Get(key string) (*tls.ClientSessionState, bool) {
+	c.mu.Lock()
+	defer c.mu.Unlock()
+
+	elem, ok := c.entries[key]
+	if !ok {
+		statCacheMisses.Add(1)
+		return nil, false
+	}
+	e := elem.Value.(*sessionEntry)
+	if e.session == nil {
+		// Restored from disk: rebuild the session lazily on first use.
+		ss, err := tls.ParseSessionState(e.state)
+		if err == nil {
+			e.session, err = tls.NewResumptionState(e.ticket, ss)
+		}
+		if err != nil {
+			c.removeLocked(elem)
+			statCacheMisses.Add(1)
+			return nil, false
+		}
+	}
+	c.order.MoveToFront(elem)
+	statCacheHits.Add(1)
+	return e.session, true
+}
+
+// Put implements tls.ClientSessionCache. A nil cs evicts key.
+func (c *SessionCache) Put(key string, cs *tls.ClientSessionState) {
+	c.mu.Lock()
+	defer c.mu.Unlock()
+
+	if cs == nil {
+		if elem, ok := c.entries[key]; ok {
+			c.removeLocked(elem)
+			c.scheduleSaveLocked()
+		}
+		return
+	}
+
+	e := &sessionEntry{key: key, created: time.Now(), session: cs}
+	if c.path != "" {
+		ticket, ss, err := cs.ResumptionState()
+		if err == nil && ss != nil {
+			if state, err := ss.Bytes(); err == nil {
+				e.ticket = ticket
+				e.state = state
+			}
+		}
+	}
+
+	if elem, ok := c.entries[key]; ok {
+		elem.Value = e
+		c.order.MoveToFront(elem)
+	} else {
+		c.entries[key] = c.order.PushFront(e)
+		for c.order.Len() > c.capacity {
+			c.removeLocked(c.order.Back())
+		}
+	}
+	c.scheduleSaveLocked()
+}
+
+func (c *SessionCache) removeLocked(elem *list.Element) {
+	delete(c.entries, elem.Value.(*sessionEntry).key)
+	c.order.Remove(elem)
+}
+
+// Namespace returns a view of c whose keys are prefixed with ns, so tickets
+// issued under different ECH configs never collide.
+func (c *SessionCache) Namespace(ns string) tls.ClientSessionCache {
+	if ns == "" {
+		return c
+	}
+	return &namespacedSessionCache{cache: c, prefix: ns + "|"}
+}
+
+type namespacedSessionCache struct {
+	cache  *SessionCache
+	prefix string
+}
+
+func (n *namespacedSessionCache) Get(key string) (*tls.ClientSessionState, bool) {
+	return n.cache.Get(n.prefix + key)
+}
+
+func (n *namespacedSessionCache) Put(key string, cs *tls.ClientSessionState) {
+	n.cache.Put(n.prefix+key, cs)
+}
+
+// quicSessionNamespace keeps tickets issued over QUIC apart from TLS-over-TCP
+// tickets for the same server name: quic-go stores its transport parameters
+// in the ticket, and crypto/tls keys both kinds by SNI alone.
+const quicSessionNamespace = "quic"
+
+// QUICSessionCache returns the QUIC view of a session cache installed by
+// this package (possibly already namespaced by ECH config). Set it as
+// ClientSessionCache on every tls.Config handed to quic-go.
+func QUICSessionCache(cache tls.ClientSessionCache) tls.ClientSessionCache {
+	switch c := cache.(type) {
+	case *SessionCache:
+		return c.Namespace(quicSessionNamespace)
+	case *namespacedSessionCache:
+		return &namespacedSessionCache{cache: c.cache, prefix: quicSessionNamespace + "|" + c.prefix}
+	}
+	return cache
+}
+
+// echSessionNamespace keys tickets by the ECH config they were issued under.
+func echSessionNamespace(echList []byte) string {
+	if len(echList) == 0 {
+		return ""
+	}
+	sum := sha256.Sum256(echList)
+	return "ech:" + hex.EncodeToString(sum[:8])
+}
+
+// --- persistence ---
+
+// EnableSessionPersistence loads tickets from path into the default cache
+// and keeps the file updated as new tickets arrive. The tickets carry
+// resumption secrets, so the file is encrypted with key (SessionKeySize
+// bytes), which the caller obtains out of band, never from a file beside
+// the cache; it is also written 0600 in a 0700 directory.
+func EnableSessionPersistence(path string, key []byte) error {
+	return defaultSessionCache.EnablePersistence(path, key)
+}
+
+// FlushSessionCache writes pending tickets to disk immediately (call on exit).
+func FlushSessionCache() {
+	defaultSessionCache.Flush()
+}
+
+func (c *SessionCache) EnablePersistence(path string, key []byte) error {
+	if len(key) != SessionKeySize {
+		return fmt.Errorf("session cache key must be %d bytes, got %d", SessionKeySize, len(key))
+	}
+	block, err := aes.NewCipher(key)
+	if err != nil {
+		return fmt.Errorf("session cache key: %w", err)
+	}
+	aead, err := cipher.NewGCM(block)
+	if err != nil {
+		return fmt.Errorf("session cache key: %w", err)
+	}
+	if err := os.MkdirAll(filepath.Dir(path), 0700); err != nil {
+		return fmt.Errorf("session cache dir: %w", err)
+	}
+
+	c.mu.Lock()
+	defer c.mu.Unlock()
+	c.path = path
+	c.aead = aead
+
+	n, err := c.loadLocked()
+	if err != nil {
+		// A corrupt file, or one written under another key, only costs one
+		// full handshake per server.
+		log.Warn("[TLS] Session cache %s unreadable, starting empty: %v", path, err)
+		return nil
+	}
+	statLoaded.Store(int64(n))
+	log.Info("[TLS] Session cache: %d ticket(s) restored from %s", n, path)
+	return nil
+}
+
+func (c *SessionCache) loadLocked() (int, error) {
+	blob, err := os.ReadFile(c.path)
+	if errors.Is(err, os.ErrNotExist) {
+		return 0, nil
+	}
+	if err != nil {
+		return 0, err
+	}
+	ns := c.aead.NonceSize()
+	if len(blob) < ns {
+		return 0, errors.New("truncated")
+	}
+	plain, err := c.aead.Open(nil, blob[:ns], blob[ns:], nil)
+	if err != nil {
+		return 0, err
+	}
+	var saved []persistedSession
+	if err := json.Unmarshal(plain, &saved); err != nil {
+		return 0, err
+	}
+
+	// Saved most-recent first; push to back to keep that order.
+	n := 0
+	cutoff := time.Now().Add(-sessionMaxAge)
+	for _, s := range saved {
+		created := time.Unix(s.Created, 0)
+		if created.Before(cutoff) || len(s.State) == 0 || c.entries[s.Key] != nil {
+			continue
+		}
+		if c.order.Len() >= c.capacity {
+			break
+		}
+		c.entries[s.Key] = c.order.PushBack(&sessionEntry{
+			key:     s.Key,
+			ticket:  s.Ticket,
+			state:   s.State,
+			created: created,
+		})
+		n++
+	}
+	return n, nil
+}
+
+func (c *SessionCache) scheduleSaveLocked() {
+	if c.path == "" {
+		return
+	}
+	if c.saveTimer != nil {
+		c.saveTimer.Reset(sessionSaveDelay)
+		return
+	}
+	c.saveTimer = time.AfterFunc(sessionSaveDelay, c.Flush)
+}
+
+// Flush writes the cache to disk if persistence is enabled.
+func (c *SessionCache) Flush() {
+	c.mu.Lock()
+	if c.path == "" {
+		c.mu.Unlock()
+		return
+	}
+	saved := make([]persistedSession, 0, c.order.Len())
+	for elem := c.order.Front(); elem != nil; elem = elem.Next() {
+		e := elem.Value.(*sessionEntry)
+		if len(e.state) == 0 {
+			continue
+		}
+		saved = append(saved, persistedSession{
+			Key:     e.key,
+			Ticket:  e.ticket,
+			State:   e.state,
+			Created: e.created.Unix(),
+		})
+	}
+	path, aead := c.path, c.aead
+	c.mu.Unlock()
+
+	plain, err := json.Marshal(saved)
+	if err != nil {
+		log.Warn("[TLS] Session cache encode failed: %v", err)
+		return
+	}
+	nonce := make([]byte, aead.NonceSize(), aead.NonceSize()+len(plain)+aead.Overhead())
+	if _, err := rand.Read(nonce); err != nil {
+		log.Warn("[TLS] Session cache nonce failed: %v", err)
+		return
+	}
+	blob := aead.Seal(nonce, nonce, plain, nil)
+
+	tmp := path + ".tmp"
+	if err := os.WriteFile(tmp, blob, 0600); err != nil {
+		log.Warn("[TLS] Session cache write failed: %v", err)
+		return
+	}
+	if err := os.Rename(tmp, path); err != nil {
+		log.Warn("[TLS] Session cache write failed: %v", err)
+		os.Remove(tmp)
+		return
+	}
+	log.V("[TLS] Session cache saved: %d ticket(s)", len(saved))
+}
+
+// --- stats ---
+
+// recordHandshake is installed as tls.Config.VerifyConnection, which runs
+// for both full and resumed client handshakes.
+func recordHandshake(cs tls.ConnectionState) error {
+	statHandshakes.Add(1)
+	if cs.DidResume {
+		statResumed.Add(1)
+	}
+	return nil
+}
+
+// Len returns the number of cached tickets.
+func (c *SessionCache) Len() int {
+	c.mu.Lock()
+	defer c.mu.Unlock()
+	return c.order.Len()
+}
+
+// GetSessionStats returns resumption counters for the default cache.
+func GetSessionStats() SessionStats {
+	return SessionStats{
+		Handshakes:  statHandshakes.Load(),
+		Resumed:     statResumed.Load(),
+		CacheHits:   statCacheHits.Load(),
+		CacheMisses: statCacheMisses.Load(),
+		Entries:     defaultSessionCache.Len(),
+		Loaded:      int(statLoaded.Load()),
+	}
+}
+
+// ResumptionRate returns Resumed/Handshakes in [0,1] (0 when no handshakes).
+func (s SessionStats) ResumptionRate() float64 {
+	if s.Handshakes == 0 {
+		return 0
+	}
+	return float64(s.Resumed) / float64(s.Handshakes)
+}
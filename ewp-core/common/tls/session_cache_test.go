@@ -0,0 +1,244 @@
+package tls
+
+import (
+	"bytes"
+	"crypto/aes"
+	"crypto/cipher"
+	"crypto/ecdsa"
+	"crypto/elliptic"
+	"crypto/rand"
+	"crypto/tls"
+	"crypto/x509"
+	"crypto/x509/pkix"
+	"encoding/json"
+	"math/big"
+	"net"
+	"os"
+	"path/filepath"
+	"testing"
+	"time"
+)
+
+func TestSessionCacheLRU(t *testing.T) {
+	tests := []struct {
+		name string
+		ops  []string // "put:k" or "get:k"
+		want []string // keys still cached, capacity 3
+	}{
+		{"under capacity", []string{"put:a", "put:b"}, []string{"a", "b"}},
+		{"evicts oldest put", []string{"put:a", "put:b", "put:c", "put:d"}, []string{"b", "c", "d"}},
+		{"get refreshes", []string{"put:a", "put:b", "put:c", "get:a", "put:d"}, []string{"a", "c", "d"}},
+		{"re-put refreshes", []string{"put:a", "put:b", "put:c", "put:a", "put:d"}, []string{"a", "c", "d"}},
+		{"miss does not refresh", []string{"put:a", "put:b", "put:c", "get:x", "put:d"}, []string{"b", "c", "d"}},
+	}
+	for _, tt := range tests {
+		t.Run(tt.name, func(t *testing.T) {
+			c := NewSessionCache(3)
+			for _, op := range tt.ops {
+				key := op[4:]
+				if op[:4] == "put:" {
+					c.Put(key, &tls.ClientSessionState{})
+				} else {
+					c.Get(key)
+				}
+			}
+			if c.Len() != len(tt.want) {
+				t.Fatalf("Len = %d, want %d", c.Len(), len(tt.want))
+			}
+			for _, key := range tt.want {
+				if _, ok := c.Get(key); !ok {
+					t.Errorf("%q evicted", key)
+				}
+			}
+		})
+	}
+}
+
+func TestSessionCacheQUICNamespace(t *testing.T) {
+	c := NewSessionCache(0)
+	ech := c.Namespace(echSessionNamespace([]byte{1, 2, 3}))
+	tcpTicket, quicTicket := &tls.ClientSessionState{}, &tls.ClientSessionState{}
+
+	c.Put("example.com", tcpTicket)
+	QUICSessionCache(c).Put("example.com", quicTicket)
+	QUICSessionCache(ech).Put("example.com", quicTicket)
+
+	if got, _ := c.Get("example.com"); got != tcpTicket {
+		t.Error("QUIC ticket replaced the TCP ticket")
+	}
+	if got, _ := QUICSessionCache(c).Get("example.com"); got != quicTicket {
+		t.Error("QUIC ticket not found in the QUIC namespace")
+	}
+	if _, ok := ech.Get("example.com"); ok {
+		t.Error("QUIC ticket under ECH leaked into the ECH TCP namespace")
+	}
+	if got, _ := QUICSessionCache(ech).Get("example.com"); got != quicTicket {
+		t.Error("QUIC ticket under ECH not found")
+	}
+	if c.Len() != 3 {
+		t.Errorf("Len = %d, want 3 distinct keys", c.Len())
+	}
+}
+
+var testKey = bytes.Repeat([]byte{0x5a}, SessionKeySize)
+
+func TestSessionCachePersistRoundTrip(t *testing.T) {
+	path := filepath.Join(t.TempDir(), "sessions", "tls-sessions.bin")
+	ticket := newSessionState(t)
+
+	c := NewSessionCache(0)
+	if err := c.EnablePersistence(path, testKey); err != nil {
+		t.Fatalf("enable persistence: %v", err)
+	}
+	c.Put("example.com", ticket)
+	c.Flush()
+
+	info, err := os.Stat(path)
+	if err != nil {
+		t.Fatalf("stat: %v", err)
+	}
+	if perm := info.Mode().Perm(); perm != 0600 {
+		t.Errorf("file mode %o, want 600", perm)
+	}
+	wantTicket, _, _ := ticket.ResumptionState()
+	if blob, _ := os.ReadFile(path); bytes.Contains(blob, wantTicket) || bytes.Contains(blob, []byte("example.com")) {
+		t.Error("session cache written in the clear")
+	}
+
+	other := NewSessionCache(0)
+	if err := other.EnablePersistence(path, bytes.Repeat([]byte{0xa5}, SessionKeySize)); err != nil {
+		t.Fatalf("enable persistence with another key: %v", err)
+	}
+	if other.Len() != 0 {
+		t.Errorf("%d ticket(s) restored under the wrong key", other.Len())
+	}
+
+	restored := NewSessionCache(0)
+	if err := restored.EnablePersistence(path, testKey); err != nil {
+		t.Fatalf("reload persistence: %v", err)
+	}
+	got, ok := restored.Get("example.com")
+	if !ok {
+		t.Fatal("ticket not restored")
+	}
+	gotTicket, _, err := got.ResumptionState()
+	if err != nil || string(gotTicket) != string(wantTicket) {
+		t.Fatalf("restored ticket %x (%v), want %x", gotTicket, err, wantTicket)
+	}
+}
+
+func TestSessionCacheLoad(t *testing.T) {
+	fresh := time.Now().Unix()
+	expired := time.Now().Add(-sessionMaxAge - time.Hour).Unix()
+	saved := func(created ...int64) []byte {
+		var s []persistedSession
+		for i, c := range created {
+			s = append(s, persistedSession{Key: string(rune('a' + i)), Ticket: []byte{1}, State: []byte{1}, Created: c})
+		}
+		blob, _ := json.Marshal(s)
+		return seal(blob)
+	}
+	valid := saved(fresh, fresh)
+
+	tests := []struct {
+		name string
+		data []byte // nil: no file
+		want int
+	}{
+		{"missing file", nil, 0},
+		{"valid", valid, 2},
+		{"expired entries dropped", saved(fresh, expired, fresh), 2},
+		{"all expired", saved(expired), 0},
+		{"empty file", []byte{}, 0},
+		{"truncated", valid[:len(valid)/2], 0},
+		{"corrupt", []byte("\x00\x17not json"), 0},
+		{"sealed garbage", seal([]byte("\x00\x17not json")), 0},
+		{"plaintext from an older version", []byte(`[{"k":"a","t":"AQ==","s":"AQ==","c":1}]`), 0},
+	}
+	for _, tt := range tests {
+		t.Run(tt.name, func(t *testing.T) {
+			path := filepath.Join(t.TempDir(), "tls-sessions.bin")
+			if tt.data != nil {
+				if err := os.WriteFile(path, tt.data, 0600); err != nil {
+					t.Fatal(err)
+				}
+			}
+			c := NewSessionCache(0)
+			if err := c.EnablePersistence(path, testKey); err != nil {
+				t.Fatalf("EnablePersistence: %v", err)
+			}
+			if c.Len() != tt.want {
+				t.Fatalf("Len = %d, want %d", c.Len(), tt.want)
+			}
+		})
+	}
+}
+
+func TestSessionCacheKeySize(t *testing.T) {
+	path := filepath.Join(t.TempDir(), "tls-sessions.bin")
+	for _, key := range [][]byte{nil, make([]byte, 16), make([]byte, SessionKeySize+1)} {
+		if err := NewSessionCache(0).EnablePersistence(path, key); err == nil {
+			t.Errorf("%d-byte key accepted", len(key))
+		}
+	}
+}
+
+// seal encrypts plain the way Flush does, under testKey.
+func seal(plain []byte) []byte {
+	block, _ := aes.NewCipher(testKey)
+	aead, _ := cipher.NewGCM(block)
+	nonce := make([]byte, aead.NonceSize())
+	return aead.Seal(nonce, nonce, plain, nil)
+}
+
+// newSessionState runs a TLS 1.3 handshake against an in-process server
+// and returns the session ticket the client received.
+func newSessionState(t *testing.T) *tls.ClientSessionState {
+	t.Helper()
+	key, err := ecdsa.GenerateKey(elliptic.P256(), rand.Reader)
+	if err != nil {
+		t.Fatal(err)
+	}
+	tmpl := &x509.Certificate{
+		SerialNumber: big.NewInt(1),
+		Subject:      pkix.Name{CommonName: "example.com"},
+		DNSNames:     []string{"example.com"},
+		NotBefore:    time.Now().Add(-time.Hour),
+		NotAfter:     time.Now().Add(time.Hour),
+	}
+	der, err := x509.CreateCertificate(rand.Reader, tmpl, tmpl, &key.PublicKey, key)
+	if err != nil {
+		t.Fatal(err)
+	}
+
+	clientConn, serverConn := net.Pipe()
+	defer clientConn.Close()
+	go func() {
+		defer serverConn.Close()
+		server := tls.Server(serverConn, &tls.Config{
+			Certificates: []tls.Certificate{{Certificate: [][]byte{der}, PrivateKey: key}},
+			MinVersion:   tls.VersionTLS13,
+		})
+		if server.Handshake() == nil {
+			server.Write([]byte{0})
+		}
+	}()
+
+	capture := NewSessionCache(0)
+	client := tls.Client(clientConn, &tls.Config{
+		ServerName:         "example.com",
+		InsecureSkipVerify: true,
+		MinVersion:         tls.VersionTLS13,
+		ClientSessionCache: capture,
+	})
+	// The ticket arrives after the handshake, ahead of the server's byte.
+	if _, err := client.Read(make([]byte, 1)); err != nil {
+		t.Fatalf("client read: %v", err)
+	}
+	// crypto/tls keys client sessions by ServerName.
+	cs, ok := capture.Get("example.com")
+	if !ok {
+		t.Fatal("no session ticket received")
+	}
+	return cs
+}
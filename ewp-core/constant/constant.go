@@ -24,6 +24,7 @@ const (
 	DefaultTunMask    = "255.255.255.0"
 	DefaultTunDNS     = "1.1.1.1"
 	DefaultTunMTU     = 1380
+	MaxTunQueues      = 16
 )
 
 // Buffer sizes
@@ -1,6 +1,7 @@
 package server
 
 import (
+	"encoding/binary"
 	"fmt"
 
 	"ewp-core/protocol/ewp"
@@ -35,5 +36,11 @@ func (h *EWPProtocolHandler) Handshake(data []byte, clientIP string) (*Handshake
 		result.FlowState = ewp.NewFlowState(req.UUID[:])
 	}
 
+	// Bytes after the handshake (AD + ciphertext + HMAC) are early data sent
+	// in the same message; they are forwarded raw, before flow processing.
+	if n := 15 + int(binary.BigEndian.Uint16(data[13:15])) + 16; !result.IsUDP && len(data) > n {
+		result.InitialData = data[n:]
+	}
+
 	return result, nil
 }
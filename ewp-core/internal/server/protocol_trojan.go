@@ -32,6 +32,7 @@ func (h *TrojanProtocolHandler) Handshake(data []byte, clientIP string) (*Handsh
 		Target:   addr.String(),
 		IsUDP:    command == trojan.CommandUDP,
 		IsTrojan: true,
+		IsMux:    command == trojan.CommandMux,
 		UserID:   maskPassword(pwd),
 	}
 
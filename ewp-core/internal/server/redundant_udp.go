@@ -0,0 +1,131 @@
+package server
+
+import (
+	"net"
+	"sync"
+
+	log "ewp-core/log"
+	"ewp-core/protocol/redundant"
+)
+
+// 冗余双路 UDP（服务端）
+// 客户端把同一条 UDP 流经两条隧道各发一份，每份载荷前带 protocol/redundant
+// 序号头。两条隧道上 FlowID 相同的会话在此汇合为一条流、共用一个出站 socket：
+// 上行按序号只转发一次，目标只看到一个客户端；回包加上本端序号后从每条
+// 隧道各回一份，由客户端按序号去重。
+
+// redundantPath 是冗余流的一条回程路径（一条隧道里的一个 UDP 会话）。
+type redundantPath interface {
+	reply(from *net.UDPAddr, payload []byte) error
+}
+
+// redundantFlow 是一条冗余流，路径全部离开后关闭。
+type redundantFlow struct {
+	id   uint64
+	conn *net.UDPConn // 建立后不变
+
+	mu     sync.Mutex
+	window redundant.Window // 上行去重
+	paths  map[redundantPath]struct{}
+	closed bool
+}
+
+var redundantFlows = struct {
+	sync.Mutex
+	m map[uint64]*redundantFlow
+}{m: make(map[uint64]*redundantFlow)}
+
+// joinRedundantFlow 把 p 加入 id 对应的流，流不存在时新建。
+func joinRedundantFlow(id uint64, p redundantPath) (*redundantFlow, error) {
+	redundantFlows.Lock()
+	defer redundantFlows.Unlock()
+
+	if f, ok := redundantFlows.m[id]; ok {
+		f.mu.Lock()
+		f.paths[p] = struct{}{}
+		f.mu.Unlock()
+		log.Debug("Redundant UDP flow %x: second path joined", id>>32)
+		return f, nil
+	}
+
+	conn, err := net.ListenUDP("udp", &net.UDPAddr{})
+	if err != nil {
+		return nil, err
+	}
+	f := &redundantFlow{
+		id:    id,
+		conn:  conn,
+		paths: map[redundantPath]struct{}{p: {}},
+	}
+	redundantFlows.m[id] = f
+	log.Debug("Redundant UDP flow %x: new", id>>32)
+	go f.receiveResponses()
+	return f, nil
+}
+
+// leave 移除路径 p；最后一条路径离开时关闭整条流。
+func (f *redundantFlow) leave(p redundantPath) {
+	redundantFlows.Lock()
+	defer redundantFlows.Unlock()
+
+	f.mu.Lock()
+	delete(f.paths, p)
+	last := len(f.paths) == 0 && !f.closed
+	if last {
+		f.closed = true
+	}
+	f.mu.Unlock()
+
+	if last {
+		delete(redundantFlows.m, f.id)
+		f.conn.Close()
+		log.Debug("Redundant UDP flow %x: closed", f.id>>32)
+	}
+}
+
+// send 转发一个上行包；另一条路径上已转发过的序号直接丢弃。
+func (f *redundantFlow) send(seq uint32, target *net.UDPAddr, payload []byte) error {
+	f.mu.Lock()
+	fresh := f.window.Admit(seq)
+	f.mu.Unlock()
+	if !fresh || len(payload) == 0 {
+		return nil
+	}
+	_, err := f.conn.WriteTo(payload, target)
+	return err
+}
+
+// receiveResponses 给每个回包编上序号，从所有路径各回一份。
+// conn 关闭（最后一条路径离开）时退出。
+func (f *redundantFlow) receiveResponses() {
+	bufp := udpBufferPool.Get().(*[]byte)
+	buf := *bufp
+	defer udpBufferPool.Put(bufp)
+
+	var seq uint32
+	var paths []redundantPath
+	msg := redundant.AppendHeader(nil, f.id, 0)
+	for {
+		n, remoteAddr, err := f.conn.ReadFromUDP(buf)
+		if err != nil {
+			return
+		}
+		if n == 0 {
+			continue
+		}
+		msg = append(redundant.AppendHeader(msg[:0], f.id, seq), buf[:n]...)
+		seq++
+
+		paths = paths[:0]
+		f.mu.Lock()
+		for p := range f.paths {
+			paths = append(paths, p)
+		}
+		f.mu.Unlock()
+		for _, p := range paths {
+			if err := p.reply(remoteAddr, msg); err != nil {
+				log.V("[UDP] redundant flow %x: reply path failed: %v", f.id>>32, err)
+			}
+		}
+	}
+}
@@ -16,6 +16,7 @@ type HandshakeResult struct {
 	InitialData []byte
 	IsUDP       bool
 	IsTrojan    bool // true when using Trojan protocol (different UDP framing)
+	IsMux       bool // true when the Trojan client requested an smux session (CommandMux)
 	UserID      string
 }
 
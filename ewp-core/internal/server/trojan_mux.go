@@ -0,0 +1,82 @@
+package server
+
+import (
+	"context"
+	"io"
+	"net"
+	"sync"
+	"time"
+
+	"ewp-core/log"
+	"ewp-core/protocol/trojan"
+)
+
+var muxRelayBufferPool = sync.Pool{
+	New: func() interface{} {
+		return make([]byte, 32*1024)
+	},
+}
+
+// HandleTrojanMux serves a Trojan CommandMux tunnel: the transport carries one
+// smux session and every stream inside it is an independent TCP or UDP relay.
+// dialTimeout bounds each outbound TCP dial (0 = no timeout).
+func HandleTrojanMux(ctx context.Context, t TransportAdapter, user string, dialTimeout time.Duration) error {
+	conn := &transportConn{transportReaderWriter: transportReaderWriter{transport: t}}
+	return trojan.HandleMuxConnection(ctx, conn, user, &trojanMuxHandler{dialTimeout: dialTimeout})
+}
+
+// transportConn adds Close to transportReaderWriter so it satisfies
+// io.ReadWriteCloser for smux.
+type transportConn struct {
+	transportReaderWriter
+}
+
+func (c *transportConn) Close() error {
+	return c.transport.Close()
+}
+
+type trojanMuxHandler struct {
+	dialTimeout time.Duration
+}
+
+func (h *trojanMuxHandler) HandleTCP(ctx context.Context, conn net.Conn, target string, user string) error {
+	dialCtx := ctx
+	if h.dialTimeout > 0 {
+		var cancel context.CancelFunc
+		dialCtx, cancel = context.WithTimeout(ctx, h.dialTimeout)
+		defer cancel()
+	}
+
+	var d net.Dialer
+	remote, err := d.DialContext(dialCtx, "tcp", target)
+	if err != nil {
+		log.V("[Mux] Dial failed to %s: %v", target, err)
+		return err
+	}
+	defer remote.Close()
+
+	log.V("[Mux] Stream connected (user: %s) -> %s", user, target)
+
+	done := make(chan struct{}, 2)
+	relay := func(dst, src net.Conn) {
+		buf := muxRelayBufferPool.Get().([]byte)
+		io.CopyBuffer(dst, src, buf)
+		muxRelayBufferPool.Put(buf)
+		dst.Close()
+		src.Close()
+		done <- struct{}{}
+	}
+	go relay(remote, conn)
+	go relay(conn, remote)
+	<-done
+	<-done
+
+	log.V("[Mux] Stream closed -> %s", target)
+	return nil
+}
+
+func (h *trojanMuxHandler) HandleUDP(ctx context.Context, conn *trojan.PacketConn, target string, user string) error {
+	log.V("[Mux] UDP stream (user: %s) -> %s", user, target)
+	HandleTrojanUDPConnection(conn.Conn, conn.Conn)
+	return nil
+}
@@ -8,6 +8,7 @@ import (
 	"time"
 
 	log "ewp-core/log"
+	"ewp-core/protocol/redundant"
 	"ewp-core/protocol/trojan"
 )
 
@@ -96,30 +97,76 @@ func (h *trojanUDPHandler) handleStream(reader io.Reader, done chan struct{}) {
 		// Create session on first packet
 		h.mu.Lock()
 		if h.session == nil {
-			conn, err := net.ListenUDP("udp", &net.UDPAddr{})
+			s, err := h.open(target, payload)
 			if err != nil {
 				h.mu.Unlock()
 				log.Warn("Trojan UDP listen error: %v", err)
 				return
 			}
-			h.session = &udpSession{
-				conn:       conn,
-				initTarget: target,
-				incoming:   make(chan incomingPkt, udpIncomingDepth),
-			}
-			h.session.updateActive()
-			log.Debug("Trojan UDP new session: %s", target)
-			go h.sessionWorker(h.session)
+			h.session = s
 		}
 		s := h.session
 		h.mu.Unlock()
 
+		if s.flow != nil {
+			if err := s.sendRedundant(target, payload); err != nil {
+				log.Warn("Trojan UDP write error: %v", err)
+				return
+			}
+			continue
+		}
 		if len(payload) > 0 {
 			safeSend(s.incoming, incomingPkt{target: target, payload: payload})
 		}
 	}
 }
 
+// open creates the tunnel's UDP session. A payload carrying the redundant
+// sequence shim joins the flow with that FlowID instead of opening its own
+// socket, the same as on EWP.
+func (h *trojanUDPHandler) open(target *net.UDPAddr, payload []byte) (*udpSession, error) {
+	s := &udpSession{
+		initTarget: target,
+		incoming:   make(chan incomingPkt, udpIncomingDepth),
+	}
+	if id, _, _, ok := redundant.Parse(payload); ok {
+		path := &trojanRedundantPath{h: h, s: s}
+		f, err := joinRedundantFlow(id, path)
+		if err != nil {
+			return nil, err
+		}
+		s.flow, s.flowPath = f, path
+		s.updateActive()
+		log.Debug("Trojan UDP new redundant session: %s", target)
+		return s, nil
+	}
+
+	conn, err := net.ListenUDP("udp", &net.UDPAddr{})
+	if err != nil {
+		return nil, err
+	}
+	s.conn = conn
+	s.updateActive()
+	log.Debug("Trojan UDP new session: %s", target)
+	go h.sessionWorker(s)
+	return s, nil
+}
+
+// trojanRedundantPath writes a redundant flow's replies back through this tunnel.
+type trojanRedundantPath struct {
+	h *trojanUDPHandler
+	s *udpSession
+}
+
+func (p *trojanRedundantPath) reply(from *net.UDPAddr, payload []byte) error {
+	p.s.updateActive()
+	resp, err := appendTrojanUDPFrame(nil, from, payload)
+	if err != nil {
+		return err
+	}
+	return p.h.writer.tryWrite(resp)
+}
+
 // sessionWorker sends outgoing UDP packets.
 func (h *trojanUDPHandler) sessionWorker(s *udpSession) {
 	go h.receiveResponses(s)
@@ -164,26 +211,31 @@ func (h *trojanUDPHandler) receiveResponses(s *udpSession) {
 		}
 		s.updateActive()
 
-		// Encode response in Trojan UDP framing: [AddrType][Addr][Port][PayloadLen:2][CRLF:2][Payload]
-		trojanAddr, err := trojan.ParseAddress(remoteAddr.String())
-		if err != nil {
-			log.Warn("Trojan UDP parse response addr error: %v", err)
-			continue
-		}
-		addrBytes, err := trojanAddr.Encode()
+		resp, err := appendTrojanUDPFrame(nil, remoteAddr, buf[:n])
 		if err != nil {
-			log.Warn("Trojan UDP encode response addr error: %v", err)
+			log.Warn("Trojan UDP encode response error: %v", err)
 			continue
 		}
-
-		resp := make([]byte, 0, len(addrBytes)+4+n)
-		resp = append(resp, addrBytes...)
-		resp = append(resp, byte(n>>8), byte(n))
-		resp = append(resp, trojan.CRLF...)
-		resp = append(resp, buf[:n]...)
-
 		if err := h.writer.write(resp); err != nil {
 			return
 		}
 	}
 }
+
+// appendTrojanUDPFrame appends a response in Trojan UDP framing:
+// [AddrType][Addr][Port][PayloadLen:2][CRLF:2][Payload]
+func appendTrojanUDPFrame(dst []byte, from *net.UDPAddr, payload []byte) ([]byte, error) {
+	trojanAddr, err := trojan.ParseAddress(from.String())
+	if err != nil {
+		return nil, err
+	}
+	addrBytes, err := trojanAddr.Encode()
+	if err != nil {
+		return nil, err
+	}
+	n := len(payload)
+	dst = append(dst, addrBytes...)
+	dst = append(dst, byte(n>>8), byte(n))
+	dst = append(dst, trojan.CRLF...)
+	return append(dst, payload...), nil
+}
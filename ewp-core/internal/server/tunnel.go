@@ -34,6 +34,13 @@ func EstablishTunnel(ctx context.Context, handshakeData []byte, opts TunnelOptio
 		}
 	}
 
+	if result.IsMux {
+		log.Info("[Tunnel] Mux mode: %s", opts.ClientIP)
+		err := HandleTrojanMux(ctx, opts.Transport, result.UserID, opts.Timeout)
+		log.Info("[Tunnel] Mux closed: %s", opts.ClientIP)
+		return err
+	}
+
 	if result.IsUDP {
 		log.Info("[Tunnel] UDP mode: %s -> %s", opts.ClientIP, result.Target)
 
@@ -10,6 +10,7 @@ import (
 
 	log "ewp-core/log"
 	"ewp-core/protocol/ewp"
+	"ewp-core/protocol/redundant"
 )
 
 // UDP 转发处理器 (服务端)
@@ -46,6 +47,10 @@ type udpSession struct {
 	lastActiveNs int64           // atomic UnixNano
 	incoming     chan incomingPkt // 有界入包队列
 	closeOnce    sync.Once
+
+	// 冗余双路会话经 flow 收发，conn 为 nil（见 redundant_udp.go）
+	flow     *redundantFlow
+	flowPath redundantPath
 }
 
 func (s *udpSession) updateActive() {
@@ -66,9 +71,22 @@ func (s *udpSession) close() {
 		if s.conn != nil {
 			s.conn.Close()
 		}
+		if s.flow != nil {
+			s.flow.leave(s.flowPath)
+		}
 	})
 }
 
+// sendRedundant 剥去序号头后交给冗余流；FlowID 不符的包丢弃。
+func (s *udpSession) sendRedundant(target *net.UDPAddr, payload []byte) error {
+	id, seq, data, ok := redundant.Parse(payload)
+	if !ok || id != s.flow.id {
+		return nil
+	}
+	s.updateActive()
+	return s.flow.send(seq, target, data)
+}
+
 // udpHandler 管理单个客户端连接的全部 UDP 会话。
 type udpHandler struct {
 	mu            sync.Mutex
@@ -187,22 +205,13 @@ func (h *udpHandler) dispatch(pkt *ewp.UDPPacket) {
 				return
 			}
 		}
-		// ListenUDP（非连接 socket）：服务器绑定随机本地端口。
-		// 任意远端均可向该端口发包 → 真正的 Full-Cone NAT。
-		// （DialUDP 是 connected socket，内核仅接受 pkt.Target 来源的回包，
-		//  导致 P2P / WebRTC ICE / 负载均衡场景下回包被内核过滤丢弃。）
-		conn, err := net.ListenUDP("udp", &net.UDPAddr{})
-		if err != nil {
-			log.Warn("UDP listen error: %v", err)
+		if !h.open(s, pkt) {
 			h.remove(pkt.GlobalID)
 			return
 		}
-		s.conn = conn
 		s.initTarget = pkt.Target
 		s.updateActive()
-		log.Debug("UDP new session: %s (GlobalID: %x)", pkt.Target, pkt.GlobalID[:4])
-		go h.sessionWorker(s)
-	} else if s.conn == nil {
+	} else if s.conn == nil && s.flow == nil {
 		return
 	}
 
@@ -217,11 +226,69 @@ func (h *udpHandler) dispatch(pkt *ewp.UDPPacket) {
 		s.initTarget = pkt.Target // 单 goroutine 写，安全
 	}
 
+	if s.flow != nil {
+		if err := s.sendRedundant(target, pkt.Payload); err != nil {
+			log.Warn("UDP write error: %v", err)
+			h.remove(s.globalID)
+		}
+		return
+	}
+
 	// safeSend: 非阻塞投递，recover 防止 closeIdle/sessionWorker 并发关闭
 	// s.incoming 导致 send-on-closed-channel panic。
 	safeSend(s.incoming, incomingPkt{target: target, payload: pkt.Payload})
 }
 
+// open 为新 session 建立出站 socket。带序号头的是冗余双路流：加入（或新建）
+// 同 FlowID 的流，共用其 socket；其余 session 独占一个。
+func (h *udpHandler) open(s *udpSession, pkt *ewp.UDPPacket) bool {
+	if id, _, _, ok := redundant.Parse(pkt.Payload); ok {
+		path := &ewpRedundantPath{h: h, s: s}
+		f, err := joinRedundantFlow(id, path)
+		if err != nil {
+			log.Warn("UDP listen error: %v", err)
+			return false
+		}
+		s.flow, s.flowPath = f, path
+		log.Debug("UDP new redundant session: %s (GlobalID: %x)", pkt.Target, pkt.GlobalID[:4])
+		return true
+	}
+
+	// ListenUDP（非连接 socket）：服务器绑定随机本地端口。
+	// 任意远端均可向该端口发包 → 真正的 Full-Cone NAT。
+	// （DialUDP 是 connected socket，内核仅接受 pkt.Target 来源的回包，
+	//  导致 P2P / WebRTC ICE / 负载均衡场景下回包被内核过滤丢弃。）
+	conn, err := net.ListenUDP("udp", &net.UDPAddr{})
+	if err != nil {
+		log.Warn("UDP listen error: %v", err)
+		return false
+	}
+	s.conn = conn
+	log.Debug("UDP new session: %s (GlobalID: %x)", pkt.Target, pkt.GlobalID[:4])
+	go h.sessionWorker(s)
+	return true
+}
+
+// ewpRedundantPath 把冗余流的回包写回本连接上的一个 EWP UDP 会话。
+type ewpRedundantPath struct {
+	h *udpHandler
+	s *udpSession
+}
+
+func (p *ewpRedundantPath) reply(from *net.UDPAddr, payload []byte) error {
+	p.s.updateActive()
+	data, err := ewp.EncodeUDPPacket(&ewp.UDPPacket{
+		GlobalID: p.s.globalID,
+		Status:   ewp.UDPStatusKeep,
+		Target:   from,
+		Payload:  payload,
+	})
+	if err != nil {
+		return err
+	}
+	return p.h.writer.tryWrite(data)
+}
+
 // safeSend 向 ch 非阻塞投递，忽略队列满和 closed channel 两种情况。
 func safeSend(ch chan incomingPkt, pkt incomingPkt) {
 	defer func() { recover() }()
@@ -378,6 +445,25 @@ func (cw *chanWriter) write(data []byte) (writeErr error) {
 	return nil
 }
 
+// tryWrite 与 write 相同，但队列满时丢包而不阻塞：冗余流的回包不能因为
+// 一条路径拥塞而拖住另一条。
+func (cw *chanWriter) tryWrite(data []byte) (writeErr error) {
+	if p := atomic.LoadPointer(&cw.lastErr); p != nil {
+		return *(*error)(p)
+	}
+	defer func() {
+		if r := recover(); r != nil {
+			writeErr = io.ErrClosedPipe
+		}
+	}()
+	select {
+	case cw.ch <- data:
+	default:
+		log.V("[UDP] reply queue full, dropping packet")
+	}
+	return nil
+}
+
 func (cw *chanWriter) close() {
 	cw.closeOnce.Do(func() {
 		close(cw.ch)
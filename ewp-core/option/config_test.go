@@ -218,6 +218,151 @@ func TestConfigValidation(t *testing.T) {
 	}
 }
 
+func TestGroupOutboundValidation(t *testing.T) {
+	node := func(tag string) OutboundConfig {
+		return OutboundConfig{Type: "ewp", Tag: tag, Server: "example.com", ServerPort: 443, UUID: "test-uuid"}
+	}
+
+	cfg := DefaultRootConfig()
+	cfg.Outbounds = []OutboundConfig{
+		{Type: "urltest", Tag: "auto", Outbounds: []string{"a", "b"}, Interval: "10s"},
+		node("a"),
+		node("b"),
+	}
+	if err := cfg.Validate(); err != nil {
+		t.Fatalf("valid urltest group rejected: %v", err)
+	}
+
+	// Unknown member
+	cfg.Outbounds[0].Outbounds = []string{"a", "missing"}
+	if err := cfg.Validate(); err == nil {
+		t.Error("Expected validation error for unknown group member")
+	}
+
+	// Group members must be nodes, not other groups or direct
+	cfg.Outbounds[0].Outbounds = []string{"a", "auto"}
+	if err := cfg.Validate(); err == nil {
+		t.Error("Expected validation error for nested group")
+	}
+
+	// Probe URL must be plain HTTP
+	cfg.Outbounds[0].Outbounds = []string{"a", "b"}
+	cfg.Outbounds[0].URL = "https://www.gstatic.com/generate_204"
+	if err := cfg.Validate(); err == nil {
+		t.Error("Expected validation error for https probe url")
+	}
+
+	// Balancer strategy and weights
+	cfg.Outbounds[0] = OutboundConfig{Type: "balancer", Tag: "lb", Outbounds: []string{"a", "b"},
+		Strategy: "round-robin", Weights: map[string]int{"a": 3}}
+	if err := cfg.Validate(); err != nil {
+		t.Fatalf("valid balancer group rejected: %v", err)
+	}
+	cfg.Outbounds[0].Strategy = "random"
+	if err := cfg.Validate(); err == nil {
+		t.Error("Expected validation error for unknown balancer strategy")
+	}
+	cfg.Outbounds[0].Strategy = ""
+	cfg.Outbounds[0].Weights = map[string]int{"c": 2}
+	if err := cfg.Validate(); err == nil {
+		t.Error("Expected validation error for weight on non-member")
+	}
+}
+
+func TestOutboundForInbound(t *testing.T) {
+	node := func(tag string) OutboundConfig {
+		return OutboundConfig{Type: "ewp", Tag: tag, Server: "example.com", ServerPort: 443, UUID: "test-uuid"}
+	}
+
+	cfg := DefaultRootConfig()
+	cfg.Inbounds = []InboundConfig{
+		{Type: "mixed", Tag: "browser", Listen: "127.0.0.1:1080"},
+		{Type: "mixed", Tag: "downloads", Listen: "127.0.0.1:1081"},
+	}
+	cfg.Outbounds = []OutboundConfig{node("a"), node("b")}
+	cfg.Route = &RouteConfig{
+		Final: "a",
+		Rules: []RouteRule{{Inbound: []string{"downloads"}, Outbound: "b"}},
+	}
+	if err := cfg.Validate(); err != nil {
+		t.Fatalf("valid multi-inbound config rejected: %v", err)
+	}
+	if got := cfg.OutboundForInbound("browser"); got != "a" {
+		t.Errorf("browser -> %s, want a", got)
+	}
+	if got := cfg.OutboundForInbound("downloads"); got != "b" {
+		t.Errorf("downloads -> %s, want b", got)
+	}
+
+	// Rules with other selectors do not bind the whole inbound
+	cfg.Route.Rules[0].Domain = []string{"example.org"}
+	if got := cfg.OutboundForInbound("downloads"); got != "a" {
+		t.Errorf("domain rule bound downloads -> %s, want a", got)
+	}
+
+	cfg.Inbounds[1].Listen = "127.0.0.1:1080"
+	if err := cfg.Validate(); err == nil {
+		t.Error("Expected validation error for duplicate listen address")
+	}
+	cfg.Inbounds[1].Listen = "127.0.0.1:1081"
+	cfg.Route.Rules[0].Inbound = []string{"missing"}
+	if err := cfg.Validate(); err == nil {
+		t.Error("Expected validation error for unknown inbound in rule")
+	}
+}
+
+func TestRedundantUDPValidation(t *testing.T) {
+	node := func(tag string) OutboundConfig {
+		return OutboundConfig{Type: "ewp", Tag: tag, Server: "example.com", ServerPort: 443, UUID: "test-uuid"}
+	}
+
+	cfg := DefaultRootConfig()
+	cfg.Inbounds = []InboundConfig{{Type: "tun", Tag: "tun-in", RedundantUDP: &RedundantUDPConfig{
+		Primary: "a", Secondary: "b", Port: []int{3478}, PortRange: []string{"27000:27100"},
+	}}}
+	cfg.Outbounds = []OutboundConfig{node("a"), node("b"), {Type: "direct", Tag: "direct"}}
+	if err := cfg.Validate(); err != nil {
+		t.Fatalf("valid redundant_udp rejected: %v", err)
+	}
+
+	r := cfg.Inbounds[0].RedundantUDP
+	r.Secondary = "a"
+	if err := cfg.Validate(); err == nil {
+		t.Error("Expected validation error for identical paths")
+	}
+	r.Secondary = "direct"
+	if err := cfg.Validate(); err == nil {
+		t.Error("Expected validation error for direct path")
+	}
+	r.Secondary = "b"
+
+	// Both paths must reach one server, which merges them by sequence.
+	cfg.Outbounds[1].Server = "other.example.com"
+	if err := cfg.Validate(); err == nil {
+		t.Error("Expected validation error for paths to different servers")
+	}
+	cfg.Outbounds[1].Server, cfg.Outbounds[1].Host = "203.0.113.7", "EXAMPLE.com"
+	if err := cfg.Validate(); err != nil {
+		t.Errorf("paths to one server via a CDN address rejected: %v", err)
+	}
+	cfg.Outbounds[1].Transport = &TransportConfig{Type: "masque"}
+	if err := cfg.Validate(); err == nil {
+		t.Error("Expected validation error for masque path")
+	}
+	cfg.Outbounds[1] = node("b")
+	cfg.Outbounds = append(cfg.Outbounds, OutboundConfig{Type: "urltest", Tag: "auto", Outbounds: []string{"a", "b"}})
+	r.Secondary = "auto"
+	if err := cfg.Validate(); err == nil {
+		t.Error("Expected validation error for group path")
+	}
+	r.Secondary = "b"
+
+	r.PortRange = []string{"27100:27000"}
+	if err := cfg.Validate(); err == nil {
+		t.Error("Expected validation error for inverted port range")
+	}
+}
+
 func TestConfigJSONRoundtrip(t *testing.T) {
 	original := DefaultRootConfig()
 	original.Outbounds = []OutboundConfig{
@@ -3,9 +3,13 @@ package option
 import (
 	"encoding/json"
 	"fmt"
+	"net/netip"
 	"os"
 	"path/filepath"
+	"slices"
+	"strconv"
 	"strings"
+	"time"
 
 	"ewp-core/constant"
 )
@@ -17,6 +21,12 @@ type RootConfig struct {
 	Inbounds  []InboundConfig  `json:"inbounds"`
 	Outbounds []OutboundConfig `json:"outbounds"`
 	Route     *RouteConfig     `json:"route,omitempty"`
+	Cache     *CacheConfig     `json:"cache,omitempty"`
+}
+
+// CacheConfig configures on-disk state that survives core restarts
+type CacheConfig struct {
+	TLSSessionFile string `json:"tls_session_file,omitempty"` // TLS session ticket cache, encrypted with $EWP_TLS_SESSION_KEY
 }
 
 // LogConfig configures logging behavior
@@ -69,11 +79,92 @@ type InboundConfig struct {
 	IPv6DNS         string `json:"ipv6_dns,omitempty"`          // IPv6 DNS server address advertised to the TUN interface
 	TunnelDoHServer string `json:"tunnel_doh_server,omitempty"` // DoH server URL used for DNS-over-tunnel (default: https://dns.google/dns-query)
 	DisableFakeIP   bool   `json:"disable_fakeip,omitempty"`    // true = Normal Mode: skip FakeIP DNS pool, use PeerRegistry vIPs only
+	DisableOffload  bool   `json:"disable_offload,omitempty"`   // Linux: open the TUN without virtio-net header offloads (TSO/GRO, checksum)
+	Queues          int    `json:"queues,omitempty"`            // Linux: TUN queues (IFF_MULTI_QUEUE), one reader each; 0/1 = single queue
+
+	RouteExcludeAddress     []string `json:"route_exclude_address,omitempty"`      // Linux: CIDRs routed around the TUN via the physical NIC
+	RouteExcludeAddressFile string   `json:"route_exclude_address_file,omitempty"` // Linux: file of further CIDRs, one per line, # comments
+
+	RedundantUDP *RedundantUDPConfig `json:"redundant_udp,omitempty"` // TUN only: duplicate matching UDP flows over two outbounds
+}
+
+// RedundantUDPConfig 冗余双路 UDP：匹配的 UDP 流同时经 primary / secondary 两个出站发送，
+// 两份包带同一序号，服务端合并为一条出站流，回包按序号去重，先到者交给应用
+// （游戏 / 语音等对丢包和抖动敏感的流量）。两个出站须是同一服务端（host，留空
+// 则 server）上的 ewp / trojan 节点，且服务端版本支持冗余流；masque 不支持。
+type RedundantUDPConfig struct {
+	Primary   string   `json:"primary"`              // outbound tag
+	Secondary string   `json:"secondary"`            // outbound tag
+	Port      []int    `json:"port,omitempty"`       // destination ports (empty with port_range = every UDP flow)
+	PortRange []string `json:"port_range,omitempty"` // "from:to"
+}
+
+// ParsePortRange parses a "from:to" port range.
+func ParsePortRange(s string) (from, to uint16, err error) {
+	a, b, ok := strings.Cut(s, ":")
+	if !ok {
+		return 0, 0, fmt.Errorf("invalid port range %q (want from:to)", s)
+	}
+	f, err1 := strconv.ParseUint(strings.TrimSpace(a), 10, 16)
+	t, err2 := strconv.ParseUint(strings.TrimSpace(b), 10, 16)
+	if err1 != nil || err2 != nil || f == 0 || f > t {
+		return 0, 0, fmt.Errorf("invalid port range %q", s)
+	}
+	return uint16(f), uint16(t), nil
+}
+
+// ParsePrefix parses a CIDR; a bare address is taken as a single host.
+func ParsePrefix(s string) (netip.Prefix, error) {
+	s = strings.TrimSpace(s)
+	if !strings.Contains(s, "/") {
+		addr, err := netip.ParseAddr(s)
+		if err != nil {
+			return netip.Prefix{}, fmt.Errorf("invalid address %q", s)
+		}
+		return netip.PrefixFrom(addr, addr.BitLen()), nil
+	}
+	p, err := netip.ParsePrefix(s)
+	if err != nil {
+		return netip.Prefix{}, fmt.Errorf("invalid CIDR %q", s)
+	}
+	return p.Masked(), nil
+}
+
+// ExcludePrefixes returns the TUN's route_exclude_address set: the inline
+// entries followed by those read from route_exclude_address_file.
+func (i *InboundConfig) ExcludePrefixes() ([]netip.Prefix, error) {
+	out := make([]netip.Prefix, 0, len(i.RouteExcludeAddress))
+	for _, s := range i.RouteExcludeAddress {
+		p, err := ParsePrefix(s)
+		if err != nil {
+			return nil, fmt.Errorf("route_exclude_address: %w", err)
+		}
+		out = append(out, p)
+	}
+	if i.RouteExcludeAddressFile == "" {
+		return out, nil
+	}
+	data, err := os.ReadFile(i.RouteExcludeAddressFile)
+	if err != nil {
+		return nil, fmt.Errorf("route_exclude_address_file: %w", err)
+	}
+	for n, line := range strings.Split(string(data), "\n") {
+		line, _, _ = strings.Cut(line, "#")
+		if line = strings.TrimSpace(line); line == "" {
+			continue
+		}
+		p, err := ParsePrefix(line)
+		if err != nil {
+			return nil, fmt.Errorf("route_exclude_address_file line %d: %w", n+1, err)
+		}
+		out = append(out, p)
+	}
+	return out, nil
 }
 
 // OutboundConfig defines an outbound connection handler
 type OutboundConfig struct {
-	Type string `json:"type"` // ewp, trojan, direct, block
+	Type string `json:"type"` // ewp, trojan, urltest, fallback, balancer, direct, block
 	Tag  string `json:"tag"`
 
 	// Server settings (for ewp/trojan)
@@ -81,6 +172,9 @@ type OutboundConfig struct {
 	ServerPort int    `json:"server_port,omitempty"`
 	Host       string `json:"host,omitempty"`         // HTTP Host 头 / gRPC authority（留空则同 server，CDN 场景使用）
 
+	// TCPFastOpen 客户端 TCP Fast Open：TLS ClientHello 随 SYN 发送（ws/grpc/xhttp）
+	TCPFastOpen bool `json:"tcp_fast_open,omitempty"`
+
 	// Authentication
 	UUID     string `json:"uuid,omitempty"`     // for ewp
 	Password string `json:"password,omitempty"` // for trojan
@@ -90,6 +184,19 @@ type OutboundConfig struct {
 	TLS       *TLSConfig       `json:"tls,omitempty"`
 	Flow      *FlowConfig      `json:"flow,omitempty"`      // for ewp
 	Multiplex *MultiplexConfig `json:"multiplex,omitempty"` // for trojan
+
+	// Group (urltest / fallback / balancer)
+	Outbounds []string       `json:"outbounds,omitempty"` // member outbound tags (ewp / trojan)
+	URL       string         `json:"url,omitempty"`       // probe URL, http:// only (default http://www.gstatic.com/generate_204)
+	Interval  string         `json:"interval,omitempty"`  // probe interval (default 30s)
+	Tolerance int            `json:"tolerance,omitempty"` // urltest: ms a member must beat the current one by (default 50)
+	Strategy  string         `json:"strategy,omitempty"`  // balancer: least-conn (default), round-robin, consistent-hash
+	Weights   map[string]int `json:"weights,omitempty"`   // balancer: member tag -> weight (default 1)
+}
+
+// IsGroup reports whether the outbound is a urltest / fallback / balancer group.
+func (o *OutboundConfig) IsGroup() bool {
+	return o.Type == "urltest" || o.Type == "fallback" || o.Type == "balancer"
 }
 
 // TransportConfig defines transport layer settings
@@ -277,6 +384,7 @@ func (c *RootConfig) Validate() error {
 
 	// Validate inbounds
 	inboundTags := make(map[string]bool)
+	listenAddrs := make(map[string]bool)
 	for i, inbound := range c.Inbounds {
 		if inbound.Tag == "" {
 			return fmt.Errorf("inbound[%d]: tag is required", i)
@@ -285,6 +393,12 @@ func (c *RootConfig) Validate() error {
 			return fmt.Errorf("inbound[%d]: duplicate tag %s", i, inbound.Tag)
 		}
 		inboundTags[inbound.Tag] = true
+		if inbound.Type != "tun" && inbound.Listen != "" {
+			if listenAddrs[inbound.Listen] {
+				return fmt.Errorf("inbound[%d] (%s): listen address %s already used", i, inbound.Tag, inbound.Listen)
+			}
+			listenAddrs[inbound.Listen] = true
+		}
 
 		if err := inbound.Validate(); err != nil {
 			return fmt.Errorf("inbound[%d] (%s): %w", i, inbound.Tag, err)
@@ -311,6 +425,73 @@ func (c *RootConfig) Validate() error {
 		}
 	}
 
+	// Group members must name ewp / trojan outbounds
+	for i, outbound := range c.Outbounds {
+		if !outbound.IsGroup() {
+			continue
+		}
+		for _, tag := range outbound.Outbounds {
+			member := c.findOutbound(tag)
+			if member == nil {
+				return fmt.Errorf("outbound[%d] (%s): references unknown outbound: %s", i, outbound.Tag, tag)
+			}
+			if member.Type != "ewp" && member.Type != "trojan" {
+				return fmt.Errorf("outbound[%d] (%s): member %s must be ewp or trojan, got %s", i, outbound.Tag, tag, member.Type)
+			}
+		}
+		for tag := range outbound.Weights {
+			if !slices.Contains(outbound.Outbounds, tag) {
+				return fmt.Errorf("outbound[%d] (%s): weight for non-member outbound: %s", i, outbound.Tag, tag)
+			}
+		}
+	}
+
+	// Redundant UDP paths must be two proxy outbounds to one server
+	for i, inbound := range c.Inbounds {
+		r := inbound.RedundantUDP
+		if r == nil {
+			continue
+		}
+		if inbound.Type != "tun" {
+			return fmt.Errorf("inbound[%d] (%s): redundant_udp is only supported on tun inbounds", i, inbound.Tag)
+		}
+		if r.Primary == r.Secondary {
+			return fmt.Errorf("inbound[%d] (%s): redundant_udp primary and secondary must differ", i, inbound.Tag)
+		}
+		var exit [2]string
+		for j, tag := range []string{r.Primary, r.Secondary} {
+			out := c.findOutbound(tag)
+			if out == nil {
+				return fmt.Errorf("inbound[%d] (%s): redundant_udp references unknown outbound: %s", i, inbound.Tag, tag)
+			}
+			if out.Type != "ewp" && out.Type != "trojan" {
+				return fmt.Errorf("inbound[%d] (%s): redundant_udp outbound %s must be ewp or trojan, got %s", i, inbound.Tag, tag, out.Type)
+			}
+			if out.Transport != nil && out.Transport.Type == "masque" {
+				return fmt.Errorf("inbound[%d] (%s): redundant_udp outbound %s: masque transport not supported", i, inbound.Tag, tag)
+			}
+			exit[j] = out.Host
+			if exit[j] == "" {
+				exit[j] = out.Server
+			}
+		}
+		// Both copies must reach the same server, which merges them by sequence.
+		if !strings.EqualFold(exit[0], exit[1]) {
+			return fmt.Errorf("inbound[%d] (%s): redundant_udp primary and secondary must use the same server, got %s and %s",
+				i, inbound.Tag, exit[0], exit[1])
+		}
+		for _, p := range r.Port {
+			if p <= 0 || p > 65535 {
+				return fmt.Errorf("inbound[%d] (%s): redundant_udp invalid port %d", i, inbound.Tag, p)
+			}
+		}
+		for _, pr := range r.PortRange {
+			if _, _, err := ParsePortRange(pr); err != nil {
+				return fmt.Errorf("inbound[%d] (%s): redundant_udp: %w", i, inbound.Tag, err)
+			}
+		}
+	}
+
 	// Validate route
 	if c.Route != nil {
 		if c.Route.Final == "" {
@@ -327,12 +508,51 @@ func (c *RootConfig) Validate() error {
 			if !outboundTags[rule.Outbound] {
 				return fmt.Errorf("route.rules[%d]: references unknown outbound: %s", i, rule.Outbound)
 			}
+			for _, tag := range rule.Inbound {
+				if !inboundTags[tag] {
+					return fmt.Errorf("route.rules[%d]: references unknown inbound: %s", i, tag)
+				}
+			}
 		}
 	}
 
 	return nil
 }
 
+// OutboundForInbound returns the tag of the outbound an inbound is bound to:
+// the first route rule that selects on that inbound alone, else outbounds[0].
+// This is how several local ports map to different nodes in one process.
+func (c *RootConfig) OutboundForInbound(inboundTag string) string {
+	if c.Route != nil {
+		for _, rule := range c.Route.Rules {
+			if slices.Contains(rule.Inbound, inboundTag) && rule.inboundOnly() {
+				return rule.Outbound
+			}
+		}
+	}
+	if len(c.Outbounds) == 0 {
+		return ""
+	}
+	return c.Outbounds[0].Tag
+}
+
+// inboundOnly reports whether the rule has no selector besides inbound.
+func (r *RouteRule) inboundOnly() bool {
+	return len(r.Domain) == 0 && len(r.DomainSuffix) == 0 && len(r.DomainKeyword) == 0 &&
+		len(r.DomainRegex) == 0 && len(r.IPCidr) == 0 && len(r.SourceIPCidr) == 0 &&
+		len(r.Protocol) == 0 && len(r.Port) == 0 && len(r.PortRange) == 0
+}
+
+// findOutbound returns the outbound with the given tag, or nil.
+func (c *RootConfig) findOutbound(tag string) *OutboundConfig {
+	for i := range c.Outbounds {
+		if c.Outbounds[i].Tag == tag {
+			return &c.Outbounds[i]
+		}
+	}
+	return nil
+}
+
 // Validate validates an inbound configuration
 func (i *InboundConfig) Validate() error {
 	validTypes := map[string]bool{"mixed": true, "socks": true, "http": true, "tun": true}
@@ -363,6 +583,12 @@ func (i *InboundConfig) Validate() error {
 		if !validStacks[i.Stack] {
 			return fmt.Errorf("invalid stack: %s (valid: mixed, gvisor, system, or empty for auto)", i.Stack)
 		}
+		if i.Queues < 0 || i.Queues > constant.MaxTunQueues {
+			return fmt.Errorf("queues must be between 0 and %d", constant.MaxTunQueues)
+		}
+		if _, err := i.ExcludePrefixes(); err != nil {
+			return err
+		}
 		i.AutoRoute = true
 	}
 
@@ -371,7 +597,7 @@ func (i *InboundConfig) Validate() error {
 
 // Validate validates an outbound configuration
 func (o *OutboundConfig) Validate() error {
-	validTypes := map[string]bool{"ewp": true, "trojan": true, "direct": true, "block": true}
+	validTypes := map[string]bool{"ewp": true, "trojan": true, "urltest": true, "fallback": true, "balancer": true, "direct": true, "block": true}
 	if !validTypes[o.Type] {
 		return fmt.Errorf("invalid type: %s", o.Type)
 	}
@@ -419,6 +645,29 @@ func (o *OutboundConfig) Validate() error {
 			}
 		}
 
+	case "urltest", "fallback", "balancer":
+		if len(o.Outbounds) == 0 {
+			return fmt.Errorf("outbounds is required for %s outbound", o.Type)
+		}
+		if o.Interval != "" {
+			if d, err := time.ParseDuration(o.Interval); err != nil || d <= 0 {
+				return fmt.Errorf("invalid interval: %s", o.Interval)
+			}
+		}
+		if o.URL != "" && !strings.HasPrefix(o.URL, "http://") {
+			return fmt.Errorf("url must be http:// (probe runs plain HTTP through the tunnel)")
+		}
+		switch o.Strategy {
+		case "", "least-conn", "round-robin", "consistent-hash":
+		default:
+			return fmt.Errorf("invalid strategy: %s (must be least-conn, round-robin or consistent-hash)", o.Strategy)
+		}
+		for tag, w := range o.Weights {
+			if w <= 0 {
+				return fmt.Errorf("weight for %s must be positive, got %d", tag, w)
+			}
+		}
+
 	case "direct", "block":
 		// No additional validation needed
 	}
@@ -2,128 +2,391 @@ package http
 
 import (
 	"bufio"
+	"errors"
 	"fmt"
 	"io"
 	"net"
+	"net/http"
+	"net/textproto"
 	"strings"
+	"sync"
+	"time"
 
 	"ewp-core/log"
 )
 
-type Request struct {
-	Method      string
-	URL         string
-	Version     string
-	Headers     map[string]string
-	HeaderLines []string
-	Target      string
-	Path        string
-	IsConnect   bool
+const (
+	// keepAliveTimeout closes a client connection idle between requests.
+	keepAliveTimeout = 90 * time.Second
+
+	// maxOrigins bounds the origin tunnels one client connection keeps
+	// open; the least recently used is closed beyond it.
+	maxOrigins = 4
+
+	upstreamBufferSize = 32 * 1024
+)
+
+// DialOrigin opens a tunnel to target ("host:port"). firstData is the start
+// of the first request and should travel with the tunnel's connect
+// request, saving a round trip.
+type DialOrigin func(target string, firstData []byte) (io.ReadWriteCloser, error)
+
+// hopHeaders are the hop-by-hop headers of RFC 9110 §7.6.1, plus the
+// Proxy-Connection header legacy clients still send. They describe one
+// connection and are never forwarded.
+var hopHeaders = []string{
+	"Connection",
+	"Proxy-Connection",
+	"Keep-Alive",
+	"Proxy-Authenticate",
+	"Proxy-Authorization",
+	"Te",
+	"Trailer",
+	"Transfer-Encoding",
+	"Upgrade",
+}
+
+var upstreamWriterPool = sync.Pool{
+	New: func() any { return bufio.NewWriterSize(nil, upstreamBufferSize) },
+}
+
+// HandleConnection serves an HTTP proxy client. CONNECT hands the
+// connection to onConnect. Plain HTTP requests are served on a persistent
+// connection: requests are read one after another (so pipelined requests
+// are answered in order), forwarded with their hop-by-hop headers removed,
+// and each origin's tunnel is reused by later requests to it for as long as
+// the origin keeps the connection alive.
+func HandleConnection(conn net.Conn, reader *bufio.Reader, onConnect func(net.Conn, string) error, dial DialOrigin) error {
+	p := &proxyConn{
+		conn:       conn,
+		reader:     reader,
+		clientAddr: conn.RemoteAddr().String(),
+		dial:       dial,
+	}
+	defer p.closeOrigins()
+
+	for served := 0; ; served++ {
+		if served > 0 {
+			conn.SetReadDeadline(time.Now().Add(keepAliveTimeout))
+		}
+		req, err := http.ReadRequest(reader)
+		if err != nil {
+			if served > 0 && isIdleClose(err) {
+				return nil
+			}
+			if served == 0 {
+				conn.Write([]byte("HTTP/1.1 400 Bad Request\r\nConnection: close\r\n\r\n"))
+			}
+			return err
+		}
+		conn.SetDeadline(time.Time{})
+
+		if req.Method == http.MethodConnect {
+			log.V("[HTTP-CONNECT] %s -> %s", p.clientAddr, req.RequestURI)
+			p.closeOrigins()
+			return onConnect(conn, req.RequestURI)
+		}
+
+		log.V("[HTTP-%s] %s -> %s", req.Method, p.clientAddr, req.URL)
+		keep, err := p.serve(req)
+		if err != nil || !keep {
+			return err
+		}
+	}
+}
+
+func isIdleClose(err error) bool {
+	if errors.Is(err, io.EOF) {
+		return true
+	}
+	var ne net.Error
+	return errors.As(err, &ne) && ne.Timeout()
+}
+
+// origin is a tunnel to one origin server, reused across requests.
+type origin struct {
+	target string
+	conn   io.ReadWriteCloser
+	reader *bufio.Reader
 }
 
-func HandleConnection(conn net.Conn, reader *bufio.Reader, onConnect func(net.Conn, string) error, onProxy func(net.Conn, string, string) error) error {
-	clientAddr := conn.RemoteAddr().String()
+type proxyConn struct {
+	conn       net.Conn
+	reader     *bufio.Reader
+	clientAddr string
+	dial       DialOrigin
 
-	requestLine, err := reader.ReadString('\n')
+	origins []*origin // most recently used last
+}
+
+func (p *proxyConn) closeOrigins() {
+	for _, o := range p.origins {
+		o.conn.Close()
+	}
+	p.origins = nil
+}
+
+func (p *proxyConn) takeOrigin(target string) *origin {
+	for i, o := range p.origins {
+		if o.target == target {
+			p.origins = append(p.origins[:i], p.origins[i+1:]...)
+			return o
+		}
+	}
+	return nil
+}
+
+func (p *proxyConn) putOrigin(o *origin) {
+	if len(p.origins) == maxOrigins {
+		p.origins[0].conn.Close()
+		p.origins = p.origins[1:]
+	}
+	p.origins = append(p.origins, o)
+}
+
+// serve forwards one request and its response. It reports whether the
+// client connection can carry another request.
+func (p *proxyConn) serve(req *http.Request) (bool, error) {
+	target, err := requestTarget(req)
 	if err != nil {
-		return err
+		p.writeError(http.StatusBadRequest)
+		return false, err
+	}
+
+	keepClient := wantsKeepAlive(req)
+	upgrade := upgradeType(req.Header)
+	removeHopHeaders(req.Header)
+	if upgrade != "" {
+		req.Header.Set("Connection", "Upgrade")
+		req.Header.Set("Upgrade", upgrade)
+	}
+	// Request.Write would otherwise add Go's default User-Agent.
+	if _, ok := req.Header["User-Agent"]; !ok {
+		req.Header["User-Agent"] = []string{""}
+	}
+	// The body is streamed to the origin as it is read, so answer
+	// 100-continue here rather than leave the client waiting for it.
+	if hasToken(req.Header.Values("Expect"), "100-continue") {
+		req.Header.Del("Expect")
+		if _, err := io.WriteString(p.conn, "HTTP/1.1 100 Continue\r\n\r\n"); err != nil {
+			return false, err
+		}
+	}
+	req.Close = false
+
+	o, resp, err := p.roundTrip(target, req)
+	if err != nil {
+		p.writeError(http.StatusBadGateway)
+		return false, err
 	}
 
-	parts := strings.Fields(requestLine)
-	if len(parts) < 3 {
-		return fmt.Errorf("invalid HTTP request line")
+	if resp.StatusCode == http.StatusSwitchingProtocols && upgrade != "" {
+		return false, p.relayUpgraded(o, resp)
 	}
 
-	req := &Request{
-		Method:  parts[0],
-		URL:     parts[1],
-		Version: parts[2],
-		Headers: make(map[string]string),
+	keepOrigin := !resp.Close
+	removeHopHeaders(resp.Header)
+	switch {
+	case resp.ContentLength < 0 && len(resp.TransferEncoding) == 0 && resp.Body != http.NoBody:
+		// The origin delimits the body by closing; so must we.
+		keepClient = false
+	case !req.ProtoAtLeast(1, 1) && len(resp.TransferEncoding) > 0:
+		// HTTP/1.0 clients cannot read chunked bodies: stream it raw
+		// and delimit by closing.
+		resp.TransferEncoding = nil
+		resp.ContentLength = -1
+		keepClient = false
+	case keepClient && !req.ProtoAtLeast(1, 1):
+		resp.Header.Set("Connection", "keep-alive")
 	}
+	resp.Close = !keepClient
 
+	err = resp.Write(p.conn)
+	resp.Body.Close()
+	if err != nil {
+		o.conn.Close()
+		return false, err
+	}
+	if keepOrigin {
+		p.putOrigin(o)
+	} else {
+		o.conn.Close()
+	}
+	return keepClient, nil
+}
+
+// roundTrip sends req on the origin's tunnel and reads the final response,
+// passing interim 1xx responses to the client. A reused tunnel the origin
+// has closed in the meantime is replaced once when the request can be
+// replayed.
+func (p *proxyConn) roundTrip(target string, req *http.Request) (*origin, *http.Response, error) {
+	o := p.takeOrigin(target)
+	reused := o != nil
 	for {
-		line, err := reader.ReadString('\n')
-		if err != nil {
-			return err
+		if o == nil {
+			o = &origin{target: target}
+		}
+		resp, err := p.send(o, req)
+		if err == nil {
+			return o, resp, nil
 		}
-		line = strings.TrimRight(line, "\r\n")
-		if line == "" {
-			break
+		if o.conn != nil {
+			o.conn.Close()
 		}
-		req.HeaderLines = append(req.HeaderLines, line)
-		if idx := strings.Index(line, ":"); idx > 0 {
-			key := strings.TrimSpace(line[:idx])
-			value := strings.TrimSpace(line[idx+1:])
-			req.Headers[strings.ToLower(key)] = value
+		if !reused || req.Body != http.NoBody || !idempotent(req.Method) {
+			return nil, nil, err
 		}
+		log.V("[HTTP] %s stale tunnel to %s, redialling: %v", p.clientAddr, target, err)
+		o, reused = nil, false
 	}
+}
 
-	switch req.Method {
-	case "CONNECT":
-		log.V("[HTTP-CONNECT] %s -> %s", clientAddr, req.URL)
-		return onConnect(conn, req.URL)
+func idempotent(method string) bool {
+	switch method {
+	case http.MethodGet, http.MethodHead, http.MethodOptions, http.MethodTrace, http.MethodPut, http.MethodDelete:
+		return true
+	}
+	return false
+}
 
-	case "GET", "POST", "PUT", "DELETE", "HEAD", "OPTIONS", "PATCH", "TRACE":
-		log.V("[HTTP-%s] %s -> %s", req.Method, clientAddr, req.URL)
+func (p *proxyConn) send(o *origin, req *http.Request) (*http.Response, error) {
+	w := upstreamWriterPool.Get().(*bufio.Writer)
+	defer upstreamWriterPool.Put(w)
 
-		var target, path string
+	if o.conn != nil {
+		w.Reset(o.conn)
+	} else {
+		// The first buffered chunk (headers and a small body) is handed to
+		// the dialler so it rides on the tunnel connect.
+		w.Reset(&lazyOrigin{o: o, dial: p.dial})
+	}
+	err := req.Write(w)
+	if err == nil {
+		err = w.Flush()
+	}
+	w.Reset(nil)
+	if err != nil {
+		return nil, err
+	}
+	if o.reader == nil {
+		o.reader = bufio.NewReader(o.conn)
+	}
 
-		if strings.HasPrefix(req.URL, "http://") {
-			urlWithoutScheme := strings.TrimPrefix(req.URL, "http://")
-			idx := strings.Index(urlWithoutScheme, "/")
-			if idx > 0 {
-				target = urlWithoutScheme[:idx]
-				path = urlWithoutScheme[idx:]
-			} else {
-				target = urlWithoutScheme
-				path = "/"
-			}
-		} else {
-			target = req.Headers["host"]
-			path = req.URL
+	for {
+		resp, err := http.ReadResponse(o.reader, req)
+		if err != nil {
+			return nil, err
 		}
-
-		if target == "" {
-			conn.Write([]byte("HTTP/1.1 400 Bad Request\r\n\r\n"))
-			return fmt.Errorf("missing target host")
+		if resp.StatusCode >= 200 || resp.StatusCode == http.StatusSwitchingProtocols {
+			return resp, nil
 		}
+		if err := resp.Write(p.conn); err != nil {
+			return nil, err
+		}
+	}
+}
 
-		if !strings.Contains(target, ":") {
-			target += ":80"
+// lazyOrigin dials the origin on its first write.
+type lazyOrigin struct {
+	o    *origin
+	dial DialOrigin
+}
+
+func (l *lazyOrigin) Write(b []byte) (int, error) {
+	if l.o.conn != nil {
+		return l.o.conn.Write(b)
+	}
+	conn, err := l.dial(l.o.target, b)
+	if err != nil {
+		return 0, err
+	}
+	l.o.conn = conn
+	return len(b), nil
+}
+
+// relayUpgraded passes a 101 response to the client and then relays raw
+// bytes both ways (WebSocket over a plain HTTP proxy).
+func (p *proxyConn) relayUpgraded(o *origin, resp *http.Response) error {
+	defer o.conn.Close()
+	if err := resp.Write(p.conn); err != nil {
+		return err
+	}
+	done := make(chan struct{})
+	go func() {
+		io.Copy(p.conn, o.reader)
+		p.conn.Close()
+		close(done)
+	}()
+	io.Copy(o.conn, p.reader)
+	o.conn.Close()
+	<-done
+	return nil
+}
+
+func (p *proxyConn) writeError(code int) {
+	fmt.Fprintf(p.conn, "HTTP/1.1 %d %s\r\nContent-Length: 0\r\nConnection: close\r\n\r\n", code, http.StatusText(code))
+}
+
+// requestTarget returns "host:port" for an absolute-form or origin-form
+// request.
+func requestTarget(req *http.Request) (string, error) {
+	host := req.Host
+	if req.URL.IsAbs() {
+		if req.URL.Scheme != "http" {
+			return "", fmt.Errorf("unsupported scheme %q", req.URL.Scheme)
 		}
+		host = req.URL.Host
+	}
+	if host == "" {
+		return "", fmt.Errorf("missing target host")
+	}
+	if _, _, err := net.SplitHostPort(host); err != nil {
+		host = net.JoinHostPort(strings.Trim(host, "[]"), "80")
+	}
+	return host, nil
+}
+
+// wantsKeepAlive reports whether the client asked to keep the connection
+// open. HTTP/1.0 clients opt in with Connection or Proxy-Connection
+// keep-alive; HTTP/1.1 clients opt out with close in either.
+func wantsKeepAlive(req *http.Request) bool {
+	tokens := append(req.Header.Values("Connection"), req.Header.Values("Proxy-Connection")...)
+	if req.ProtoAtLeast(1, 1) {
+		return !hasToken(tokens, "close")
+	}
+	return hasToken(tokens, "keep-alive")
+}
 
-		var requestBuilder strings.Builder
-		requestBuilder.WriteString(fmt.Sprintf("%s %s %s\r\n", req.Method, path, req.Version))
+func upgradeType(h http.Header) string {
+	if !hasToken(h.Values("Connection"), "upgrade") {
+		return ""
+	}
+	return h.Get("Upgrade")
+}
 
-		for _, line := range req.HeaderLines {
-			key := strings.Split(line, ":")[0]
-			keyLower := strings.ToLower(strings.TrimSpace(key))
-			if keyLower != "proxy-connection" && keyLower != "proxy-authorization" {
-				requestBuilder.WriteString(line)
-				requestBuilder.WriteString("\r\n")
+// removeHopHeaders deletes hopHeaders and any header named in Connection.
+func removeHopHeaders(h http.Header) {
+	for _, v := range h.Values("Connection") {
+		for _, name := range strings.Split(v, ",") {
+			if name = textproto.TrimString(name); name != "" {
+				h.Del(name)
 			}
 		}
-		requestBuilder.WriteString("\r\n")
+	}
+	for _, name := range hopHeaders {
+		h.Del(name)
+	}
+}
 
-		if contentLength := req.Headers["content-length"]; contentLength != "" {
-			var length int
-			fmt.Sscanf(contentLength, "%d", &length)
-			if length > 0 && length < 10*1024*1024 {
-				body := make([]byte, length)
-				if _, err := io.ReadFull(reader, body); err == nil {
-					requestBuilder.Write(body)
-				}
+func hasToken(values []string, token string) bool {
+	for _, v := range values {
+		for _, t := range strings.Split(v, ",") {
+			if strings.EqualFold(textproto.TrimString(t), token) {
+				return true
 			}
 		}
-
-		firstFrame := requestBuilder.String()
-		return onProxy(conn, target, firstFrame)
-
-	default:
-		log.Printf("[HTTP] %s unsupported method: %s", clientAddr, req.Method)
-		conn.Write([]byte("HTTP/1.1 405 Method Not Allowed\r\n\r\n"))
-		return fmt.Errorf("unsupported method: %s", req.Method)
 	}
+	return false
 }
 
 func SendConnectSuccess(conn net.Conn) error {
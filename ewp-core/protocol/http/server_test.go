@@ -0,0 +1,208 @@
+package http
+
+import (
+	"bufio"
+	"bytes"
+	"io"
+	"net"
+	"net/http"
+	"strconv"
+	"strings"
+	"sync"
+	"sync/atomic"
+	"testing"
+	"time"
+)
+
+// fakeOrigin is an in-memory origin server reached through a pipe, standing
+// in for a tunnel. Each dial gets its own connection; handler answers the
+// requests read on it.
+type fakeOrigin struct {
+	dials   atomic.Int32
+	handler func(req *http.Request, w io.Writer) (keep bool)
+
+	mu    sync.Mutex
+	conns []net.Conn
+	seen  []*http.Request
+}
+
+func (f *fakeOrigin) dial(target string, firstData []byte) (io.ReadWriteCloser, error) {
+	f.dials.Add(1)
+	client, server := net.Pipe()
+	f.mu.Lock()
+	f.conns = append(f.conns, server)
+	f.mu.Unlock()
+	go f.serve(server)
+	if _, err := client.Write(firstData); err != nil {
+		return nil, err
+	}
+	return client, nil
+}
+
+func (f *fakeOrigin) serve(conn net.Conn) {
+	defer conn.Close()
+	r := bufio.NewReader(conn)
+	for {
+		req, err := http.ReadRequest(r)
+		if err != nil {
+			return
+		}
+		body, _ := io.ReadAll(req.Body)
+		req.Body = io.NopCloser(bytes.NewReader(body))
+		f.mu.Lock()
+		f.seen = append(f.seen, req)
+		f.mu.Unlock()
+		if !f.handler(req, conn) {
+			return
+		}
+	}
+}
+
+// closeIdle drops every origin connection, as an origin's idle timeout
+// would.
+func (f *fakeOrigin) closeIdle() {
+	f.mu.Lock()
+	defer f.mu.Unlock()
+	for _, c := range f.conns {
+		c.Close()
+	}
+	f.conns = nil
+}
+
+func echoPath(req *http.Request, w io.Writer) bool {
+	body := req.URL.Path
+	io.WriteString(w, "HTTP/1.1 200 OK\r\nContent-Length: "+strconv.Itoa(len(body))+"\r\nX-Hop: drop\r\nConnection: X-Hop\r\n\r\n"+body)
+	return true
+}
+
+// startProxy runs HandleConnection on one end of a pipe and returns the
+// client end with a reader for responses.
+func startProxy(tb testing.TB, origin *fakeOrigin) (net.Conn, *bufio.Reader, chan error) {
+	tb.Helper()
+	server, client := net.Pipe()
+	done := make(chan error, 1)
+	go func() {
+		done <- HandleConnection(server, bufio.NewReader(server), func(net.Conn, string) error { return nil }, origin.dial)
+		server.Close()
+	}()
+	tb.Cleanup(func() { client.Close() })
+	return client, bufio.NewReader(client), done
+}
+
+func readBody(tb testing.TB, r *bufio.Reader, method string) (*http.Response, string) {
+	tb.Helper()
+	resp, err := http.ReadResponse(r, &http.Request{Method: method})
+	if err != nil {
+		tb.Fatal(err)
+	}
+	body, err := io.ReadAll(resp.Body)
+	if err != nil {
+		tb.Fatal(err)
+	}
+	return resp, string(body)
+}
+
+func TestKeepAliveReusesOrigin(t *testing.T) {
+	origin := &fakeOrigin{handler: echoPath}
+	conn, r, _ := startProxy(t, origin)
+
+	for _, path := range []string{"/a", "/b", "/c"} {
+		go io.WriteString(conn, "GET http://example.com"+path+" HTTP/1.1\r\nHost: example.com\r\nProxy-Connection: keep-alive\r\n\r\n")
+		resp, body := readBody(t, r, "GET")
+		if body != path {
+			t.Errorf("body %q, want %q", body, path)
+		}
+		if resp.Close {
+			t.Errorf("%s: proxy closed the client connection", path)
+		}
+		if resp.Header.Get("X-Hop") != "" {
+			t.Errorf("%s: header named in Connection was forwarded", path)
+		}
+	}
+	if n := origin.dials.Load(); n != 1 {
+		t.Errorf("dials = %d, want 1", n)
+	}
+	for _, req := range origin.seen {
+		if req.Header.Get("Proxy-Connection") != "" {
+			t.Error("Proxy-Connection forwarded to origin")
+		}
+		if req.RequestURI[0] != '/' {
+			t.Errorf("origin got request-target %q, want origin-form", req.RequestURI)
+		}
+	}
+}
+
+func TestPipelinedRequestsAnsweredInOrder(t *testing.T) {
+	origin := &fakeOrigin{handler: echoPath}
+	conn, r, _ := startProxy(t, origin)
+
+	var batch strings.Builder
+	paths := []string{"/1", "/2", "/3", "/4"}
+	for _, p := range paths {
+		batch.WriteString("GET http://example.com" + p + " HTTP/1.1\r\nHost: example.com\r\n\r\n")
+	}
+	go io.WriteString(conn, batch.String())
+
+	for _, p := range paths {
+		if _, body := readBody(t, r, "GET"); body != p {
+			t.Fatalf("got %q, want %q", body, p)
+		}
+	}
+}
+
+func TestHTTP10ClientIsClosed(t *testing.T) {
+	origin := &fakeOrigin{handler: func(req *http.Request, w io.Writer) bool {
+		io.WriteString(w, "HTTP/1.1 200 OK\r\nTransfer-Encoding: chunked\r\n\r\n5\r\nhello\r\n0\r\n\r\n")
+		return true
+	}}
+	conn, r, done := startProxy(t, origin)
+
+	go io.WriteString(conn, "GET http://example.com/ HTTP/1.0\r\nHost: example.com\r\n\r\n")
+	resp, body := readBody(t, r, "GET")
+	if body != "hello" {
+		t.Errorf("body %q", body)
+	}
+	if len(resp.TransferEncoding) != 0 {
+		t.Errorf("chunked response sent to an HTTP/1.0 client")
+	}
+	select {
+	case err := <-done:
+		if err != nil {
+			t.Errorf("HandleConnection: %v", err)
+		}
+	case <-time.After(5 * time.Second):
+		t.Fatal("connection kept open for an HTTP/1.0 client")
+	}
+}
+
+func TestStaleOriginRedialled(t *testing.T) {
+	origin := &fakeOrigin{handler: echoPath}
+	conn, r, _ := startProxy(t, origin)
+
+	go io.WriteString(conn, "GET http://example.com/first HTTP/1.1\r\nHost: example.com\r\n\r\n")
+	readBody(t, r, "GET")
+	origin.closeIdle()
+
+	go io.WriteString(conn, "GET http://example.com/second HTTP/1.1\r\nHost: example.com\r\n\r\n")
+	if _, body := readBody(t, r, "GET"); body != "/second" {
+		t.Errorf("body %q", body)
+	}
+	if n := origin.dials.Load(); n != 2 {
+		t.Errorf("dials = %d, want 2", n)
+	}
+}
+
+func TestRemoveHopHeaders(t *testing.T) {
+	h := http.Header{
+		"Connection":       {"keep-alive, X-Custom"},
+		"Keep-Alive":       {"timeout=5"},
+		"X-Custom":         {"1"},
+		"Proxy-Connection": {"keep-alive"},
+		"Te":               {"trailers"},
+		"Accept":           {"*/*"},
+	}
+	removeHopHeaders(h)
+	if len(h) != 1 || h.Get("Accept") == "" {
+		t.Errorf("left %v", h)
+	}
+}
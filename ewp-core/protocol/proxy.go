@@ -10,6 +10,7 @@ import (
 
 	"ewp-core/log"
 	"ewp-core/transport"
+	"ewp-core/transport/conntrack"
 )
 
 var (
@@ -26,6 +27,7 @@ var (
 
 type TunnelHandler struct {
 	transport transport.Transport
+	tag       string // inbound tag, shown in the connection registry
 }
 
 func NewTunnelHandler(trans transport.Transport) *TunnelHandler {
@@ -38,7 +40,7 @@ func (h *TunnelHandler) HandleTunnel(conn net.Conn, target string, clientAddr st
 	atomic.AddInt64(&activeConns, 1)
 	defer atomic.AddInt64(&activeConns, -1)
 
-	tunnelConn, err := h.transport.Dial()
+	tunnelConn, err := h.dialTracked(clientAddr)
 	if err != nil {
 		return err
 	}
@@ -109,11 +111,82 @@ func (h *TunnelHandler) HandleTunnel(conn net.Conn, target string, clientAddr st
 	return nil
 }
 
+// DialOrigin opens a tunnel to target for the plain HTTP proxy, sending
+// firstData with the connect request. The returned stream counts towards
+// the traffic statistics and keeps the tunnel pinged until closed.
+func (h *TunnelHandler) DialOrigin(target, clientAddr string, firstData []byte) (io.ReadWriteCloser, error) {
+	tunnelConn, err := h.dialTracked(clientAddr)
+	if err != nil {
+		return nil, err
+	}
+	stopPing := tunnelConn.StartPing(30 * time.Second)
+	if err := tunnelConn.Connect(target, firstData); err != nil {
+		if stopPing != nil {
+			close(stopPing)
+		}
+		tunnelConn.Close()
+		return nil, err
+	}
+	atomic.AddInt64(&activeConns, 1)
+	atomic.AddInt64(&totalUpload, int64(len(firstData)))
+	log.V("[Proxy] %s connected: %s", clientAddr, target)
+	return &originConn{TunnelConn: tunnelConn, stopPing: stopPing}, nil
+}
+
+// originConn adapts a connected TunnelConn to io.ReadWriteCloser.
+type originConn struct {
+	transport.TunnelConn
+	stopPing  chan struct{}
+	closeOnce sync.Once
+}
+
+func (c *originConn) Read(p []byte) (int, error) {
+	n, err := c.TunnelConn.Read(p)
+	atomic.AddInt64(&totalDownload, int64(n))
+	return n, err
+}
+
+func (c *originConn) Write(p []byte) (int, error) {
+	if err := c.TunnelConn.Write(p); err != nil {
+		return 0, err
+	}
+	atomic.AddInt64(&totalUpload, int64(len(p)))
+	return len(p), nil
+}
+
+func (c *originConn) Close() error {
+	err := net.ErrClosed
+	c.closeOnce.Do(func() {
+		if c.stopPing != nil {
+			close(c.stopPing)
+		}
+		atomic.AddInt64(&activeConns, -1)
+		err = c.TunnelConn.Close()
+	})
+	return err
+}
+
 // Dial creates a new tunnel connection for UDP sessions.
 func (h *TunnelHandler) Dial() (transport.TunnelConn, error) {
 	return h.transport.Dial()
 }
 
+// dialTracked dials a tunnel that is listed in the connection registry
+// once connected, so the controller can show and close it.
+func (h *TunnelHandler) dialTracked(clientAddr string) (transport.TunnelConn, error) {
+	start := time.Now()
+	conn, err := h.transport.Dial()
+	if err != nil {
+		return nil, err
+	}
+	return conntrack.Wrap(conn, conntrack.Meta{
+		Inbound:   h.tag,
+		Source:    clientAddr,
+		Transport: h.transport.Name(),
+		DialStart: start,
+	}), nil
+}
+
 func IsNormalCloseError(err error) bool {
 	if err == nil {
 		return false
@@ -0,0 +1,67 @@
+package redundant
+
+import (
+	"bytes"
+	"testing"
+)
+
+func TestHeaderRoundTrip(t *testing.T) {
+	b := AppendHeader(nil, 0x0102030405060708, 0xfffffffe)
+	if len(b) != HeaderLen {
+		t.Fatalf("header is %d bytes, want %d", len(b), HeaderLen)
+	}
+	b = append(b, "payload"...)
+	flow, seq, payload, ok := Parse(b)
+	if !ok || flow != 0x0102030405060708 || seq != 0xfffffffe || string(payload) != "payload" {
+		t.Fatalf("Parse = %x, %d, %q, %v", flow, seq, payload, ok)
+	}
+
+	for _, plain := range [][]byte{nil, []byte("short"), bytes.Repeat([]byte{0xe7}, 64)} {
+		if _, _, payload, ok := Parse(plain); ok || !bytes.Equal(payload, plain) {
+			t.Errorf("Parse(%q) accepted a plain datagram", plain)
+		}
+	}
+}
+
+func TestWindowAdmit(t *testing.T) {
+	tests := []struct {
+		name string
+		seqs []uint32
+		want []bool
+	}{
+		{"in order", []uint32{1, 2, 3}, []bool{true, true, true}},
+		{"duplicates", []uint32{1, 1, 2, 2, 1}, []bool{true, false, true, false, false}},
+		{"reordered", []uint32{5, 3, 4, 3, 5}, []bool{true, true, true, false, false}},
+		{"gap clears stale bits", []uint32{0, 1000, 1030, 1024}, []bool{true, true, true, true}},
+		{"jump past window", []uint32{0, 5000, 0, 4999}, []bool{true, true, false, true}},
+		{"too old", []uint32{2000, 976, 977}, []bool{true, false, true}},
+		{"wraps", []uint32{0xffffffff, 0, 0xffffffff, 1, 0}, []bool{true, true, false, true, false}},
+	}
+	for _, tt := range tests {
+		t.Run(tt.name, func(t *testing.T) {
+			var w Window
+			for i, seq := range tt.seqs {
+				if got := w.Admit(seq); got != tt.want[i] {
+					t.Fatalf("Admit(%d) at step %d = %v, want %v", seq, i, got, tt.want[i])
+				}
+			}
+		})
+	}
+}
+
+func TestWindowInterleavedCopies(t *testing.T) {
+	var w Window
+	delivered := 0
+	// The second path lags the first by up to 100 packets.
+	for i := uint32(0); i < 10000; i++ {
+		if w.Admit(i) {
+			delivered++
+		}
+		if i >= 100 && w.Admit(i-100) {
+			t.Fatalf("late copy of %d admitted", i-100)
+		}
+	}
+	if delivered != 10000 {
+		t.Fatalf("delivered %d, want 10000", delivered)
+	}
+}
@@ -2,6 +2,7 @@ package protocol
 
 import (
 	"bufio"
+	"io"
 	"net"
 	"time"
 
@@ -37,6 +38,11 @@ func NewServer(listenAddr string, trans transport.Transport, dnsServer string, u
 	return s
 }
 
+// SetTag names the inbound this server belongs to in the connection registry.
+func (s *Server) SetTag(tag string) {
+	s.tunnelHandler.tag = tag
+}
+
 func (s *Server) Run() error {
 	listener, err := commonnet.ListenTFO("tcp", s.listenAddr)
 	if err != nil {
@@ -102,7 +108,10 @@ func (s *Server) handleSOCKS(conn net.Conn, reader *bufio.Reader, clientAddr str
 		dnsHandler := func(dnsQuery []byte) ([]byte, error) {
 			return s.dnsClient.QueryRaw(dnsQuery)
 		}
-		return socks5.HandleUDPAssociate(conn, clientAddr, dnsHandler, s.tunnelHandler.Dial)
+		dialFn := func() (transport.TunnelConn, error) {
+			return s.tunnelHandler.dialTracked(clientAddr)
+		}
+		return socks5.HandleUDPAssociate(conn, clientAddr, dnsHandler, dialFn)
 	}
 
 	if err := socks5.HandleConnection(conn, reader, s.users, onConnect, onUDPAssociate); err != nil {
@@ -119,13 +128,11 @@ func (s *Server) handleHTTP(conn net.Conn, reader *bufio.Reader, clientAddr stri
 		})
 	}
 
-	onProxy := func(conn net.Conn, target string, firstFrame string) error {
-		return s.tunnelHandler.HandleTunnel(conn, target, clientAddr, []byte(firstFrame), func() error {
-			return nil
-		})
+	dialOrigin := func(target string, firstData []byte) (io.ReadWriteCloser, error) {
+		return s.tunnelHandler.DialOrigin(target, clientAddr, firstData)
 	}
 
-	if err := httpproxy.HandleConnection(conn, reader, onConnect, onProxy); err != nil {
+	if err := httpproxy.HandleConnection(conn, reader, onConnect, dialOrigin); err != nil {
 		if !IsNormalCloseError(err) {
 			log.Printf("[HTTP] %s proxy failed: %v", clientAddr, err)
 		}
@@ -1,110 +1,113 @@
 package socks5
 
 import (
-	"fmt"
+	"bytes"
+	"encoding/binary"
+	"errors"
 	"net"
 	"net/netip"
 	"sync"
 	"sync/atomic"
 	"time"
 
+	"golang.org/x/net/ipv4"
+
 	commpool "ewp-core/common/bufferpool"
+	"ewp-core/constant"
 	"ewp-core/log"
 	"ewp-core/transport"
 )
 
-const udpSessionIdleTimeout = 5 * time.Minute
+const (
+	udpSessionIdleTimeout = 5 * time.Minute
 
-// udpSession holds a persistent tunnel connection for one UDP destination.
-type udpSession struct {
-	tunnelConn transport.TunnelConn
-	stopPing   chan struct{}
-	lastActive time.Time
-	mu         sync.Mutex
-}
+	// udpBatchSize is the number of datagrams moved per recvmmsg / sendmmsg
+	// on the local socket (one per call on platforms without them).
+	udpBatchSize = 8
 
-func (s *udpSession) touch() {
-	s.mu.Lock()
-	s.lastActive = time.Now()
-	s.mu.Unlock()
-}
+	// udpReplyQueue bounds the replies waiting for the batched writer;
+	// beyond it tunnel readers drop, as a UDP socket would.
+	udpReplyQueue = 64
 
-func (s *udpSession) close() {
-	select {
-	case <-s.stopPing:
-	default:
-		close(s.stopPing)
-	}
-	s.tunnelConn.Close()
-}
+	// maxUDPHeaderLen is the longest SOCKS5 UDP request header (domain
+	// address). Reply buffers reserve it in front of the payload.
+	maxUDPHeaderLen = 4 + 1 + 255 + 2
+)
 
-// sessionMap manages per-destination UDP sessions.
-type sessionMap struct {
-	mu       sync.Mutex
-	sessions map[string]*udpSession
+var errAssociationClosed = errors.New("udp association closed")
+
+// sharedKey indexes the tunnel that carries every IP destination of an
+// association. EWP and Trojan frame each UDP packet with its target
+// address, so one tunnel serves any number of peers. Domain targets can only
+// be named in ConnectUDP and get a tunnel each, as does every target once
+// the transport turns out to be pinned (MASQUE).
+var sharedKey = transport.Endpoint{}
+
+// udpTunnel is one tunnel of an association.
+type udpTunnel struct {
+	conn   transport.TunnelConn
+	target transport.Endpoint // ConnectUDP target
+	pinned bool               // carries only target
+
+	// header is the SOCKS5 address header echoed on replies from a domain
+	// tunnel, so the client can match them to the name it sent to. IP
+	// tunnels build it from each reply's source address instead.
+	header []byte
+
+	ready      chan struct{} // closed once connected or failed
+	err        error
+	up         atomic.Bool
+	stopPing   chan struct{}
+	lastActive atomic.Int64
+	closeOnce  sync.Once
 }
 
-func newSessionMap() *sessionMap {
-	return &sessionMap{sessions: make(map[string]*udpSession)}
+func (t *udpTunnel) touch() {
+	t.lastActive.Store(time.Now().UnixNano())
 }
 
-func (m *sessionMap) getOrCreate(target string, dialFn func() (transport.TunnelConn, error)) (*udpSession, bool, error) {
-	m.mu.Lock()
-	defer m.mu.Unlock()
-
-	if s, ok := m.sessions[target]; ok {
-		return s, false, nil
-	}
-
-	conn, err := dialFn()
-	if err != nil {
-		return nil, true, fmt.Errorf("dial tunnel: %w", err)
-	}
-
-	stopPing := conn.StartPing(30 * time.Second)
-	s := &udpSession{
-		tunnelConn: conn,
-		stopPing:   stopPing,
-		lastActive: time.Now(),
-	}
-	m.sessions[target] = s
-	return s, true, nil
+func (t *udpTunnel) close() {
+	t.closeOnce.Do(func() {
+		if t.stopPing != nil {
+			close(t.stopPing)
+		}
+		t.conn.Close()
+	})
 }
 
-func (m *sessionMap) closeAll() {
-	m.mu.Lock()
-	defer m.mu.Unlock()
-	for _, s := range m.sessions {
-		s.close()
-	}
-	m.sessions = make(map[string]*udpSession)
+// udpAssociation is the state of one UDP ASSOCIATE: the local relay socket,
+// its tunnels and the batched reply writer.
+type udpAssociation struct {
+	udpConn    *net.UDPConn
+	pc         *ipv4.PacketConn
+	clientAddr string
+	clientIP   netip.Addr
+	dnsHandler func([]byte) ([]byte, error)
+	dialFn     func() (transport.TunnelConn, error)
+
+	lastSender atomic.Pointer[net.UDPAddr]
+	replies    chan udpReply
+	done       chan struct{}
+
+	mu      sync.Mutex
+	tunnels map[transport.Endpoint]*udpTunnel
+	pinned  bool // the transport cannot multiplex: key every IP target
+	closed  bool
 }
 
-func (m *sessionMap) get(target string) (*udpSession, bool) {
-	m.mu.Lock()
-	s, ok := m.sessions[target]
-	m.mu.Unlock()
-	return s, ok
+// udpReply is a queued reply: (*buf)[start:end] is header plus payload.
+type udpReply struct {
+	buf        *[]byte
+	start, end int
 }
 
-func (m *sessionMap) closeIdle() {
-	m.mu.Lock()
-	now := time.Now()
-	var idle []*udpSession
-	for target, s := range m.sessions {
-		s.mu.Lock()
-		expired := now.Sub(s.lastActive) > udpSessionIdleTimeout
-		s.mu.Unlock()
-		if expired {
-			idle = append(idle, s)
-			delete(m.sessions, target)
-			log.V("[UDP] Session idle-expired: %s", target)
-		}
-	}
-	m.mu.Unlock()
-	for _, s := range idle {
-		s.close()
-	}
+// replyPool holds UDP-sized reply buffers: maxUDPHeaderLen of headroom and
+// the payload read straight from the tunnel behind it.
+var replyPool = sync.Pool{
+	New: func() any {
+		b := make([]byte, constant.UDPBufferSize)
+		return &b
+	},
 }
 
 // HandleUDPAssociate handles a SOCKS5 UDP ASSOCIATE command.
@@ -141,174 +144,366 @@ func HandleUDPAssociate(
 		return err
 	}
 
-	// Parse the client's TCP source IP for source validation.
-	clientIP := parseClientIP(clientAddr)
-
-	sessions := newSessionMap()
-	stopChan := make(chan struct{})
-	var lastSenderAddr atomic.Pointer[net.UDPAddr]
-
-	go relayUDPLoop(udpConn, clientAddr, clientIP, stopChan, dnsHandler, dialFn, sessions, &lastSenderAddr)
+	a := &udpAssociation{
+		udpConn:    udpConn,
+		pc:         ipv4.NewPacketConn(udpConn),
+		clientAddr: clientAddr,
+		clientIP:   parseClientIP(clientAddr),
+		dnsHandler: dnsHandler,
+		dialFn:     dialFn,
+		replies:    make(chan udpReply, udpReplyQueue),
+		done:       make(chan struct{}),
+		tunnels:    make(map[transport.Endpoint]*udpTunnel),
+	}
+	go a.writeLoop()
+	go a.relayLoop()
 
 	// Block until the control TCP connection is closed (any read/error).
 	tcpConn.SetReadDeadline(time.Time{})
 	buf := make([]byte, 1)
 	tcpConn.Read(buf)
 
-	close(stopChan)
-	udpConn.Close()
-	sessions.closeAll()
+	a.close()
 
 	log.Printf("[UDP] %s UDP ASSOCIATE closed", clientAddr)
 	return nil
 }
 
-func parseClientIP(clientAddr string) net.IP {
-	host, _, err := net.SplitHostPort(clientAddr)
+func parseClientIP(clientAddr string) netip.Addr {
+	ap, err := netip.ParseAddrPort(clientAddr)
 	if err != nil {
-		return nil
+		return netip.Addr{}
 	}
-	return net.ParseIP(host)
+	return ap.Addr().Unmap()
 }
 
-func relayUDPLoop(
-	udpConn *net.UDPConn,
-	clientAddr string,
-	clientIP net.IP,
-	stopChan chan struct{},
-	dnsHandler func([]byte) ([]byte, error),
-	dialFn func() (transport.TunnelConn, error),
-	sessions *sessionMap,
-	lastSender *atomic.Pointer[net.UDPAddr],
-) {
+func (a *udpAssociation) close() {
+	a.mu.Lock()
+	a.closed = true
+	tunnels := a.tunnels
+	a.tunnels = make(map[transport.Endpoint]*udpTunnel)
+	a.mu.Unlock()
+
+	close(a.done)
+	a.udpConn.Close()
+	for _, t := range tunnels {
+		if t.up.Load() {
+			t.close()
+		}
+	}
+}
+
+// relayLoop reads client datagrams in batches and forwards each one. Writes
+// to a connected tunnel happen inline straight from the batch buffer; a
+// datagram that needs a new tunnel is copied and handed to a goroutine.
+func (a *udpAssociation) relayLoop() {
 	idleTicker := time.NewTicker(1 * time.Minute)
 	defer idleTicker.Stop()
 
-	buf := commpool.GetUDP()
-	defer commpool.PutUDP(buf)
+	msgs := make([]ipv4.Message, udpBatchSize)
+	for i := range msgs {
+		buf := commpool.GetUDP()
+		defer commpool.PutUDP(buf)
+		msgs[i].Buffers = [][]byte{buf}
+	}
 
 	for {
 		select {
-		case <-stopChan:
+		case <-a.done:
 			return
 		case <-idleTicker.C:
-			sessions.closeIdle()
-			continue
+			a.closeIdle()
 		default:
 		}
 
-		udpConn.SetReadDeadline(time.Now().Add(1 * time.Second))
-		n, senderAddr, err := udpConn.ReadFromUDP(buf)
+		a.pc.SetReadDeadline(time.Now().Add(1 * time.Second))
+		n, err := a.pc.ReadBatch(msgs, 0)
 		if err != nil {
 			if netErr, ok := err.(net.Error); ok && netErr.Timeout() {
 				continue
 			}
 			return
 		}
+		for i := range msgs[:n] {
+			sender, ok := msgs[i].Addr.(*net.UDPAddr)
+			if !ok {
+				continue
+			}
+			a.handlePacket(msgs[i].Buffers[0][:msgs[i].N], sender)
+		}
+	}
+}
 
-		// Source validation: only accept packets from the client that initiated ASSOCIATE.
-		if clientIP != nil && !senderAddr.IP.Equal(clientIP) {
-			log.V("[UDP] %s rejected packet from unexpected source %s", clientAddr, senderAddr)
-			continue
+func (a *udpAssociation) handlePacket(packet []byte, sender *net.UDPAddr) {
+	// Source validation: only accept packets from the client that initiated ASSOCIATE.
+	if a.clientIP.IsValid() && sender.AddrPort().Addr().Unmap() != a.clientIP {
+		log.V("[UDP] %s rejected packet from unexpected source %s", a.clientAddr, sender)
+		return
+	}
+
+	endpoint, headerLen, ok := parseUDPHeader(packet)
+	if !ok {
+		if len(packet) >= 3 && packet[2] != 0x00 {
+			log.V("[UDP] %s fragmented UDP not supported (frag=%d)", a.clientAddr, packet[2])
 		}
+		return
+	}
+	payload := packet[headerLen:]
 
-		if n < 10 {
-			continue
+	// Update last sender atomically so the reply writer can read it race-free.
+	a.lastSender.Store(sender)
+
+	if endpoint.Port == 53 && a.dnsHandler != nil {
+		log.V("[UDP-DNS] %s -> %s", a.clientAddr, endpoint)
+		go a.relayDNS(sender, bytes.Clone(payload), bytes.Clone(packet[:headerLen]))
+		return
+	}
+	if endpoint.Port == 3478 || endpoint.Port == 19302 {
+		log.Printf("[UDP-STUN] %s -> %s (WebRTC STUN tunneled)", a.clientAddr, endpoint)
+	} else {
+		log.V("[UDP] %s -> %s", a.clientAddr, endpoint)
+	}
+
+	// Fast path: tunnel connected — WriteUDP frames from the batch buffer.
+	a.mu.Lock()
+	t := a.tunnels[a.keyFor(endpoint)]
+	a.mu.Unlock()
+	if t != nil && t.up.Load() && (!t.pinned || t.target == endpoint) {
+		if err := t.conn.WriteUDP(endpoint, payload); err != nil {
+			log.V("[UDP] %s WriteUDP failed for %s: %v", a.clientAddr, endpoint, err)
 		}
+		t.touch()
+		return
+	}
 
-		// RSV(2) + FRAG(1) check.
-		if buf[0] != 0x00 || buf[1] != 0x00 {
-			continue
+	// Slow path: the dial may block, run it in a goroutine.
+	go a.sendSlow(endpoint, bytes.Clone(payload), bytes.Clone(packet[:headerLen]))
+}
+
+// keyFor returns the tunnel key of endpoint. Callers hold a.mu.
+func (a *udpAssociation) keyFor(endpoint transport.Endpoint) transport.Endpoint {
+	if endpoint.Domain == "" && !a.pinned {
+		return sharedKey
+	}
+	return endpoint
+}
+
+func (a *udpAssociation) sendSlow(endpoint transport.Endpoint, payload, header []byte) {
+	for {
+		t, created, err := a.tunnel(endpoint, payload, header)
+		if err != nil {
+			if !errors.Is(err, errAssociationClosed) {
+				log.Printf("[UDP] tunnel for %s failed: %v", endpoint, err)
+			}
+			return
 		}
-		if buf[2] != 0x00 {
-			log.V("[UDP] %s fragmented UDP not supported (frag=%d)", clientAddr, buf[2])
+		if created {
+			return // payload went out with ConnectUDP
+		}
+		// The shared tunnel this packet waited on turned out to be pinned
+		// to another target; route again now that a.pinned is set.
+		if t.pinned && t.target != endpoint {
 			continue
 		}
+		if err := t.conn.WriteUDP(endpoint, payload); err != nil {
+			log.V("[UDP] %s WriteUDP failed for %s: %v", a.clientAddr, endpoint, err)
+		}
+		t.touch()
+		return
+	}
+}
+
+// tunnel returns the connected tunnel for endpoint, dialling it with
+// payload as the first datagram if it does not exist. Concurrent callers for
+// the same key wait for the one dial.
+func (a *udpAssociation) tunnel(endpoint transport.Endpoint, payload, header []byte) (*udpTunnel, bool, error) {
+	a.mu.Lock()
+	if a.closed {
+		a.mu.Unlock()
+		return nil, false, errAssociationClosed
+	}
+	key := a.keyFor(endpoint)
+	if t, ok := a.tunnels[key]; ok {
+		a.mu.Unlock()
+		<-t.ready
+		if t.err != nil {
+			return nil, false, t.err
+		}
+		return t, false, nil
+	}
+	t := &udpTunnel{target: endpoint, ready: make(chan struct{})}
+	if endpoint.Domain != "" {
+		t.header = header
+	}
+	a.tunnels[key] = t
+	a.mu.Unlock()
 
-		atyp := buf[3]
-		var headerLen int
-		var endpoint transport.Endpoint
+	t.err = a.connect(t, endpoint, payload)
 
-		switch atyp {
-		case AddressTypeIPv4:
-			if n < 10 {
-				continue
-			}
-			ip, _ := netip.AddrFromSlice(buf[4:8])
-			port := uint16(buf[8])<<8 | uint16(buf[9])
-			endpoint = transport.Endpoint{Addr: netip.AddrPortFrom(ip, port)}
-			headerLen = 10
+	a.mu.Lock()
+	switch {
+	case t.err != nil:
+		if a.tunnels[key] == t {
+			delete(a.tunnels, key)
+		}
+	case a.closed:
+		t.err = errAssociationClosed
+	case t.pinned && key == sharedKey:
+		// The transport binds UDP to the first target: file this tunnel
+		// under that target and key every later destination on its own.
+		a.pinned = true
+		delete(a.tunnels, sharedKey)
+		a.tunnels[endpoint] = t
+		log.V("[UDP] %s transport is pinned per target, one tunnel per destination", a.clientAddr)
+	}
+	a.mu.Unlock()
 
-		case AddressTypeDomain:
-			if n < 5 {
-				continue
-			}
-			domainLen := int(buf[4])
-			if n < 7+domainLen {
-				continue
-			}
-			host := string(buf[5 : 5+domainLen])
-			port := uint16(buf[5+domainLen])<<8 | uint16(buf[6+domainLen])
-			endpoint = transport.Endpoint{Domain: host, Port: port}
-			headerLen = 7 + domainLen
+	if t.err != nil {
+		if t.conn != nil {
+			t.close()
+		}
+		close(t.ready)
+		return nil, false, t.err
+	}
+	t.touch()
+	t.up.Store(true)
+	close(t.ready)
+	go a.readTunnel(t)
+	return t, true, nil
+}
 
-		case AddressTypeIPv6:
-			if n < 22 {
-				continue
+func (a *udpAssociation) connect(t *udpTunnel, endpoint transport.Endpoint, payload []byte) error {
+	conn, err := a.dialFn()
+	if err != nil {
+		return err
+	}
+	t.conn = conn
+	if err := conn.ConnectUDP(endpoint, payload); err != nil {
+		return err
+	}
+	t.pinned = transport.IsUDPPinned(conn)
+	t.stopPing = conn.StartPing(30 * time.Second)
+	return nil
+}
+
+func (a *udpAssociation) closeIdle() {
+	deadline := time.Now().Add(-udpSessionIdleTimeout).UnixNano()
+	var idle []*udpTunnel
+	a.mu.Lock()
+	for key, t := range a.tunnels {
+		if t.up.Load() && t.lastActive.Load() < deadline {
+			idle = append(idle, t)
+			delete(a.tunnels, key)
+			log.V("[UDP] Session idle-expired: %s", t.target)
+		}
+	}
+	a.mu.Unlock()
+	for _, t := range idle {
+		t.close()
+	}
+}
+
+// readTunnel queues every reply from t for the batched writer, with the
+// SOCKS5 header written into the headroom in front of the payload.
+func (a *udpAssociation) readTunnel(t *udpTunnel) {
+	defer func() {
+		a.mu.Lock()
+		for key, cur := range a.tunnels {
+			if cur == t {
+				delete(a.tunnels, key)
 			}
-			ip, _ := netip.AddrFromSlice(buf[4:20])
-			port := uint16(buf[20])<<8 | uint16(buf[21])
-			endpoint = transport.Endpoint{Addr: netip.AddrPortFrom(ip, port)}
-			headerLen = 22
+		}
+		a.mu.Unlock()
+		t.close()
+	}()
 
-		default:
+	for {
+		bufp := replyPool.Get().(*[]byte)
+		buf := *bufp
+		n, from, err := t.conn.ReadUDPFrom(buf[maxUDPHeaderLen:])
+		if err != nil {
+			replyPool.Put(bufp)
+			log.V("[UDP] Tunnel response read ended for %s: %v", t.target, err)
+			return
+		}
+		if n == 0 {
+			replyPool.Put(bufp)
 			continue
 		}
+		t.touch()
 
-		target := endpoint.String()
+		header := t.header
+		if header == nil {
+			if !from.IsValid() {
+				from = t.target.Addr
+			}
+			var tmp [22]byte
+			header = appendUDPHeader(tmp[:0], from)
+		}
+		start := maxUDPHeaderLen - len(header)
+		copy(buf[start:], header)
 
-		// Update last sender atomically so readTunnelResponses can read it race-free.
-		lastSender.Store(senderAddr)
+		select {
+		case a.replies <- udpReply{buf: bufp, start: start, end: maxUDPHeaderLen + n}:
+		case <-a.done:
+			replyPool.Put(bufp)
+			return
+		default:
+			replyPool.Put(bufp)
+			log.V("[UDP] %s reply queue full, dropped reply from %s", a.clientAddr, t.target)
+		}
+	}
+}
 
-		headerCopy := make([]byte, headerLen)
-		copy(headerCopy, buf[:headerLen])
-		payloadCopy := make([]byte, n-headerLen)
-		copy(payloadCopy, buf[headerLen:n])
+// writeLoop sends queued replies to the client, taking whatever is queued
+// (up to udpBatchSize) per sendmmsg.
+func (a *udpAssociation) writeLoop() {
+	msgs := make([]ipv4.Message, udpBatchSize)
+	bufs := make([][1][]byte, udpBatchSize)
+	batch := make([]udpReply, 0, udpBatchSize)
+	for {
+		select {
+		case r := <-a.replies:
+			batch = append(batch, r)
+		case <-a.done:
+			return
+		}
+	drain:
+		for len(batch) < udpBatchSize {
+			select {
+			case r := <-a.replies:
+				batch = append(batch, r)
+			default:
+				break drain
+			}
+		}
 
-		if endpoint.Port == 53 && dnsHandler != nil {
-			log.V("[UDP-DNS] %s -> %s", clientAddr, target)
-			go handleDNSRelay(udpConn, senderAddr, payloadCopy, headerCopy, dnsHandler)
-		} else {
-			if endpoint.Port == 3478 || endpoint.Port == 19302 {
-				log.Printf("[UDP-STUN] %s -> %s (WebRTC STUN tunneled)", clientAddr, target)
-			} else {
-				log.V("[UDP] %s -> %s", clientAddr, target)
+		if sender := a.lastSender.Load(); sender != nil {
+			for i, r := range batch {
+				bufs[i][0] = (*r.buf)[r.start:r.end]
+				msgs[i].Buffers = bufs[i][:]
+				msgs[i].Addr = sender
 			}
-			// Fast path: session already exists — write inline without spawning a goroutine.
-			// Full Cone NAT: Session is keyed by the CLIENT's sender IP:Port to map 1 Local Port -> 1 Tunnel
-			senderKey := senderAddr.String()
-			
-			if s, ok := sessions.get(senderKey); ok {
-				if err := s.tunnelConn.WriteUDP(endpoint, payloadCopy); err != nil {
-					log.V("[UDP] %s WriteUDP failed for %s: %v", clientAddr, target, err)
+			for off := 0; off < len(batch); {
+				n, err := a.pc.WriteBatch(msgs[off:len(batch)], 0)
+				if err != nil {
+					log.V("[UDP] %s write replies to client failed: %v", a.clientAddr, err)
+					break
 				}
-				s.touch()
-			} else {
-				// Slow path: new session — dial may block, run in goroutine.
-				go handleTunnelUDP(udpConn, payloadCopy, headerCopy, endpoint, senderKey, sessions, dialFn, lastSender)
+				off += n
 			}
 		}
+		for i, r := range batch {
+			replyPool.Put(r.buf)
+			batch[i] = udpReply{}
+			bufs[i][0] = nil
+		}
+		batch = batch[:0]
 	}
 }
 
-func handleDNSRelay(
-	udpConn *net.UDPConn,
-	clientAddr *net.UDPAddr,
-	dnsQuery []byte,
-	socks5Header []byte,
-	dnsHandler func([]byte) ([]byte, error),
-) {
-	resp, err := dnsHandler(dnsQuery)
+func (a *udpAssociation) relayDNS(sender *net.UDPAddr, dnsQuery, socks5Header []byte) {
+	resp, err := a.dnsHandler(dnsQuery)
 	if err != nil {
 		log.Printf("[UDP-DNS] DoH query failed: %v", err)
 		return
@@ -316,77 +511,51 @@ func handleDNSRelay(
 	response := make([]byte, 0, len(socks5Header)+len(resp))
 	response = append(response, socks5Header...)
 	response = append(response, resp...)
-	if _, err := udpConn.WriteToUDP(response, clientAddr); err != nil {
+	if _, err := a.udpConn.WriteToUDP(response, sender); err != nil {
 		log.V("[UDP-DNS] write response failed: %v", err)
 	}
 }
 
-func handleTunnelUDP(
-	udpConn *net.UDPConn,
-	payload []byte,
-	socks5Header []byte,
-	endpoint transport.Endpoint,
-	senderKey string,
-	sessions *sessionMap,
-	dialFn func() (transport.TunnelConn, error),
-	lastSender *atomic.Pointer[net.UDPAddr],
-) {
-	target := endpoint.String()
-	session, isNew, err := sessions.getOrCreate(senderKey, dialFn)
-	if err != nil {
-		log.Printf("[UDP] tunnel dial failed for %s: %v", target, err)
-		return
+// parseUDPHeader parses the SOCKS5 UDP request header (RFC 1928 §7).
+// Fragmented datagrams are rejected.
+func parseUDPHeader(b []byte) (transport.Endpoint, int, bool) {
+	if len(b) < 10 || b[0] != 0x00 || b[1] != 0x00 || b[2] != 0x00 {
+		return transport.Endpoint{}, 0, false
 	}
-
-	if isNew {
-		if err := session.tunnelConn.ConnectUDP(endpoint, payload); err != nil {
-			log.Printf("[UDP] ConnectUDP failed for %s: %v", target, err)
-			sessions.mu.Lock()
-			delete(sessions.sessions, senderKey)
-			sessions.mu.Unlock()
-			session.close()
-			return
+	switch b[3] {
+	case AddressTypeIPv4:
+		ip := netip.AddrFrom4([4]byte(b[4:8]))
+		return transport.Endpoint{Addr: netip.AddrPortFrom(ip, binary.BigEndian.Uint16(b[8:10]))}, 10, true
+
+	case AddressTypeDomain:
+		domainLen := int(b[4])
+		if len(b) < 7+domainLen {
+			return transport.Endpoint{}, 0, false
 		}
-		go readTunnelResponses(udpConn, session, socks5Header, target, lastSender)
-	} else {
-		// Session was created by another goroutine between get() and getOrCreate() (rare).
-		if err := session.tunnelConn.WriteUDP(endpoint, payload); err != nil {
-			log.V("[UDP] WriteUDP failed for %s: %v", target, err)
+		port := binary.BigEndian.Uint16(b[5+domainLen:])
+		return transport.Endpoint{Domain: string(b[5 : 5+domainLen]), Port: port}, 7 + domainLen, true
+
+	case AddressTypeIPv6:
+		if len(b) < 22 {
+			return transport.Endpoint{}, 0, false
 		}
+		ip := netip.AddrFrom16([16]byte(b[4:20]))
+		return transport.Endpoint{Addr: netip.AddrPortFrom(ip, binary.BigEndian.Uint16(b[20:22]))}, 22, true
 	}
-	session.touch()
+	return transport.Endpoint{}, 0, false
 }
 
-func readTunnelResponses(
-	udpConn *net.UDPConn,
-	session *udpSession,
-	socks5Header []byte,
-	target string,
-	lastSender *atomic.Pointer[net.UDPAddr],
-) {
-	for {
-		payload, err := session.tunnelConn.ReadUDP()
-		if err != nil {
-			log.V("[UDP] Tunnel response read ended for %s: %v", target, err)
-			return
-		}
-		if len(payload) == 0 {
-			continue
-		}
-
-		session.touch()
-
-		sender := lastSender.Load()
-		if sender == nil {
-			continue
-		}
-
-		response := make([]byte, 0, len(socks5Header)+len(payload))
-		response = append(response, socks5Header...)
-		response = append(response, payload...)
-
-		if _, err := udpConn.WriteToUDP(response, sender); err != nil {
-			log.V("[UDP] write response to client failed for %s: %v", target, err)
-		}
+// appendUDPHeader appends the SOCKS5 UDP header for a reply from addr.
+func appendUDPHeader(b []byte, addr netip.AddrPort) []byte {
+	ip := addr.Addr().Unmap()
+	if ip.Is4() {
+		a4 := ip.As4()
+		b = append(b, 0, 0, 0, AddressTypeIPv4)
+		b = append(b, a4[:]...)
+	} else {
+		a16 := ip.As16()
+		b = append(b, 0, 0, 0, AddressTypeIPv6)
+		b = append(b, a16[:]...)
 	}
+	return binary.BigEndian.AppendUint16(b, addr.Port())
 }
@@ -0,0 +1,259 @@
+package socks5
+
+import (
+	"bytes"
+	"encoding/binary"
+	"errors"
+	"io"
+	"net"
+	"net/netip"
+	"sync"
+	"sync/atomic"
+	"testing"
+	"time"
+
+	"ewp-core/transport"
+)
+
+// echoTunnel is a TunnelConn whose far end echoes every UDP packet back
+// from the address it was sent to. A pinned tunnel, like MASQUE, ignores
+// WriteUDP's endpoint and always answers from its ConnectUDP target.
+type echoTunnel struct {
+	pinned  bool
+	target  transport.Endpoint
+	replies chan echoFrame
+	done    chan struct{}
+	once    sync.Once
+}
+
+type echoFrame struct {
+	from netip.AddrPort
+	data []byte
+}
+
+func newEchoTunnel(pinned bool) *echoTunnel {
+	return &echoTunnel{pinned: pinned, replies: make(chan echoFrame, 256), done: make(chan struct{})}
+}
+
+func (c *echoTunnel) push(ep transport.Endpoint, data []byte) error {
+	if c.pinned {
+		ep = c.target
+	}
+	from := ep.Addr
+	if ep.Domain != "" {
+		from = netip.AddrPortFrom(netip.MustParseAddr("192.0.2.1"), ep.Port)
+	}
+	select {
+	case c.replies <- echoFrame{from: from, data: bytes.Clone(data)}:
+		return nil
+	case <-c.done:
+		return io.ErrClosedPipe
+	}
+}
+
+func (c *echoTunnel) ConnectUDP(ep transport.Endpoint, data []byte) error {
+	c.target = ep
+	return c.push(ep, data)
+}
+
+func (c *echoTunnel) WriteUDP(ep transport.Endpoint, data []byte) error { return c.push(ep, data) }
+
+func (c *echoTunnel) ReadUDPFrom(buf []byte) (int, netip.AddrPort, error) {
+	select {
+	case f := <-c.replies:
+		return copy(buf, f.data), f.from, nil
+	case <-c.done:
+		return 0, netip.AddrPort{}, io.EOF
+	}
+}
+
+func (c *echoTunnel) ReadUDP() ([]byte, error) {
+	buf := make([]byte, 65535)
+	n, _, err := c.ReadUDPFrom(buf)
+	return buf[:n], err
+}
+
+func (c *echoTunnel) ReadUDPTo(buf []byte) (int, error) {
+	n, _, err := c.ReadUDPFrom(buf)
+	return n, err
+}
+
+func (c *echoTunnel) Connect(string, []byte) error          { return errors.New("tcp not supported") }
+func (c *echoTunnel) Read([]byte) (int, error)              { return 0, io.EOF }
+func (c *echoTunnel) Write([]byte) error                    { return io.ErrClosedPipe }
+func (c *echoTunnel) StartPing(time.Duration) chan struct{} { return nil }
+func (c *echoTunnel) UDPPinned() bool                       { return c.pinned }
+func (c *echoTunnel) Close() error                          { c.once.Do(func() { close(c.done) }); return nil }
+
+// startAssociation runs HandleUDPAssociate over a pipe and returns a client
+// socket connected to the relay. dials counts tunnel dials.
+func startAssociation(tb testing.TB, pinned bool) (*net.UDPConn, *atomic.Int32) {
+	tb.Helper()
+	dials := new(atomic.Int32)
+	dial := func() (transport.TunnelConn, error) {
+		dials.Add(1)
+		return newEchoTunnel(pinned), nil
+	}
+
+	server, client := net.Pipe()
+	go HandleUDPAssociate(server, "127.0.0.1:40000", nil, dial)
+
+	reply := make([]byte, 10)
+	if _, err := io.ReadFull(client, reply); err != nil {
+		tb.Fatal(err)
+	}
+	relay := &net.UDPAddr{IP: net.IPv4(127, 0, 0, 1), Port: int(binary.BigEndian.Uint16(reply[8:]))}
+	conn, err := net.DialUDP("udp", nil, relay)
+	if err != nil {
+		tb.Fatal(err)
+	}
+	tb.Cleanup(func() {
+		conn.Close()
+		client.Close()
+	})
+	return conn, dials
+}
+
+func ipTarget(i int) netip.AddrPort {
+	return netip.AddrPortFrom(netip.AddrFrom4([4]byte{198, 51, 100, byte(i)}), uint16(10000+i))
+}
+
+func udpRequest(to netip.AddrPort, payload []byte) []byte {
+	return append(appendUDPHeader(nil, to), payload...)
+}
+
+// readReplies reads n replies and returns them keyed by payload.
+func readReplies(tb testing.TB, conn *net.UDPConn, n int) map[string][]byte {
+	tb.Helper()
+	got := make(map[string][]byte)
+	buf := make([]byte, 65535)
+	conn.SetReadDeadline(time.Now().Add(5 * time.Second))
+	for len(got) < n {
+		m, err := conn.Read(buf)
+		if err != nil {
+			tb.Fatalf("got %d/%d replies: %v", len(got), n, err)
+		}
+		_, hl, ok := parseUDPHeader(buf[:m])
+		if !ok {
+			tb.Fatalf("malformed reply % x", buf[:m])
+		}
+		got[string(buf[hl:m])] = bytes.Clone(buf[:hl])
+	}
+	return got
+}
+
+func TestUDPAssociateSharesTunnel(t *testing.T) {
+	for _, tc := range []struct {
+		name      string
+		pinned    bool
+		wantDials int32
+	}{
+		{"multiplexed", false, 1},
+		{"pinned", true, 16},
+	} {
+		t.Run(tc.name, func(t *testing.T) {
+			conn, dials := startAssociation(t, tc.pinned)
+
+			// A burst before any tunnel exists: every packet waits on the
+			// first dial, then pinned transports fan out per target.
+			for i := 1; i <= 16; i++ {
+				if _, err := conn.Write(udpRequest(ipTarget(i), []byte{byte(i)})); err != nil {
+					t.Fatal(err)
+				}
+			}
+			got := readReplies(t, conn, 16)
+			for i := 1; i <= 16; i++ {
+				want := appendUDPHeader(nil, ipTarget(i))
+				if !bytes.Equal(got[string([]byte{byte(i)})], want) {
+					t.Errorf("reply %d header % x, want % x", i, got[string([]byte{byte(i)})], want)
+				}
+			}
+			if n := dials.Load(); n != tc.wantDials {
+				t.Errorf("dials = %d, want %d", n, tc.wantDials)
+			}
+		})
+	}
+}
+
+func TestUDPAssociateDomainTarget(t *testing.T) {
+	conn, dials := startAssociation(t, false)
+
+	domainHeader := []byte{0, 0, 0, AddressTypeDomain, 11}
+	domainHeader = append(domainHeader, "example.com"...)
+	domainHeader = binary.BigEndian.AppendUint16(domainHeader, 4433)
+
+	conn.Write(udpRequest(ipTarget(1), []byte("ip")))
+	readReplies(t, conn, 1)
+	conn.Write(append(bytes.Clone(domainHeader), "domain"...))
+	got := readReplies(t, conn, 1)
+
+	// Replies from a domain tunnel carry the name the client sent to.
+	if !bytes.Equal(got["domain"], domainHeader) {
+		t.Errorf("domain reply header % x, want % x", got["domain"], domainHeader)
+	}
+	if n := dials.Load(); n != 2 {
+		t.Errorf("dials = %d, want 2 (shared + domain)", n)
+	}
+}
+
+func TestUDPAssociateRejectsOtherSources(t *testing.T) {
+	dial := func() (transport.TunnelConn, error) { return newEchoTunnel(false), nil }
+	server, client := net.Pipe()
+	defer client.Close()
+	// The association belongs to a client at 192.0.2.10; loopback packets
+	// must be ignored.
+	go HandleUDPAssociate(server, "192.0.2.10:40000", nil, dial)
+	reply := make([]byte, 10)
+	io.ReadFull(client, reply)
+
+	relay := &net.UDPAddr{IP: net.IPv4(127, 0, 0, 1), Port: int(binary.BigEndian.Uint16(reply[8:]))}
+	conn, err := net.DialUDP("udp", nil, relay)
+	if err != nil {
+		t.Fatal(err)
+	}
+	defer conn.Close()
+	conn.Write(udpRequest(ipTarget(1), []byte("x")))
+	conn.SetReadDeadline(time.Now().Add(200 * time.Millisecond))
+	if _, err := conn.Read(make([]byte, 64)); err == nil {
+		t.Fatal("relay answered a packet from a foreign source")
+	}
+}
+
+// BenchmarkUDPAssociateThroughput pushes 1200-byte datagrams to 64 peers
+// through one association, 32 in flight at a time.
+func BenchmarkUDPAssociateThroughput(b *testing.B) {
+	const (
+		peers   = 64
+		window  = 32
+		payload = 1200
+	)
+	conn, dials := startAssociation(b, false)
+	conn.SetReadBuffer(1 << 20)
+
+	packets := make([][]byte, peers)
+	for i := range packets {
+		packets[i] = udpRequest(ipTarget(i+1), make([]byte, payload))
+	}
+	buf := make([]byte, 65535)
+
+	b.SetBytes(payload)
+	b.ResetTimer()
+	lost := 0
+	for sent := 0; sent < b.N; {
+		burst := min(window, b.N-sent)
+		for i := 0; i < burst; i++ {
+			conn.Write(packets[(sent+i)%peers])
+		}
+		sent += burst
+		conn.SetReadDeadline(time.Now().Add(time.Second))
+		for i := 0; i < burst; i++ {
+			if _, err := conn.Read(buf); err != nil {
+				lost += burst - i
+				break
+			}
+		}
+	}
+	b.StopTimer()
+	b.ReportMetric(float64(lost), "lost")
+	b.ReportMetric(float64(dials.Load()), "tunnels")
+}
@@ -19,7 +19,7 @@ type MuxHandler interface {
 }
 
 // HandleMuxConnection 处理 Mux 多路复用连接
-func HandleMuxConnection(ctx context.Context, conn net.Conn, user string, handler MuxHandler) error {
+func HandleMuxConnection(ctx context.Context, conn io.ReadWriteCloser, user string, handler MuxHandler) error {
 	config := smux.DefaultConfig()
 	config.KeepAliveDisabled = true
 
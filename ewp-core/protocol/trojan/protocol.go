@@ -24,6 +24,10 @@ const (
 	MaxSocksaddrLength = 259
 )
 
+// MuxTarget is the placeholder destination sent with CommandMux. The server
+// ignores it; each smux stream carries its own command and address.
+const MuxTarget = "MUX_CONN:443"
+
 var CRLF = []byte{'\r', '\n'}
 
 type Address struct {
@@ -0,0 +1,315 @@
+// Package conntrack keeps a registry of live proxied flows so a local
+// controller can list them, watch their traffic and close them.
+//
+// Inbound handlers wrap the tunnel they dial with Wrap; the flow is
+// registered once Connect / ConnectUDP succeeds and removed on Close.
+// Byte counters are plain atomics on the hot path; rates are derived by
+// Watcher from successive snapshots, so an idle registry costs nothing.
+package conntrack
+
+import (
+	"cmp"
+	"net/netip"
+	"slices"
+	"sync"
+	"sync/atomic"
+	"time"
+
+	"ewp-core/transport"
+)
+
+// Meta describes where a flow comes from.
+type Meta struct {
+	Inbound   string    // inbound tag
+	Source    string    // client address (host:port)
+	Transport string    // outbound transport name
+	DialStart time.Time // when the tunnel dial began; zero = setup latency not recorded
+}
+
+// Info is a point-in-time view of one flow.
+type Info struct {
+	ID        uint64    `json:"id"`
+	Network   string    `json:"network"` // "tcp" or "udp"
+	Inbound   string    `json:"inbound,omitempty"`
+	Source    string    `json:"source,omitempty"`
+	Target    string    `json:"target"`
+	Transport string    `json:"transport,omitempty"`
+	Start     time.Time `json:"start"`
+	Upload    int64     `json:"upload"`
+	Download  int64     `json:"download"`
+}
+
+var (
+	nextID atomic.Uint64
+
+	mu    sync.RWMutex
+	flows = make(map[uint64]*Conn)
+
+	// Traffic of flows that have already closed, folded in on Close so the
+	// totals need no shared counter on the data path.
+	closedUpload   atomic.Int64
+	closedDownload atomic.Int64
+
+	// Tunnel setup latency (dial + connect) since the last TakeSetupLatency.
+	setupCount atomic.Int64
+	setupNanos atomic.Int64
+)
+
+// Conn is a transport.TunnelConn that counts bytes and is listed in the
+// registry between a successful Connect / ConnectUDP and Close.
+type Conn struct {
+	transport.TunnelConn
+
+	meta     Meta
+	id       uint64
+	network  string
+	target   string
+	start    time.Time
+	upload   atomic.Int64
+	download atomic.Int64
+	closed   atomic.Bool
+}
+
+// Wrap returns conn with flow tracking. The flow appears in Snapshot once
+// it is connected.
+func Wrap(conn transport.TunnelConn, meta Meta) *Conn {
+	return &Conn{TunnelConn: conn, meta: meta}
+}
+
+// Register tracks a tunnel that is already connected.
+func Register(conn transport.TunnelConn, meta Meta, network, target string) *Conn {
+	c := Wrap(conn, meta)
+	c.register(network, target)
+	return c
+}
+
+func (c *Conn) register(network, target string) {
+	now := time.Now()
+	if !c.meta.DialStart.IsZero() {
+		setupCount.Add(1)
+		setupNanos.Add(int64(now.Sub(c.meta.DialStart)))
+	}
+	mu.Lock()
+	c.id = nextID.Add(1)
+	c.network, c.target, c.start = network, target, now
+	if !c.closed.Load() {
+		flows[c.id] = c
+	}
+	mu.Unlock()
+}
+
+func (c *Conn) Connect(target string, initialData []byte) error {
+	if err := c.TunnelConn.Connect(target, initialData); err != nil {
+		return err
+	}
+	c.upload.Add(int64(len(initialData)))
+	c.register("tcp", target)
+	return nil
+}
+
+func (c *Conn) ConnectUDP(target transport.Endpoint, initialData []byte) error {
+	if err := c.TunnelConn.ConnectUDP(target, initialData); err != nil {
+		return err
+	}
+	c.upload.Add(int64(len(initialData)))
+	c.register("udp", target.String())
+	return nil
+}
+
+func (c *Conn) Read(buf []byte) (int, error) {
+	n, err := c.TunnelConn.Read(buf)
+	c.download.Add(int64(n))
+	return n, err
+}
+
+func (c *Conn) Write(data []byte) error {
+	err := c.TunnelConn.Write(data)
+	if err == nil {
+		c.upload.Add(int64(len(data)))
+	}
+	return err
+}
+
+func (c *Conn) WriteUDP(target transport.Endpoint, data []byte) error {
+	err := c.TunnelConn.WriteUDP(target, data)
+	if err == nil {
+		c.upload.Add(int64(len(data)))
+	}
+	return err
+}
+
+func (c *Conn) ReadUDP() ([]byte, error) {
+	data, err := c.TunnelConn.ReadUDP()
+	c.download.Add(int64(len(data)))
+	return data, err
+}
+
+func (c *Conn) ReadUDPTo(buf []byte) (int, error) {
+	n, err := c.TunnelConn.ReadUDPTo(buf)
+	c.download.Add(int64(n))
+	return n, err
+}
+
+func (c *Conn) ReadUDPFrom(buf []byte) (int, netip.AddrPort, error) {
+	n, addr, err := c.TunnelConn.ReadUDPFrom(buf)
+	c.download.Add(int64(n))
+	return n, addr, err
+}
+
+func (c *Conn) UDPPinned() bool {
+	return transport.IsUDPPinned(c.TunnelConn)
+}
+
+// Close removes the flow from the registry and closes the tunnel. The
+// relay loops notice the closed tunnel and tear down the client side.
+func (c *Conn) Close() error {
+	if !c.closed.Swap(true) {
+		mu.Lock()
+		delete(flows, c.id)
+		mu.Unlock()
+		closedUpload.Add(c.upload.Load())
+		closedDownload.Add(c.download.Load())
+	}
+	return c.TunnelConn.Close()
+}
+
+func (c *Conn) info() Info {
+	return Info{
+		ID:        c.id,
+		Network:   c.network,
+		Inbound:   c.meta.Inbound,
+		Source:    c.meta.Source,
+		Target:    c.target,
+		Transport: c.meta.Transport,
+		Start:     c.start,
+		Upload:    c.upload.Load(),
+		Download:  c.download.Load(),
+	}
+}
+
+// Snapshot returns every live flow, oldest first.
+func Snapshot() []Info {
+	mu.RLock()
+	out := make([]Info, 0, len(flows))
+	for _, c := range flows {
+		out = append(out, c.info())
+	}
+	mu.RUnlock()
+	slices.SortFunc(out, func(a, b Info) int { return cmp.Compare(a.ID, b.ID) })
+	return out
+}
+
+// Totals is the aggregate traffic of every flow since start.
+type Totals struct {
+	Active   int
+	Upload   int64
+	Download int64
+}
+
+// GetTotals sums closed and live flows.
+func GetTotals() Totals {
+	t := Totals{Upload: closedUpload.Load(), Download: closedDownload.Load()}
+	mu.RLock()
+	t.Active = len(flows)
+	for _, c := range flows {
+		t.Upload += c.upload.Load()
+		t.Download += c.download.Load()
+	}
+	mu.RUnlock()
+	return t
+}
+
+// TakeSetupLatency returns the mean tunnel setup latency of the flows
+// connected since the previous call (0 if none) and resets the window.
+func TakeSetupLatency() time.Duration {
+	n := setupCount.Swap(0)
+	total := setupNanos.Swap(0)
+	if n == 0 {
+		return 0
+	}
+	return time.Duration(total / n)
+}
+
+// Close closes the flow with the given id. It reports whether it existed.
+func Close(id uint64) bool {
+	mu.RLock()
+	c, ok := flows[id]
+	mu.RUnlock()
+	if ok {
+		c.Close()
+	}
+	return ok
+}
+
+// Update carries the counters of a flow that changed since the last diff.
+// Rates are bytes per second over the interval between the two diffs.
+type Update struct {
+	ID       uint64 `json:"id"`
+	Upload   int64  `json:"upload"`
+	Download int64  `json:"download"`
+	UpRate   int64  `json:"up_rate"`
+	DownRate int64  `json:"down_rate"`
+}
+
+// Diff is an incremental change to the flow table.
+type Diff struct {
+	Added   []Info   `json:"added,omitempty"`
+	Updated []Update `json:"updated,omitempty"`
+	Removed []uint64 `json:"removed,omitempty"`
+}
+
+// Empty reports whether the diff carries no change.
+func (d Diff) Empty() bool {
+	return len(d.Added) == 0 && len(d.Updated) == 0 && len(d.Removed) == 0
+}
+
+// Watcher turns successive snapshots into diffs for one subscriber.
+// The first Next returns every live flow as Added.
+type Watcher struct {
+	prev   map[uint64]Info
+	moving map[uint64]bool // flows last reported with a non-zero rate
+	last   time.Time
+}
+
+// Next returns the changes since the previous call.
+func (w *Watcher) Next(now time.Time) Diff {
+	cur := Snapshot()
+	var d Diff
+	elapsed := now.Sub(w.last).Seconds()
+	next := make(map[uint64]Info, len(cur))
+	for _, f := range cur {
+		next[f.ID] = f
+		old, ok := w.prev[f.ID]
+		if !ok {
+			d.Added = append(d.Added, f)
+			continue
+		}
+		if f.Upload == old.Upload && f.Download == old.Download {
+			if w.moving[f.ID] {
+				// Report the drop to zero once so the rate does not stick.
+				delete(w.moving, f.ID)
+				d.Updated = append(d.Updated, Update{ID: f.ID, Upload: f.Upload, Download: f.Download})
+			}
+			continue
+		}
+		u := Update{ID: f.ID, Upload: f.Upload, Download: f.Download}
+		if elapsed > 0 {
+			u.UpRate = int64(float64(f.Upload-old.Upload) / elapsed)
+			u.DownRate = int64(float64(f.Download-old.Download) / elapsed)
+		}
+		if w.moving == nil {
+			w.moving = make(map[uint64]bool)
+		}
+		w.moving[f.ID] = true
+		d.Updated = append(d.Updated, u)
+	}
+	for id := range w.prev {
+		if _, ok := next[id]; !ok {
+			d.Removed = append(d.Removed, id)
+			delete(w.moving, id)
+		}
+	}
+	slices.Sort(d.Removed)
+	w.prev, w.last = next, now
+	return d
+}
@@ -0,0 +1,130 @@
+package conntrack
+
+import (
+	"net/netip"
+	"testing"
+	"time"
+
+	"ewp-core/transport"
+)
+
+type stubConn struct {
+	closed bool
+}
+
+func (s *stubConn) Connect(string, []byte) error                { return nil }
+func (s *stubConn) ConnectUDP(transport.Endpoint, []byte) error { return nil }
+func (s *stubConn) WriteUDP(transport.Endpoint, []byte) error   { return nil }
+func (s *stubConn) ReadUDP() ([]byte, error)                    { return []byte("pong"), nil }
+func (s *stubConn) ReadUDPTo(buf []byte) (int, error)           { return copy(buf, "pong"), nil }
+func (s *stubConn) ReadUDPFrom(buf []byte) (int, netip.AddrPort, error) {
+	return copy(buf, "pong"), netip.AddrPort{}, nil
+}
+func (s *stubConn) Read(buf []byte) (int, error)          { return copy(buf, "response"), nil }
+func (s *stubConn) Write([]byte) error                    { return nil }
+func (s *stubConn) Close() error                          { s.closed = true; return nil }
+func (s *stubConn) StartPing(time.Duration) chan struct{} { return nil }
+
+func find(id uint64) (Info, bool) {
+	for _, f := range Snapshot() {
+		if f.ID == id {
+			return f, true
+		}
+	}
+	return Info{}, false
+}
+
+func TestRegistryLifecycle(t *testing.T) {
+	c := Wrap(&stubConn{}, Meta{Inbound: "mixed-in", Source: "127.0.0.1:5000", Transport: "WebSocket"})
+	if err := c.Connect("example.com:443", []byte("hello")); err != nil {
+		t.Fatal(err)
+	}
+	c.Write([]byte("abc"))
+	c.Read(make([]byte, 64))
+
+	f, ok := find(c.id)
+	if !ok {
+		t.Fatal("connected flow not listed")
+	}
+	if f.Network != "tcp" || f.Target != "example.com:443" || f.Inbound != "mixed-in" {
+		t.Fatalf("unexpected info: %+v", f)
+	}
+	if f.Upload != 8 || f.Download != 8 {
+		t.Fatalf("upload=%d download=%d, want 8/8", f.Upload, f.Download)
+	}
+
+	if !Close(c.id) {
+		t.Fatal("Close(id) did not find the flow")
+	}
+	if !c.TunnelConn.(*stubConn).closed {
+		t.Fatal("Close(id) did not close the tunnel")
+	}
+	if _, ok := find(c.id); ok {
+		t.Fatal("closed flow still listed")
+	}
+}
+
+func TestUnconnectedFlowNotListed(t *testing.T) {
+	before := len(Snapshot())
+	c := Wrap(&stubConn{}, Meta{})
+	if len(Snapshot()) != before {
+		t.Fatal("flow listed before Connect")
+	}
+	c.Close()
+}
+
+func TestWatcherDiffs(t *testing.T) {
+	var w Watcher
+	t0 := time.Now()
+	w.Next(t0) // drain flows left by other tests
+
+	c := Wrap(&stubConn{}, Meta{})
+	c.ConnectUDP(transport.Endpoint{Domain: "stun.example.com", Port: 3478}, nil)
+	d := w.Next(t0.Add(time.Second))
+	if len(d.Added) != 1 || d.Added[0].Network != "udp" || d.Added[0].Target != "stun.example.com:3478" {
+		t.Fatalf("added = %+v", d.Added)
+	}
+
+	c.WriteUDP(transport.Endpoint{}, make([]byte, 1000))
+	d = w.Next(t0.Add(3 * time.Second))
+	if len(d.Updated) != 1 || d.Updated[0].UpRate != 500 {
+		t.Fatalf("updated = %+v, want up_rate 500", d.Updated)
+	}
+
+	// Idle: one update with the rate back at zero, then silence.
+	d = w.Next(t0.Add(4 * time.Second))
+	if len(d.Updated) != 1 || d.Updated[0].UpRate != 0 {
+		t.Fatalf("idle update = %+v", d.Updated)
+	}
+	if d = w.Next(t0.Add(5 * time.Second)); !d.Empty() {
+		t.Fatalf("expected empty diff, got %+v", d)
+	}
+
+	c.Close()
+	d = w.Next(t0.Add(6 * time.Second))
+	if len(d.Removed) != 1 || d.Removed[0] != c.id {
+		t.Fatalf("removed = %v", d.Removed)
+	}
+}
+
+func TestTotalsIncludeClosedFlows(t *testing.T) {
+	before := GetTotals()
+	c := Wrap(&stubConn{}, Meta{DialStart: time.Now().Add(-40 * time.Millisecond)})
+	TakeSetupLatency()
+	c.Connect("example.com:80", nil)
+	if d := TakeSetupLatency(); d < 40*time.Millisecond {
+		t.Fatalf("setup latency %v, want >= 40ms", d)
+	}
+	c.Write(make([]byte, 100))
+	c.Read(make([]byte, 64))
+	c.Close()
+
+	after := GetTotals()
+	if after.Upload-before.Upload != 100 || after.Download-before.Download != 8 {
+		t.Fatalf("totals delta up=%d down=%d, want 100/8",
+			after.Upload-before.Upload, after.Download-before.Download)
+	}
+	if after.Active != before.Active {
+		t.Fatalf("active %d, want %d", after.Active, before.Active)
+	}
+}
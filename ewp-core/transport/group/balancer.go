@@ -0,0 +1,342 @@
+package group
+
+import (
+	"errors"
+	"fmt"
+	"hash/fnv"
+	"math"
+	"net"
+	"net/netip"
+	"sync"
+	"sync/atomic"
+	"time"
+
+	"ewp-core/transport"
+)
+
+// Strategy selects how a balancer spreads connections over its members.
+type Strategy int
+
+const (
+	// LeastConn picks the member with the fewest active connections per
+	// unit of weight, so long downloads do not pile up on one node.
+	LeastConn Strategy = iota
+	// RoundRobin rotates through members in proportion to their weights
+	// (smooth weighted round-robin, as in nginx).
+	RoundRobin
+	// ConsistentHash maps each destination host to a fixed member
+	// (weighted rendezvous hashing). Sessions that need a stable exit IP
+	// stay sticky, and losing a member only remaps the hosts it owned.
+	ConsistentHash
+)
+
+// ParseStrategy maps a config value to a Strategy ("" = least-conn).
+func ParseStrategy(s string) (Strategy, error) {
+	switch s {
+	case "", "least-conn":
+		return LeastConn, nil
+	case "round-robin":
+		return RoundRobin, nil
+	case "consistent-hash":
+		return ConsistentHash, nil
+	}
+	return 0, fmt.Errorf("unknown balancer strategy: %s", s)
+}
+
+func (s Strategy) String() string {
+	switch s {
+	case RoundRobin:
+		return "round-robin"
+	case ConsistentHash:
+		return "consistent-hash"
+	}
+	return "least-conn"
+}
+
+var errNotConnected = errors.New("balancer: tunnel not connected")
+
+// pick chooses a member for key (the destination host) among the healthy
+// members not in tried, falling back to down ones when nothing healthy is
+// left. The member's active count is taken under the lock so that a burst of
+// connections spreads out under least-conn.
+func (g *Group) pick(key string, tried map[*member]bool) *member {
+	g.mu.Lock()
+	defer g.mu.Unlock()
+
+	var cands []*member
+	for _, m := range g.members {
+		if !tried[m] && m.healthy() {
+			cands = append(cands, m)
+		}
+	}
+	if len(cands) == 0 {
+		for _, m := range g.members {
+			if !tried[m] {
+				cands = append(cands, m)
+			}
+		}
+	}
+	if len(cands) == 0 {
+		return nil
+	}
+
+	var m *member
+	switch {
+	case g.opts.Strategy == RoundRobin:
+		m = pickRoundRobin(cands)
+	case g.opts.Strategy == ConsistentHash && key != "":
+		m = pickHash(cands, key)
+	default:
+		m = g.pickLeastConnLocked(cands)
+	}
+	m.active.Add(1)
+	return m
+}
+
+func (g *Group) pickLeastConnLocked(cands []*member) *member {
+	// Rotate the starting point so ties do not always go to the first member.
+	g.rr++
+	var best *member
+	var bestLoad float64
+	for i := range cands {
+		m := cands[(g.rr+i)%len(cands)]
+		load := float64(m.active.Load()) / float64(m.Weight)
+		if best == nil || load < bestLoad {
+			best, bestLoad = m, load
+		}
+	}
+	return best
+}
+
+func pickRoundRobin(cands []*member) *member {
+	var best *member
+	total := 0
+	for _, m := range cands {
+		m.current += m.Weight
+		total += m.Weight
+		if best == nil || m.current > best.current {
+			best = m
+		}
+	}
+	best.current -= total
+	return best
+}
+
+func pickHash(cands []*member, key string) *member {
+	var best *member
+	var bestScore float64
+	for _, m := range cands {
+		h := fnv.New64a()
+		h.Write([]byte(m.Tag))
+		h.Write([]byte{0})
+		h.Write([]byte(key))
+		// Uniform in (0,1); -w/ln(u) gives each member a share
+		// proportional to its weight.
+		u := (float64(h.Sum64()>>11) + 0.5) / (1 << 53)
+		score := -float64(m.Weight) / math.Log(u)
+		if best == nil || score > bestScore {
+			best, bestScore = m, score
+		}
+	}
+	return best
+}
+
+// balancedConn defers member selection to Connect / ConnectUDP, where the
+// destination is known. A heartbeat requested before that is started on the
+// member tunnel once it exists.
+type balancedConn struct {
+	g *Group
+
+	// bound is set once, under mu, when open succeeds; the data path loads
+	// it without taking the lock.
+	bound atomic.Pointer[boundMember]
+
+	mu           sync.Mutex
+	closed       bool
+	pingInterval time.Duration
+	pingStop     chan struct{}
+
+	released atomic.Bool
+}
+
+// boundMember is the member tunnel a balancedConn was opened on.
+type boundMember struct {
+	conn transport.TunnelConn
+	m    *member
+}
+
+func (c *balancedConn) Connect(target string, initialData []byte) error {
+	host := target
+	if h, _, err := net.SplitHostPort(target); err == nil {
+		host = h
+	}
+	return c.open(host, func(conn transport.TunnelConn) error {
+		return conn.Connect(target, initialData)
+	})
+}
+
+func (c *balancedConn) ConnectUDP(target transport.Endpoint, initialData []byte) error {
+	host := target.Domain
+	if host == "" {
+		host = target.Addr.Addr().String()
+	}
+	return c.open(host, func(conn transport.TunnelConn) error {
+		return conn.ConnectUDP(target, initialData)
+	})
+}
+
+// open dials members in strategy order until one yields a tunnel, then
+// runs connect on it. Dial failures fall through to the next member; a
+// failed connect is reported and returned, since initialData may already
+// be on the wire.
+func (c *balancedConn) open(key string, connect func(transport.TunnelConn) error) error {
+	c.mu.Lock()
+	if c.bound.Load() != nil || c.closed {
+		c.mu.Unlock()
+		return errors.New("balancer: tunnel already used")
+	}
+	c.mu.Unlock()
+
+	tried := make(map[*member]bool, len(c.g.members))
+	var lastErr error
+	for {
+		m := c.g.pick(key, tried)
+		if m == nil {
+			return fmt.Errorf("group %s: all members failed: %w", c.g.tag, lastErr)
+		}
+		tried[m] = true
+		conn, err := m.Transport.Dial()
+		if err != nil {
+			m.active.Add(-1)
+			lastErr = err
+			c.g.reportFailure(m, err)
+			continue
+		}
+		m.total.Add(1)
+
+		c.mu.Lock()
+		if c.closed {
+			c.mu.Unlock()
+			m.active.Add(-1)
+			conn.Close()
+			return net.ErrClosed
+		}
+		c.bound.Store(&boundMember{conn: conn, m: m})
+		if c.pingStop != nil {
+			bridgePing(conn.StartPing(c.pingInterval), c.pingStop)
+		}
+		c.mu.Unlock()
+
+		if err := connect(conn); err != nil {
+			c.g.reportFailure(m, err)
+			return err
+		}
+		return nil
+	}
+}
+
+// bridgePing stops the member heartbeat when the caller closes its channel.
+func bridgePing(inner, outer chan struct{}) {
+	if inner == nil {
+		return
+	}
+	go func() {
+		<-outer
+		close(inner)
+	}()
+}
+
+func (c *balancedConn) UDPPinned() bool {
+	b := c.bound.Load()
+	return b != nil && transport.IsUDPPinned(b.conn)
+}
+
+func (c *balancedConn) StartPing(interval time.Duration) chan struct{} {
+	c.mu.Lock()
+	defer c.mu.Unlock()
+	stop := make(chan struct{})
+	if b := c.bound.Load(); b != nil {
+		bridgePing(b.conn.StartPing(interval), stop)
+		return stop
+	}
+	c.pingInterval, c.pingStop = interval, stop
+	return stop
+}
+
+func (c *balancedConn) Close() error {
+	c.mu.Lock()
+	c.closed = true
+	b := c.bound.Load()
+	c.mu.Unlock()
+	if b == nil {
+		return nil
+	}
+	if !c.released.Swap(true) {
+		b.m.active.Add(-1)
+	}
+	return b.conn.Close()
+}
+
+func (c *balancedConn) Read(buf []byte) (int, error) {
+	b := c.bound.Load()
+	if b == nil {
+		return 0, errNotConnected
+	}
+	n, err := b.conn.Read(buf)
+	b.m.download.Add(int64(n))
+	return n, err
+}
+
+func (c *balancedConn) Write(data []byte) error {
+	b := c.bound.Load()
+	if b == nil {
+		return errNotConnected
+	}
+	err := b.conn.Write(data)
+	if err == nil {
+		b.m.upload.Add(int64(len(data)))
+	}
+	return err
+}
+
+func (c *balancedConn) WriteUDP(target transport.Endpoint, data []byte) error {
+	b := c.bound.Load()
+	if b == nil {
+		return errNotConnected
+	}
+	err := b.conn.WriteUDP(target, data)
+	if err == nil {
+		b.m.upload.Add(int64(len(data)))
+	}
+	return err
+}
+
+func (c *balancedConn) ReadUDP() ([]byte, error) {
+	b := c.bound.Load()
+	if b == nil {
+		return nil, errNotConnected
+	}
+	data, err := b.conn.ReadUDP()
+	b.m.download.Add(int64(len(data)))
+	return data, err
+}
+
+func (c *balancedConn) ReadUDPTo(buf []byte) (int, error) {
+	b := c.bound.Load()
+	if b == nil {
+		return 0, errNotConnected
+	}
+	n, err := b.conn.ReadUDPTo(buf)
+	b.m.download.Add(int64(n))
+	return n, err
+}
+
+func (c *balancedConn) ReadUDPFrom(buf []byte) (int, netip.AddrPort, error) {
+	b := c.bound.Load()
+	if b == nil {
+		return 0, netip.AddrPort{}, errNotConnected
+	}
+	n, addr, err := b.conn.ReadUDPFrom(buf)
+	b.m.download.Add(int64(n))
+	return n, addr, err
+}
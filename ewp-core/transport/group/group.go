@@ -0,0 +1,514 @@
+// Package group spreads new connections over several node transports.
+//
+//   - urltest: the lowest-latency healthy member, switching only when another
+//     member beats the current one by more than Tolerance (hysteresis).
+//   - fallback: the first healthy member in configured order.
+//   - balancer: every healthy member, chosen per connection by Strategy
+//     (see balancer.go).
+//
+// Members are probed in the background with a real tunnel handshake plus an
+// HTTP request to URL. A failed Dial or Connect marks the member down at once
+// and triggers an early re-probe, so new connections move to another member
+// within seconds instead of waiting for the next interval.
+package group
+
+import (
+	"bytes"
+	"fmt"
+	"io"
+	"net"
+	"net/url"
+	"strings"
+	"sync"
+	"sync/atomic"
+	"time"
+
+	"ewp-core/log"
+	"ewp-core/transport"
+)
+
+const (
+	DefaultURL       = "http://www.gstatic.com/generate_204"
+	DefaultInterval  = 30 * time.Second
+	DefaultTolerance = 50 * time.Millisecond
+	DefaultTimeout   = 5 * time.Second
+
+	// minRecheckGap rate-limits failure-triggered probe rounds.
+	minRecheckGap = 2 * time.Second
+)
+
+// Mode selects how the active member is chosen.
+type Mode int
+
+const (
+	URLTest Mode = iota
+	Fallback
+	Balancer
+)
+
+// ParseMode maps an outbound type ("urltest", "fallback", "balancer") to a Mode.
+func ParseMode(s string) (Mode, error) {
+	switch s {
+	case "urltest":
+		return URLTest, nil
+	case "fallback":
+		return Fallback, nil
+	case "balancer":
+		return Balancer, nil
+	}
+	return 0, fmt.Errorf("unknown group type: %s", s)
+}
+
+func (m Mode) String() string {
+	switch m {
+	case Fallback:
+		return "Fallback"
+	case Balancer:
+		return "Balancer"
+	}
+	return "URLTest"
+}
+
+// Member is one node of the group. Weight only matters for Balancer
+// (<= 0 means 1).
+type Member struct {
+	Tag       string
+	Transport transport.Transport
+	Weight    int
+}
+
+// Options tunes probing and balancing; zero values select the defaults.
+type Options struct {
+	URL       string
+	Interval  time.Duration
+	Tolerance time.Duration
+	Timeout   time.Duration
+	Strategy  Strategy // Balancer only
+}
+
+// MemberStatus is a snapshot of one member for logging / UI.
+type MemberStatus struct {
+	Tag      string
+	Latency  time.Duration // 0 = not probed yet
+	Healthy  bool
+	Selected bool // urltest / fallback: the active member
+
+	// Connection stats; Upload/Download are counted by Balancer only
+	Weight   int
+	Active   int64
+	Total    int64
+	Failures int64
+	Upload   int64
+	Download int64
+}
+
+// Latency states stored in member.latency (nanoseconds otherwise).
+const (
+	latencyUnknown int64 = 0
+	latencyDown    int64 = -1
+)
+
+type member struct {
+	Member
+	latency atomic.Int64
+
+	active   atomic.Int64
+	total    atomic.Int64
+	failures atomic.Int64
+	upload   atomic.Int64
+	download atomic.Int64
+
+	current int // smooth weighted round-robin state, guarded by Group.mu
+}
+
+func (m *member) healthy() bool { return m.latency.Load() != latencyDown }
+
+// Group is a transport.Transport that dials through the active member.
+type Group struct {
+	tag     string
+	mode    Mode
+	members []*member
+	opts    Options
+
+	probeTarget  string // host:port
+	probeRequest []byte
+
+	mu          sync.Mutex
+	selected    int
+	lastRecheck time.Time
+	rr          int // tie-breaker rotation for least-conn
+
+	recheck   chan struct{}
+	done      chan struct{}
+	closeOnce sync.Once
+}
+
+// New builds a group and starts background probing.
+func New(tag string, mode Mode, members []Member, opts Options) (*Group, error) {
+	if len(members) == 0 {
+		return nil, fmt.Errorf("group %s: no members", tag)
+	}
+	if opts.URL == "" {
+		opts.URL = DefaultURL
+	}
+	if opts.Interval <= 0 {
+		opts.Interval = DefaultInterval
+	}
+	if opts.Tolerance <= 0 {
+		opts.Tolerance = DefaultTolerance
+	}
+	if opts.Timeout <= 0 {
+		opts.Timeout = DefaultTimeout
+	}
+
+	target, request, err := buildProbe(opts.URL)
+	if err != nil {
+		return nil, fmt.Errorf("group %s: %w", tag, err)
+	}
+
+	g := &Group{
+		tag:          tag,
+		mode:         mode,
+		opts:         opts,
+		probeTarget:  target,
+		probeRequest: request,
+		recheck:      make(chan struct{}, 1),
+		done:         make(chan struct{}),
+	}
+	for _, m := range members {
+		if m.Weight <= 0 {
+			m.Weight = 1
+		}
+		g.members = append(g.members, &member{Member: m})
+	}
+	go g.loop()
+	return g, nil
+}
+
+func (g *Group) Name() string {
+	if g.mode == Balancer {
+		return fmt.Sprintf("%s[%s](%s, %d members)", g.mode, g.tag, g.opts.Strategy, len(g.members))
+	}
+	g.mu.Lock()
+	cur := g.members[g.selected]
+	g.mu.Unlock()
+	return fmt.Sprintf("%s[%s](%s)", g.mode, g.tag, cur.Transport.Name())
+}
+
+func (g *Group) SetBypassConfig(cfg *transport.BypassConfig) {
+	for _, m := range g.members {
+		m.Transport.SetBypassConfig(cfg)
+	}
+}
+
+// Dial opens a tunnel through the active member, falling through to the
+// remaining members (healthy ones first) when it fails. A balancer defers
+// the choice to Connect, where the destination is known.
+func (g *Group) Dial() (transport.TunnelConn, error) {
+	if g.mode == Balancer {
+		return &balancedConn{g: g}, nil
+	}
+	var lastErr error
+	for _, m := range g.dialOrder() {
+		conn, err := m.Transport.Dial()
+		if err != nil {
+			lastErr = err
+			g.reportFailure(m, err)
+			continue
+		}
+		m.active.Add(1)
+		m.total.Add(1)
+		return &groupConn{TunnelConn: conn, g: g, m: m}, nil
+	}
+	return nil, fmt.Errorf("group %s: all members failed: %w", g.tag, lastErr)
+}
+
+// Close stops probing and closes members that hold pooled state.
+func (g *Group) Close() error {
+	g.closeOnce.Do(func() {
+		close(g.done)
+		for _, m := range g.members {
+			if c, ok := m.Transport.(io.Closer); ok {
+				c.Close()
+			}
+		}
+	})
+	return nil
+}
+
+// Status returns a snapshot of every member.
+func (g *Group) Status() []MemberStatus {
+	g.mu.Lock()
+	selected := g.selected
+	g.mu.Unlock()
+
+	out := make([]MemberStatus, len(g.members))
+	for i, m := range g.members {
+		lat := m.latency.Load()
+		out[i] = MemberStatus{
+			Tag:      m.Tag,
+			Healthy:  lat != latencyDown,
+			Selected: g.mode != Balancer && i == selected,
+			Weight:   m.Weight,
+			Active:   m.active.Load(),
+			Total:    m.total.Load(),
+			Failures: m.failures.Load(),
+			Upload:   m.upload.Load(),
+			Download: m.download.Load(),
+		}
+		if lat > 0 {
+			out[i].Latency = time.Duration(lat)
+		}
+	}
+	return out
+}
+
+func (g *Group) dialOrder() []*member {
+	g.mu.Lock()
+	selected := g.selected
+	g.mu.Unlock()
+
+	order := make([]*member, 0, len(g.members))
+	order = append(order, g.members[selected])
+	var down []*member
+	for i, m := range g.members {
+		if i == selected {
+			continue
+		}
+		if m.healthy() {
+			order = append(order, m)
+		} else {
+			down = append(down, m)
+		}
+	}
+	return append(order, down...)
+}
+
+func (g *Group) reportFailure(m *member, err error) {
+	m.failures.Add(1)
+	if m.latency.Swap(latencyDown) != latencyDown {
+		log.Warn("[Group] %s: member %s failed: %v", g.tag, m.Tag, err)
+	}
+	g.mu.Lock()
+	g.reselectLocked()
+	trigger := time.Since(g.lastRecheck) >= minRecheckGap
+	if trigger {
+		g.lastRecheck = time.Now()
+	}
+	g.mu.Unlock()
+
+	if trigger {
+		select {
+		case g.recheck <- struct{}{}:
+		default:
+		}
+	}
+}
+
+// update records a probe result and re-evaluates the selection.
+func (g *Group) update(m *member, latency time.Duration, ok bool) {
+	if ok {
+		m.latency.Store(int64(latency))
+	} else {
+		m.latency.Store(latencyDown)
+	}
+	g.mu.Lock()
+	g.reselectLocked()
+	g.mu.Unlock()
+}
+
+func (g *Group) reselectLocked() {
+	if g.mode == Balancer {
+		return
+	}
+	next := g.selected
+	switch g.mode {
+	case Fallback:
+		for i, m := range g.members {
+			if m.healthy() {
+				next = i
+				break
+			}
+		}
+	default:
+		next = g.bestURLTestLocked()
+	}
+	if next != g.selected {
+		from, to := g.members[g.selected], g.members[next]
+		log.Info("[Group] %s: %s -> %s (%s)", g.tag, from.Tag, to.Tag, formatLatency(to.latency.Load()))
+		g.selected = next
+	}
+}
+
+// bestURLTestLocked keeps the current member unless it is down or another
+// probed member is faster by more than the tolerance.
+func (g *Group) bestURLTestLocked() int {
+	best := -1
+	var bestLat int64
+	for i, m := range g.members {
+		if lat := m.latency.Load(); lat > 0 && (best < 0 || lat < bestLat) {
+			best, bestLat = i, lat
+		}
+	}
+
+	cur := g.members[g.selected].latency.Load()
+	switch {
+	case cur == latencyDown:
+		if best >= 0 {
+			return best
+		}
+		// Nothing probed healthy yet: try an unprobed member.
+		for i, m := range g.members {
+			if m.latency.Load() == latencyUnknown {
+				return i
+			}
+		}
+		return g.selected
+	case best < 0:
+		return g.selected
+	case cur == latencyUnknown, bestLat+int64(g.opts.Tolerance) < cur:
+		return best
+	}
+	return g.selected
+}
+
+// --- probing ---
+
+func (g *Group) loop() {
+	g.probeAll()
+	ticker := time.NewTicker(g.opts.Interval)
+	defer ticker.Stop()
+	for {
+		select {
+		case <-g.done:
+			return
+		case <-ticker.C:
+		case <-g.recheck:
+		}
+		g.probeAll()
+	}
+}
+
+func (g *Group) probeAll() {
+	var wg sync.WaitGroup
+	for _, m := range g.members {
+		wg.Add(1)
+		go func(m *member) {
+			defer wg.Done()
+			lat, err := g.probe(m.Transport)
+			if err != nil {
+				log.V("[Group] %s: probe %s failed: %v", g.tag, m.Tag, err)
+			}
+			g.update(m, lat, err == nil)
+		}(m)
+	}
+	wg.Wait()
+}
+
+// probe opens a fresh tunnel and measures the time until the first byte of
+// the HTTP response to the probe request.
+func (g *Group) probe(t transport.Transport) (time.Duration, error) {
+	start := time.Now()
+	deadline := start.Add(g.opts.Timeout)
+
+	conn, err := t.Dial()
+	if err != nil {
+		return 0, err
+	}
+	defer conn.Close()
+	remaining := time.Until(deadline)
+	if remaining <= 0 {
+		return 0, fmt.Errorf("timeout")
+	}
+	timer := time.AfterFunc(remaining, func() { conn.Close() })
+	defer timer.Stop()
+
+	if err := conn.Connect(g.probeTarget, g.probeRequest); err != nil {
+		return 0, err
+	}
+	buf := make([]byte, 16)
+	n, err := conn.Read(buf)
+	if n == 0 {
+		if err == nil {
+			err = io.ErrUnexpectedEOF
+		}
+		if time.Now().After(deadline) {
+			return 0, fmt.Errorf("timeout")
+		}
+		return 0, err
+	}
+	if !bytes.HasPrefix(buf[:n], []byte("HTTP/")) {
+		return 0, fmt.Errorf("unexpected probe response %q", buf[:n])
+	}
+	return time.Since(start), nil
+}
+
+func buildProbe(rawURL string) (string, []byte, error) {
+	u, err := url.Parse(rawURL)
+	if err != nil {
+		return "", nil, fmt.Errorf("invalid probe url: %w", err)
+	}
+	if u.Scheme != "http" {
+		return "", nil, fmt.Errorf("probe url must be http:// (got %s)", u.Scheme)
+	}
+	host := u.Hostname()
+	port := u.Port()
+	if port == "" {
+		port = "80"
+	}
+	path := u.RequestURI()
+
+	var b strings.Builder
+	fmt.Fprintf(&b, "HEAD %s HTTP/1.1\r\n", path)
+	fmt.Fprintf(&b, "Host: %s\r\n", u.Host)
+	b.WriteString("User-Agent: ewp-core\r\nConnection: close\r\n\r\n")
+	return net.JoinHostPort(host, port), []byte(b.String()), nil
+}
+
+func formatLatency(lat int64) string {
+	switch lat {
+	case latencyDown:
+		return "down"
+	case latencyUnknown:
+		return "untested"
+	}
+	return time.Duration(lat).Round(time.Millisecond).String()
+}
+
+// --- conn ---
+
+// groupConn reports Connect failures so the group can move away from a
+// member whose tunnel dials but cannot carry requests.
+type groupConn struct {
+	transport.TunnelConn
+	g      *Group
+	m      *member
+	closed atomic.Bool
+}
+
+func (c *groupConn) Close() error {
+	if !c.closed.Swap(true) {
+		c.m.active.Add(-1)
+	}
+	return c.TunnelConn.Close()
+}
+
+func (c *groupConn) UDPPinned() bool {
+	return transport.IsUDPPinned(c.TunnelConn)
+}
+
+func (c *groupConn) Connect(target string, initialData []byte) error {
+	err := c.TunnelConn.Connect(target, initialData)
+	if err != nil {
+		c.g.reportFailure(c.m, err)
+	}
+	return err
+}
+
+func (c *groupConn) ConnectUDP(target transport.Endpoint, initialData []byte) error {
+	err := c.TunnelConn.ConnectUDP(target, initialData)
+	if err != nil {
+		c.g.reportFailure(c.m, err)
+	}
+	return err
+}
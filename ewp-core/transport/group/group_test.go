@@ -0,0 +1,362 @@
+package group
+
+// Selection and failover tests with fake member transports: each fake
+// answers the probe request with an HTTP status line after a fixed delay, or
+// fails Dial outright when marked broken.
+//
+// Run:
+//   go test -count=1 ./transport/group/...
+//   go test -run=^$ -bench=Group ./transport/group/
+
+import (
+	"errors"
+	"fmt"
+	"net/netip"
+	"sync/atomic"
+	"testing"
+	"time"
+
+	"ewp-core/transport"
+)
+
+type fakeTransport struct {
+	name   string
+	delay  time.Duration
+	broken atomic.Bool
+	dials  atomic.Int64
+}
+
+func (f *fakeTransport) Name() string                            { return f.name }
+func (f *fakeTransport) SetBypassConfig(*transport.BypassConfig) {}
+
+func (f *fakeTransport) Dial() (transport.TunnelConn, error) {
+	f.dials.Add(1)
+	if f.broken.Load() {
+		return nil, errors.New("connection refused")
+	}
+	return &fakeConn{delay: f.delay}, nil
+}
+
+type fakeConn struct {
+	delay time.Duration
+	sent  bool
+}
+
+func (c *fakeConn) Connect(string, []byte) error { return nil }
+func (c *fakeConn) ConnectUDP(transport.Endpoint, []byte) error {
+	return nil
+}
+func (c *fakeConn) WriteUDP(transport.Endpoint, []byte) error { return nil }
+func (c *fakeConn) ReadUDP() ([]byte, error)                  { return nil, nil }
+func (c *fakeConn) ReadUDPTo([]byte) (int, error)             { return 0, nil }
+func (c *fakeConn) ReadUDPFrom([]byte) (int, netip.AddrPort, error) {
+	return 0, netip.AddrPort{}, nil
+}
+func (c *fakeConn) Read(buf []byte) (int, error) {
+	if c.sent {
+		return 0, errors.New("EOF")
+	}
+	c.sent = true
+	time.Sleep(c.delay)
+	return copy(buf, "HTTP/1.1 204 No Content\r\n\r\n"), nil
+}
+func (c *fakeConn) Write([]byte) error                    { return nil }
+func (c *fakeConn) Close() error                          { return nil }
+func (c *fakeConn) StartPing(time.Duration) chan struct{} { return make(chan struct{}) }
+
+func newTestGroup(t *testing.T, mode Mode, members ...*fakeTransport) *Group {
+	t.Helper()
+	var ms []Member
+	for _, f := range members {
+		ms = append(ms, Member{Tag: f.name, Transport: f})
+	}
+	g, err := New("test", mode, ms, Options{Interval: time.Hour, Tolerance: 20 * time.Millisecond})
+	if err != nil {
+		t.Fatal(err)
+	}
+	t.Cleanup(func() { g.Close() })
+	return g
+}
+
+func selected(g *Group) string {
+	for _, s := range g.Status() {
+		if s.Selected {
+			return s.Tag
+		}
+	}
+	return ""
+}
+
+func waitSelected(t *testing.T, g *Group, want string) {
+	t.Helper()
+	deadline := time.Now().Add(3 * time.Second)
+	for selected(g) != want {
+		if time.Now().After(deadline) {
+			t.Fatalf("selected %q, want %q (status %+v)", selected(g), want, g.Status())
+		}
+		time.Sleep(5 * time.Millisecond)
+	}
+}
+
+func TestURLTestPicksFastestMember(t *testing.T) {
+	slow := &fakeTransport{name: "slow", delay: 80 * time.Millisecond}
+	fast := &fakeTransport{name: "fast", delay: 5 * time.Millisecond}
+	g := newTestGroup(t, URLTest, slow, fast)
+	waitSelected(t, g, "fast")
+}
+
+func TestURLTestHysteresis(t *testing.T) {
+	a := &fakeTransport{name: "a"}
+	b := &fakeTransport{name: "b"}
+	g := newTestGroup(t, URLTest, a, b)
+	ma, mb := g.members[0], g.members[1]
+
+	g.update(ma, 100*time.Millisecond, true)
+	g.update(mb, 90*time.Millisecond, true)
+	if got := selected(g); got != "a" {
+		t.Fatalf("10ms gain is within tolerance, must stay on a: got %s", got)
+	}
+
+	g.update(mb, 50*time.Millisecond, true)
+	if got := selected(g); got != "b" {
+		t.Fatalf("50ms gain exceeds tolerance, must switch to b: got %s", got)
+	}
+}
+
+func TestDialFailsOverImmediately(t *testing.T) {
+	primary := &fakeTransport{name: "primary"}
+	backup := &fakeTransport{name: "backup"}
+	g := newTestGroup(t, Fallback, primary, backup)
+	waitSelected(t, g, "primary")
+
+	primary.broken.Store(true)
+	conn, err := g.Dial()
+	if err != nil {
+		t.Fatalf("dial must fall through to backup: %v", err)
+	}
+	conn.Close()
+	if got := selected(g); got != "backup" {
+		t.Fatalf("selected %s after primary failure, want backup", got)
+	}
+
+	// Once primary recovers, the failure-triggered re-probe brings it back.
+	primary.broken.Store(false)
+	time.Sleep(minRecheckGap)
+	g.reportFailure(g.members[1], errors.New("forced"))
+	waitSelected(t, g, "primary")
+}
+
+func TestAllMembersDown(t *testing.T) {
+	a := &fakeTransport{name: "a"}
+	a.broken.Store(true)
+	b := &fakeTransport{name: "b"}
+	b.broken.Store(true)
+	g := newTestGroup(t, URLTest, a, b)
+
+	if _, err := g.Dial(); err == nil {
+		t.Fatal("dial must fail when every member is down")
+	}
+}
+
+func newBalancer(t *testing.T, strategy Strategy, members ...Member) *Group {
+	t.Helper()
+	g, err := New("lb", Balancer, members, Options{Interval: time.Hour, Strategy: strategy})
+	if err != nil {
+		t.Fatal(err)
+	}
+	t.Cleanup(func() { g.Close() })
+	return g
+}
+
+func connectN(t *testing.T, g *Group, n int, target func(i int) string) []transport.TunnelConn {
+	t.Helper()
+	var conns []transport.TunnelConn
+	for i := 0; i < n; i++ {
+		conn, err := g.Dial()
+		if err != nil {
+			t.Fatal(err)
+		}
+		if err := conn.Connect(target(i), nil); err != nil {
+			t.Fatal(err)
+		}
+		conns = append(conns, conn)
+	}
+	return conns
+}
+
+func sameTarget(int) string { return "example.com:443" }
+
+func TestBalancerLeastConnSpreadsLoad(t *testing.T) {
+	a, b, c := &fakeTransport{name: "a"}, &fakeTransport{name: "b"}, &fakeTransport{name: "c"}
+	g := newBalancer(t, LeastConn,
+		Member{Tag: "a", Transport: a}, Member{Tag: "b", Transport: b}, Member{Tag: "c", Transport: c})
+
+	conns := connectN(t, g, 9, sameTarget)
+	for _, s := range g.Status() {
+		if s.Active != 3 {
+			t.Fatalf("%s has %d active connections, want 3 (status %+v)", s.Tag, s.Active, g.Status())
+		}
+	}
+	for _, conn := range conns {
+		conn.Close()
+	}
+	for _, s := range g.Status() {
+		if s.Active != 0 || s.Total != 3 {
+			t.Fatalf("%s: active=%d total=%d after close, want 0/3", s.Tag, s.Active, s.Total)
+		}
+	}
+}
+
+func TestBalancerWeightedRoundRobin(t *testing.T) {
+	a, b := &fakeTransport{name: "a"}, &fakeTransport{name: "b"}
+	g := newBalancer(t, RoundRobin,
+		Member{Tag: "a", Transport: a, Weight: 3}, Member{Tag: "b", Transport: b, Weight: 1})
+
+	for _, conn := range connectN(t, g, 40, sameTarget) {
+		conn.Close()
+	}
+	// Probes dial members too, so count tunnels through the balancer.
+	st := g.Status()
+	if st[0].Total != 30 || st[1].Total != 10 {
+		t.Fatalf("connections a=%d b=%d, want 30/10", st[0].Total, st[1].Total)
+	}
+}
+
+func TestBalancerConsistentHashIsSticky(t *testing.T) {
+	fakes := []*fakeTransport{{name: "a"}, {name: "b"}, {name: "c"}}
+	var ms []Member
+	for _, f := range fakes {
+		ms = append(ms, Member{Tag: f.name, Transport: f})
+	}
+	g := newBalancer(t, ConsistentHash, ms...)
+
+	owner := func(host string) string {
+		conn, err := g.Dial()
+		if err != nil {
+			t.Fatal(err)
+		}
+		defer conn.Close()
+		if err := conn.Connect(host+":443", nil); err != nil {
+			t.Fatal(err)
+		}
+		return conn.(*balancedConn).bound.Load().m.Tag
+	}
+
+	hosts := make([]string, 60)
+	first := make(map[string]string)
+	used := make(map[string]bool)
+	for i := range hosts {
+		hosts[i] = fmt.Sprintf("host%d.example", i)
+		first[hosts[i]] = owner(hosts[i])
+		used[first[hosts[i]]] = true
+	}
+	if len(used) != 3 {
+		t.Fatalf("60 hosts landed on %d members, want all 3", len(used))
+	}
+	for _, h := range hosts {
+		if got := owner(h); got != first[h] {
+			t.Fatalf("%s moved from %s to %s without a membership change", h, first[h], got)
+		}
+	}
+
+	// Losing b only remaps the hosts b owned.
+	fakes[1].broken.Store(true)
+	for _, h := range hosts {
+		got := owner(h)
+		if first[h] != "b" && got != first[h] {
+			t.Fatalf("%s moved from %s to %s when an unrelated member failed", h, first[h], got)
+		}
+		if got == "b" {
+			t.Fatalf("%s still routed to the failed member", h)
+		}
+	}
+}
+
+func TestBalancerPingBeforeConnect(t *testing.T) {
+	a := &fakeTransport{name: "a"}
+	g := newBalancer(t, LeastConn, Member{Tag: "a", Transport: a})
+
+	conn, err := g.Dial()
+	if err != nil {
+		t.Fatal(err)
+	}
+	stop := conn.StartPing(time.Second)
+	if err := conn.Write([]byte("x")); err == nil {
+		t.Fatal("write before Connect must fail")
+	}
+	if err := conn.Connect("example.com:80", nil); err != nil {
+		t.Fatal(err)
+	}
+	if err := conn.Write([]byte("hello")); err != nil {
+		t.Fatal(err)
+	}
+	close(stop)
+	conn.Close()
+	if s := g.Status()[0]; s.Upload != 5 || s.Active != 0 {
+		t.Fatalf("upload=%d active=%d, want 5/0", s.Upload, s.Active)
+	}
+}
+
+func TestBalancerWriteDuringConnect(t *testing.T) {
+	a := &fakeTransport{name: "a"}
+	g := newBalancer(t, LeastConn, Member{Tag: "a", Transport: a})
+
+	conn, err := g.Dial()
+	if err != nil {
+		t.Fatal(err)
+	}
+	defer conn.Close()
+	// A heartbeat or UDP pinning check may touch the tunnel while Connect
+	// binds it; run with -race.
+	done := make(chan struct{})
+	go func() {
+		defer close(done)
+		for conn.Write([]byte("x")) != nil {
+			conn.(*balancedConn).UDPPinned()
+		}
+	}()
+	if err := conn.Connect("example.com:80", nil); err != nil {
+		t.Fatal(err)
+	}
+	<-done
+}
+
+// BenchmarkGroupWrite compares the data-path cost of a balancer tunnel
+// against writing to the member tunnel directly.
+func BenchmarkGroupWrite(b *testing.B) {
+	payload := make([]byte, 32*1024)
+	run := func(b *testing.B, conn transport.TunnelConn) {
+		b.SetBytes(int64(len(payload)))
+		b.ReportAllocs()
+		b.RunParallel(func(pb *testing.PB) {
+			for pb.Next() {
+				if err := conn.Write(payload); err != nil {
+					b.Error(err)
+					return
+				}
+			}
+		})
+	}
+
+	b.Run("member", func(b *testing.B) {
+		conn, _ := (&fakeTransport{name: "a"}).Dial()
+		run(b, conn)
+	})
+	b.Run("balancer", func(b *testing.B) {
+		g, err := New("lb", Balancer, []Member{{Tag: "a", Transport: &fakeTransport{name: "a"}}},
+			Options{Interval: time.Hour, Strategy: LeastConn})
+		if err != nil {
+			b.Fatal(err)
+		}
+		defer g.Close()
+		conn, err := g.Dial()
+		if err != nil {
+			b.Fatal(err)
+		}
+		defer conn.Close()
+		if err := conn.Connect("example.com:443", nil); err != nil {
+			b.Fatal(err)
+		}
+		run(b, conn)
+	})
+}
@@ -50,12 +50,20 @@ func NewConn(conn *grpc.ClientConn, stream grpc.ClientStream, uuid [16]byte, pas
 
 func (c *Conn) Connect(target string, initialData []byte) error {
 	if c.useTrojan {
-		return c.connectTrojan(target, initialData)
+		return c.connectTrojan(trojan.CommandTCP, target, initialData)
 	}
 	return c.connectEWP(target, initialData)
 }
 
-func (c *Conn) connectTrojan(target string, initialData []byte) error {
+// ConnectMux opens the tunnel in Trojan mux mode (see transport.MuxConnector).
+func (c *Conn) ConnectMux() error {
+	if !c.useTrojan {
+		return fmt.Errorf("mux requires trojan protocol")
+	}
+	return c.connectTrojan(trojan.CommandMux, trojan.MuxTarget, nil)
+}
+
+func (c *Conn) connectTrojan(command byte, target string, initialData []byte) error {
 	addr, err := trojan.ParseAddress(target)
 	if err != nil {
 		return fmt.Errorf("parse address: %w", err)
@@ -64,7 +72,7 @@ func (c *Conn) connectTrojan(target string, initialData []byte) error {
 	var handshakeData []byte
 	handshakeData = append(handshakeData, c.key[:]...)
 	handshakeData = append(handshakeData, trojan.CRLF...)
-	handshakeData = append(handshakeData, trojan.CommandTCP)
+	handshakeData = append(handshakeData, command)
 
 	addrBytes, err := addr.Encode()
 	if err != nil {
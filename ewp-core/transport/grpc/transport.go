@@ -54,6 +54,7 @@ type Transport struct {
 	useMozillaCA        bool
 	echManager          *commontls.ECHManager
 	bypassCfg           *transport.BypassConfig
+	tcpFastOpen         bool
 }
 
 func New(serverAddr, uuidStr string, useECH, enableFlow bool, serviceName string, echManager *commontls.ECHManager) (*Transport, error) {
@@ -106,6 +107,13 @@ func (t *Transport) SetSNI(sni string) *Transport {
 	return t
 }
 
+// SetTCPFastOpen enables client-side TCP Fast Open: the TLS ClientHello is
+// sent in the SYN once the kernel holds a cookie for the server.
+func (t *Transport) SetTCPFastOpen(enabled bool) *Transport {
+	t.tcpFastOpen = enabled
+	return t
+}
+
 func (t *Transport) SetKeepalive(idleTimeout, healthCheckTimeout time.Duration, permitWithoutStream bool) *Transport {
 	t.idleTimeout = idleTimeout
 	t.healthCheckTimeout = healthCheckTimeout
@@ -208,6 +216,7 @@ func (t *Transport) Dial() (transport.TunnelConn, error) {
 }
 
 func (t *Transport) getOrCreateConn(host, sniOverride, addr string) (*grpc.ClientConn, error) {
+	serverHost := host
 	if sniOverride != "" {
 		host = sniOverride
 	}
@@ -233,12 +242,17 @@ func (t *Transport) getOrCreateConn(host, sniOverride, addr string) (*grpc.Clien
 
 	var opts []grpc.DialOption
 
-	// Use bypass dialer in TUN mode to avoid routing loops; else TFO
+	// Use bypass dialer in TUN mode to avoid routing loops
 	opts = append(opts, grpc.WithContextDialer(func(ctx context.Context, address string) (net.Conn, error) {
-		if t.bypassCfg != nil && t.bypassCfg.TCPDialer != nil {
-			return t.bypassCfg.TCPDialer.DialContext(ctx, "tcp", address)
+		var dialer *net.Dialer
+		if t.bypassCfg != nil {
+			dialer = t.bypassCfg.TCPDialer
 		}
-		return commonnet.DialTFOContext(ctx, "tcp", address, 10*time.Second)
+		conn, err := commonnet.DialTCP(ctx, dialer, "tcp", address, t.tcpFastOpen)
+		// gRPC runs the TLS handshake itself, so only the connect outcome
+		// is reported.
+		transport.ReportDial(t.bypassCfg, serverHost, address, 0, err)
+		return conn, err
 	}))
 
 	opts = append(opts, grpc.WithConnectParams(grpc.ConnectParams{
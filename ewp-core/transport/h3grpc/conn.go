@@ -172,11 +172,25 @@ func (c *Conn) Connect(target string, initialData []byte) error {
 	}
 
 	if c.useTrojan {
-		return c.trojanConnect(target, initialData)
+		return c.trojanConnect(trojan.CommandTCP, target, initialData)
 	}
 	return c.ewpConnect(target, initialData)
 }
 
+// ConnectMux opens the tunnel in Trojan mux mode (see transport.MuxConnector).
+func (c *Conn) ConnectMux() error {
+	if !c.useTrojan {
+		return fmt.Errorf("mux requires trojan protocol")
+	}
+	if err := c.establishH3(); err != nil {
+		return err
+	}
+	if err := c.waitConnected(); err != nil {
+		return err
+	}
+	return c.trojanConnect(trojan.CommandMux, trojan.MuxTarget, nil)
+}
+
 // ewpConnect sends EWP protocol connect request
 func (c *Conn) ewpConnect(target string, initialData []byte) error {
 	addr, err := ewp.ParseAddress(target)
@@ -227,7 +241,7 @@ func (c *Conn) ewpConnect(target string, initialData []byte) error {
 }
 
 // trojanConnect sends Trojan protocol connect request
-func (c *Conn) trojanConnect(target string, initialData []byte) error {
+func (c *Conn) trojanConnect(command byte, target string, initialData []byte) error {
 	addr, err := trojan.ParseAddress(target)
 	if err != nil {
 		return fmt.Errorf("parse address: %w", err)
@@ -236,7 +250,7 @@ func (c *Conn) trojanConnect(target string, initialData []byte) error {
 	var handshakeData []byte
 	handshakeData = append(handshakeData, c.key[:]...)
 	handshakeData = append(handshakeData, trojan.CRLF...)
-	handshakeData = append(handshakeData, trojan.CommandTCP)
+	handshakeData = append(handshakeData, command)
 
 	addrBytes, err := addr.Encode()
 	if err != nil {
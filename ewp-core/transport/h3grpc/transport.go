@@ -11,6 +11,7 @@ import (
 	"sync"
 	"time"
 
+	"ewp-core/common/quicresume"
 	commontls "ewp-core/common/tls"
 	"ewp-core/log"
 	"ewp-core/protocol/trojan"
@@ -131,8 +132,9 @@ func (t *Transport) initClient() error {
 	// Force HTTP/3 ALPN
 	stdTLSConfig.NextProtos = []string{"h3"}
 
-	// Enable session resumption for 0-RTT
-	stdTLSConfig.ClientSessionCache = tls.NewLRUClientSessionCache(100)
+	// Session resumption for 0-RTT uses the shared ticket cache installed by
+	// commontls (persisted across restarts when enabled), in its QUIC namespace.
+	stdTLSConfig.ClientSessionCache = commontls.QUICSessionCache(stdTLSConfig.ClientSessionCache)
 
 	t.tlsConfig = stdTLSConfig
 
@@ -146,12 +148,14 @@ func (t *Transport) initClient() error {
 		DisablePathMTUDiscovery:        false,
 		EnableDatagrams:                false,
 		Allow0RTT:                      true,
+		TokenStore:                     quicresume.TokenStore(),
 	}
 
 	t.http3Transport = &http3.Transport{
 		TLSClientConfig:    t.tlsConfig,
 		QUICConfig:         t.quicConfig,
 		DisableCompression: true,
+		Dial:               t.dialQUIC,
 	}
 
 	t.client = &http.Client{
@@ -236,14 +240,32 @@ func (t *Transport) SetBypassConfig(cfg *transport.BypassConfig) {
 	t.mu.Lock()
 	defer t.mu.Unlock()
 	t.bypassCfg = cfg
-	if t.http3Transport == nil {
-		return
-	}
-	if cfg != nil && cfg.UDPListenConfig != nil {
-		t.http3Transport.Dial = t.makeBypassQUICDial(cfg.UDPListenConfig, cfg.LocalIP)
+}
+
+// dialQUIC is the http3.Transport dial hook. It uses DialEarly so a resumed
+// session can start in 0-RTT; http3 only sends GET_0RTT requests before the
+// handshake completes, so the tunnel POST (not replay-safe) still waits for
+// it. In TUN mode the dial goes through the bypass socket.
+func (t *Transport) dialQUIC(ctx context.Context, addr string, tlsCfg *tls.Config, cfg *quic.Config) (*quic.Conn, error) {
+	t.mu.RLock()
+	bypassCfg := t.bypassCfg
+	t.mu.RUnlock()
+
+	var conn *quic.Conn
+	var err error
+	if bypassCfg != nil && bypassCfg.UDPListenConfig != nil {
+		conn, err = t.makeBypassQUICDial(bypassCfg.UDPListenConfig, bypassCfg.LocalIP)(ctx, addr, tlsCfg, cfg)
 	} else {
-		t.http3Transport.Dial = nil
+		conn, err = quic.DialAddrEarly(ctx, addr, tlsCfg, cfg)
 	}
+	if parsed, perr := transport.ParseAddress(t.serverAddr); perr == nil {
+		transport.ReportDial(bypassCfg, parsed.Host, addr, 0, err)
+	}
+	if err != nil {
+		return nil, err
+	}
+	quicresume.Track(conn)
+	return conn, nil
 }
 
 // makeBypassQUICDial returns an http3.Transport.Dial function that uses a UDP
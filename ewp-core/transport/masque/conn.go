@@ -50,6 +50,9 @@ type Conn struct {
 	// Used as the context for ReceiveDatagram so that goroutines blocked on datagram
 	// reads are unblocked when the connection dies (H-2: prevents goroutine leaks).
 	connCtx    context.Context
+	// handshakeDone is closed once the QUIC handshake completes. Until then
+	// the connection may be in 0-RTT, whose data an attacker can replay.
+	handshakeDone <-chan struct{}
 	uuid       [16]byte
 	template   *uritemplate.Template
 
@@ -58,8 +61,8 @@ type Conn struct {
 	udpTarget netip.AddrPort
 }
 
-func newConn(cc *http3.ClientConn, uuid [16]byte, tmpl *uritemplate.Template) *Conn {
-	return &Conn{clientConn: cc, connCtx: cc.Context(), uuid: uuid, template: tmpl}
+func newConn(cc *http3.ClientConn, handshakeDone <-chan struct{}, uuid [16]byte, tmpl *uritemplate.Template) *Conn {
+	return &Conn{clientConn: cc, connCtx: cc.Context(), handshakeDone: handshakeDone, uuid: uuid, template: tmpl}
 }
 
 // ── TCP ──────────────────────────────────────────────────────────────────────
@@ -82,6 +85,18 @@ func (c *Conn) Connect(target string, initialData []byte) error {
 	ctx, cancel := context.WithTimeout(context.Background(), 15*time.Second)
 	defer cancel()
 
+	// A TCP CONNECT plus its initial data is not replay-safe: never send it
+	// in 0-RTT. CONNECT-UDP may go early (datagrams tolerate duplication).
+	if c.handshakeDone != nil {
+		select {
+		case <-c.handshakeDone:
+		case <-c.connCtx.Done():
+			return fmt.Errorf("masque: connection closed before handshake completed")
+		case <-ctx.Done():
+			return fmt.Errorf("masque: handshake: %w", ctx.Err())
+		}
+	}
+
 	rstr, err := c.clientConn.OpenRequestStream(ctx)
 	if err != nil {
 		return fmt.Errorf("masque: open request stream: %w", err)
@@ -277,6 +292,11 @@ func (c *Conn) Close() error {
 	return nil
 }
 
+// UDPPinned reports true: a CONNECT-UDP stream is bound to one target.
+func (c *Conn) UDPPinned() bool {
+	return true
+}
+
 // StartPing is a no-op; QUIC KeepAlivePeriod handles liveness.
 func (c *Conn) StartPing(_ time.Duration) chan struct{} {
 	return nil
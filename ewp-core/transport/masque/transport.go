@@ -9,6 +9,7 @@ import (
 	"sync"
 	"time"
 
+	"ewp-core/common/quicresume"
 	commontls "ewp-core/common/tls"
 	"ewp-core/log"
 	"ewp-core/transport"
@@ -123,7 +124,7 @@ func (t *Transport) initConfigs() error {
 		return fmt.Errorf("masque: get TLS config: %w", err)
 	}
 	stdTLS.NextProtos = []string{http3.NextProtoH3}
-	stdTLS.ClientSessionCache = tls.NewLRUClientSessionCache(64)
+	stdTLS.ClientSessionCache = commontls.QUICSessionCache(stdTLS.ClientSessionCache)
 	t.tlsConfig = stdTLS
 
 	t.quicConfig = &quic.Config{
@@ -136,7 +137,7 @@ func (t *Transport) initConfigs() error {
 		MaxIdleTimeout:                 90 * time.Second,
 		KeepAlivePeriod:                10 * time.Second,
 		InitialPacketSize:              1280,
-		TokenStore:                     quic.NewLRUTokenStore(16, 5),
+		TokenStore:                     quicresume.TokenStore(),
 		EnableDatagrams:                true,
 		Allow0RTT:                      true,
 	}
@@ -209,24 +210,32 @@ func (t *Transport) Close() error {
 
 // Dial returns a TunnelConn backed by an HTTP/3 stream on the shared QUIC connection.
 func (t *Transport) Dial() (transport.TunnelConn, error) {
-	cc, err := t.getClientConn()
+	cc, qconn, err := t.getClientConn()
 	if err != nil {
 		return nil, err
 	}
-	return newConn(cc, t.uuid, t.udpTemplate), nil
+	return newConn(cc, qconn.HandshakeComplete(), t.uuid, t.udpTemplate), nil
 }
 
-// getClientConn returns the live http3.ClientConn, reconnecting if needed.
-func (t *Transport) getClientConn() (*http3.ClientConn, error) {
+// liveConn is the singleflight result of connect().
+type liveConn struct {
+	cc    *http3.ClientConn
+	qconn *quic.Conn
+}
+
+// getClientConn returns the live http3.ClientConn and its QUIC connection,
+// reconnecting if needed.
+func (t *Transport) getClientConn() (*http3.ClientConn, *quic.Conn, error) {
 	t.mu.Lock()
 	cc := t.clientConn
+	qconn := t.quicConn
 	t.mu.Unlock()
 
 	if cc != nil {
 		select {
 		case <-cc.Context().Done():
 		default:
-			return cc, nil
+			return cc, qconn, nil
 		}
 		log.V("[MASQUE] ClientConn dead, reconnecting")
 		t.mu.Lock()
@@ -237,25 +246,26 @@ func (t *Transport) getClientConn() (*http3.ClientConn, error) {
 	}
 
 	if err := t.waitBackoff(); err != nil {
-		return nil, err
+		return nil, nil, err
 	}
 
 	v, err, _ := t.sfGroup.Do("connect", func() (interface{}, error) {
-		cc, err := t.connect()
+		lc, err := t.connect()
 		if err != nil {
 			t.recordBackoffFailure()
 			return nil, err
 		}
 		t.resetBackoff()
-		return cc, nil
+		return lc, nil
 	})
 	if err != nil {
-		return nil, err
+		return nil, nil, err
 	}
-	return v.(*http3.ClientConn), nil
+	lc := v.(*liveConn)
+	return lc.cc, lc.qconn, nil
 }
 
-func (t *Transport) connect() (*http3.ClientConn, error) {
+func (t *Transport) connect() (*liveConn, error) {
 	t.mu.Lock()
 	tlsConfig := t.tlsConfig
 	quicConfig := t.quicConfig
@@ -284,15 +294,22 @@ func (t *Transport) connect() (*http3.ClientConn, error) {
 	ctx, cancel := context.WithTimeout(context.Background(), 15*time.Second)
 	defer cancel()
 
+	// DialEarly: with a cached session the connection is usable in 0-RTT.
+	// Only replay-safe requests go out before the handshake completes
+	// (see Conn.Connect).
 	var qconn *quic.Conn
 	if bypassCfg != nil && bypassCfg.UDPListenConfig != nil {
 		qconn, err = t.bypassDial(ctx, addr, tlsConfig, quicConfig, bypassCfg)
 	} else {
-		qconn, err = quic.DialAddr(ctx, addr, tlsConfig, quicConfig)
+		qconn, err = quic.DialAddrEarly(ctx, addr, tlsConfig, quicConfig)
 	}
+	// A QUIC endpoint usually does not answer the resolver's TCP probes;
+	// dial outcomes are what it learns about this edge.
+	transport.ReportDial(bypassCfg, parsed.Host, addr, 0, err)
 	if err != nil {
 		return nil, fmt.Errorf("masque: QUIC dial %s: %w", addr, err)
 	}
+	quicresume.Track(qconn)
 
 	h3tr := &http3.Transport{EnableDatagrams: true}
 	cc := h3tr.NewClientConn(qconn)
@@ -329,7 +346,7 @@ func (t *Transport) connect() (*http3.ClientConn, error) {
 	t.mu.Unlock()
 
 	log.V("[MASQUE] Connected to %s", t.serverAddr)
-	return cc, nil
+	return &liveConn{cc: cc, qconn: qconn}, nil
 }
 
 func (t *Transport) bypassDial(ctx context.Context, addr string, tlsCfg *tls.Config, qCfg *quic.Config, cfg *transport.BypassConfig) (*quic.Conn, error) {
@@ -0,0 +1,194 @@
+package mux
+
+import (
+	"encoding/binary"
+	"fmt"
+	"io"
+	"net/netip"
+	"time"
+
+	"ewp-core/protocol/trojan"
+	"ewp-core/transport"
+
+	"github.com/xtaci/smux"
+)
+
+// Conn is one smux stream presented as a transport.TunnelConn.
+// TCP streams carry raw payload after the request header; UDP streams carry
+// Trojan UDP frames: [Addr][Length:2][CRLF][Payload].
+type Conn struct {
+	stream *smux.Stream
+
+	// hdr is scratch space for decoding UDP frame headers
+	// (largest: domain address 1+1+255+2, plus length and CRLF).
+	hdr [trojan.MaxSocksaddrLength + 4]byte
+}
+
+func newConn(stream *smux.Stream) *Conn {
+	return &Conn{stream: stream}
+}
+
+// --- Connect ---
+
+func (c *Conn) Connect(target string, initialData []byte) error {
+	addr, err := trojan.ParseAddress(target)
+	if err != nil {
+		return fmt.Errorf("parse address: %w", err)
+	}
+	addrBytes, err := addr.Encode()
+	if err != nil {
+		return fmt.Errorf("encode address: %w", err)
+	}
+
+	buf := make([]byte, 0, 1+len(addrBytes)+len(initialData))
+	buf = append(buf, trojan.CommandTCP)
+	buf = append(buf, addrBytes...)
+	buf = append(buf, initialData...)
+	if _, err := c.stream.Write(buf); err != nil {
+		return fmt.Errorf("mux stream request: %w", err)
+	}
+	return nil
+}
+
+func (c *Conn) ConnectUDP(target transport.Endpoint, initialData []byte) error {
+	buf := make([]byte, 0, 1+trojan.MaxSocksaddrLength+4+len(initialData))
+	buf = append(buf, trojan.CommandUDP)
+	buf = appendEndpoint(buf, target)
+	if len(initialData) > 0 {
+		buf = appendUDPFrame(buf, target, initialData)
+	}
+	if _, err := c.stream.Write(buf); err != nil {
+		return fmt.Errorf("mux UDP stream request: %w", err)
+	}
+	return nil
+}
+
+// --- UDP ---
+
+func (c *Conn) WriteUDP(target transport.Endpoint, data []byte) error {
+	buf := make([]byte, 0, trojan.MaxSocksaddrLength+4+len(data))
+	buf = appendUDPFrame(buf, target, data)
+	_, err := c.stream.Write(buf)
+	return err
+}
+
+func (c *Conn) ReadUDP() ([]byte, error) {
+	n, _, err := c.readUDPHeader()
+	if err != nil {
+		return nil, err
+	}
+	payload := make([]byte, n)
+	if _, err := io.ReadFull(c.stream, payload); err != nil {
+		return nil, err
+	}
+	return payload, nil
+}
+
+func (c *Conn) ReadUDPTo(buf []byte) (int, error) {
+	n, _, err := c.ReadUDPFrom(buf)
+	return n, err
+}
+
+func (c *Conn) ReadUDPFrom(buf []byte) (int, netip.AddrPort, error) {
+	n, addrLen, err := c.readUDPHeader()
+	if err != nil {
+		return 0, netip.AddrPort{}, err
+	}
+	remote := decodeAddrPort(c.hdr[:addrLen])
+
+	if n > len(buf) {
+		// Drain the oversized datagram so the stream stays framed.
+		if _, err := io.CopyN(io.Discard, c.stream, int64(n)); err != nil {
+			return 0, netip.AddrPort{}, err
+		}
+		return 0, remote, fmt.Errorf("mux UDP packet too large: %d > %d", n, len(buf))
+	}
+	if _, err := io.ReadFull(c.stream, buf[:n]); err != nil {
+		return 0, netip.AddrPort{}, err
+	}
+	return n, remote, nil
+}
+
+// readUDPHeader reads [Addr][Length:2][CRLF] into c.hdr and returns the
+// payload length and the encoded address length.
+func (c *Conn) readUDPHeader() (int, int, error) {
+	if _, err := io.ReadFull(c.stream, c.hdr[:1]); err != nil {
+		return 0, 0, err
+	}
+	var addrLen int
+	switch c.hdr[0] {
+	case trojan.AddressTypeIPv4:
+		addrLen = 1 + 4 + 2
+	case trojan.AddressTypeIPv6:
+		addrLen = 1 + 16 + 2
+	case trojan.AddressTypeDomain:
+		if _, err := io.ReadFull(c.stream, c.hdr[1:2]); err != nil {
+			return 0, 0, err
+		}
+		addrLen = 1 + 1 + int(c.hdr[1]) + 2
+	default:
+		return 0, 0, fmt.Errorf("unknown trojan address type: %d", c.hdr[0])
+	}
+
+	start := 1
+	if c.hdr[0] == trojan.AddressTypeDomain {
+		start = 2
+	}
+	if _, err := io.ReadFull(c.stream, c.hdr[start:addrLen+4]); err != nil {
+		return 0, 0, err
+	}
+	n := int(binary.BigEndian.Uint16(c.hdr[addrLen : addrLen+2]))
+	return n, addrLen, nil
+}
+
+// --- Stream ---
+
+func (c *Conn) Read(buf []byte) (int, error) {
+	return c.stream.Read(buf)
+}
+
+func (c *Conn) Write(data []byte) error {
+	_, err := c.stream.Write(data)
+	return err
+}
+
+func (c *Conn) Close() error {
+	return c.stream.Close()
+}
+
+// StartPing is a no-op per stream: the session's underlying tunnel is pinged
+// once by the Transport. A non-nil channel is returned because some callers
+// close it unconditionally.
+func (c *Conn) StartPing(interval time.Duration) chan struct{} {
+	return make(chan struct{})
+}
+
+// --- helpers ---
+
+func appendEndpoint(buf []byte, target transport.Endpoint) []byte {
+	if target.Domain != "" {
+		buf = append(buf, trojan.AddressTypeDomain, byte(len(target.Domain)))
+		buf = append(buf, target.Domain...)
+		return append(buf, byte(target.Port>>8), byte(target.Port))
+	}
+	return trojan.AppendAddrPort(buf, netip.AddrPortFrom(target.Addr.Addr().Unmap(), target.Addr.Port()))
+}
+
+func appendUDPFrame(buf []byte, target transport.Endpoint, payload []byte) []byte {
+	buf = appendEndpoint(buf, target)
+	buf = append(buf, byte(len(payload)>>8), byte(len(payload)))
+	buf = append(buf, trojan.CRLF...)
+	return append(buf, payload...)
+}
+
+func decodeAddrPort(b []byte) netip.AddrPort {
+	switch b[0] {
+	case trojan.AddressTypeIPv4:
+		ip := netip.AddrFrom4(*(*[4]byte)(b[1:5]))
+		return netip.AddrPortFrom(ip, binary.BigEndian.Uint16(b[5:7]))
+	case trojan.AddressTypeIPv6:
+		ip := netip.AddrFrom16(*(*[16]byte)(b[1:17]))
+		return netip.AddrPortFrom(ip, binary.BigEndian.Uint16(b[17:19]))
+	}
+	return netip.AddrPort{}
+}
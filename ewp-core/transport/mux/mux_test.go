@@ -0,0 +1,358 @@
+package mux
+
+// Correctness tests and new-connection latency benchmarks for the Trojan mux
+// client. The fake transport simulates the TLS + transport handshake cost with
+// a fixed sleep per Dial and serves the Trojan protocol over net.Pipe using the
+// real server-side protocol/trojan mux implementation.
+//
+// Run:
+//   go test -count=1 ./transport/mux/...
+//   go test -run=^$ -bench=ParallelShortRequests -benchtime=2000x ./transport/mux/
+
+import (
+	"bytes"
+	"context"
+	"fmt"
+	"io"
+	"net"
+	"net/netip"
+	"sync/atomic"
+	"testing"
+	"time"
+
+	"ewp-core/protocol/trojan"
+	"ewp-core/transport"
+)
+
+const testPassword = "mux-test-password"
+
+// ── fake transport ───────────────────────────────────────────────────────────
+
+type fakeTransport struct {
+	handshake time.Duration
+	dials     atomic.Int64
+	// stall, when set, blocks every Dial after the first until it is closed
+	// (a blackholed server).
+	stall chan struct{}
+}
+
+func (f *fakeTransport) Name() string                            { return "Fake+Trojan" }
+func (f *fakeTransport) SetBypassConfig(*transport.BypassConfig) {}
+
+func (f *fakeTransport) Dial() (transport.TunnelConn, error) {
+	if f.dials.Add(1) > 1 && f.stall != nil {
+		<-f.stall
+	}
+	if f.handshake > 0 {
+		time.Sleep(f.handshake)
+	}
+	client, server := net.Pipe()
+	go serveTrojan(server)
+	return &fakeTunnel{conn: client, key: trojan.GenerateKey(testPassword)}, nil
+}
+
+type fakeTunnel struct {
+	conn net.Conn
+	key  [trojan.KeyLength]byte
+}
+
+func (c *fakeTunnel) handshake(command byte, target string, payload []byte) error {
+	addr, err := trojan.ParseAddress(target)
+	if err != nil {
+		return err
+	}
+	return trojan.WriteHandshake(c.conn, c.key, command, addr, payload)
+}
+
+func (c *fakeTunnel) Connect(target string, initialData []byte) error {
+	return c.handshake(trojan.CommandTCP, target, initialData)
+}
+func (c *fakeTunnel) ConnectMux() error {
+	return c.handshake(trojan.CommandMux, trojan.MuxTarget, nil)
+}
+func (c *fakeTunnel) ConnectUDP(transport.Endpoint, []byte) error {
+	return fmt.Errorf("not implemented")
+}
+func (c *fakeTunnel) WriteUDP(transport.Endpoint, []byte) error { return fmt.Errorf("not implemented") }
+func (c *fakeTunnel) ReadUDP() ([]byte, error)                  { return nil, fmt.Errorf("not implemented") }
+func (c *fakeTunnel) ReadUDPTo([]byte) (int, error)             { return 0, fmt.Errorf("not implemented") }
+func (c *fakeTunnel) ReadUDPFrom([]byte) (int, netip.AddrPort, error) {
+	return 0, netip.AddrPort{}, fmt.Errorf("not implemented")
+}
+func (c *fakeTunnel) Read(buf []byte) (int, error) { return c.conn.Read(buf) }
+func (c *fakeTunnel) Write(data []byte) error {
+	_, err := c.conn.Write(data)
+	return err
+}
+func (c *fakeTunnel) Close() error                          { return c.conn.Close() }
+func (c *fakeTunnel) StartPing(time.Duration) chan struct{} { return make(chan struct{}) }
+
+// ── fake server ──────────────────────────────────────────────────────────────
+
+func serveTrojan(conn net.Conn) {
+	defer conn.Close()
+	keys := map[[trojan.KeyLength]byte]string{trojan.GenerateKey(testPassword): testPassword}
+	user, command, _, err := trojan.ReadHandshake(conn, keys)
+	if err != nil {
+		return
+	}
+	switch command {
+	case trojan.CommandMux:
+		trojan.HandleMuxConnection(context.Background(), conn, user, echoHandler{})
+	case trojan.CommandTCP:
+		io.Copy(conn, conn)
+	}
+}
+
+type echoHandler struct{}
+
+func (echoHandler) HandleTCP(ctx context.Context, conn net.Conn, target string, user string) error {
+	_, err := io.Copy(conn, conn)
+	return err
+}
+
+func (echoHandler) HandleUDP(ctx context.Context, conn *trojan.PacketConn, target string, user string) error {
+	for {
+		payload, addr, err := conn.ReadPacket()
+		if err != nil {
+			return err
+		}
+		if err := conn.WritePacket(payload, addr); err != nil {
+			return err
+		}
+	}
+}
+
+// ── tests ────────────────────────────────────────────────────────────────────
+
+func TestMuxTCPRoundTripReusesSession(t *testing.T) {
+	ft := &fakeTransport{}
+	tr := New(ft, 4)
+	defer tr.Close()
+
+	for i := 0; i < 10; i++ {
+		conn, err := tr.Dial()
+		if err != nil {
+			t.Fatalf("dial %d: %v", i, err)
+		}
+		msg := []byte(fmt.Sprintf("hello-%d", i))
+		if err := conn.Connect("example.com:80", msg); err != nil {
+			t.Fatalf("connect %d: %v", i, err)
+		}
+		got := make([]byte, len(msg))
+		if _, err := io.ReadFull(readerOf(conn), got); err != nil {
+			t.Fatalf("read %d: %v", i, err)
+		}
+		if !bytes.Equal(got, msg) {
+			t.Fatalf("echo %d: got %q want %q", i, got, msg)
+		}
+		conn.Close()
+	}
+
+	if n := ft.dials.Load(); n != 1 {
+		t.Fatalf("sequential streams must share one session: dials=%d", n)
+	}
+}
+
+func TestMuxConcurrencyOpensNewSession(t *testing.T) {
+	ft := &fakeTransport{}
+	tr := New(ft, 2)
+	defer tr.Close()
+
+	var conns []transport.TunnelConn
+	for i := 0; i < 3; i++ {
+		conn, err := tr.Dial()
+		if err != nil {
+			t.Fatalf("dial %d: %v", i, err)
+		}
+		conns = append(conns, conn)
+	}
+	defer func() {
+		for _, c := range conns {
+			c.Close()
+		}
+	}()
+
+	if n := ft.dials.Load(); n != 2 {
+		t.Fatalf("3 streams at concurrency 2 must use 2 sessions: dials=%d", n)
+	}
+	if sessions, streams := tr.Stats(); sessions != 2 || streams != 3 {
+		t.Fatalf("stats: sessions=%d streams=%d, want 2/3", sessions, streams)
+	}
+}
+
+func TestMuxStalledDialDoesNotBlockReuse(t *testing.T) {
+	ft := &fakeTransport{stall: make(chan struct{})}
+	tr := New(ft, 2)
+	defer tr.Close()
+	defer close(ft.stall)
+
+	a1, err := tr.Dial()
+	if err != nil {
+		t.Fatalf("dial 1: %v", err)
+	}
+	defer a1.Close()
+	a2, err := tr.Dial()
+	if err != nil {
+		t.Fatalf("dial 2: %v", err)
+	}
+
+	// The first session is full: the third Dial starts a second session,
+	// whose handshake never completes.
+	go func() {
+		if conn, err := tr.Dial(); err == nil {
+			conn.Close()
+		}
+	}()
+	for ft.dials.Load() < 2 {
+		time.Sleep(time.Millisecond)
+	}
+
+	a2.Close()
+	for deadline := time.Now().Add(2 * time.Second); ; {
+		if _, streams := tr.Stats(); streams == 1 {
+			break
+		}
+		if time.Now().After(deadline) {
+			t.Fatal("closed stream still counted on its session")
+		}
+		time.Sleep(time.Millisecond)
+	}
+
+	done := make(chan error, 1)
+	go func() {
+		conn, err := tr.Dial()
+		if err == nil {
+			conn.Close()
+		}
+		done <- err
+	}()
+	select {
+	case err := <-done:
+		if err != nil {
+			t.Fatalf("dial on freed slot: %v", err)
+		}
+	case <-time.After(2 * time.Second):
+		t.Fatal("Dial blocked behind a stalled session handshake")
+	}
+	if n := ft.dials.Load(); n != 2 {
+		t.Fatalf("freed slot must be reused: dials=%d", n)
+	}
+}
+
+func TestMuxConcurrentDialsShareSession(t *testing.T) {
+	ft := &fakeTransport{handshake: 20 * time.Millisecond}
+	tr := New(ft, 4)
+	defer tr.Close()
+
+	conns := make(chan transport.TunnelConn, 4)
+	errs := make(chan error, 4)
+	for i := 0; i < 4; i++ {
+		go func() {
+			conn, err := tr.Dial()
+			if err != nil {
+				errs <- err
+				return
+			}
+			conns <- conn
+		}()
+	}
+	for i := 0; i < 4; i++ {
+		select {
+		case err := <-errs:
+			t.Fatalf("dial: %v", err)
+		case conn := <-conns:
+			defer conn.Close()
+		}
+	}
+	if n := ft.dials.Load(); n != 1 {
+		t.Fatalf("4 concurrent dials at concurrency 4 must share one handshake: dials=%d", n)
+	}
+}
+
+func TestMuxUDPRoundTrip(t *testing.T) {
+	tr := New(&fakeTransport{}, 4)
+	defer tr.Close()
+
+	conn, err := tr.Dial()
+	if err != nil {
+		t.Fatalf("dial: %v", err)
+	}
+	defer conn.Close()
+
+	target := transport.Endpoint{Addr: netip.MustParseAddrPort("1.2.3.4:53")}
+	if err := conn.ConnectUDP(target, []byte("ping")); err != nil {
+		t.Fatalf("connect udp: %v", err)
+	}
+	if err := conn.WriteUDP(target, []byte("pong")); err != nil {
+		t.Fatalf("write udp: %v", err)
+	}
+
+	buf := make([]byte, 64)
+	for _, want := range []string{"ping", "pong"} {
+		n, from, err := conn.ReadUDPFrom(buf)
+		if err != nil {
+			t.Fatalf("read udp: %v", err)
+		}
+		if string(buf[:n]) != want || from != target.Addr {
+			t.Fatalf("got %q from %v, want %q from %v", buf[:n], from, want, target.Addr)
+		}
+	}
+}
+
+// ── benchmarks ───────────────────────────────────────────────────────────────
+
+// BenchmarkParallelShortRequests measures new-connection latency for many
+// parallel short request/response exchanges. Each Dial on the fake transport
+// costs 2ms (a stand-in for the TLS + transport handshake); with mux only the
+// first stream per session pays it.
+func BenchmarkParallelShortRequests(b *testing.B) {
+	run := func(b *testing.B, dial func(*fakeTransport) transport.Transport) {
+		ft := &fakeTransport{handshake: 2 * time.Millisecond}
+		tr := dial(ft)
+		req := bytes.Repeat([]byte{'x'}, 64)
+
+		b.SetParallelism(8)
+		b.ResetTimer()
+		b.RunParallel(func(pb *testing.PB) {
+			resp := make([]byte, len(req))
+			for pb.Next() {
+				conn, err := tr.Dial()
+				if err != nil {
+					b.Error(err)
+					return
+				}
+				if err := conn.Connect("example.com:80", req); err != nil {
+					b.Error(err)
+					conn.Close()
+					return
+				}
+				if _, err := io.ReadFull(readerOf(conn), resp); err != nil {
+					b.Error(err)
+				}
+				conn.Close()
+			}
+		})
+		b.StopTimer()
+		b.ReportMetric(float64(ft.dials.Load())/float64(b.N), "dials/op")
+		if c, ok := tr.(io.Closer); ok {
+			c.Close()
+		}
+	}
+
+	b.Run("direct", func(b *testing.B) {
+		run(b, func(ft *fakeTransport) transport.Transport { return ft })
+	})
+	b.Run("mux", func(b *testing.B) {
+		run(b, func(ft *fakeTransport) transport.Transport { return New(ft, DefaultConcurrency) })
+	})
+}
+
+// readerOf adapts TunnelConn.Read to io.Reader for io.ReadFull.
+func readerOf(c transport.TunnelConn) io.Reader {
+	return readerFunc(c.Read)
+}
+
+type readerFunc func([]byte) (int, error)
+
+func (f readerFunc) Read(p []byte) (int, error) { return f(p) }
@@ -0,0 +1,295 @@
+// Package mux multiplexes Trojan tunnel connections over a small pool of
+// smux sessions. Each session is one underlying transport connection opened
+// with Trojan CommandMux; every Dial() opens a new smux stream instead of
+// paying a fresh TLS + transport handshake.
+//
+// Wire format matches protocol/trojan/mux.go on the server side:
+//
+//	stream := [Command:1][Trojan address][payload...]
+package mux
+
+import (
+	"fmt"
+	"io"
+	"sync"
+	"time"
+
+	"ewp-core/log"
+	"ewp-core/transport"
+
+	"github.com/xtaci/smux"
+)
+
+const (
+	// DefaultConcurrency is the number of streams carried by one session
+	// before a new underlying tunnel is opened.
+	DefaultConcurrency = 8
+
+	// sessionPingInterval keeps the underlying tunnel alive at the transport
+	// level (WebSocket ping, etc.). smux keepalive is disabled because the
+	// server side runs with KeepAliveDisabled and never answers NOPs.
+	sessionPingInterval = 30 * time.Second
+)
+
+// Transport wraps a Trojan transport and hands out smux streams.
+type Transport struct {
+	inner       transport.Transport
+	concurrency int
+
+	mu       sync.Mutex
+	sessions []*session
+	dialing  []*pendingSession // sessions being set up, not yet in sessions
+}
+
+type session struct {
+	tunnel   transport.TunnelConn
+	smux     *smux.Session
+	stopPing chan struct{}
+
+	// Guarded by Transport.mu.
+	opening  int  // streams being opened outside the lock
+	draining bool // OpenStream failed; closed once its streams end
+}
+
+// pendingSession is a session dial in flight. Up to concurrency callers
+// wait on it instead of dialing their own; done is closed once the
+// session is in Transport.sessions (or err is set).
+type pendingSession struct {
+	done  chan struct{}
+	slots int // streams promised to waiters, the dialer's own included
+	err   error
+}
+
+// load is the number of streams on s, counting those being opened.
+func (s *session) load() int {
+	return s.smux.NumStreams() + s.opening
+}
+
+// New wraps inner so that Dial() returns streams multiplexed over at most
+// ceil(active/concurrency) underlying tunnels. concurrency <= 0 selects
+// DefaultConcurrency.
+func New(inner transport.Transport, concurrency int) *Transport {
+	if concurrency <= 0 {
+		concurrency = DefaultConcurrency
+	}
+	return &Transport{
+		inner:       inner,
+		concurrency: concurrency,
+	}
+}
+
+func (t *Transport) Name() string {
+	return t.inner.Name() + "+Mux"
+}
+
+func (t *Transport) SetBypassConfig(cfg *transport.BypassConfig) {
+	t.inner.SetBypassConfig(cfg)
+}
+
+// Dial opens a new stream on the least-loaded session that still has
+// capacity. When all are full it joins a session dial already in flight
+// that has room, or starts a new one. The lock is never held across a
+// dial or a stream open, so a slow or blackholed handshake only delays
+// the callers waiting for that session.
+func (t *Transport) Dial() (transport.TunnelConn, error) {
+	for {
+		t.mu.Lock()
+		if s := t.pickLocked(); s != nil {
+			s.opening++
+			t.mu.Unlock()
+			if conn, ok := t.openStream(s); ok {
+				return conn, nil
+			}
+			continue
+		}
+
+		var wait *pendingSession
+		for _, p := range t.dialing {
+			if p.slots < t.concurrency {
+				wait = p
+				break
+			}
+		}
+		if wait != nil {
+			wait.slots++
+			t.mu.Unlock()
+			<-wait.done
+			if wait.err != nil {
+				return nil, wait.err
+			}
+			continue // take a slot on the new session like any caller
+		}
+
+		p := &pendingSession{done: make(chan struct{}), slots: 1}
+		t.dialing = append(t.dialing, p)
+		t.mu.Unlock()
+		return t.dialSession(p)
+	}
+}
+
+// pickLocked prunes closed sessions and returns the least-loaded one with
+// a free stream slot, or nil.
+func (t *Transport) pickLocked() *session {
+	var best *session
+	live := t.sessions[:0]
+	for _, s := range t.sessions {
+		if s.smux.IsClosed() || (s.draining && s.load() == 0) {
+			s.close()
+			continue
+		}
+		live = append(live, s)
+		if s.draining {
+			continue
+		}
+		if n := s.load(); n < t.concurrency && (best == nil || n < best.load()) {
+			best = s
+		}
+	}
+	for i := len(live); i < len(t.sessions); i++ {
+		t.sessions[i] = nil
+	}
+	t.sessions = live
+	return best
+}
+
+// openStream opens a stream on s, for which the caller has counted itself
+// in s.opening. A session that refuses streams is drained.
+func (t *Transport) openStream(s *session) (*Conn, bool) {
+	stream, err := s.smux.OpenStream()
+	t.mu.Lock()
+	s.opening--
+	if err != nil {
+		s.draining = true
+	}
+	t.mu.Unlock()
+	if err != nil {
+		log.V("[Mux] Open stream on existing session failed: %v", err)
+		return nil, false
+	}
+	return newConn(stream), true
+}
+
+// dialSession sets up the session promised by p, publishes it to the
+// callers waiting on p and opens the dialer's own stream on it.
+func (t *Transport) dialSession(p *pendingSession) (transport.TunnelConn, error) {
+	s, err := t.newSession()
+
+	t.mu.Lock()
+	for i, q := range t.dialing {
+		if q == p {
+			t.dialing = append(t.dialing[:i], t.dialing[i+1:]...)
+			break
+		}
+	}
+	if err == nil {
+		s.opening++ // the dialer's slot, taken before waiters can pick
+		t.sessions = append(t.sessions, s)
+		log.V("[Mux] New session over %s (%d active)", t.inner.Name(), len(t.sessions))
+	}
+	p.err = err
+	close(p.done)
+	t.mu.Unlock()
+	if err != nil {
+		return nil, err
+	}
+
+	stream, err := s.smux.OpenStream()
+	t.mu.Lock()
+	s.opening--
+	t.mu.Unlock()
+	if err != nil {
+		return nil, fmt.Errorf("mux open stream: %w", err)
+	}
+	return newConn(stream), nil
+}
+
+func (t *Transport) newSession() (*session, error) {
+	tunnel, err := t.inner.Dial()
+	if err != nil {
+		return nil, err
+	}
+
+	mc, ok := tunnel.(transport.MuxConnector)
+	if !ok {
+		tunnel.Close()
+		return nil, fmt.Errorf("mux: %s does not support trojan mux", t.inner.Name())
+	}
+	if err := mc.ConnectMux(); err != nil {
+		tunnel.Close()
+		return nil, fmt.Errorf("mux handshake: %w", err)
+	}
+
+	cfg := smux.DefaultConfig()
+	cfg.KeepAliveDisabled = true
+
+	sess, err := smux.Client(&tunnelStream{tunnel: tunnel}, cfg)
+	if err != nil {
+		tunnel.Close()
+		return nil, fmt.Errorf("mux session: %w", err)
+	}
+
+	return &session{
+		tunnel:   tunnel,
+		smux:     sess,
+		stopPing: tunnel.StartPing(sessionPingInterval),
+	}, nil
+}
+
+func (s *session) close() {
+	if s.stopPing != nil {
+		select {
+		case <-s.stopPing:
+		default:
+			close(s.stopPing)
+		}
+	}
+	s.smux.Close()
+}
+
+// Close tears down every session and its underlying tunnel.
+func (t *Transport) Close() error {
+	t.mu.Lock()
+	defer t.mu.Unlock()
+	for _, s := range t.sessions {
+		s.close()
+	}
+	t.sessions = nil
+	return nil
+}
+
+// Stats returns the number of live sessions and open streams.
+func (t *Transport) Stats() (sessions, streams int) {
+	t.mu.Lock()
+	defer t.mu.Unlock()
+	for _, s := range t.sessions {
+		if s.smux.IsClosed() {
+			continue
+		}
+		sessions++
+		streams += s.smux.NumStreams()
+	}
+	return sessions, streams
+}
+
+// tunnelStream adapts a TunnelConn to io.ReadWriteCloser for smux. smux
+// serialises writes in its send loop and reads from a single recv loop.
+type tunnelStream struct {
+	tunnel transport.TunnelConn
+}
+
+var _ io.ReadWriteCloser = (*tunnelStream)(nil)
+
+func (s *tunnelStream) Read(p []byte) (int, error) {
+	return s.tunnel.Read(p)
+}
+
+func (s *tunnelStream) Write(p []byte) (int, error) {
+	if err := s.tunnel.Write(p); err != nil {
+		return 0, err
+	}
+	return len(p), nil
+}
+
+func (s *tunnelStream) Close() error {
+	return s.tunnel.Close()
+}
@@ -2,31 +2,81 @@ package transport
 
 import (
 	"context"
+	"errors"
 	"fmt"
 	"net"
+	"sort"
 	"sync"
+	"sync/atomic"
 	"time"
+
+	"ewp-core/log"
+)
+
+const (
+	edgeCacheTTL       = 60 * time.Second // DNS answers and rankings are refreshed this often
+	edgeRefreshAhead   = 15 * time.Second // ... starting this long before they expire
+	edgeDNSRetry       = 10 * time.Second // a failed refresh is retried after this
+	edgeResolveTimeout = 10 * time.Second
+	edgeProbeTimeout   = 3 * time.Second
+
+	// An IP failing edgeDemoteAfter dials or probes in a row is passed over
+	// for edgeDemoteBase, doubling with each further failure up to
+	// edgeDemoteMax. One success restores it.
+	edgeDemoteAfter = 2
+	edgeDemoteBase  = 30 * time.Second
+	edgeDemoteMax   = 5 * time.Minute
+
+	// Each RTT sample moves the estimate 1/edgeEWMAWeight of the way, as
+	// TCP smooths its RTT; a new edge is only preferred over the current
+	// one when it is edgeSwitchMargin faster, so near-equal edges do not
+	// flap.
+	edgeEWMAWeight   = 4
+	edgeSwitchMargin = 0.9
 )
 
 // BypassResolver resolves hostnames using a DNS connection that bypasses the TUN device.
-// When multiple IPs are returned, all are probed in parallel and the one with the lowest
-// TCP handshake latency is returned (optimal CDN edge-node selection).
-// Results are cached to avoid port exhaustion under high-concurrency TUN traffic.
+// When multiple IPs are returned, each keeps an RTT estimate (EWMA) and a failure count,
+// fed by background TCP probes and by the outcome of real dials (ReportDial), and the
+// fastest IP that is not failing is returned (optimal CDN edge-node selection).
+//
+// Callers never wait for a probe: only the first lookup of a host blocks, and only on DNS.
+// Answers are refreshed and re-probed in the background before they expire, and an IP
+// that keeps failing is demoted so new tunnels fail over to the next one.
 type BypassResolver struct {
-	resolver  *net.Resolver
-	tcpDialer *net.Dialer
+	lookupHost func(ctx context.Context, host string) ([]string, error)
+	tcpDialer  *net.Dialer
 
-	// DNS result cache
+	// DNS result cache, keyed by host:port
 	mu       sync.Mutex
 	cache    map[string]*dnsEntry
 	cacheTTL time.Duration
 }
 
 type dnsEntry struct {
-	ip      string
-	expires time.Time
+	host, port string
+	ready      chan struct{} // closed when the first lookup finishes
+	err        error         // first lookup's error; edges is empty
+
+	edges      []*edgeState // in DNS answer order
+	current    *edgeState   // last IP handed out
+	expires    time.Time
+	refreshing bool
 }
 
+type edgeState struct {
+	ip           string
+	rtt          time.Duration // EWMA; 0 = not measured yet
+	fails        int           // consecutive failures
+	demotedUntil time.Time
+
+	successes, failures int64
+}
+
+// lastResolver is the most recently created resolver, reported by
+// GetEdgeStats. A process has one bypass configuration at a time.
+var lastResolver atomic.Pointer[BypassResolver]
+
 // NewBypassResolver creates a resolver whose DNS queries use the bypass TCP dialer,
 // ensuring DNS traffic does not loop through the TUN device.
 // dnsServer must be "host:port" (e.g. "8.8.8.8:53"). Empty defaults to "8.8.8.8:53".
@@ -41,94 +91,336 @@ func NewBypassResolver(cfg *BypassConfig, dnsServer string) *BypassResolver {
 			return cfg.TCPDialer.DialContext(ctx, "tcp", server)
 		},
 	}
-	return &BypassResolver{
-		resolver:  r,
-		tcpDialer: cfg.TCPDialer,
-		cache:     make(map[string]*dnsEntry),
-		cacheTTL:  60 * time.Second,
+	br := &BypassResolver{
+		lookupHost: r.LookupHost,
+		tcpDialer:  cfg.TCPDialer,
+		cache:      make(map[string]*dnsEntry),
+		cacheTTL:   edgeCacheTTL,
 	}
+	lastResolver.Store(br)
+	return br
 }
 
-// ResolveBestIP resolves host and returns the IP with the lowest TCP latency on port.
-// Results are cached for cacheTTL to prevent port exhaustion in TUN mode.
+// ResolveBestIP resolves host and returns the IP currently ranked best for port.
+// The first call for a host waits for DNS and returns the first answer while the
+// IPs are probed in the background; later calls return immediately from the cache.
 func (r *BypassResolver) ResolveBestIP(host, port string) (string, error) {
-	cacheKey := host + ":" + port
+	key := net.JoinHostPort(host, port)
 
-	// Fast path: check cache
 	r.mu.Lock()
-	if entry, ok := r.cache[cacheKey]; ok && time.Now().Before(entry.expires) {
-		ip := entry.ip
-		r.mu.Unlock()
-		return ip, nil
+	e, ok := r.cache[key]
+	if !ok {
+		e = &dnsEntry{host: host, port: port, ready: make(chan struct{})}
+		r.cache[key] = e
 	}
 	r.mu.Unlock()
+	if !ok {
+		r.refresh(e, true)
+	}
+	<-e.ready
 
-	// Slow path: resolve and probe
-	ctx, cancel := context.WithTimeout(context.Background(), 10*time.Second)
-	defer cancel()
-
-	addrs, err := r.resolver.LookupHost(ctx, host)
-	if err != nil || len(addrs) == 0 {
-		return "", fmt.Errorf("bypass DNS resolve %s: %w", host, err)
+	r.mu.Lock()
+	defer r.mu.Unlock()
+	if len(e.edges) == 0 {
+		// Let the next call try again.
+		if r.cache[key] == e {
+			delete(r.cache, key)
+		}
+		return "", e.err
+	}
+	now := time.Now()
+	if !e.refreshing && now.After(e.expires.Add(-edgeRefreshAhead)) {
+		e.refreshing = true
+		go r.refresh(e, false)
 	}
+	return r.pick(e, now).ip, nil
+}
 
-	var bestIP string
-	if len(addrs) == 1 {
-		bestIP = addrs[0]
-	} else {
-		bestIP = r.probeBestIP(ctx, addrs, port)
+// refresh looks host up again and re-probes its IPs. For the first lookup
+// (first set) it returns once DNS has answered and leaves the probes
+// running; otherwise it runs to completion and clears e.refreshing.
+func (r *BypassResolver) refresh(e *dnsEntry, first bool) {
+	ctx, cancel := context.WithTimeout(context.Background(), edgeResolveTimeout)
+	addrs, err := r.lookupHost(ctx, e.host)
+	cancel()
+	if err == nil && len(addrs) == 0 {
+		err = errors.New("no addresses")
 	}
 
-	// Store in cache
 	r.mu.Lock()
-	r.cache[cacheKey] = &dnsEntry{ip: bestIP, expires: time.Now().Add(r.cacheTTL)}
+	now := time.Now()
+	if err != nil {
+		// Keep serving the previous answer and try again shortly.
+		e.err = fmt.Errorf("bypass DNS resolve %s: %w", e.host, err)
+		e.expires = now.Add(edgeDNSRetry + edgeRefreshAhead)
+	} else {
+		e.merge(addrs)
+		e.expires = now.Add(r.cacheTTL)
+	}
+	var ips []string
+	if len(e.edges) > 1 {
+		ips = make([]string, len(e.edges))
+		for i, ed := range e.edges {
+			ips[i] = ed.ip
+		}
+	}
+	e.refreshing = len(ips) > 0 // stays set while probing
+	if first {
+		close(e.ready)
+	}
 	r.mu.Unlock()
 
-	return bestIP, nil
+	if len(ips) == 0 {
+		return
+	}
+	if first {
+		go r.probe(e, ips)
+	} else {
+		r.probe(e, ips)
+	}
 }
 
-// probeBestIP probes all IPs and returns the one with lowest latency.
-func (r *BypassResolver) probeBestIP(ctx context.Context, addrs []string, port string) string {
-	type probeResult struct {
-		ip      string
-		latency time.Duration
+// merge replaces the IP list with a new DNS answer, keeping the state of
+// IPs that are still present.
+func (e *dnsEntry) merge(addrs []string) {
+	old := make(map[string]*edgeState, len(e.edges))
+	for _, ed := range e.edges {
+		old[ed.ip] = ed
 	}
+	edges := make([]*edgeState, 0, len(addrs))
+	for _, ip := range addrs {
+		ed, ok := old[ip]
+		if !ok {
+			ed = &edgeState{ip: ip}
+		}
+		delete(old, ip) // duplicate answers
+		edges = append(edges, ed)
+	}
+	e.edges = edges
+	if _, gone := old[ipOf(e.current)]; gone {
+		e.current = nil
+	}
+}
 
-	ch := make(chan probeResult, len(addrs))
-	var wg sync.WaitGroup
+func ipOf(ed *edgeState) string {
+	if ed == nil {
+		return ""
+	}
+	return ed.ip
+}
 
-	probeCtx, probeCancel := context.WithTimeout(ctx, 3*time.Second)
-	defer probeCancel()
+// probe measures the TCP handshake time to every IP in parallel and folds
+// the results into their estimates, then clears e.refreshing. A failed
+// probe only counts against an IP when another one answered: if none did,
+// the network is down or the server does not take TCP on that port (QUIC
+// transports), and real dials are the only evidence.
+func (r *BypassResolver) probe(e *dnsEntry, ips []string) {
+	ctx, cancel := context.WithTimeout(context.Background(), edgeProbeTimeout)
+	defer cancel()
 
-	for _, ip := range addrs {
+	rtts := make([]time.Duration, len(ips))
+	errs := make([]error, len(ips))
+	var wg sync.WaitGroup
+	for i, ip := range ips {
 		wg.Add(1)
-		go func(ip string) {
+		go func(i int, ip string) {
 			defer wg.Done()
-			addr := net.JoinHostPort(ip, port)
 			start := time.Now()
-			conn, err := r.tcpDialer.DialContext(probeCtx, "tcp", addr)
-			if err != nil {
-				ch <- probeResult{ip, time.Hour}
-				return
+			conn, err := r.tcpDialer.DialContext(ctx, "tcp", net.JoinHostPort(ip, e.port))
+			rtts[i], errs[i] = time.Since(start), err
+			if err == nil {
+				conn.Close()
+			}
+		}(i, ip)
+	}
+	wg.Wait()
+
+	answered := false
+	for _, err := range errs {
+		answered = answered || err == nil
+	}
+	r.mu.Lock()
+	defer r.mu.Unlock()
+	if answered {
+		for i, ip := range ips {
+			r.observe(e, ip, rtts[i], errs[i])
+		}
+	}
+	e.refreshing = false
+}
+
+// Report records the outcome of a connection to ip for host:port: an error
+// counts toward demoting the IP, a success restores it and, when rtt is
+// non-zero, adds an RTT sample. Unknown hosts and IPs are ignored.
+func (r *BypassResolver) Report(host, port, ip string, rtt time.Duration, err error) {
+	if errors.Is(err, context.Canceled) {
+		return // the caller gave up; says nothing about the edge
+	}
+	r.mu.Lock()
+	defer r.mu.Unlock()
+	e, ok := r.cache[net.JoinHostPort(host, port)]
+	if !ok {
+		return
+	}
+	if r.observe(e, ip, rtt, err) && !e.refreshing && len(e.edges) > 1 {
+		// A demoted edge: re-rank the others now rather than at expiry.
+		e.refreshing = true
+		go r.refresh(e, false)
+	}
+}
+
+// observe updates one IP's estimate. It reports whether the IP was just
+// demoted. r.mu must be held.
+func (r *BypassResolver) observe(e *dnsEntry, ip string, rtt time.Duration, err error) bool {
+	var ed *edgeState
+	for _, x := range e.edges {
+		if x.ip == ip {
+			ed = x
+			break
+		}
+	}
+	if ed == nil {
+		return false
+	}
+	now := time.Now()
+	if err != nil {
+		ed.failures++
+		ed.fails++
+		if ed.fails < edgeDemoteAfter {
+			return false
+		}
+		backoff := edgeDemoteBase << min(ed.fails-edgeDemoteAfter, 8)
+		ed.demotedUntil = now.Add(min(backoff, edgeDemoteMax))
+		return ed.fails == edgeDemoteAfter
+	}
+	ed.successes++
+	ed.fails = 0
+	ed.demotedUntil = time.Time{}
+	if rtt > 0 {
+		if ed.rtt == 0 {
+			ed.rtt = rtt
+		} else {
+			ed.rtt += (rtt - ed.rtt) / edgeEWMAWeight
+		}
+	}
+	return false
+}
+
+// pick returns the IP to dial: the fastest measured one that is not
+// demoted, else the first unmeasured one in DNS order. The current IP is
+// kept unless it is demoted or another is edgeSwitchMargin faster. With
+// every IP demoted, the one whose demotion ends first is tried. r.mu must
+// be held.
+func (r *BypassResolver) pick(e *dnsEntry, now time.Time) *edgeState {
+	var best *edgeState
+	for _, ed := range e.edges {
+		if now.Before(ed.demotedUntil) {
+			continue
+		}
+		if best == nil || ed.rtt > 0 && (best.rtt == 0 || ed.rtt < best.rtt) {
+			best = ed
+		}
+	}
+	if best == nil {
+		for _, ed := range e.edges {
+			if best == nil || ed.demotedUntil.Before(best.demotedUntil) {
+				best = ed
 			}
-			conn.Close()
-			ch <- probeResult{ip, time.Since(start)}
-		}(ip)
+		}
 	}
 
-	go func() {
-		wg.Wait()
-		close(ch)
-	}()
+	cur := e.current
+	if cur != nil && cur != best && !now.Before(cur.demotedUntil) &&
+		cur.rtt > 0 && float64(best.rtt) > float64(cur.rtt)*edgeSwitchMargin {
+		return cur
+	}
+	if cur != nil && cur != best {
+		log.V("[Resolver] %s: edge %s -> %s", e.host, cur.ip, best.ip)
+	}
+	e.current = best
+	return best
+}
 
-	best := probeResult{ip: addrs[0], latency: time.Hour}
-	for result := range ch {
-		if result.latency < best.latency {
-			best = result
+// EdgeStats is one resolved IP of a server as ranked by the bypass resolver.
+type EdgeStats struct {
+	Host      string  `json:"host"` // host:port
+	IP        string  `json:"ip"`
+	RTTMs     float64 `json:"rtt_ms"` // EWMA; 0 = not measured yet
+	Successes int64   `json:"successes"`
+	Failures  int64   `json:"failures"`
+	Demoted   bool    `json:"demoted"`
+	Selected  bool    `json:"selected"` // the IP new connections go to
+}
+
+// Stats returns the state of every cached IP, grouped by host.
+func (r *BypassResolver) Stats() []EdgeStats {
+	r.mu.Lock()
+	defer r.mu.Unlock()
+	now := time.Now()
+	var out []EdgeStats
+	for key, e := range r.cache {
+		for _, ed := range e.edges {
+			out = append(out, EdgeStats{
+				Host:      key,
+				IP:        ed.ip,
+				RTTMs:     float64(ed.rtt) / float64(time.Millisecond),
+				Successes: ed.successes,
+				Failures:  ed.failures,
+				Demoted:   now.Before(ed.demotedUntil),
+				Selected:  ed == e.current,
+			})
 		}
 	}
+	sort.SliceStable(out, func(i, j int) bool { return out[i].Host < out[j].Host })
+	return out
+}
 
-	return best.ip
+// GetEdgeStats returns the edge ranking of the active bypass resolver, or
+// nil when there is none (bypass is only used in TUN mode).
+func GetEdgeStats() []EdgeStats {
+	if r := lastResolver.Load(); r != nil {
+		return r.Stats()
+	}
+	return nil
+}
+
+// DialDirect opens a TCP connection to addr ("host:port") around the
+// tunnel: in TUN mode through the active bypass resolver's DNS and dialer,
+// so it leaves on the physical interface, otherwise with a plain dialer.
+// It tells the GUI supervisor whether the uplink itself works.
+func DialDirect(ctx context.Context, addr string) (net.Conn, error) {
+	r := lastResolver.Load()
+	if r == nil {
+		var d net.Dialer
+		return d.DialContext(ctx, "tcp", addr)
+	}
+	host, port, err := net.SplitHostPort(addr)
+	if err != nil {
+		return nil, err
+	}
+	ips, err := r.lookupHost(ctx, host)
+	if err != nil {
+		return nil, fmt.Errorf("bypass DNS resolve %s: %w", host, err)
+	}
+	if len(ips) == 0 {
+		return nil, fmt.Errorf("bypass DNS resolve %s: no addresses", host)
+	}
+	return r.tcpDialer.DialContext(ctx, "tcp", net.JoinHostPort(ips[0], port))
+}
+
+// ReportDial feeds the outcome of a connection to addr ("ip:port", with the
+// IP from ResolveIP for host) back to cfg's resolver, so that edges failing
+// real connections are demoted and their RTT tracked. rtt is the time to an
+// established connection, 0 when the caller has no clean sample.
+func ReportDial(cfg *BypassConfig, host, addr string, rtt time.Duration, err error) {
+	if cfg == nil || cfg.Resolver == nil {
+		return
+	}
+	ip, port, splitErr := net.SplitHostPort(addr)
+	if splitErr != nil {
+		return
+	}
+	cfg.Resolver.Report(host, port, ip, rtt, err)
 }
 
 // ResolveIP resolves host to an IP address for the given port.
@@ -144,4 +436,3 @@ func ResolveIP(cfg *BypassConfig, host, port string) (string, error) {
 	}
 	return ips[0].String(), nil
 }
-
@@ -0,0 +1,229 @@
+package transport
+
+import (
+	"context"
+	"errors"
+	"net"
+	"sync/atomic"
+	"syscall"
+	"testing"
+	"time"
+)
+
+// newTestResolver returns a resolver whose DNS answers addrs and whose
+// probes dial the given dialer.
+func newTestResolver(d *net.Dialer, addrs ...string) (*BypassResolver, *atomic.Int32) {
+	var lookups atomic.Int32
+	r := &BypassResolver{
+		lookupHost: func(context.Context, string) ([]string, error) {
+			lookups.Add(1)
+			return addrs, nil
+		},
+		tcpDialer: d,
+		cache:     make(map[string]*dnsEntry),
+		cacheTTL:  edgeCacheTTL,
+	}
+	return r, &lookups
+}
+
+// slowDialer stalls every dial for d before failing it.
+func slowDialer(d time.Duration) *net.Dialer {
+	return &net.Dialer{Control: func(string, string, syscall.RawConn) error {
+		time.Sleep(d)
+		return errors.New("unreachable")
+	}}
+}
+
+func waitFor(t *testing.T, cond func() bool) {
+	t.Helper()
+	deadline := time.Now().Add(5 * time.Second)
+	for !cond() {
+		if time.Now().After(deadline) {
+			t.Fatal("condition not reached")
+		}
+		time.Sleep(10 * time.Millisecond)
+	}
+}
+
+func TestResolveDoesNotWaitForProbes(t *testing.T) {
+	r, _ := newTestResolver(slowDialer(time.Second), "192.0.2.1", "192.0.2.2")
+
+	start := time.Now()
+	ip, err := r.ResolveBestIP("edge.example", "443")
+	if err != nil {
+		t.Fatal(err)
+	}
+	if ip != "192.0.2.1" {
+		t.Errorf("got %s, want the first answer before probes finish", ip)
+	}
+	if d := time.Since(start); d > 500*time.Millisecond {
+		t.Errorf("first lookup took %v, blocked on probes", d)
+	}
+}
+
+func TestProbesRankEdges(t *testing.T) {
+	ln, err := net.Listen("tcp", "127.0.0.1:0")
+	if err != nil {
+		t.Fatal(err)
+	}
+	defer ln.Close()
+	go func() {
+		for {
+			c, err := ln.Accept()
+			if err != nil {
+				return
+			}
+			c.Close()
+		}
+	}()
+	_, port, _ := net.SplitHostPort(ln.Addr().String())
+
+	// Nothing listens on 127.0.0.2: its probe is refused.
+	r, _ := newTestResolver(&net.Dialer{}, "127.0.0.2", "127.0.0.1")
+	if ip, _ := r.ResolveBestIP("edge.example", port); ip != "127.0.0.2" {
+		t.Errorf("first lookup returned %s, want the first answer", ip)
+	}
+	waitFor(t, func() bool {
+		ip, _ := r.ResolveBestIP("edge.example", port)
+		return ip == "127.0.0.1"
+	})
+}
+
+func TestFailingEdgeDemoted(t *testing.T) {
+	r, _ := newTestResolver(slowDialer(0))
+	e := &dnsEntry{host: "edge.example", port: "443", refreshing: true} // no background refresh
+	e.merge([]string{"192.0.2.1", "192.0.2.2"})
+	r.cache["edge.example:443"] = e
+	r.observe(e, "192.0.2.1", 20*time.Millisecond, nil)
+	r.observe(e, "192.0.2.2", 40*time.Millisecond, nil)
+	if got := r.pick(e, time.Now()).ip; got != "192.0.2.1" {
+		t.Fatalf("picked %s", got)
+	}
+
+	// Real dials to the chosen edge keep failing: new tunnels move on.
+	for i := 0; i < edgeDemoteAfter; i++ {
+		r.Report("edge.example", "443", "192.0.2.1", 0, errors.New("connection reset"))
+	}
+	if got := r.pick(e, time.Now()).ip; got != "192.0.2.2" {
+		t.Fatalf("still dialing %s after %d failures", got, edgeDemoteAfter)
+	}
+	// ... and come back once the demotion lapses.
+	if got := r.pick(e, time.Now().Add(edgeDemoteBase)).ip; got != "192.0.2.1" {
+		t.Errorf("picked %s after the demotion ended", got)
+	}
+
+	// One success restores it at once.
+	r.Report("edge.example", "443", "192.0.2.1", 20*time.Millisecond, nil)
+	for _, s := range r.Stats() {
+		if s.IP == "192.0.2.1" && (s.Demoted || s.RTTMs != 20 || s.Failures != 2 || s.Successes != 2) {
+			t.Errorf("after success: %+v", s)
+		}
+	}
+}
+
+func TestCanceledDialNotCounted(t *testing.T) {
+	r, _ := newTestResolver(slowDialer(0), "192.0.2.1")
+	ip, _ := r.ResolveBestIP("edge.example", "443")
+	for i := 0; i < 5; i++ {
+		r.Report("edge.example", "443", ip, 0, context.Canceled)
+	}
+	if s := r.Stats(); len(s) != 1 || s[0].Failures != 0 {
+		t.Errorf("stats %+v", s)
+	}
+}
+
+func TestRankingByEWMA(t *testing.T) {
+	r, _ := newTestResolver(slowDialer(0), "192.0.2.1", "192.0.2.2")
+	e := &dnsEntry{host: "edge.example", port: "443"}
+	e.merge([]string{"192.0.2.1", "192.0.2.2"})
+	now := time.Now()
+
+	r.observe(e, "192.0.2.1", 100*time.Millisecond, nil)
+	r.observe(e, "192.0.2.2", 50*time.Millisecond, nil)
+	if got := r.pick(e, now).ip; got != "192.0.2.2" {
+		t.Fatalf("picked %s, want the faster edge", got)
+	}
+
+	// One slow sample moves the estimate a quarter of the way: 50 -> 75 ms.
+	r.observe(e, "192.0.2.2", 150*time.Millisecond, nil)
+	if rtt := e.edges[1].rtt; rtt != 75*time.Millisecond {
+		t.Errorf("EWMA = %v, want 75ms", rtt)
+	}
+	if got := r.pick(e, now).ip; got != "192.0.2.2" {
+		t.Errorf("switched edges on one slow sample")
+	}
+
+	// Within the switch margin the current edge is kept.
+	r.observe(e, "192.0.2.2", 110*time.Millisecond, nil) // 84 ms
+	r.observe(e, "192.0.2.1", 60*time.Millisecond, nil)  // 90 ms
+	if got := r.pick(e, now).ip; got != "192.0.2.2" {
+		t.Errorf("switched to a slower edge")
+	}
+	for i := 0; i < 4; i++ {
+		r.observe(e, "192.0.2.1", 40*time.Millisecond, nil)
+	}
+	if got := r.pick(e, now).ip; got != "192.0.2.1" {
+		t.Errorf("kept %s after the other edge became clearly faster", got)
+	}
+}
+
+func TestRefreshAheadOfExpiry(t *testing.T) {
+	r, lookups := newTestResolver(slowDialer(0), "192.0.2.1")
+	r.ResolveBestIP("edge.example", "443")
+
+	r.mu.Lock()
+	r.cache["edge.example:443"].expires = time.Now().Add(edgeRefreshAhead / 2)
+	r.mu.Unlock()
+
+	start := time.Now()
+	if _, err := r.ResolveBestIP("edge.example", "443"); err != nil {
+		t.Fatal(err)
+	}
+	if d := time.Since(start); d > 100*time.Millisecond {
+		t.Errorf("refresh blocked the caller for %v", d)
+	}
+	waitFor(t, func() bool { return lookups.Load() == 2 })
+}
+
+func TestFailedLookupRetried(t *testing.T) {
+	var calls atomic.Int32
+	r := &BypassResolver{
+		lookupHost: func(context.Context, string) ([]string, error) {
+			if calls.Add(1) == 1 {
+				return nil, errors.New("SERVFAIL")
+			}
+			return []string{"192.0.2.1"}, nil
+		},
+		tcpDialer: slowDialer(0),
+		cache:     make(map[string]*dnsEntry),
+		cacheTTL:  edgeCacheTTL,
+	}
+	if _, err := r.ResolveBestIP("edge.example", "443"); err == nil {
+		t.Fatal("first lookup should fail")
+	}
+	if ip, err := r.ResolveBestIP("edge.example", "443"); err != nil || ip != "192.0.2.1" {
+		t.Errorf("retry = %s, %v", ip, err)
+	}
+}
+
+func TestDialDirectUsesBypassResolver(t *testing.T) {
+	ln, err := net.Listen("tcp", "127.0.0.1:0")
+	if err != nil {
+		t.Fatal(err)
+	}
+	defer ln.Close()
+	_, port, _ := net.SplitHostPort(ln.Addr().String())
+
+	// The name only resolves through the bypass resolver's DNS.
+	r, lookups := newTestResolver(&net.Dialer{}, "127.0.0.1")
+	lastResolver.Store(r)
+	defer lastResolver.Store(nil)
+	conn, err := DialDirect(context.Background(), net.JoinHostPort("edge.invalid", port))
+	if err != nil {
+		t.Fatal(err)
+	}
+	conn.Close()
+	if lookups.Load() != 1 {
+		t.Errorf("bypass DNS queried %d times, want 1", lookups.Load())
+	}
+}
@@ -55,6 +55,28 @@ type TunnelConn interface {
 	StartPing(interval time.Duration) chan struct{}
 }
 
+// UDPPinned is implemented by tunnel connections whose UDP association only
+// reaches the ConnectUDP target (MASQUE CONNECT-UDP): WriteUDP ignores its
+// endpoint. Callers multiplexing destinations over one tunnel must dial one
+// per target for these. Wrappers forward it; before ConnectUDP the answer
+// may not be known yet.
+type UDPPinned interface {
+	UDPPinned() bool
+}
+
+// IsUDPPinned reports whether conn only carries UDP for its ConnectUDP target.
+func IsUDPPinned(conn TunnelConn) bool {
+	p, ok := conn.(UDPPinned)
+	return ok && p.UDPPinned()
+}
+
+// MuxConnector is implemented by Trojan tunnel connections that can open the
+// tunnel in Trojan mux mode (CommandMux) instead of relaying a single target.
+// After ConnectMux succeeds, Read/Write carry an smux session byte stream.
+type MuxConnector interface {
+	ConnectMux() error
+}
+
 // BypassConfig holds dialers that bypass the TUN routing table.
 // Used in TUN mode to prevent routing loops: the transport's outgoing
 // TCP/UDP sockets are bound to the physical network interface so they
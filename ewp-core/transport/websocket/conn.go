@@ -4,6 +4,7 @@ import (
 	"encoding/binary"
 	"fmt"
 	"io"
+	"net"
 	"net/netip"
 	"sync"
 	"time"
@@ -43,6 +44,12 @@ type Conn struct {
 	heartbeatPeriod time.Duration
 	earlyDataLength int
 	earlyDataSent   bool
+
+	// With early data the upgrade is deferred until the first message is
+	// known; pendingUpgrade performs it and rawConn is the TLS connection
+	// to close if the tunnel is dropped before that.
+	pendingUpgrade func(earlyData []byte) error
+	rawConn        net.Conn
 }
 
 func newConn(uuid [16]byte, password string, enableFlow, useTrojan bool) *Conn {
@@ -118,11 +125,33 @@ func (c *Conn) Write(data []byte) error {
 func (c *Conn) Close() error {
 	c.closeOnce.Do(func() {
 		close(c.closeCh)
+		if c.socket == nil {
+			if c.rawConn != nil {
+				c.rawConn.Close()
+			}
+			return
+		}
 		_ = c.socket.WriteClose(1000, nil)
 	})
 	return nil
 }
 
+// writeFirst sends the first tunnel message. If the upgrade is still pending
+// and msg fits in the early data budget, msg is carried by the upgrade request
+// itself; otherwise the upgrade runs first and msg follows as a normal frame.
+func (c *Conn) writeFirst(msg []byte) error {
+	if upgrade := c.pendingUpgrade; upgrade != nil {
+		c.pendingUpgrade = nil
+		if len(msg) <= c.earlyDataLength {
+			return upgrade(msg)
+		}
+		if err := upgrade(nil); err != nil {
+			return err
+		}
+	}
+	return c.socket.WriteMessage(gws.OpcodeBinary, msg)
+}
+
 func (c *Conn) StartPing(interval time.Duration) chan struct{} {
 	if c.heartbeatPeriod > 0 {
 		interval = c.heartbeatPeriod
@@ -155,11 +184,19 @@ func (c *Conn) SetHeartbeat(period time.Duration)  { c.heartbeatPeriod = period
 
 func (c *Conn) Connect(target string, initialData []byte) error {
 	if c.useTrojan {
-		return c.connectTrojan(target, initialData)
+		return c.connectTrojan(trojan.CommandTCP, target, initialData)
 	}
 	return c.connectEWP(target, initialData)
 }
 
+// ConnectMux opens the tunnel in Trojan mux mode (see transport.MuxConnector).
+func (c *Conn) ConnectMux() error {
+	if !c.useTrojan {
+		return fmt.Errorf("mux requires trojan protocol")
+	}
+	return c.connectTrojan(trojan.CommandMux, trojan.MuxTarget, nil)
+}
+
 func (c *Conn) connectEWP(target string, initialData []byte) error {
 	addr, err := ewp.ParseAddress(target)
 	if err != nil {
@@ -174,15 +211,15 @@ func (c *Conn) connectEWP(target string, initialData []byte) error {
 		return fmt.Errorf("encode handshake: %w", err)
 	}
 
-	if c.earlyDataLength > 0 && len(initialData) > 0 && len(initialData) <= c.earlyDataLength && !c.earlyDataSent {
-		if err := c.socket.Writev(gws.OpcodeBinary, handshakeData, initialData); err != nil {
-			return fmt.Errorf("send handshake+early data: %w", err)
-		}
+	// With early data enabled, the first request bytes share the handshake
+	// message (sent raw; the server forwards them as InitialData).
+	first := handshakeData
+	if c.earlyDataLength > 0 && len(initialData) > 0 && len(handshakeData)+len(initialData) <= c.earlyDataLength {
+		first = append(handshakeData, initialData...)
 		c.earlyDataSent = true
-	} else {
-		if err := c.socket.WriteMessage(gws.OpcodeBinary, handshakeData); err != nil {
-			return fmt.Errorf("send handshake: %w", err)
-		}
+	}
+	if err := c.writeFirst(first); err != nil {
+		return fmt.Errorf("send handshake: %w", err)
 	}
 
 	select {
@@ -216,7 +253,7 @@ func (c *Conn) connectEWP(target string, initialData []byte) error {
 	return nil
 }
 
-func (c *Conn) connectTrojan(target string, initialData []byte) error {
+func (c *Conn) connectTrojan(command byte, target string, initialData []byte) error {
 	addr, err := trojan.ParseAddress(target)
 	if err != nil {
 		return err
@@ -228,13 +265,13 @@ func (c *Conn) connectTrojan(target string, initialData []byte) error {
 	buf := make([]byte, 0, trojan.KeyLength+2+1+len(addrBytes)+2+len(initialData))
 	buf = append(buf, c.key[:]...)
 	buf = append(buf, trojan.CRLF...)
-	buf = append(buf, trojan.CommandTCP)
+	buf = append(buf, command)
 	buf = append(buf, addrBytes...)
 	buf = append(buf, trojan.CRLF...)
 	if len(initialData) > 0 {
 		buf = append(buf, initialData...)
 	}
-	if err := c.socket.WriteMessage(gws.OpcodeBinary, buf); err != nil {
+	if err := c.writeFirst(buf); err != nil {
 		return err
 	}
 	log.V("[Trojan] WS TCP handshake sent: %s", target)
@@ -266,7 +303,7 @@ func (c *Conn) connectEWPUDP(target transport.Endpoint, initialData []byte) erro
 	if err != nil {
 		return fmt.Errorf("encode handshake: %w", err)
 	}
-	if err := c.socket.WriteMessage(gws.OpcodeBinary, handshakeData); err != nil {
+	if err := c.writeFirst(handshakeData); err != nil {
 		return fmt.Errorf("send handshake: %w", err)
 	}
 
@@ -333,7 +370,7 @@ func (c *Conn) connectTrojanUDP(target transport.Endpoint, initialData []byte) e
 		buf = trojan.AppendAddrPort(buf, target.Addr)
 	}
 	buf = append(buf, trojan.CRLF...)
-	if err := c.socket.WriteMessage(gws.OpcodeBinary, buf); err != nil {
+	if err := c.writeFirst(buf); err != nil {
 		return err
 	}
 	log.V("[Trojan] WS UDP handshake sent: %v", target)
@@ -0,0 +1,76 @@
+package websocket
+
+import (
+	"encoding/base64"
+	"net/http"
+	"strings"
+)
+
+// WebSocket early data: the first tunnel message (protocol handshake plus the
+// first request bytes) rides in the HTTP upgrade request, base64url-encoded,
+// so the server can act on it without waiting for a post-upgrade frame.
+//
+// With the default header (Sec-WebSocket-Protocol) the value is appended as a
+// second subprotocol after the auth token:
+//
+//	Sec-WebSocket-Protocol: <uuid|password>, <base64url(first message)>
+//
+// The server answers with the auth token only. Any other header name carries
+// the encoded message on its own.
+const DefaultEarlyDataHeader = "Sec-WebSocket-Protocol"
+
+// MaxEarlyDataSize bounds the decoded early data accepted by the server.
+const MaxEarlyDataSize = 8192
+
+// isDefaultEarlyDataHeader reports whether headerName selects the default
+// header. The comparison is canonical on both sides: net/http spells it
+// "Sec-Websocket-Protocol".
+func isDefaultEarlyDataHeader(headerName string) bool {
+	return headerName == "" || http.CanonicalHeaderKey(headerName) == http.CanonicalHeaderKey(DefaultEarlyDataHeader)
+}
+
+// SetEarlyDataHeader stores data in h under headerName ("" = default). Data
+// over MaxEarlyDataSize would be refused by the server, so it is left out
+// of h and false is returned; the caller sends it after the upgrade.
+func SetEarlyDataHeader(h http.Header, headerName, auth string, data []byte) bool {
+	if len(data) > MaxEarlyDataSize {
+		return false
+	}
+	encoded := base64.RawURLEncoding.EncodeToString(data)
+	if isDefaultEarlyDataHeader(headerName) {
+		h.Set(DefaultEarlyDataHeader, auth+", "+encoded)
+		return true
+	}
+	h.Set(headerName, encoded)
+	return true
+}
+
+// ParseEarlyDataHeader returns the auth subprotocol and the decoded early data
+// (nil when absent). headerName "" selects the default header. A malformed
+// early data value is reported as ok=false.
+func ParseEarlyDataHeader(h http.Header, headerName string) (auth string, data []byte, ok bool) {
+	proto := h.Get(DefaultEarlyDataHeader)
+
+	var encoded string
+	if isDefaultEarlyDataHeader(headerName) {
+		// The auth token may itself contain commas; early data never does.
+		if i := strings.LastIndexByte(proto, ','); i >= 0 {
+			encoded = strings.TrimSpace(proto[i+1:])
+			proto = strings.TrimSpace(proto[:i])
+		}
+	} else {
+		encoded = h.Get(headerName)
+	}
+
+	if encoded == "" {
+		return proto, nil, true
+	}
+	if base64.RawURLEncoding.DecodedLen(len(encoded)) > MaxEarlyDataSize {
+		return proto, nil, false
+	}
+	data, err := base64.RawURLEncoding.DecodeString(encoded)
+	if err != nil {
+		return proto, nil, false
+	}
+	return proto, data, true
+}
@@ -0,0 +1,96 @@
+package websocket
+
+import (
+	"bytes"
+	"net/http"
+	"testing"
+)
+
+func TestEarlyDataHeaderRoundTrip(t *testing.T) {
+	tests := []struct {
+		name   string
+		header string
+		auth   string
+		data   []byte
+	}{
+		{"empty default header", "", "token", []byte{}},
+		{"empty custom header", "X-Early-Data", "token", []byte{}},
+		{"default header", "", "token", []byte("GET / HTTP/1.1\r\n")},
+		{"default header by name", DefaultEarlyDataHeader, "token", []byte{0, 1, 2, 0xff}},
+		{"default header lower case", "sec-websocket-protocol", "token", []byte{0, 1, 2, 0xff}},
+		{"auth with comma", "", "pass,word", []byte("hello")},
+		{"custom header", "X-Early-Data", "token", []byte("hello")},
+		{"at limit default header", "", "token", bytes.Repeat([]byte{0xfb}, MaxEarlyDataSize)},
+		{"at limit custom header", "X-Early-Data", "token", bytes.Repeat([]byte{0xfb}, MaxEarlyDataSize)},
+	}
+	for _, tt := range tests {
+		t.Run(tt.name, func(t *testing.T) {
+			h := http.Header{}
+			h.Set(DefaultEarlyDataHeader, tt.auth)
+			if !SetEarlyDataHeader(h, tt.header, tt.auth, tt.data) {
+				t.Fatalf("SetEarlyDataHeader refused %d bytes", len(tt.data))
+			}
+			auth, data, ok := ParseEarlyDataHeader(h, tt.header)
+			if !ok {
+				t.Fatalf("ParseEarlyDataHeader rejected %v", h)
+			}
+			if auth != tt.auth {
+				t.Errorf("auth = %q, want %q", auth, tt.auth)
+			}
+			if !bytes.Equal(data, tt.data) {
+				t.Errorf("data = %d bytes, want %d", len(data), len(tt.data))
+			}
+		})
+	}
+}
+
+func TestEarlyDataHeaderOverLimit(t *testing.T) {
+	for _, name := range []string{"", "X-Early-Data"} {
+		h := http.Header{}
+		h.Set(DefaultEarlyDataHeader, "token")
+		if SetEarlyDataHeader(h, name, "token", make([]byte, MaxEarlyDataSize+1)) {
+			t.Errorf("header %q: over-limit early data accepted", name)
+		}
+		if got := h.Get(DefaultEarlyDataHeader); got != "token" {
+			t.Errorf("header %q: Sec-WebSocket-Protocol = %q, want it untouched", name, got)
+		}
+		if name != "" && h.Get(name) != "" {
+			t.Errorf("header %q set for over-limit early data", name)
+		}
+	}
+
+	// A client that ignores the limit is refused by the server.
+	h := http.Header{}
+	h.Set("X-Early-Data", string(bytes.Repeat([]byte{'A'}, 10924)))
+	if _, data, ok := ParseEarlyDataHeader(h, "X-Early-Data"); ok || data != nil {
+		t.Errorf("over-limit early data parsed: ok=%v, %d bytes", ok, len(data))
+	}
+}
+
+func TestEarlyDataHeaderMalformed(t *testing.T) {
+	tests := []struct {
+		name   string
+		header string
+		value  string
+	}{
+		{"invalid characters", "X-Early-Data", "a!b@c"},
+		{"standard alphabet", "X-Early-Data", "+/+/"},
+		{"padded", "X-Early-Data", "aGk="},
+		{"impossible length", "X-Early-Data", "aGVsbG8xx"},
+		{"default header", "", "token, not*base64"},
+	}
+	for _, tt := range tests {
+		t.Run(tt.name, func(t *testing.T) {
+			h := http.Header{}
+			if tt.header == "" {
+				h.Set(DefaultEarlyDataHeader, tt.value)
+			} else {
+				h.Set(DefaultEarlyDataHeader, "token")
+				h.Set(tt.header, tt.value)
+			}
+			if _, data, ok := ParseEarlyDataHeader(h, tt.header); ok || data != nil {
+				t.Errorf("malformed early data %q parsed: ok=%v, %q", tt.value, ok, data)
+			}
+		})
+	}
+}
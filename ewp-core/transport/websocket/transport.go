@@ -34,6 +34,10 @@ type Transport struct {
 	headers    map[string]string
 	echManager *commontls.ECHManager
 	bypassCfg  *transport.BypassConfig
+
+	maxEarlyData    int
+	earlyDataHeader string
+	tcpFastOpen     bool
 }
 
 func New(serverAddr, token string, useECH, enableFlow bool, path string, echMgr *commontls.ECHManager) (*Transport, error) {
@@ -154,14 +158,13 @@ func (t *Transport) dial() (transport.TunnelConn, error) {
 	dialCtx, dialCancel := context.WithTimeout(context.Background(), 15*time.Second)
 	defer dialCancel()
 
-	var rawConn net.Conn
-	if t.bypassCfg != nil && t.bypassCfg.TCPDialer != nil {
-		t.bypassCfg.TCPDialer.Timeout = 10 * time.Second
-		rawConn, err = t.bypassCfg.TCPDialer.DialContext(dialCtx, "tcp", connectAddr)
-	} else {
-		rawConn, err = commonnet.DialTFO("tcp", connectAddr, 10*time.Second)
+	var dialer *net.Dialer
+	if t.bypassCfg != nil {
+		dialer = t.bypassCfg.TCPDialer
 	}
+	rawConn, err := commonnet.DialTCP(dialCtx, dialer, "tcp", connectAddr, t.tcpFastOpen)
 	if err != nil {
+		transport.ReportDial(t.bypassCfg, parsed.Host, connectAddr, 0, err)
 		return nil, fmt.Errorf("TCP dial: %w", err)
 	}
 	log.V("[WebSocket] TCP connected: %s -> %s", rawConn.LocalAddr(), rawConn.RemoteAddr())
@@ -172,38 +175,63 @@ func (t *Transport) dial() (transport.TunnelConn, error) {
 	}
 	if err := tlsConn.HandshakeContext(dialCtx); err != nil {
 		rawConn.Close()
+		transport.ReportDial(t.bypassCfg, parsed.Host, connectAddr, 0, err)
 		return nil, fmt.Errorf("TLS handshake: %w", err)
 	}
 	tlsConn.SetDeadline(time.Time{})
+	transport.ReportDial(t.bypassCfg, parsed.Host, connectAddr, commonnet.SmoothedRTT(rawConn), nil)
 	log.V("[WebSocket] TLS connected: %s (proto: %s)", connectAddr, tlsConn.ConnectionState().NegotiatedProtocol)
 
 	wsURL := fmt.Sprintf("wss://%s:%s%s", httpHost, parsed.Port, t.path)
 
+	auth := t.token
+	if t.useTrojan {
+		auth = t.password
+	}
 	reqHeader := http.Header{}
 	for k, v := range t.headers {
 		reqHeader.Set(k, v)
 	}
-	if t.useTrojan {
-		reqHeader.Set("Sec-WebSocket-Protocol", t.password)
-	} else {
-		reqHeader.Set("Sec-WebSocket-Protocol", t.token)
-	}
+	reqHeader.Set("Sec-WebSocket-Protocol", auth)
 
 	c := newConn(t.uuid, t.password, t.enableFlow, t.useTrojan)
 
-	socket, _, err := gws.NewClientFromConn(c, &gws.ClientOption{
-		Addr:           wsURL,
-		RequestHeader:  reqHeader,
-		ReadBufferSize: 65536,
-	}, tlsConn)
-	if err != nil {
-		tlsConn.Close()
-		return nil, fmt.Errorf("WS upgrade: %w", err)
+	upgrade := func(earlyData []byte) error {
+		header := reqHeader
+		if len(earlyData) > 0 {
+			header = reqHeader.Clone()
+			if !SetEarlyDataHeader(header, t.earlyDataHeader, auth, earlyData) {
+				tlsConn.Close()
+				return fmt.Errorf("WS early data: %d bytes exceeds %d", len(earlyData), MaxEarlyDataSize)
+			}
+		}
+		socket, _, err := gws.NewClientFromConn(c, &gws.ClientOption{
+			Addr:           wsURL,
+			RequestHeader:  header,
+			ReadBufferSize: 65536,
+		}, tlsConn)
+		if err != nil {
+			tlsConn.Close()
+			return fmt.Errorf("WS upgrade: %w", err)
+		}
+		c.socket = socket
+		go socket.ReadLoop()
+		log.V("[WebSocket] Connected to %s (early data: %d bytes)", wsURL, len(earlyData))
+		return nil
 	}
-	c.socket = socket
-	go socket.ReadLoop()
 
-	log.V("[WebSocket] Connected to %s", wsURL)
+	// Early data: defer the upgrade until Connect so the first tunnel
+	// message can ride in the upgrade request instead of costing its own RTT.
+	if t.maxEarlyData > 0 {
+		c.SetEarlyData(t.maxEarlyData)
+		c.rawConn = tlsConn
+		c.pendingUpgrade = upgrade
+		return c, nil
+	}
+
+	if err := upgrade(nil); err != nil {
+		return nil, err
+	}
 	return c, nil
 }
 
@@ -224,6 +252,25 @@ func (t *Transport) SetHeaders(headers map[string]string) *Transport {
 	return t
 }
 
+// SetEarlyData enables WebSocket early data: up to maxBytes of the first
+// tunnel message are sent in the upgrade request under headerName
+// ("" = Sec-WebSocket-Protocol). maxBytes <= 0 disables it.
+func (t *Transport) SetEarlyData(maxBytes int, headerName string) *Transport {
+	if maxBytes > MaxEarlyDataSize {
+		maxBytes = MaxEarlyDataSize
+	}
+	t.maxEarlyData = maxBytes
+	t.earlyDataHeader = headerName
+	return t
+}
+
+// SetTCPFastOpen enables client-side TCP Fast Open: the TLS ClientHello is
+// sent in the SYN once the kernel holds a cookie for the server.
+func (t *Transport) SetTCPFastOpen(enabled bool) *Transport {
+	t.tcpFastOpen = enabled
+	return t
+}
+
 func isIPAddress(s string) bool {
 	return net.ParseIP(s) != nil
 }
@@ -62,12 +62,20 @@ func NewStreamOneConn(httpClient *http.Client, host, port, path string, uuid [16
 
 func (c *StreamOneConn) Connect(target string, initialData []byte) error {
 	if c.useTrojan {
-		return c.connectTrojan(target, initialData)
+		return c.connectTrojan(trojan.CommandTCP, target, initialData)
 	}
 	return c.connectEWP(target, initialData)
 }
 
-func (c *StreamOneConn) connectTrojan(target string, initialData []byte) error {
+// ConnectMux opens the tunnel in Trojan mux mode (see transport.MuxConnector).
+func (c *StreamOneConn) ConnectMux() error {
+	if !c.useTrojan {
+		return fmt.Errorf("mux requires trojan protocol")
+	}
+	return c.connectTrojan(trojan.CommandMux, trojan.MuxTarget, nil)
+}
+
+func (c *StreamOneConn) connectTrojan(command byte, target string, initialData []byte) error {
 	c.mu.Lock()
 	defer c.mu.Unlock()
 
@@ -110,7 +118,7 @@ func (c *StreamOneConn) connectTrojan(target string, initialData []byte) error {
 	var handshakeData []byte
 	handshakeData = append(handshakeData, key[:]...)
 	handshakeData = append(handshakeData, trojan.CRLF...)
-	handshakeData = append(handshakeData, trojan.CommandTCP)
+	handshakeData = append(handshakeData, command)
 
 	addrBytes, err := addr.Encode()
 	if err != nil {
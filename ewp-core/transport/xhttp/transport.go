@@ -59,9 +59,10 @@ type Transport struct {
 	xmuxManager *XmuxManager
 	xmuxMu      sync.Mutex
 
-	sni       string
-	host      string
-	bypassCfg *transport.BypassConfig
+	sni         string
+	host        string
+	bypassCfg   *transport.BypassConfig
+	tcpFastOpen bool
 }
 
 func New(serverAddr, token string, useECH, enableFlow bool, path string, echManager *commontls.ECHManager) (*Transport, error) {
@@ -148,6 +149,13 @@ func (t *Transport) SetSNI(sni string) *Transport {
 	return t
 }
 
+// SetTCPFastOpen enables client-side TCP Fast Open: the TLS ClientHello is
+// sent in the SYN once the kernel holds a cookie for the server.
+func (t *Transport) SetTCPFastOpen(enabled bool) *Transport {
+	t.tcpFastOpen = enabled
+	return t
+}
+
 func (t *Transport) SetHost(host string) *Transport {
 	t.host = host
 	return t
@@ -344,17 +352,25 @@ func (t *Transport) createHTTPClient(host, port string) (*http.Client, error) {
 	// HTTP/2 Transport 配置 - 参考 Xray-core ChromeH2KeepAlivePeriod
 	h2Transport := &http2.Transport{
 		DialTLSContext: func(ctx context.Context, network, addr string, cfg *tls.Config) (net.Conn, error) {
-			var rawConn net.Conn
-			var err error
-			if t.bypassCfg != nil && t.bypassCfg.TCPDialer != nil {
-				rawConn, err = t.bypassCfg.TCPDialer.DialContext(ctx, "tcp", target)
-			} else {
-				rawConn, err = commonnet.DialTFOContext(ctx, "tcp", target, 10*time.Second)
+			var dialer *net.Dialer
+			if t.bypassCfg != nil {
+				dialer = t.bypassCfg.TCPDialer
 			}
+			rawConn, err := commonnet.DialTCP(ctx, dialer, "tcp", target, t.tcpFastOpen)
 			if err != nil {
+				transport.ReportDial(t.bypassCfg, host, target, 0, err)
+				return nil, err
+			}
+			// Handshake here rather than on first write so the outcome
+			// can be reported against the edge.
+			tlsConn := tls.Client(rawConn, stdConfig)
+			if err := tlsConn.HandshakeContext(ctx); err != nil {
+				rawConn.Close()
+				transport.ReportDial(t.bypassCfg, host, target, 0, err)
 				return nil, err
 			}
-			return tls.Client(rawConn, stdConfig), nil
+			transport.ReportDial(t.bypassCfg, host, target, commonnet.SmoothedRTT(rawConn), nil)
+			return tlsConn, nil
 		},
 		IdleConnTimeout:            90 * time.Second, // 连接空闲超时
 		ReadIdleTimeout:            15 * time.Second, // 读空闲超时（参考 Chrome）→ 触发 HTTP/2 PING
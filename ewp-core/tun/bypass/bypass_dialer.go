@@ -4,6 +4,7 @@ import (
 	"context"
 	"fmt"
 	"net"
+	"net/netip"
 
 	"ewp-core/log"
 	"ewp-core/transport"
@@ -25,6 +26,8 @@ type BypassDialer struct {
 	// ListenConfig is a net.ListenConfig whose Control function binds every
 	// UDP socket to the physical interface, bypassing TUN routing.
 	ListenConfig *net.ListenConfig
+
+	platform platformState // per-OS routing state (Linux: netlink session)
 }
 
 // NewBypassDialer detects the physical outbound interface and returns a
@@ -79,12 +82,22 @@ func NewBypassDialer(serverAddr string) (*BypassDialer, error) {
 	return bd, nil
 }
 
-// Close removes any kernel routing rules and routes installed by NewBypassDialer.
+// Close removes any kernel routing rules and routes installed by NewBypassDialer
+// and ExcludeRoutes.
 // Must be called when the TUN interface is torn down (e.g. on program exit).
 func (b *BypassDialer) Close() {
 	b.platformCleanup()
 }
 
+// ExcludeRoutes routes prefixes around the TUN through the physical
+// interface, so traffic to them never enters the tunnel. Adjacent and
+// overlapping prefixes are merged first. Call it before the TUN routes are
+// added; a later call replaces the set. Routes are removed by Close.
+// Returns the number of routes installed.
+func (b *BypassDialer) ExcludeRoutes(prefixes []netip.Prefix) (int, error) {
+	return b.platformExclude(AggregatePrefixes(prefixes))
+}
+
 // ToBypassConfig converts to the transport.BypassConfig used by all transports.
 // A BypassResolver is automatically created so that DNS queries also bypass the TUN
 // and all resolved IPs are probed to select the optimal CDN edge node.
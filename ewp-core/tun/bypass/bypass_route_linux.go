@@ -5,6 +5,8 @@ package bypass
 import (
 	"encoding/binary"
 	"fmt"
+	"net/netip"
+	"sync"
 	"syscall"
 
 	"golang.org/x/sys/unix"
@@ -14,6 +16,9 @@ const (
 	bypassRouteTable = 252 // custom routing table (avoids main=254, local=255, default=253)
 	bypassRulePrio   = 100 // ip rule priority
 
+	excludeRouteTable = 251 // routes for route_exclude_address prefixes
+	excludeRulePrio   = 99  // ahead of the TUN default route in main
+
 	// FRA_* routing rule attributes (linux/fib_rules.h)
 	fraFwmark   = 10
 	fraFwmask   = 16
@@ -40,62 +45,6 @@ func nlAttrU32(t uint16, v uint32) []byte {
 	return nlAttr(t, d)
 }
 
-// netlinkDo opens a NETLINK_ROUTE socket, sends one message, and waits for ACK.
-// body is the fixed-size header (struct rtmsg / fib_rule_hdr).
-// attrs are the variable-length attribute blobs to append.
-func netlinkDo(msgType uint16, flags uint16, body []byte, attrs ...[]byte) error {
-	sock, err := unix.Socket(unix.AF_NETLINK, unix.SOCK_RAW|unix.SOCK_CLOEXEC, unix.NETLINK_ROUTE)
-	if err != nil {
-		return fmt.Errorf("netlink socket: %w", err)
-	}
-	defer unix.Close(sock)
-
-	attrTotal := 0
-	for _, a := range attrs {
-		attrTotal += len(a)
-	}
-	msgLen := unix.SizeofNlMsghdr + len(body) + attrTotal
-	buf := make([]byte, (msgLen+3)&^3)
-
-	binary.NativeEndian.PutUint32(buf[0:4], uint32(msgLen))
-	binary.NativeEndian.PutUint16(buf[4:6], msgType)
-	binary.NativeEndian.PutUint16(buf[6:8], flags)
-	binary.NativeEndian.PutUint32(buf[8:12], 1) // seq
-	binary.NativeEndian.PutUint32(buf[12:16], 0) // pid
-
-	off := unix.SizeofNlMsghdr
-	copy(buf[off:], body)
-	off += len(body)
-	for _, a := range attrs {
-		copy(buf[off:], a)
-		off += len(a)
-	}
-
-	sa := &unix.SockaddrNetlink{Family: unix.AF_NETLINK}
-	if err := unix.Sendto(sock, buf[:msgLen], 0, sa); err != nil {
-		return fmt.Errorf("netlink send: %w", err)
-	}
-
-	resp := make([]byte, 4096)
-	n, _, err := unix.Recvfrom(sock, resp, 0)
-	if err != nil {
-		return fmt.Errorf("netlink recv: %w", err)
-	}
-	msgs, err := syscall.ParseNetlinkMessage(resp[:n])
-	if err != nil {
-		return fmt.Errorf("netlink parse: %w", err)
-	}
-	for _, m := range msgs {
-		if m.Header.Type == unix.NLMSG_ERROR {
-			errno := int32(binary.NativeEndian.Uint32(m.Data[:4]))
-			if errno != 0 {
-				return syscall.Errno(-errno)
-			}
-		}
-	}
-	return nil
-}
-
 // rtmsgBody builds the 12-byte struct rtmsg / fib_rule_hdr body.
 // Fields: [family, dst_len, src_len, tos, table, proto/res1, scope/res2, type/action, flags(4)]
 func rtmsgBody(family, table, proto, scope, typ uint8) []byte {
@@ -108,68 +57,163 @@ func rtmsgBody(family, table, proto, scope, typ uint8) []byte {
 	return b
 }
 
-// netlinkAddRule: ip rule add fwmark <mark> lookup <table> prio <prio> (IPv4 or IPv6)
-func netlinkAddRule(family uint8, mark, table, prio uint32) error {
+// platformState is the Linux routing state owned by a BypassDialer: the
+// netlink session its rules and routes are installed through.
+type platformState struct {
+	mu       sync.Mutex
+	nl       *nlSession
+	excluded int // routes in excludeRouteTable
+}
+
+// ruleMsg builds the fib_rule_hdr and attributes of "ip rule ... lookup
+// <table> prio <prio>", matching fwmark <mark> when mark is non-zero.
+func ruleMsg(family uint8, mark, table, prio uint32) ([]byte, [][]byte) {
 	body := rtmsgBody(family, unix.RT_TABLE_UNSPEC, 0, 0, frActToTbl)
-	attrs := [][]byte{
-		nlAttrU32(fraPriority, prio),
-		nlAttrU32(fraFwmark, mark),
-		nlAttrU32(fraFwmask, 0xFFFFFFFF),
-		nlAttrU32(fraTable, table),
+	attrs := [][]byte{nlAttrU32(fraPriority, prio)}
+	if mark != 0 {
+		attrs = append(attrs, nlAttrU32(fraFwmark, mark), nlAttrU32(fraFwmask, 0xFFFFFFFF))
 	}
+	attrs = append(attrs, nlAttrU32(fraTable, table))
+	return body, attrs
+}
+
+// addRule: ip rule add [fwmark <mark>] lookup <table> prio <prio> (IPv4 or IPv6)
+func (s *nlSession) addRule(family uint8, mark, table, prio uint32) error {
+	body, attrs := ruleMsg(family, mark, table, prio)
 	flags := uint16(unix.NLM_F_REQUEST | unix.NLM_F_ACK | unix.NLM_F_CREATE)
-	err := netlinkDo(unix.RTM_NEWRULE, flags, body, attrs...)
-	if err == syscall.EEXIST {
-		return nil
-	}
-	return err
+	return s.do(unix.RTM_NEWRULE, flags, syscall.EEXIST, body, attrs...)
 }
 
-// netlinkDelRule: ip rule del fwmark <mark> lookup <table>
-func netlinkDelRule(family uint8, mark, table, prio uint32) error {
-	body := rtmsgBody(family, unix.RT_TABLE_UNSPEC, 0, 0, frActToTbl)
-	attrs := [][]byte{
-		nlAttrU32(fraPriority, prio),
-		nlAttrU32(fraFwmark, mark),
-		nlAttrU32(fraFwmask, 0xFFFFFFFF),
-		nlAttrU32(fraTable, table),
-	}
-	err := netlinkDo(unix.RTM_DELRULE,
-		uint16(unix.NLM_F_REQUEST|unix.NLM_F_ACK), body, attrs...)
-	if err == syscall.ENOENT {
-		return nil
-	}
-	return err
+// delRule: ip rule del [fwmark <mark>] lookup <table> prio <prio>
+func (s *nlSession) delRule(family uint8, mark, table, prio uint32) error {
+	body, attrs := ruleMsg(family, mark, table, prio)
+	return s.do(unix.RTM_DELRULE, uint16(unix.NLM_F_REQUEST|unix.NLM_F_ACK), syscall.ENOENT, body, attrs...)
 }
 
-// netlinkAddRoute: ip route add default dev <iface> table <table> (IPv4 or IPv6)
-func netlinkAddRoute(family uint8, ifIndex, table uint32) error {
+// addRoute: ip route add default dev <iface> table <table> (IPv4 or IPv6)
+func (s *nlSession) addRoute(family uint8, ifIndex, table uint32) error {
 	body := rtmsgBody(family, unix.RT_TABLE_UNSPEC, unix.RTPROT_BOOT, unix.RT_SCOPE_UNIVERSE, unix.RTN_UNICAST)
+	flags := uint16(unix.NLM_F_REQUEST | unix.NLM_F_ACK | unix.NLM_F_CREATE)
+	return s.do(unix.RTM_NEWROUTE, flags, syscall.EEXIST, body,
+		nlAttrU32(unix.RTA_TABLE, table), nlAttrU32(unix.RTA_OIF, ifIndex))
+}
+
+// delRoute: ip route del default table <table>
+func (s *nlSession) delRoute(family uint8, ifIndex, table uint32) error {
+	body := rtmsgBody(family, unix.RT_TABLE_UNSPEC, unix.RTPROT_BOOT, unix.RT_SCOPE_UNIVERSE, unix.RTN_UNICAST)
+	return s.do(unix.RTM_DELROUTE, uint16(unix.NLM_F_REQUEST|unix.NLM_F_ACK), syscall.ENOENT, body,
+		nlAttrU32(unix.RTA_TABLE, table), nlAttrU32(unix.RTA_OIF, ifIndex))
+}
+
+// queueRoute queues "ip route add <prefix> [via <gw>] dev <iface> table
+// <table>" without waiting for its ACK. Without a gateway the route is
+// link-scoped, as for an on-link or point-to-point interface.
+func (s *nlSession) queueRoute(p netip.Prefix, gw netip.Addr, ifIndex, table uint32) error {
+	family := uint8(unix.AF_INET)
+	if p.Addr().Is6() {
+		family = unix.AF_INET6
+	}
+	scope := uint8(unix.RT_SCOPE_UNIVERSE)
+	if !gw.IsValid() {
+		scope = unix.RT_SCOPE_LINK
+	}
+	body := rtmsgBody(family, unix.RT_TABLE_UNSPEC, unix.RTPROT_BOOT, scope, unix.RTN_UNICAST)
+	body[1] = uint8(p.Bits())
 	attrs := [][]byte{
+		nlAttr(unix.RTA_DST, p.Addr().AsSlice()),
 		nlAttrU32(unix.RTA_TABLE, table),
 		nlAttrU32(unix.RTA_OIF, ifIndex),
 	}
+	if gw.IsValid() {
+		attrs = append(attrs, nlAttr(unix.RTA_GATEWAY, gw.AsSlice()))
+	}
 	flags := uint16(unix.NLM_F_REQUEST | unix.NLM_F_ACK | unix.NLM_F_CREATE)
-	err := netlinkDo(unix.RTM_NEWROUTE, flags, body, attrs...)
-	if err == syscall.EEXIST {
-		return nil
+	return s.add(unix.RTM_NEWROUTE, flags, syscall.EEXIST, body, attrs...)
+}
+
+// routeTable returns the table a dumped route belongs to.
+func routeTable(m *syscall.NetlinkMessage, attrs []syscall.NetlinkRouteAttr) uint32 {
+	for _, a := range attrs {
+		if a.Attr.Type == unix.RTA_TABLE && len(a.Value) >= 4 {
+			return binary.NativeEndian.Uint32(a.Value)
+		}
 	}
-	return err
+	return uint32(m.Data[4])
 }
 
-// netlinkDelRoute: ip route del default table <table>
-func netlinkDelRoute(family uint8, ifIndex, table uint32) error {
-	body := rtmsgBody(family, unix.RT_TABLE_UNSPEC, unix.RTPROT_BOOT, unix.RT_SCOPE_UNIVERSE, unix.RTN_UNICAST)
-	attrs := [][]byte{
-		nlAttrU32(unix.RTA_TABLE, table),
-		nlAttrU32(unix.RTA_OIF, ifIndex),
+func dumpRoutes(s *nlSession, family uint8) ([]syscall.NetlinkMessage, error) {
+	body := make([]byte, unix.SizeofRtMsg)
+	body[0] = family
+	return s.dump(unix.RTM_GETROUTE, body)
+}
+
+// defaultGateway returns the gateway of the main-table default route out
+// of ifIndex, or the zero Addr when that route has none.
+func (s *nlSession) defaultGateway(family uint8, ifIndex uint32) (netip.Addr, error) {
+	msgs, err := dumpRoutes(s, family)
+	if err != nil {
+		return netip.Addr{}, err
 	}
-	err := netlinkDo(unix.RTM_DELROUTE,
-		uint16(unix.NLM_F_REQUEST|unix.NLM_F_ACK), body, attrs...)
-	if err == syscall.ENOENT {
-		return nil
+	for i := range msgs {
+		m := &msgs[i]
+		if len(m.Data) < unix.SizeofRtMsg || m.Data[1] != 0 {
+			continue // not a default route
+		}
+		attrs, err := syscall.ParseNetlinkRouteAttr(m)
+		if err != nil || routeTable(m, attrs) != unix.RT_TABLE_MAIN {
+			continue
+		}
+		var oif uint32
+		var gw netip.Addr
+		for _, a := range attrs {
+			switch a.Attr.Type {
+			case unix.RTA_OIF:
+				if len(a.Value) >= 4 {
+					oif = binary.NativeEndian.Uint32(a.Value)
+				}
+			case unix.RTA_GATEWAY:
+				gw, _ = netip.AddrFromSlice(a.Value)
+			}
+		}
+		if oif == ifIndex && gw.IsValid() {
+			return gw, nil
+		}
+	}
+	return netip.Addr{}, nil
+}
+
+// flushTable deletes every route of family in table, batching the deletes
+// like the installs. Routes already gone are not an error.
+func (s *nlSession) flushTable(family uint8, table uint32) (int, error) {
+	msgs, err := dumpRoutes(s, family)
+	if err != nil {
+		return 0, err
+	}
+	n := 0
+	for i := range msgs {
+		m := &msgs[i]
+		if len(m.Data) < unix.SizeofRtMsg {
+			continue
+		}
+		attrs, err := syscall.ParseNetlinkRouteAttr(m)
+		if err != nil || routeTable(m, attrs) != table {
+			continue
+		}
+		// The header and destination identify the route; the rest of the
+		// dumped attributes (cache info, preference) are not needed.
+		body := append([]byte(nil), m.Data[:unix.SizeofRtMsg]...)
+		del := [][]byte{nlAttrU32(unix.RTA_TABLE, table)}
+		for _, a := range attrs {
+			if a.Attr.Type == unix.RTA_DST {
+				del = append(del, nlAttr(unix.RTA_DST, a.Value))
+			}
+		}
+		if err := s.add(unix.RTM_DELROUTE, uint16(unix.NLM_F_REQUEST|unix.NLM_F_ACK), syscall.ESRCH, body, del...); err != nil {
+			return n, err
+		}
+		n++
 	}
-	return err
+	return n, s.flush()
 }
 
 // platformSetup adds policy routing so that sockets marked with bypassFWMark
@@ -180,27 +224,136 @@ func netlinkDelRoute(family uint8, ifIndex, table uint32) error {
 //	ip route add default dev <iface> table 252
 //	ip rule  add fwmark 0xEC011 lookup 252 prio 100   (IPv4 + IPv6)
 func (b *BypassDialer) platformSetup() error {
-	iface := b.iface
-	idx := uint32(iface.Index)
+	nl, err := openSession()
+	if err != nil {
+		return err
+	}
+	idx := uint32(b.iface.Index)
 
-	if err := netlinkAddRoute(unix.AF_INET, idx, bypassRouteTable); err != nil {
+	if err := nl.addRoute(unix.AF_INET, idx, bypassRouteTable); err != nil {
+		nl.Close()
 		return fmt.Errorf("add bypass IPv4 route: %w", err)
 	}
-	if err := netlinkAddRule(unix.AF_INET, bypassFWMark, bypassRouteTable, bypassRulePrio); err != nil {
-		_ = netlinkDelRoute(unix.AF_INET, idx, bypassRouteTable)
+	if err := nl.addRule(unix.AF_INET, bypassFWMark, bypassRouteTable, bypassRulePrio); err != nil {
+		_ = nl.delRoute(unix.AF_INET, idx, bypassRouteTable)
+		nl.Close()
 		return fmt.Errorf("add bypass IPv4 rule: %w", err)
 	}
 	// IPv6 is best-effort; some environments may lack IPv6.
-	_ = netlinkAddRoute(unix.AF_INET6, idx, bypassRouteTable)
-	_ = netlinkAddRule(unix.AF_INET6, bypassFWMark, bypassRouteTable, bypassRulePrio)
+	_ = nl.addRoute(unix.AF_INET6, idx, bypassRouteTable)
+	_ = nl.addRule(unix.AF_INET6, bypassFWMark, bypassRouteTable, bypassRulePrio)
+
+	b.platform.mu.Lock()
+	b.platform.nl = nl
+	b.platform.mu.Unlock()
 	return nil
 }
 
-// platformCleanup removes the routing rule and route added by platformSetup.
+// platformExclude routes prefixes through the physical interface, ahead of
+// the TUN default route:
+//
+//	ip route add <prefix> via <gateway> dev <iface> table 251   (per prefix)
+//	ip rule  add lookup 251 prio 99                             (IPv4 + IPv6)
+//
+// The routes go out in batches over the dialer's netlink session, so a set
+// of thousands costs a handful of sendmsg calls rather than one socket and
+// round trip each. Routes left in table 251 by an earlier run are flushed
+// first. Returns the number of routes installed; on error the routes and
+// rules installed so far are removed again.
+func (b *BypassDialer) platformExclude(prefixes []netip.Prefix) (n int, err error) {
+	b.platform.mu.Lock()
+	defer b.platform.mu.Unlock()
+	nl := b.platform.nl
+	if nl == nil {
+		if nl, err = openSession(); err != nil {
+			return 0, err
+		}
+		b.platform.nl = nl
+	}
+	defer func() {
+		if err != nil {
+			removeExcludes(nl)
+		}
+	}()
+	idx := uint32(b.iface.Index)
+	for _, family := range []uint8{unix.AF_INET, unix.AF_INET6} {
+		if _, err := nl.flushTable(family, excludeRouteTable); err != nil {
+			return 0, fmt.Errorf("flush exclude routes: %w", err)
+		}
+	}
+
+	var gw4, gw6 netip.Addr
+	var has4, has6 bool
+	for _, p := range prefixes {
+		if p.Addr().Is4() {
+			has4 = true
+		} else {
+			has6 = true
+		}
+	}
+	if has4 {
+		gw4, _ = nl.defaultGateway(unix.AF_INET, idx)
+	}
+	if has6 {
+		gw6, _ = nl.defaultGateway(unix.AF_INET6, idx)
+	}
+
+	for _, p := range prefixes {
+		gw := gw4
+		if p.Addr().Is6() {
+			gw = gw6
+		}
+		if err := nl.queueRoute(p, gw, idx, excludeRouteTable); err != nil {
+			return 0, fmt.Errorf("add exclude route: %w", err)
+		}
+	}
+	if err := nl.flush(); err != nil {
+		return 0, fmt.Errorf("add exclude route: %w", err)
+	}
+
+	if has4 {
+		if err := nl.addRule(unix.AF_INET, 0, excludeRouteTable, excludeRulePrio); err != nil {
+			return 0, fmt.Errorf("add exclude IPv4 rule: %w", err)
+		}
+	}
+	if has6 {
+		if err := nl.addRule(unix.AF_INET6, 0, excludeRouteTable, excludeRulePrio); err != nil {
+			return 0, fmt.Errorf("add exclude IPv6 rule: %w", err)
+		}
+	}
+	b.platform.excluded = len(prefixes)
+	return len(prefixes), nil
+}
+
+// removeExcludes deletes the rules and routes of platformExclude. Rules go
+// first so traffic stops matching the table before it is emptied.
+func removeExcludes(nl *nlSession) {
+	_ = nl.delRule(unix.AF_INET, 0, excludeRouteTable, excludeRulePrio)
+	_ = nl.delRule(unix.AF_INET6, 0, excludeRouteTable, excludeRulePrio)
+	_, _ = nl.flushTable(unix.AF_INET, excludeRouteTable)
+	_, _ = nl.flushTable(unix.AF_INET6, excludeRouteTable)
+}
+
+// platformCleanup removes the routing rules and routes added by
+// platformSetup and platformExclude. Rules go first so traffic stops
+// matching the tables before they are emptied.
 func (b *BypassDialer) platformCleanup() {
+	b.platform.mu.Lock()
+	defer b.platform.mu.Unlock()
+	nl := b.platform.nl
+	if nl == nil {
+		return
+	}
+	b.platform.nl = nil
+	defer nl.Close()
+
 	idx := uint32(b.iface.Index)
-	_ = netlinkDelRule(unix.AF_INET, bypassFWMark, bypassRouteTable, bypassRulePrio)
-	_ = netlinkDelRule(unix.AF_INET6, bypassFWMark, bypassRouteTable, bypassRulePrio)
-	_ = netlinkDelRoute(unix.AF_INET, idx, bypassRouteTable)
-	_ = netlinkDelRoute(unix.AF_INET6, idx, bypassRouteTable)
+	_ = nl.delRule(unix.AF_INET, bypassFWMark, bypassRouteTable, bypassRulePrio)
+	_ = nl.delRule(unix.AF_INET6, bypassFWMark, bypassRouteTable, bypassRulePrio)
+	if b.platform.excluded > 0 {
+		removeExcludes(nl)
+		b.platform.excluded = 0
+	}
+	_ = nl.delRoute(unix.AF_INET, idx, bypassRouteTable)
+	_ = nl.delRoute(unix.AF_INET6, idx, bypassRouteTable)
 }
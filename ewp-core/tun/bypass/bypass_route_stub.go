@@ -2,9 +2,22 @@
 
 package bypass
 
+import (
+	"errors"
+	"net/netip"
+)
+
+// platformState is empty where no routing state is kept.
+type platformState struct{}
+
 // platformSetup is a no-op on platforms that manage bypass at the socket level
 // (Windows: bind to physical IP; Darwin: IP_BOUND_IF; Android: VpnService.protect).
 func (b *BypassDialer) platformSetup() error { return nil }
 
+// platformExclude is not implemented outside Linux.
+func (b *BypassDialer) platformExclude([]netip.Prefix) (int, error) {
+	return 0, errors.New("route exclusion is only supported on Linux")
+}
+
 // platformCleanup is a no-op on non-Linux platforms.
 func (b *BypassDialer) platformCleanup() {}
@@ -0,0 +1,183 @@
+//go:build linux && !android
+
+package bypass
+
+import (
+	"encoding/binary"
+	"fmt"
+	"syscall"
+
+	"golang.org/x/sys/unix"
+)
+
+const (
+	// nlBatchBytes bounds the requests packed into one sendmsg. It also
+	// bounds the ACKs outstanding at once, keeping them well inside the
+	// socket's receive buffer.
+	nlBatchBytes = 32 * 1024
+
+	nlRecvBuffer = 1 << 20
+)
+
+// nlSession is a NETLINK_ROUTE socket kept open for a series of requests.
+// Requests queued with add are packed back to back into as few sendmsg
+// calls as fit in nlBatchBytes; flush sends them and collects every ACK.
+// The kernel processes each message of a batch even when an earlier one
+// fails, so one error does not stall the rest.
+type nlSession struct {
+	fd      int
+	seq     uint32
+	buf     []byte      // queued requests
+	pending []nlPending // one per queued request, in seq order
+	rbuf    []byte
+}
+
+type nlPending struct {
+	seq    uint32
+	ignore syscall.Errno // counts as success (EEXIST on create, ENOENT on delete)
+}
+
+func openSession() (*nlSession, error) {
+	fd, err := unix.Socket(unix.AF_NETLINK, unix.SOCK_RAW|unix.SOCK_CLOEXEC, unix.NETLINK_ROUTE)
+	if err != nil {
+		return nil, fmt.Errorf("netlink socket: %w", err)
+	}
+	if err := unix.Bind(fd, &unix.SockaddrNetlink{Family: unix.AF_NETLINK}); err != nil {
+		unix.Close(fd)
+		return nil, fmt.Errorf("netlink bind: %w", err)
+	}
+	_ = unix.SetsockoptInt(fd, unix.SOL_SOCKET, unix.SO_RCVBUF, nlRecvBuffer)
+	return &nlSession{
+		fd:   fd,
+		buf:  make([]byte, 0, nlBatchBytes),
+		rbuf: make([]byte, 64*1024),
+	}, nil
+}
+
+func (s *nlSession) Close() {
+	unix.Close(s.fd)
+}
+
+// add queues one request. body is the fixed-size header (struct rtmsg /
+// fib_rule_hdr); attrs are the attribute blobs appended after it. A full
+// batch is flushed first, so add can report an earlier request's error.
+func (s *nlSession) add(msgType, flags uint16, ignore syscall.Errno, body []byte, attrs ...[]byte) error {
+	msgLen := unix.SizeofNlMsghdr + len(body)
+	for _, a := range attrs {
+		msgLen += len(a)
+	}
+	if len(s.buf) > 0 && len(s.buf)+msgLen > nlBatchBytes {
+		if err := s.flush(); err != nil {
+			return err
+		}
+	}
+
+	s.seq++
+	off := len(s.buf)
+	s.buf = append(s.buf, make([]byte, unix.SizeofNlMsghdr)...)
+	binary.NativeEndian.PutUint32(s.buf[off:], uint32(msgLen))
+	binary.NativeEndian.PutUint16(s.buf[off+4:], msgType)
+	binary.NativeEndian.PutUint16(s.buf[off+6:], flags)
+	binary.NativeEndian.PutUint32(s.buf[off+8:], s.seq)
+	s.buf = append(s.buf, body...)
+	for _, a := range attrs {
+		s.buf = append(s.buf, a...)
+	}
+	s.pending = append(s.pending, nlPending{seq: s.seq, ignore: ignore})
+	return nil
+}
+
+// flush sends the queued requests in one sendmsg and waits for all their
+// ACKs. It returns the first error that is not the request's ignored one.
+func (s *nlSession) flush() error {
+	if len(s.buf) == 0 {
+		return nil
+	}
+	pending := s.pending
+	s.pending = s.pending[:0]
+	err := unix.Sendto(s.fd, s.buf, 0, &unix.SockaddrNetlink{Family: unix.AF_NETLINK})
+	s.buf = s.buf[:0]
+	if err != nil {
+		return fmt.Errorf("netlink send: %w", err)
+	}
+
+	first := pending[0].seq
+	var firstErr error
+	for acked := 0; acked < len(pending); {
+		n, _, err := unix.Recvfrom(s.fd, s.rbuf, 0)
+		if err != nil {
+			return fmt.Errorf("netlink recv: %w", err)
+		}
+		msgs, err := syscall.ParseNetlinkMessage(s.rbuf[:n])
+		if err != nil {
+			return fmt.Errorf("netlink parse: %w", err)
+		}
+		for _, m := range msgs {
+			i := int(m.Header.Seq - first)
+			if m.Header.Type != unix.NLMSG_ERROR || i < 0 || i >= len(pending) {
+				continue
+			}
+			acked++
+			errno := syscall.Errno(-int32(binary.NativeEndian.Uint32(m.Data[:4])))
+			if errno != 0 && errno != pending[i].ignore && firstErr == nil {
+				firstErr = errno
+			}
+		}
+	}
+	return firstErr
+}
+
+// do sends a single request and waits for its ACK.
+func (s *nlSession) do(msgType, flags uint16, ignore syscall.Errno, body []byte, attrs ...[]byte) error {
+	if err := s.add(msgType, flags, ignore, body, attrs...); err != nil {
+		return err
+	}
+	return s.flush()
+}
+
+// dump sends a NLM_F_DUMP request and returns every reply message. Data
+// is copied out of the receive buffer.
+func (s *nlSession) dump(msgType uint16, body []byte) ([]syscall.NetlinkMessage, error) {
+	if err := s.flush(); err != nil {
+		return nil, err
+	}
+	s.seq++
+	seq := s.seq
+	req := make([]byte, unix.SizeofNlMsghdr, unix.SizeofNlMsghdr+len(body))
+	binary.NativeEndian.PutUint32(req[0:], uint32(unix.SizeofNlMsghdr+len(body)))
+	binary.NativeEndian.PutUint16(req[4:], msgType)
+	binary.NativeEndian.PutUint16(req[6:], unix.NLM_F_REQUEST|unix.NLM_F_DUMP)
+	binary.NativeEndian.PutUint32(req[8:], seq)
+	req = append(req, body...)
+	if err := unix.Sendto(s.fd, req, 0, &unix.SockaddrNetlink{Family: unix.AF_NETLINK}); err != nil {
+		return nil, fmt.Errorf("netlink send: %w", err)
+	}
+
+	var out []syscall.NetlinkMessage
+	for {
+		n, _, err := unix.Recvfrom(s.fd, s.rbuf, 0)
+		if err != nil {
+			return nil, fmt.Errorf("netlink recv: %w", err)
+		}
+		msgs, err := syscall.ParseNetlinkMessage(s.rbuf[:n])
+		if err != nil {
+			return nil, fmt.Errorf("netlink parse: %w", err)
+		}
+		for _, m := range msgs {
+			if m.Header.Seq != seq {
+				continue
+			}
+			switch m.Header.Type {
+			case unix.NLMSG_DONE:
+				return out, nil
+			case unix.NLMSG_ERROR:
+				if errno := syscall.Errno(-int32(binary.NativeEndian.Uint32(m.Data[:4]))); errno != 0 {
+					return nil, errno
+				}
+			default:
+				m.Data = append([]byte(nil), m.Data...)
+				out = append(out, m)
+			}
+		}
+	}
+}
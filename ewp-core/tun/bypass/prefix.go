@@ -0,0 +1,48 @@
+package bypass
+
+import (
+	"net/netip"
+	"slices"
+)
+
+// AggregatePrefixes returns the smallest set of prefixes covering exactly
+// the addresses of in: prefixes are masked, those inside another one are
+// dropped, and sibling pairs are merged into their parent until none is
+// left. The result is sorted, IPv4 before IPv6. Invalid prefixes are
+// skipped.
+func AggregatePrefixes(in []netip.Prefix) []netip.Prefix {
+	ps := make([]netip.Prefix, 0, len(in))
+	for _, p := range in {
+		if p.IsValid() {
+			ps = append(ps, p.Masked())
+		}
+	}
+	slices.SortFunc(ps, func(a, b netip.Prefix) int {
+		if c := a.Addr().Compare(b.Addr()); c != 0 {
+			return c
+		}
+		return a.Bits() - b.Bits()
+	})
+
+	out := ps[:0]
+	for _, p := range ps {
+		// Sorted by start address, shortest first, so a covering prefix
+		// is always the last one kept.
+		if n := len(out); n > 0 && out[n-1].Bits() <= p.Bits() && out[n-1].Contains(p.Addr()) {
+			continue
+		}
+		out = append(out, p)
+		for len(out) >= 2 {
+			a, b := out[len(out)-2], out[len(out)-1]
+			if a.Bits() != b.Bits() || a.Bits() == 0 || a.Addr().BitLen() != b.Addr().BitLen() {
+				break
+			}
+			parent := netip.PrefixFrom(a.Addr(), a.Bits()-1).Masked()
+			if parent.Addr() != a.Addr() || !parent.Contains(b.Addr()) {
+				break
+			}
+			out = append(out[:len(out)-2], parent)
+		}
+	}
+	return out
+}
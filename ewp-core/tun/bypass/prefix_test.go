@@ -0,0 +1,56 @@
+package bypass
+
+import (
+	"net/netip"
+	"slices"
+	"testing"
+)
+
+func prefixes(ss ...string) []netip.Prefix {
+	out := make([]netip.Prefix, len(ss))
+	for i, s := range ss {
+		out[i] = netip.MustParsePrefix(s)
+	}
+	return out
+}
+
+func TestAggregatePrefixes(t *testing.T) {
+	tests := []struct {
+		name string
+		in   []netip.Prefix
+		want []netip.Prefix
+	}{
+		{"empty", nil, prefixes()},
+		{"siblings merge", prefixes("10.0.0.0/25", "10.0.0.128/25"), prefixes("10.0.0.0/24")},
+		{"merge cascades", prefixes("10.0.3.0/24", "10.0.0.0/24", "10.0.2.0/24", "10.0.1.0/24"), prefixes("10.0.0.0/22")},
+		{"adjacent non-siblings stay", prefixes("10.0.1.0/24", "10.0.2.0/24"), prefixes("10.0.1.0/24", "10.0.2.0/24")},
+		{"covered dropped", prefixes("10.0.0.0/8", "10.1.2.0/24", "10.0.0.0/16"), prefixes("10.0.0.0/8")},
+		{"duplicates", prefixes("192.168.1.0/24", "192.168.1.0/24"), prefixes("192.168.1.0/24")},
+		{"host bits masked", prefixes("192.168.1.7/24"), prefixes("192.168.1.0/24")},
+		{"families kept apart", prefixes("fd00::/9", "0.0.0.0/1", "128.0.0.0/1", "fd80::/9"), prefixes("0.0.0.0/0", "fd00::/8")},
+		{"default not merged further", prefixes("0.0.0.0/0", "::/0"), prefixes("0.0.0.0/0", "::/0")},
+	}
+	for _, tt := range tests {
+		t.Run(tt.name, func(t *testing.T) {
+			if got := AggregatePrefixes(tt.in); !slices.Equal(got, tt.want) {
+				t.Errorf("got %v, want %v", got, tt.want)
+			}
+		})
+	}
+}
+
+func TestAggregatePrefixesNonAdjacent(t *testing.T) {
+	in := benchPrefixes(10000)
+	if got := AggregatePrefixes(in); len(got) != len(in) {
+		t.Errorf("%d non-adjacent prefixes aggregated to %d", len(in), len(got))
+	}
+}
+
+// benchPrefixes returns n /24s with a gap after each, so none merge.
+func benchPrefixes(n int) []netip.Prefix {
+	out := make([]netip.Prefix, n)
+	for i := range out {
+		out[i] = netip.PrefixFrom(netip.AddrFrom4([4]byte{10, byte(i >> 7), byte(i&127) * 2, 0}), 24)
+	}
+	return out
+}
@@ -1,6 +1,7 @@
 package gvisor
 
 import (
+	"errors"
 	"sync"
 
 	tun "golang.zx2c4.com/wireguard/tun"
@@ -10,21 +11,50 @@ import (
 	"gvisor.dev/gvisor/pkg/tcpip/stack"
 )
 
+// tunOffset is the headroom left in front of every packet exchanged with
+// the device. wireguard-go's drivers write their own header there: the
+// 10-byte virtio-net header on Linux, the 4-byte address family on Darwin.
+const tunOffset = 16
+
+// groBufferSize is the capacity of a write buffer on an offloaded device.
+// wireguard-go coalesces a batch by appending the following segments'
+// payloads to the head packet in place, and skips any packet whose buffer
+// has no room for them; a buffer can hold a full 64 KiB super-packet.
+const groBufferSize = tunOffset + 65535
+
 type endpoint struct {
-	tunDev     tun.Device
+	devs       []tun.Device // one per device queue
 	mtu        uint32
+	offload    bool // devices exchange virtio-net headers (Linux TSO/GRO)
 	dispatcher stack.NetworkDispatcher
-	bufPool    sync.Pool // []byte buffers of size mtu+4; reduces GC pressure in dispatchLoop
+	batches    sync.Pool // *writeBatch
 }
 
-// newEndpoint wraps a wireguard-go tun.Device as a gvisor LinkEndpoint.
-func newEndpoint(dev tun.Device, mtu uint32) (stack.LinkEndpoint, error) {
+// writeBatch holds the device buffers for one WritePackets call. Buffers
+// keep their capacity across calls, so steady-state writes do not allocate.
+type writeBatch struct {
+	bufs   [][]byte
+	queues [][][]byte // bufs split by device queue
+	bufCap int        // minimum capacity of a new buffer
+}
+
+// newEndpoint wraps the queues of a wireguard-go tun.Device as a gvisor
+// LinkEndpoint. Each queue gets its own dispatch loop.
+func newEndpoint(devs []tun.Device, mtu uint32) (stack.LinkEndpoint, error) {
+	if len(devs) == 0 {
+		return nil, errors.New("no TUN device")
+	}
 	ep := &endpoint{
-		tunDev: dev,
-		mtu:    mtu,
+		devs:    devs,
+		mtu:     mtu,
+		offload: offloaded(devs[0]),
 	}
-	ep.bufPool.New = func() any {
-		return make([]byte, mtu+4)
+	ep.batches.New = func() any {
+		b := &writeBatch{}
+		if ep.offload {
+			b.bufCap = groBufferSize
+		}
+		return b
 	}
 	return ep, nil
 }
@@ -33,7 +63,22 @@ func (e *endpoint) MTU() uint32 {
 	return e.mtu
 }
 
+// offloaded reports whether wireguard-go negotiated the virtio-net header
+// for dev; only then does it read and write more than one packet per call.
+func offloaded(dev tun.Device) bool {
+	return dev.BatchSize() > 1
+}
+
+// Capabilities advertises RX checksum offload when the device is offloaded:
+// wireguard-go completes the checksums of every segment it splits out of a
+// kernel super-packet and of packets flagged NEEDS_CSUM, so gVisor need not
+// verify them again. TX checksum offload is not advertised because packets
+// the device does not coalesce go to the kernel without a virtio-net
+// checksum request and must already be complete.
 func (e *endpoint) Capabilities() stack.LinkEndpointCapabilities {
+	if e.offload {
+		return stack.CapabilityRXChecksumOffload
+	}
 	return stack.CapabilityNone
 }
 
@@ -45,21 +90,102 @@ func (e *endpoint) LinkAddress() tcpip.LinkAddress {
 	return ""
 }
 
+// WritePackets copies each packet once, straight from its views into a
+// pooled device buffer, and hands the list to the device in a single Write
+// call per queue.
 func (e *endpoint) WritePackets(pkts stack.PacketBufferList) (int, tcpip.Error) {
-	n := 0
-	for _, pkt := range pkts.AsSlice() {
-		view := pkt.ToView()
-		buf := make([]byte, len(view.AsSlice()))
-		copy(buf, view.AsSlice())
-		view.Release()
-
-		_, err := e.tunDev.Write([][]byte{buf}, 0)
+	b := e.batches.Get().(*writeBatch)
+	defer e.batches.Put(b)
+
+	list := pkts.AsSlice()
+	b.bufs = b.bufs[:0]
+	for _, pkt := range list {
+		b.bufs = append(b.bufs, b.fill(len(b.bufs), pkt))
+	}
+	if len(b.bufs) == 0 {
+		return 0, nil
+	}
+	if len(e.devs) == 1 {
+		return writeQueue(e.devs[0], b.bufs)
+	}
+
+	if len(b.queues) != len(e.devs) {
+		b.queues = make([][][]byte, len(e.devs))
+	}
+	for q := range b.queues {
+		b.queues[q] = b.queues[q][:0]
+	}
+	for i, pkt := range list {
+		q := queueOf(pkt, len(e.devs))
+		b.queues[q] = append(b.queues[q], b.bufs[i])
+	}
+	written := 0
+	var werr tcpip.Error
+	for q, bufs := range b.queues {
+		if len(bufs) == 0 {
+			continue
+		}
+		n, err := writeQueue(e.devs[q], bufs)
+		written += n
 		if err != nil {
-			return n, &tcpip.ErrAborted{}
+			werr = err
 		}
-		n++
 	}
-	return n, nil
+	return written, werr
+}
+
+func writeQueue(dev tun.Device, bufs [][]byte) (int, tcpip.Error) {
+	n, err := dev.Write(bufs, tunOffset)
+	if err != nil {
+		return min(n, len(bufs)), &tcpip.ErrAborted{}
+	}
+	return len(bufs), nil
+}
+
+// queueOf picks the device queue for pkt. gVisor's TCP endpoints stamp a
+// per-connection hash on their packets, so a connection always leaves on
+// the same queue; packets without one (UDP, ICMP) are hashed by address.
+func queueOf(pkt *stack.PacketBuffer, n int) int {
+	h := pkt.Hash
+	if h == 0 {
+		nh := pkt.NetworkHeader().Slice()
+		var addrs []byte
+		switch header.IPVersion(nh) {
+		case header.IPv4Version:
+			if len(nh) >= header.IPv4MinimumSize {
+				addrs = nh[12:20]
+			}
+		case header.IPv6Version:
+			if len(nh) >= header.IPv6MinimumSize {
+				addrs = nh[8:40]
+			}
+		}
+		h = 2166136261 // FNV-1a
+		for _, c := range addrs {
+			h = (h ^ uint32(c)) * 16777619
+		}
+	}
+	return int(h % uint32(n))
+}
+
+// fill copies pkt into the i-th buffer after tunOffset bytes of headroom,
+// growing the buffer if the packet does not fit. New buffers get at least
+// bufCap bytes of capacity.
+func (b *writeBatch) fill(i int, pkt *stack.PacketBuffer) []byte {
+	size := tunOffset + pkt.Size()
+	var buf []byte
+	if i < cap(b.bufs) { // reuse the buffer left in this slot by an earlier call
+		buf = b.bufs[:i+1][i]
+	}
+	if cap(buf) < size {
+		buf = make([]byte, size, max(size, b.bufCap))
+	}
+	buf = buf[:size]
+	off := tunOffset
+	for _, s := range pkt.AsSlices() {
+		off += copy(buf[off:], s)
+	}
+	return buf
 }
 
 func (e *endpoint) Attach(dispatcher stack.NetworkDispatcher) {
@@ -68,27 +194,38 @@ func (e *endpoint) Attach(dispatcher stack.NetworkDispatcher) {
 		return
 	}
 
-	go e.dispatchLoop()
+	for _, dev := range e.devs {
+		go e.dispatchLoop(dev)
+	}
 }
 
-func (e *endpoint) dispatchLoop() {
+// dispatchLoop reads up to BatchSize packets per call from one queue
+// directly into gVisor views; each filled view is handed to the stack as
+// the packet's payload without a copy and replaced by a fresh one.
+func (e *endpoint) dispatchLoop(dev tun.Device) {
 	// BatchSize reports the preferred number of packets to read per call.
 	// For most platforms without GRO this is 1; Linux with vnetHdr can be 128.
-	batchSize := e.tunDev.BatchSize()
+	batchSize := dev.BatchSize()
 	if batchSize <= 0 {
 		batchSize = 1
 	}
+	bufSize := tunOffset + int(e.mtu)
 
-	// Pre-allocate buffer slices for the full batch.
+	views := make([]*buffer.View, batchSize)
 	bufs := make([][]byte, batchSize)
-	for i := range bufs {
-		bufs[i] = e.bufPool.Get().([]byte) // +4 headroom baked into pool alloc size
+	for i := range views {
+		views[i] = buffer.NewViewSize(bufSize)
+		bufs[i] = views[i].AsSlice()
 	}
 	sizes := make([]int, batchSize)
+	defer func() {
+		for _, v := range views {
+			v.Release()
+		}
+	}()
 
 	for {
-		// Read up to batchSize packets in one syscall.
-		n, err := e.tunDev.Read(bufs, sizes, 0)
+		n, err := dev.Read(bufs, sizes, tunOffset)
 		if err != nil {
 			return
 		}
@@ -98,11 +235,8 @@ func (e *endpoint) dispatchLoop() {
 				continue
 			}
 
-			// sizes[i] is the actual byte count for packet i.
-			payload := bufs[i][:sizes[i]]
-
 			var protocol tcpip.NetworkProtocolNumber
-			switch header.IPVersion(payload) {
+			switch header.IPVersion(bufs[i][tunOffset:]) {
 			case header.IPv4Version:
 				protocol = header.IPv4ProtocolNumber
 			case header.IPv6Version:
@@ -111,17 +245,17 @@ func (e *endpoint) dispatchLoop() {
 				continue
 			}
 
+			v := views[i]
+			v.TrimFront(tunOffset)
+			v.CapLength(sizes[i])
 			pkt := stack.NewPacketBuffer(stack.PacketBufferOptions{
-				Payload: buffer.MakeWithData(payload),
+				Payload: buffer.MakeWithView(v),
 			})
 			e.dispatcher.DeliverNetworkPacket(protocol, pkt)
 			pkt.DecRef()
 
-			// Refresh the buffer for reuse — the previous slice was
-			// handed to gVisor via MakeWithData (which copies), but we
-			// must not reuse it since gVisor may still reference it.
-			// Pool.Get() is faster than make() on hot paths (P-local cache).
-			bufs[i] = e.bufPool.Get().([]byte)
+			views[i] = buffer.NewViewSize(bufSize)
+			bufs[i] = views[i].AsSlice()
 		}
 	}
 }
@@ -0,0 +1,131 @@
+//go:build linux && !android
+
+package gvisor
+
+import (
+	"encoding/json"
+	"os"
+	"os/exec"
+	"runtime"
+	"testing"
+
+	"golang.org/x/sys/unix"
+	tun "golang.zx2c4.com/wireguard/tun"
+	"gvisor.dev/gvisor/pkg/buffer"
+	"gvisor.dev/gvisor/pkg/tcpip"
+	"gvisor.dev/gvisor/pkg/tcpip/checksum"
+	"gvisor.dev/gvisor/pkg/tcpip/header"
+	"gvisor.dev/gvisor/pkg/tcpip/stack"
+)
+
+// TestWritePacketsCoalesced writes one connection's in-order TCP segments
+// to an offloaded TUN device and checks that the kernel received fewer
+// packets than were written: wireguard-go merged them into super-packets,
+// which it only does when the write buffers have room to grow. It runs in
+// a private network namespace and needs root.
+func TestWritePacketsCoalesced(t *testing.T) {
+	if os.Geteuid() != 0 {
+		t.Skip("needs root for a network namespace and a TUN device")
+	}
+	// The thread stays locked: it dies with its namespace when the test
+	// goroutine exits.
+	runtime.LockOSThread()
+	if err := unix.Unshare(unix.CLONE_NEWNET); err != nil {
+		t.Skipf("unshare network namespace: %v", err)
+	}
+	dev, err := tun.CreateTUN("ewpgro0", 1500)
+	if err != nil {
+		t.Skipf("create TUN: %v", err)
+	}
+	defer dev.Close()
+	ep, _ := newEndpoint([]tun.Device{dev}, 1500)
+	if !ep.(*endpoint).offload {
+		t.Skip("kernel refused TUN offloads")
+	}
+	name, _ := dev.Name()
+	for _, args := range [][]string{
+		{"link", "set", name, "up"},
+		{"addr", "add", "10.78.0.1/24", "dev", name},
+	} {
+		if out, err := exec.Command("ip", args...).CombinedOutput(); err != nil {
+			t.Fatalf("ip %v: %v: %s", args, err, out)
+		}
+	}
+
+	const segments = 16
+	before := rxPackets(t, name)
+	list := tcpSegments(segments, 1000)
+	defer list.DecRef()
+	if n, err := ep.WritePackets(list); err != nil || n != segments {
+		t.Fatalf("WritePackets = %d, %v", n, err)
+	}
+	if got := rxPackets(t, name) - before; got == 0 || got >= segments {
+		t.Errorf("device received %d packets for %d segments, want them coalesced", got, segments)
+	}
+}
+
+// tcpSegments returns n consecutive ACK segments of one IPv4 connection,
+// each carrying size bytes of payload, with valid checksums.
+func tcpSegments(n, size int) stack.PacketBufferList {
+	src := tcpip.AddrFrom4([4]byte{10, 78, 0, 2})
+	dst := tcpip.AddrFrom4([4]byte{10, 78, 0, 1})
+	var list stack.PacketBufferList
+	for i := 0; i < n; i++ {
+		raw := make([]byte, header.IPv4MinimumSize+header.TCPMinimumSize+size)
+		ip := header.IPv4(raw)
+		ip.Encode(&header.IPv4Fields{
+			TotalLength: uint16(len(raw)),
+			ID:          uint16(i),
+			Flags:       header.IPv4FlagDontFragment,
+			TTL:         64,
+			Protocol:    uint8(header.TCPProtocolNumber),
+			SrcAddr:     src,
+			DstAddr:     dst,
+		})
+		ip.SetChecksum(^ip.CalculateChecksum())
+
+		tcp := header.TCP(raw[header.IPv4MinimumSize:])
+		tcp.Encode(&header.TCPFields{
+			SrcPort:    443,
+			DstPort:    40000,
+			SeqNum:     1 + uint32(i*size),
+			AckNum:     1,
+			DataOffset: header.TCPMinimumSize,
+			Flags:      header.TCPFlagAck,
+			WindowSize: 65535,
+		})
+		payload := tcp.Payload()
+		for j := range payload {
+			payload[j] = byte(i + j)
+		}
+		xsum := header.PseudoHeaderChecksum(header.TCPProtocolNumber, src, dst, uint16(len(tcp)))
+		xsum = checksum.Checksum(payload, xsum)
+		tcp.SetChecksum(^tcp.CalculateChecksum(xsum))
+
+		list.PushBack(stack.NewPacketBuffer(stack.PacketBufferOptions{
+			Payload: buffer.MakeWithData(raw),
+		}))
+	}
+	return list
+}
+
+// rxPackets returns the number of packets the kernel has received on the
+// interface, which for a TUN device is one per packet written to it.
+func rxPackets(t *testing.T, name string) uint64 {
+	t.Helper()
+	out, err := exec.Command("ip", "-j", "-s", "link", "show", "dev", name).Output()
+	if err != nil {
+		t.Fatalf("ip link show: %v", err)
+	}
+	var links []struct {
+		Stats struct {
+			RX struct {
+				Packets uint64 `json:"packets"`
+			} `json:"rx"`
+		} `json:"stats64"`
+	}
+	if err := json.Unmarshal(out, &links); err != nil || len(links) != 1 {
+		t.Fatalf("parse ip link show: %v: %s", err, out)
+	}
+	return links[0].Stats.RX.Packets
+}
@@ -13,6 +13,7 @@ import (
 	"gvisor.dev/gvisor/pkg/tcpip"
 	"gvisor.dev/gvisor/pkg/tcpip/adapters/gonet"
 	"gvisor.dev/gvisor/pkg/tcpip/header"
+	"gvisor.dev/gvisor/pkg/tcpip/link/qdisc/fifo"
 	"gvisor.dev/gvisor/pkg/tcpip/network/ipv4"
 	"gvisor.dev/gvisor/pkg/tcpip/network/ipv6"
 	"gvisor.dev/gvisor/pkg/tcpip/stack"
@@ -55,6 +56,13 @@ type Stack struct {
 
 // NewStack creates a new gVisor TCP/IP stack attached to the given wireguard-go TUN device
 func NewStack(tunDev tun.Device, config *StackConfig) (*Stack, error) {
+	return NewMultiQueueStack([]tun.Device{tunDev}, config)
+}
+
+// NewMultiQueueStack creates a gVisor stack attached to every queue of a
+// multi-queue TUN device. Each queue is read by its own goroutine; outbound
+// packets are spread over the queues by flow.
+func NewMultiQueueStack(tunDevs []tun.Device, config *StackConfig) (*Stack, error) {
 	if config.TCPHandler == nil || config.UDPHandler == nil {
 		return nil, errors.New("TCP and UDP handlers are required")
 	}
@@ -72,13 +80,21 @@ func NewStack(tunDev tun.Device, config *StackConfig) (*Stack, error) {
 		},
 	})
 
-	ep, err := newEndpoint(tunDev, uint32(config.MTU))
+	ep, err := newEndpoint(tunDevs, uint32(config.MTU))
 	if err != nil {
 		return nil, fmt.Errorf("create gvisor endpoint: %w", err)
 	}
 
 	nicID := tcpip.NICID(1)
-	if err := ipStack.CreateNIC(nicID, ep); err != nil {
+	var nicOpts stack.NICOptions
+	if offloaded(tunDevs[0]) || len(tunDevs) > 1 {
+		// Queue outbound packets so they reach the device in batches,
+		// which the kernel side coalesces into super-packets (GRO). One
+		// dispatcher per device queue; the qdisc keeps a TCP connection
+		// on one dispatcher by its packet hash.
+		nicOpts.QDisc = fifo.New(ep, len(tunDevs), 1000)
+	}
+	if err := ipStack.CreateNICWithOptions(nicID, ep, nicOpts); err != nil {
 		return nil, fmt.Errorf("create NIC: %v", err)
 	}
 
@@ -105,7 +121,7 @@ func NewStack(tunDev tun.Device, config *StackConfig) (*Stack, error) {
 
 	s := &Stack{
 		ipStack:   ipStack,
-		tunDev:    tunDev,
+		tunDev:    tunDevs[0],
 		config:    config,
 		stopClean: make(chan struct{}),
 	}
@@ -300,7 +316,8 @@ func (s *Stack) InjectUDP(payload []byte, src netip.AddrPort, dst netip.AddrPort
 	if srcIP.Is4() && dstIP.Is4() {
 		// IPv4 + UDP
 		ipLen := 20 + udpLen // IPv4 header(20) + UDP
-		pkt := make([]byte, ipLen)
+		buf := make([]byte, tunOffset+ipLen)
+		pkt := buf[tunOffset:]
 
 		// IPv4 header
 		pkt[0] = 0x45 // Version=4, IHL=5 (20 bytes)
@@ -348,7 +365,7 @@ func (s *Stack) InjectUDP(payload []byte, src netip.AddrPort, dst netip.AddrPort
 
 		// payload already copied above
 
-		_, err := s.tunDev.Write([][]byte{pkt}, 0)
+		_, err := s.tunDev.Write([][]byte{buf}, tunOffset)
 		return err
 	}
 
@@ -14,6 +14,7 @@ import (
 	"ewp-core/log"
 	"ewp-core/nat"
 	"ewp-core/transport"
+	"ewp-core/transport/conntrack"
 
 	"golang.org/x/sync/singleflight"
 	"gvisor.dev/gvisor/pkg/tcpip/adapters/gonet"
@@ -72,6 +73,7 @@ type Handler struct {
 	udpSessions        sync.Map           // map[udpSessionKey]*udpSession
 	udpSF              singleflight.Group // deduplicates concurrent ConnectUDP for same 5-tuple
 	udpSessionTimeout  time.Duration      // idle timeout for UDP sessions; 0 = default 2min
+	redundantUDP       *RedundantUDPConfig // nil = every flow uses h.transport only
 }
 
 func NewHandler(ctx context.Context, trans transport.Transport, udpWriter UDPWriter) *Handler {
@@ -99,6 +101,12 @@ func (h *Handler) SetPeerRegistry(reg nat.PeerRegistry) {
 	h.peerReg = reg
 }
 
+// SetRedundantUDP duplicates matching UDP flows over two transports
+// (see redundant.go). nil disables it.
+func (h *Handler) SetRedundantUDP(cfg *RedundantUDPConfig) {
+	h.redundantUDP = cfg
+}
+
 // SetUDPSessionTimeout overrides the default UDP session idle timeout (2 min).
 // Sessions inactive for longer than this are cleaned up.
 func (h *Handler) SetUDPSessionTimeout(d time.Duration) {
@@ -136,12 +144,19 @@ func (h *Handler) HandleTCP(conn *gonet.TCPConn) {
 	}
 	log.Printf("[TUN TCP] New connection: %s -> %s", srcAddr, target)
 
-	tunnelConn, err := h.transport.Dial()
+	dialStart := time.Now()
+	rawConn, err := h.transport.Dial()
 	if err != nil {
 		log.Printf("[TUN TCP] Tunnel dial failed: %v", err)
 		conn.Close()
 		return
 	}
+	tunnelConn := conntrack.Wrap(rawConn, conntrack.Meta{
+		Inbound:   "tun",
+		Source:    srcAddr.String(),
+		Transport: h.transport.Name(),
+		DialStart: dialStart,
+	})
 	defer tunnelConn.Close()
 	defer conn.Close()
 
@@ -246,21 +261,33 @@ func (h *Handler) HandleUDP(payload []byte, src netip.AddrPort, dst netip.AddrPo
 		// wasted stream-open overhead under burst traffic.
 		sfKey := src.String() + "|" + dst.String()
 		v, err, _ := h.udpSF.Do(sfKey, func() (interface{}, error) {
-			tunnelConn, err := h.transport.Dial()
-			if err != nil {
-				return nil, fmt.Errorf("tunnel dial: %w", err)
-			}
-
 			if endpoint.Domain != "" {
 				log.V("[TUN UDP] New session: %s -> %s:%d", src, endpoint.Domain, dst.Port())
 			} else {
 				log.V("[TUN UDP] New session: %s -> %s", src, dst)
 			}
 
-			if err := tunnelConn.ConnectUDP(endpoint, nil); err != nil {
-				tunnelConn.Close()
-				return nil, fmt.Errorf("ConnectUDP: %w", err)
+			var tunnelConn transport.TunnelConn
+			meta := conntrack.Meta{Inbound: "tun", Source: src.String(), Transport: h.transport.Name(), DialStart: time.Now()}
+			if h.redundantUDP != nil && h.redundantUDP.matches(dst.Port()) {
+				conn, err := dialRedundantUDP(h.redundantUDP, endpoint)
+				if err != nil {
+					return nil, fmt.Errorf("redundant ConnectUDP: %w", err)
+				}
+				tunnelConn = conn
+				meta.Transport = h.redundantUDP.Primary.Name() + " + " + h.redundantUDP.Secondary.Name()
+			} else {
+				conn, err := h.transport.Dial()
+				if err != nil {
+					return nil, fmt.Errorf("tunnel dial: %w", err)
+				}
+				if err := conn.ConnectUDP(endpoint, nil); err != nil {
+					conn.Close()
+					return nil, fmt.Errorf("ConnectUDP: %w", err)
+				}
+				tunnelConn = conn
 			}
+			tunnelConn = conntrack.Register(tunnelConn, meta, "udp", endpoint.String())
 
 			s := &udpSession{tunnelConn: tunnelConn, remoteAddr: dst}
 			s.lastActive.Store(time.Now().UnixNano())
@@ -24,6 +24,9 @@ func newHandlerCore(ctx context.Context, cfg *Config, writer UDPWriter) (*Handle
 	if !cfg.DisableFakeIP {
 		h.SetFakeIPPool(dns.NewFakeIPPool())
 	}
+	if cfg.RedundantUDP != nil {
+		h.SetRedundantUDP(cfg.RedundantUDP)
+	}
 
 	return h, reg
 }
@@ -0,0 +1,317 @@
+package tun
+
+import (
+	"crypto/rand"
+	"encoding/binary"
+	"errors"
+	"net/netip"
+	"sync"
+	"sync/atomic"
+	"time"
+
+	commpool "ewp-core/common/bufferpool"
+	"ewp-core/constant"
+	"ewp-core/log"
+	"ewp-core/protocol/redundant"
+	"ewp-core/transport"
+)
+
+// Redundant dual-path UDP: a matching flow is opened over two transports
+// to the same server, every datagram is sent on both, and replies are
+// deduplicated so the app sees each one once, from whichever path delivered
+// it first. Loss or a latency spike on one path is then hidden by the other.
+//
+// Both copies carry the protocol/redundant sequence shim. The server joins
+// them into one upstream socket, so the target sees one client and one
+// session, and numbers its replies so the client drops the second copy by
+// sequence rather than by content.
+
+const (
+	pathPrimary   = 0
+	pathSecondary = 1
+)
+
+// PortRange is an inclusive destination port range.
+type PortRange struct {
+	From, To uint16
+}
+
+// RedundantUDPConfig selects the UDP flows duplicated over two transports.
+type RedundantUDPConfig struct {
+	Primary   transport.Transport
+	Secondary transport.Transport
+	Ports     []PortRange // empty = every UDP flow
+}
+
+func (c *RedundantUDPConfig) matches(port uint16) bool {
+	if len(c.Ports) == 0 {
+		return true
+	}
+	for _, r := range c.Ports {
+		if port >= r.From && port <= r.To {
+			return true
+		}
+	}
+	return false
+}
+
+// RedundantUDPStats aggregates closed and live redundant flows.
+type RedundantUDPStats struct {
+	Flows          int64 // flows opened on both paths
+	Degraded       int64 // flows where only one path could be opened
+	Delivered      int64 // unique datagrams handed to the app
+	SecondaryFirst int64 // ... of which the secondary path delivered first
+	Duplicates     int64 // late copies dropped
+}
+
+var redundantStats struct {
+	flows, degraded, delivered, secondaryFirst, duplicates atomic.Int64
+}
+
+// GetRedundantUDPStats returns a snapshot of the redundant UDP counters.
+func GetRedundantUDPStats() RedundantUDPStats {
+	return RedundantUDPStats{
+		Flows:          redundantStats.flows.Load(),
+		Degraded:       redundantStats.degraded.Load(),
+		Delivered:      redundantStats.delivered.Load(),
+		SecondaryFirst: redundantStats.secondaryFirst.Load(),
+		Duplicates:     redundantStats.duplicates.Load(),
+	}
+}
+
+// dialRedundantUDP opens the flow on both paths in parallel. If one path
+// fails the flow continues on the other alone; it fails only if both do.
+func dialRedundantUDP(cfg *RedundantUDPConfig, endpoint transport.Endpoint) (transport.TunnelConn, error) {
+	var conns [2]transport.TunnelConn
+	var errs [2]error
+	var wg sync.WaitGroup
+	for i, t := range [2]transport.Transport{cfg.Primary, cfg.Secondary} {
+		wg.Add(1)
+		go func(i int, t transport.Transport) {
+			defer wg.Done()
+			conn, err := t.Dial()
+			if err != nil {
+				errs[i] = err
+				return
+			}
+			if err := conn.ConnectUDP(endpoint, nil); err != nil {
+				conn.Close()
+				errs[i] = err
+				return
+			}
+			conns[i] = conn
+		}(i, t)
+	}
+	wg.Wait()
+
+	switch {
+	case conns[0] != nil && conns[1] != nil:
+		redundantStats.flows.Add(1)
+		return newRedundantConn(conns[0], conns[1]), nil
+	case conns[0] != nil:
+		redundantStats.degraded.Add(1)
+		log.V("[TUN UDP] Redundant: secondary path unavailable (%v), primary only", errs[1])
+		return conns[0], nil
+	case conns[1] != nil:
+		redundantStats.degraded.Add(1)
+		log.V("[TUN UDP] Redundant: primary path unavailable (%v), secondary only", errs[0])
+		return conns[1], nil
+	}
+	return nil, errors.Join(errs[0], errs[1])
+}
+
+type redundantPacket struct {
+	buf    []byte
+	pooled bool // buf came from commpool.GetSmall
+	n      int
+	addr   netip.AddrPort
+	path   int
+}
+
+// release returns the packet's buffer to the pool if it came from there.
+func (p *redundantPacket) release() {
+	if p.pooled {
+		commpool.PutSmall(p.buf)
+	}
+}
+
+// redundantConn is a transport.TunnelConn over two UDP tunnels. It only
+// implements the UDP side; udpSession uses it like any other tunnel.
+type redundantConn struct {
+	paths   [2]transport.TunnelConn
+	packets chan redundantPacket
+	done    chan struct{}
+	once    sync.Once
+
+	flow    uint64 // shim flow ID, shared by both paths
+	sendSeq atomic.Uint32
+
+	// only touched by the ReadUDPFrom caller
+	window      redundant.Window
+	closedPaths int
+
+	// per-flow stats
+	delivered      atomic.Int64
+	secondaryFirst atomic.Int64
+	duplicates     atomic.Int64
+}
+
+func newRedundantConn(primary, secondary transport.TunnelConn) *redundantConn {
+	c := &redundantConn{
+		paths:   [2]transport.TunnelConn{primary, secondary},
+		packets: make(chan redundantPacket, 64),
+		done:    make(chan struct{}),
+	}
+	var id [8]byte
+	rand.Read(id[:])
+	c.flow = binary.BigEndian.Uint64(id[:])
+	go c.readPath(pathPrimary)
+	go c.readPath(pathSecondary)
+	return c
+}
+
+// readPath pumps one tunnel into the shared queue. The flow ends only when
+// both paths have ended, so a dying secondary does not cut the session.
+func (c *redundantConn) readPath(path int) {
+	buf := commpool.GetUDP()
+	defer commpool.PutUDP(buf)
+	for {
+		n, addr, err := c.paths[path].ReadUDPFrom(buf)
+		if err != nil {
+			c.pathDone(path, err)
+			return
+		}
+		pkt := redundantPacket{n: n, addr: addr, path: path}
+		if n <= constant.SmallBufferSize {
+			pkt.buf, pkt.pooled = commpool.GetSmall(), true
+		} else {
+			pkt.buf = make([]byte, n)
+		}
+		copy(pkt.buf, buf[:n])
+		select {
+		case c.packets <- pkt:
+		case <-c.done:
+			pkt.release()
+			return
+		}
+	}
+}
+
+var errRedundantClosed = errors.New("redundant UDP: both paths closed")
+
+func (c *redundantConn) pathDone(path int, err error) {
+	log.V("[TUN UDP] Redundant path %d closed: %v", path, err)
+	c.paths[path].Close()
+	select {
+	case c.packets <- redundantPacket{path: path, n: -1}:
+	case <-c.done:
+	}
+}
+
+func (c *redundantConn) ReadUDPFrom(buf []byte) (int, netip.AddrPort, error) {
+	for {
+		var pkt redundantPacket
+		select {
+		case pkt = <-c.packets:
+		case <-c.done:
+			return 0, netip.AddrPort{}, errRedundantClosed
+		}
+		if pkt.n < 0 {
+			if c.closedPaths++; c.closedPaths == 2 {
+				return 0, netip.AddrPort{}, errRedundantClosed
+			}
+			continue
+		}
+
+		// A reply without the shim came from a server that predates it and
+		// is passed through as is.
+		payload := pkt.buf[:pkt.n]
+		if flow, seq, data, ok := redundant.Parse(payload); ok && flow == c.flow {
+			if !c.window.Admit(seq) {
+				c.duplicates.Add(1)
+				redundantStats.duplicates.Add(1)
+				pkt.release()
+				continue
+			}
+			payload = data
+		}
+		c.delivered.Add(1)
+		redundantStats.delivered.Add(1)
+		if pkt.path == pathSecondary {
+			c.secondaryFirst.Add(1)
+			redundantStats.secondaryFirst.Add(1)
+		}
+		n := copy(buf, payload)
+		pkt.release()
+		return n, pkt.addr, nil
+	}
+}
+
+func (c *redundantConn) ReadUDPTo(buf []byte) (int, error) {
+	n, _, err := c.ReadUDPFrom(buf)
+	return n, err
+}
+
+func (c *redundantConn) ReadUDP() ([]byte, error) {
+	buf := make([]byte, constant.UDPBufferSize)
+	n, _, err := c.ReadUDPFrom(buf)
+	if err != nil {
+		return nil, err
+	}
+	return buf[:n], nil
+}
+
+// WriteUDP sends on both paths under one sequence number; it fails only if
+// neither accepted the datagram. The tunnels copy data before returning.
+func (c *redundantConn) WriteUDP(target transport.Endpoint, data []byte) error {
+	buf := commpool.GetUDP()
+	defer commpool.PutUDP(buf)
+	msg := redundant.AppendHeader(buf[:0], c.flow, c.sendSeq.Add(1)-1)
+	msg = append(msg, data...)
+
+	err0 := c.paths[pathPrimary].WriteUDP(target, msg)
+	err1 := c.paths[pathSecondary].WriteUDP(target, msg)
+	if err0 != nil && err1 != nil {
+		return errors.Join(err0, err1)
+	}
+	return nil
+}
+
+func (c *redundantConn) StartPing(interval time.Duration) chan struct{} {
+	stop := make(chan struct{})
+	inner := [2]chan struct{}{
+		c.paths[pathPrimary].StartPing(interval),
+		c.paths[pathSecondary].StartPing(interval),
+	}
+	go func() {
+		<-stop
+		for _, ch := range inner {
+			if ch != nil {
+				close(ch)
+			}
+		}
+	}()
+	return stop
+}
+
+func (c *redundantConn) Close() error {
+	c.once.Do(func() {
+		close(c.done)
+		c.paths[pathPrimary].Close()
+		c.paths[pathSecondary].Close()
+		if d := c.delivered.Load(); d > 0 {
+			log.V("[TUN UDP] Redundant flow closed: %d datagrams, secondary first %d (%.0f%%), %d duplicates dropped",
+				d, c.secondaryFirst.Load(), float64(c.secondaryFirst.Load())*100/float64(d), c.duplicates.Load())
+		}
+	})
+	return nil
+}
+
+var errRedundantUDPOnly = errors.New("redundant UDP: stream operations not supported")
+
+func (c *redundantConn) Connect(string, []byte) error { return errRedundantUDPOnly }
+func (c *redundantConn) ConnectUDP(transport.Endpoint, []byte) error {
+	return errRedundantUDPOnly
+}
+func (c *redundantConn) Read([]byte) (int, error) { return 0, errRedundantUDPOnly }
+func (c *redundantConn) Write([]byte) error       { return errRedundantUDPOnly }
@@ -0,0 +1,206 @@
+package tun
+
+import (
+	"net/netip"
+	"strings"
+	"sync"
+	"testing"
+	"time"
+
+	"ewp-core/constant"
+	"ewp-core/protocol/redundant"
+	"ewp-core/transport"
+)
+
+// reply frames payload the way the server does for flow c.
+func reply(c *redundantConn, seq uint32, payload string) []byte {
+	return append(redundant.AppendHeader(nil, c.flow, seq), payload...)
+}
+
+// recordingConn keeps what is written to it.
+type recordingConn struct {
+	*mockTunnelConn
+	mu      sync.Mutex
+	written [][]byte
+}
+
+func (r *recordingConn) WriteUDP(_ transport.Endpoint, data []byte) error {
+	r.mu.Lock()
+	defer r.mu.Unlock()
+	r.written = append(r.written, append([]byte(nil), data...))
+	return nil
+}
+
+func readRedundant(t *testing.T, c *redundantConn) (string, bool) {
+	t.Helper()
+	type result struct {
+		data string
+		err  error
+	}
+	ch := make(chan result, 1)
+	go func() {
+		buf := make([]byte, 1500)
+		n, _, err := c.ReadUDPFrom(buf)
+		ch <- result{string(buf[:n]), err}
+	}()
+	select {
+	case r := <-ch:
+		if r.err != nil {
+			return "", false
+		}
+		return r.data, true
+	case <-time.After(200 * time.Millisecond):
+		return "", false
+	}
+}
+
+func TestRedundantUDPDeduplicates(t *testing.T) {
+	primary, secondary := newMockTunnelConn(), newMockTunnelConn()
+	c := newRedundantConn(primary, secondary)
+	defer c.Close()
+	from := netip.MustParseAddrPort("203.0.113.9:3478")
+
+	// Secondary wins the race for "a"; primary wins for "b".
+	secondary.inbound <- inboundPacket{reply(c, 0, "a"), from}
+	if got, _ := readRedundant(t, c); got != "a" {
+		t.Fatalf("got %q, want a", got)
+	}
+	primary.inbound <- inboundPacket{reply(c, 0, "a"), from}
+	primary.inbound <- inboundPacket{reply(c, 1, "b"), from}
+	if got, _ := readRedundant(t, c); got != "b" {
+		t.Fatalf("late copy of a not dropped: got %q", got)
+	}
+	secondary.inbound <- inboundPacket{reply(c, 1, "b"), from}
+	if got, ok := readRedundant(t, c); ok {
+		t.Fatalf("late copy of b delivered: %q", got)
+	}
+
+	if c.delivered.Load() != 2 || c.secondaryFirst.Load() != 1 || c.duplicates.Load() != 2 {
+		t.Fatalf("delivered=%d secondaryFirst=%d duplicates=%d, want 2/1/2",
+			c.delivered.Load(), c.secondaryFirst.Load(), c.duplicates.Load())
+	}
+}
+
+func TestRedundantUDPKeepsRepeatedPayloads(t *testing.T) {
+	primary, secondary := newMockTunnelConn(), newMockTunnelConn()
+	c := newRedundantConn(primary, secondary)
+	defer c.Close()
+	from := netip.MustParseAddrPort("203.0.113.9:3478")
+
+	// The target sends the same keepalive twice, back to back; the server
+	// numbers them apart, so both reach the app, once each.
+	for seq := uint32(0); seq < 2; seq++ {
+		primary.inbound <- inboundPacket{reply(c, seq, "ka"), from}
+		if got, ok := readRedundant(t, c); !ok || got != "ka" {
+			t.Fatalf("keepalive %d not delivered", seq)
+		}
+	}
+	secondary.inbound <- inboundPacket{reply(c, 0, "ka"), from}
+	secondary.inbound <- inboundPacket{reply(c, 1, "ka"), from}
+	if got, ok := readRedundant(t, c); ok {
+		t.Fatalf("secondary copies delivered: %q", got)
+	}
+}
+
+func TestRedundantUDPPassesUnshimmedReplies(t *testing.T) {
+	primary, secondary := newMockTunnelConn(), newMockTunnelConn()
+	c := newRedundantConn(primary, secondary)
+	defer c.Close()
+	from := netip.MustParseAddrPort("203.0.113.9:3478")
+
+	other := append(redundant.AppendHeader(nil, c.flow+1, 0), "x"...)
+	for _, data := range [][]byte{[]byte("plain"), []byte("plain"), other} {
+		primary.inbound <- inboundPacket{data, from}
+		if got, _ := readRedundant(t, c); got != string(data) {
+			t.Fatalf("got %q, want %q unchanged", got, data)
+		}
+	}
+}
+
+func TestRedundantUDPWritesShimOnBothPaths(t *testing.T) {
+	primary := &recordingConn{mockTunnelConn: newMockTunnelConn()}
+	secondary := &recordingConn{mockTunnelConn: newMockTunnelConn()}
+	c := newRedundantConn(primary, secondary)
+	defer c.Close()
+
+	for _, payload := range []string{"one", "two"} {
+		if err := c.WriteUDP(transport.Endpoint{}, []byte(payload)); err != nil {
+			t.Fatal(err)
+		}
+	}
+	for i, path := range []*recordingConn{primary, secondary} {
+		if len(path.written) != 2 {
+			t.Fatalf("path %d: %d datagrams written, want 2", i, len(path.written))
+		}
+		for seq, want := range []string{"one", "two"} {
+			flow, got, payload, ok := redundant.Parse(path.written[seq])
+			if !ok || flow != c.flow || got != uint32(seq) || string(payload) != want {
+				t.Errorf("path %d datagram %d: flow %x seq %d %q, want %x/%d/%q",
+					i, seq, flow, got, payload, c.flow, seq, want)
+			}
+		}
+	}
+}
+
+func TestRedundantUDPSurvivesOnePath(t *testing.T) {
+	primary, secondary := newMockTunnelConn(), newMockTunnelConn()
+	c := newRedundantConn(primary, secondary)
+	defer c.Close()
+	from := netip.MustParseAddrPort("203.0.113.9:3478")
+
+	primary.Close()
+	secondary.inbound <- inboundPacket{reply(c, 0, "x"), from}
+	if got, _ := readRedundant(t, c); got != "x" {
+		t.Fatalf("got %q after primary loss, want x", got)
+	}
+	secondary.Close()
+	buf := make([]byte, 16)
+	if _, _, err := c.ReadUDPFrom(buf); err == nil {
+		t.Fatal("read must fail once both paths are closed")
+	}
+}
+
+func TestRedundantUDPPoolsOnlySmallPackets(t *testing.T) {
+	primary, secondary := newMockTunnelConn(), newMockTunnelConn()
+	c := newRedundantConn(primary, secondary)
+	defer c.Close()
+	from := netip.MustParseAddrPort("203.0.113.9:3478")
+
+	for _, size := range []int{1, constant.SmallBufferSize, constant.SmallBufferSize + 1, 1400} {
+		payload := strings.Repeat("x", size)
+		primary.inbound <- inboundPacket{[]byte(payload), from}
+		var pkt redundantPacket
+		select {
+		case pkt = <-c.packets:
+		case <-time.After(200 * time.Millisecond):
+			t.Fatalf("%d-byte packet not queued", size)
+		}
+		if want := size <= constant.SmallBufferSize; pkt.pooled != want {
+			t.Errorf("%d-byte packet: pooled=%v, want %v", size, pkt.pooled, want)
+		}
+		if string(pkt.buf[:pkt.n]) != payload {
+			t.Errorf("%d-byte packet corrupted", size)
+		}
+		pkt.release()
+	}
+
+	// And end to end: a large packet is delivered whole.
+	primary.inbound <- inboundPacket{[]byte(strings.Repeat("y", 1400)), from}
+	if got, _ := readRedundant(t, c); len(got) != 1400 {
+		t.Fatalf("large packet: got %d bytes, want 1400", len(got))
+	}
+}
+
+func TestRedundantUDPPortMatch(t *testing.T) {
+	cfg := &RedundantUDPConfig{Ports: []PortRange{{3478, 3478}, {27000, 27100}}}
+	for port, want := range map[uint16]bool{3478: true, 27050: true, 443: false, 27101: false} {
+		if cfg.matches(port) != want {
+			t.Errorf("matches(%d) = %v, want %v", port, !want, want)
+		}
+	}
+	if !(&RedundantUDPConfig{}).matches(443) {
+		t.Error("empty port list must match every flow")
+	}
+}
+
+var _ transport.TunnelConn = (*redundantConn)(nil)
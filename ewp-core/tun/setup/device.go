@@ -0,0 +1,15 @@
+//go:build !linux
+
+package setup
+
+import tun "golang.zx2c4.com/wireguard/tun"
+
+// CreateTUN opens the TUN device. Multiple queues and offloads are only
+// implemented on Linux; elsewhere a single queue is opened as is.
+func CreateTUN(name string, mtu, queues int, offload bool) ([]tun.Device, error) {
+	dev, err := tun.CreateTUN(name, mtu)
+	if err != nil {
+		return nil, err
+	}
+	return []tun.Device{dev}, nil
+}
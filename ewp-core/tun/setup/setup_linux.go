@@ -4,10 +4,88 @@ package setup
 
 import (
 	"fmt"
+	"os"
 	"os/exec"
 	"strings"
+
+	"golang.org/x/sys/unix"
+	tun "golang.zx2c4.com/wireguard/tun"
 )
 
+// CreateTUN opens the TUN device and returns one tun.Device per queue.
+// With more than one queue the device is opened with IFF_MULTI_QUEUE; the
+// kernel spreads flows over the queues by their hash, and every queue can
+// be read and written independently.
+//
+// With offload, wireguard-go opens each queue with IFF_VNET_HDR and enables
+// checksum and TSO/USO offload: the kernel hands over GSO super-packets
+// that are split on read, and batched writes are coalesced back into
+// super-packets (GRO). If the kernel refuses the offloads the device is
+// reopened without the virtio-net header.
+func CreateTUN(name string, mtu, queues int, offload bool) ([]tun.Device, error) {
+	if queues <= 1 && offload {
+		dev, err := tun.CreateTUN(name, mtu)
+		if err != nil {
+			return nil, err
+		}
+		return []tun.Device{dev}, nil
+	}
+
+	flags := uint16(unix.IFF_TUN | unix.IFF_NO_PI)
+	if offload {
+		flags |= unix.IFF_VNET_HDR
+	}
+	if queues > 1 {
+		flags |= unix.IFF_MULTI_QUEUE
+	} else {
+		queues = 1
+	}
+	devs := make([]tun.Device, 0, queues)
+	for i := 0; i < queues; i++ {
+		dev, err := openQueue(name, mtu, flags)
+		if err != nil {
+			for _, d := range devs {
+				d.Close()
+			}
+			if offload {
+				return CreateTUN(name, mtu, queues, false)
+			}
+			return nil, fmt.Errorf("create TUN %s queue %d: %w", name, i, err)
+		}
+		if i == 0 {
+			// Attach the remaining queues to the name the kernel chose.
+			if name, err = dev.Name(); err != nil {
+				dev.Close()
+				return nil, err
+			}
+		}
+		devs = append(devs, dev)
+	}
+	return devs, nil
+}
+
+// openQueue opens one queue of the TUN device and hands it to wireguard-go,
+// which negotiates the offloads when flags carry IFF_VNET_HDR.
+func openQueue(name string, mtu int, flags uint16) (tun.Device, error) {
+	fd, err := unix.Open("/dev/net/tun", unix.O_RDWR|unix.O_CLOEXEC, 0)
+	if err != nil {
+		return nil, fmt.Errorf("open /dev/net/tun: %w", err)
+	}
+	ifr, err := unix.NewIfreq(name)
+	if err == nil {
+		ifr.SetUint16(flags)
+		err = unix.IoctlIfreq(fd, unix.TUNSETIFF, ifr)
+	}
+	if err == nil {
+		err = unix.SetNonblock(fd, true)
+	}
+	if err != nil {
+		unix.Close(fd)
+		return nil, err
+	}
+	return tun.CreateTUNFromFile(os.NewFile(uintptr(fd), "/dev/net/tun"), mtu)
+}
+
 func SetupTUN(ifName, ipCIDR, ipv6CIDR, dns, ipv6DNS string, mtu int) error {
 	if err := run("ip", "link", "set", ifName, "mtu", fmt.Sprint(mtu), "up"); err != nil {
 		return fmt.Errorf("bring up interface: %w", err)
@@ -0,0 +1,281 @@
+//go:build linux && !android
+
+package setup
+
+import (
+	"encoding/binary"
+	"fmt"
+	"net"
+	"os"
+	"runtime"
+	"sync/atomic"
+	"testing"
+	"time"
+
+	"golang.org/x/sys/unix"
+	tun "golang.zx2c4.com/wireguard/tun"
+)
+
+const (
+	benchMTU     = 1500
+	benchPayload = 1400
+	benchOffset  = 16 // headroom for the virtio-net header, as the gVisor endpoint leaves
+	benchBatch   = 64
+)
+
+var (
+	benchLocal = net.IPv4(10, 77, 0, 1).To4()
+	benchPeer  = net.IPv4(10, 77, 0, 2).To4()
+)
+
+// BenchmarkTUNThroughput measures raw TUN device throughput with and
+// without offloads, in a private network namespace so the host's routes
+// are untouched. It needs root:
+//
+//	sudo go test -run '^$' -bench TUNThroughput ./tun/setup/
+//
+// kernel-to-tun sends UDP to a peer routed through the TUN (as GSO
+// super-packets where the kernel supports UDP_SEGMENT) and reads them off
+// the device; tun-to-kernel writes batches of UDP packets into the device
+// for a local socket.
+func BenchmarkTUNThroughput(b *testing.B) {
+	if os.Geteuid() != 0 {
+		b.Skip("needs root for a network namespace and a TUN device")
+	}
+	for _, offload := range []bool{false, true} {
+		mode := "plain"
+		if offload {
+			mode = "offload"
+		}
+		b.Run(mode+"/kernel-to-tun", func(b *testing.B) { benchTUN(b, offload, 1, benchKernelToTUN) })
+		b.Run(mode+"/tun-to-kernel", func(b *testing.B) { benchTUN(b, offload, 1, benchTUNToKernel) })
+	}
+}
+
+// BenchmarkTUNQueues measures how throughput scales with the number of
+// device queues (IFF_MULTI_QUEUE), one reader or writer goroutine per queue
+// and 16 UDP flows for the kernel to spread. It needs root:
+//
+//	sudo go test -run '^$' -bench TUNQueues -cpu 8 ./tun/setup/
+func BenchmarkTUNQueues(b *testing.B) {
+	if os.Geteuid() != 0 {
+		b.Skip("needs root for a network namespace and a TUN device")
+	}
+	for _, queues := range []int{1, 2, 4, 8} {
+		b.Run(fmt.Sprintf("queues=%d/kernel-to-tun", queues), func(b *testing.B) { benchTUN(b, true, queues, benchKernelToTUN) })
+		b.Run(fmt.Sprintf("queues=%d/tun-to-kernel", queues), func(b *testing.B) { benchTUN(b, true, queues, benchTUNToKernel) })
+	}
+}
+
+func benchTUN(b *testing.B, offload bool, queues int, fn func(*testing.B, []tun.Device)) {
+	// The thread stays locked: it dies with its namespace when the
+	// benchmark goroutine exits.
+	runtime.LockOSThread()
+	if err := unix.Unshare(unix.CLONE_NEWNET); err != nil {
+		b.Skipf("unshare network namespace: %v", err)
+	}
+	devs, err := CreateTUN("ewpbench0", benchMTU, queues, offload)
+	if err != nil {
+		b.Fatal(err)
+	}
+	defer func() {
+		for _, dev := range devs {
+			dev.Close()
+		}
+	}()
+	if offload && devs[0].BatchSize() == 1 {
+		b.Skip("kernel refused TUN offloads")
+	}
+	name, _ := devs[0].Name()
+	for _, args := range [][]string{
+		{"link", "set", "lo", "up"},
+		{"link", "set", name, "mtu", fmt.Sprint(benchMTU), "up"},
+		{"addr", "add", "10.77.0.1/24", "dev", name},
+	} {
+		if err := run("ip", args...); err != nil {
+			b.Fatal(err)
+		}
+	}
+	fn(b, devs)
+}
+
+// benchKernelToTUN sends from 16 UDP sockets and reads every queue until
+// b.N datagrams have arrived.
+func benchKernelToTUN(b *testing.B, devs []tun.Device) {
+	const flows = 16
+	var conns []*net.UDPConn
+	for i := 0; i < flows; i++ {
+		conn, err := net.DialUDP("udp4", nil, &net.UDPAddr{IP: benchPeer, Port: 9})
+		if err != nil {
+			b.Fatal(err)
+		}
+		defer conn.Close()
+		conns = append(conns, conn)
+	}
+
+	// One write of segs*benchPayload bytes leaves as segs datagrams.
+	segs := 1
+	if rc, err := conns[0].SyscallConn(); err == nil {
+		rc.Control(func(fd uintptr) {
+			if unix.SetsockoptInt(int(fd), unix.IPPROTO_UDP, unix.UDP_SEGMENT, benchPayload) == nil {
+				segs = 32
+			}
+		})
+	}
+	if segs > 1 {
+		for _, conn := range conns[1:] {
+			rc, _ := conn.SyscallConn()
+			rc.Control(func(fd uintptr) {
+				unix.SetsockoptInt(int(fd), unix.IPPROTO_UDP, unix.UDP_SEGMENT, benchPayload)
+			})
+		}
+	}
+
+	stop := make(chan struct{})
+	defer close(stop)
+	var got atomic.Int64
+	done := make(chan struct{})
+	b.SetBytes(benchPayload)
+	b.ResetTimer()
+	for _, conn := range conns {
+		go func(conn *net.UDPConn) {
+			msg := make([]byte, segs*benchPayload)
+			for {
+				select {
+				case <-stop:
+					return
+				default:
+					conn.Write(msg) // drops under pressure are expected
+				}
+			}
+		}(conn)
+	}
+	for _, dev := range devs {
+		go func(dev tun.Device) {
+			batch := dev.BatchSize()
+			bufs := make([][]byte, batch)
+			for i := range bufs {
+				bufs[i] = make([]byte, benchOffset+benchMTU)
+			}
+			sizes := make([]int, batch)
+			for {
+				n, err := dev.Read(bufs, sizes, benchOffset)
+				if err != nil {
+					return
+				}
+				k := int64(0)
+				for i := 0; i < n; i++ {
+					if sizes[i] == 28+benchPayload {
+						k++
+					}
+				}
+				if total := got.Add(k); total >= int64(b.N) && total-k < int64(b.N) {
+					close(done)
+				}
+			}
+		}(dev)
+	}
+	<-done
+	b.StopTimer()
+	reportGbps(b)
+}
+
+// benchTUNToKernel writes batches of UDP packets into every queue, one
+// flow and one receiving socket per queue, until b.N datagrams have been
+// received.
+func benchTUNToKernel(b *testing.B, devs []tun.Device) {
+	var lns []*net.UDPConn
+	for q := range devs {
+		ln, err := net.ListenUDP("udp4", &net.UDPAddr{IP: benchLocal, Port: 5201 + q})
+		if err != nil {
+			b.Fatal(err)
+		}
+		defer ln.Close()
+		ln.SetReadBuffer(8 << 20)
+		lns = append(lns, ln)
+	}
+
+	stop := make(chan struct{})
+	defer close(stop)
+	var got atomic.Int64
+	done := make(chan struct{})
+	b.SetBytes(benchPayload)
+	b.ResetTimer()
+	for q, dev := range devs {
+		pkt := udpPacket(benchPeer, benchLocal, 40000, uint16(5201+q), make([]byte, benchPayload))
+		go func(dev tun.Device, pkt []byte) {
+			// Buffers have room to grow: coalescing appends the following
+			// packets' payloads to the first one in place.
+			bufs := make([][]byte, benchBatch)
+			for i := range bufs {
+				bufs[i] = make([]byte, benchOffset+len(pkt), benchOffset+65535)
+			}
+			for {
+				select {
+				case <-stop:
+					return
+				default:
+				}
+				for i := range bufs {
+					bufs[i] = bufs[i][:benchOffset+len(pkt)]
+					copy(bufs[i][benchOffset:], pkt)
+				}
+				dev.Write(bufs, benchOffset)
+			}
+		}(dev, pkt)
+	}
+	for _, ln := range lns {
+		go func(ln *net.UDPConn) {
+			buf := make([]byte, 65535)
+			for {
+				if _, err := ln.Read(buf); err != nil {
+					return
+				}
+				if got.Add(1) == int64(b.N) {
+					close(done)
+				}
+			}
+		}(ln)
+	}
+
+	select {
+	case <-done:
+	case <-time.After(time.Minute):
+		b.Fatalf("received %d of %d datagrams", got.Load(), b.N)
+	}
+	b.StopTimer()
+	reportGbps(b)
+}
+
+func reportGbps(b *testing.B) {
+	if s := b.Elapsed().Seconds(); s > 0 {
+		b.ReportMetric(float64(b.N)*benchPayload*8/s/1e9, "Gbit/s")
+	}
+}
+
+// udpPacket builds an IPv4/UDP packet. The UDP checksum is left zero,
+// which IPv4 allows.
+func udpPacket(src, dst net.IP, sport, dport uint16, payload []byte) []byte {
+	pkt := make([]byte, 28+len(payload))
+	pkt[0] = 0x45
+	binary.BigEndian.PutUint16(pkt[2:], uint16(len(pkt)))
+	pkt[6] = 0x40 // DF
+	pkt[8] = 64
+	pkt[9] = unix.IPPROTO_UDP
+	copy(pkt[12:16], src)
+	copy(pkt[16:20], dst)
+	var sum uint32
+	for i := 0; i < 20; i += 2 {
+		sum += uint32(binary.BigEndian.Uint16(pkt[i:]))
+	}
+	for sum > 0xffff {
+		sum = sum&0xffff + sum>>16
+	}
+	binary.BigEndian.PutUint16(pkt[10:], ^uint16(sum))
+
+	binary.BigEndian.PutUint16(pkt[20:], sport)
+	binary.BigEndian.PutUint16(pkt[22:], dport)
+	binary.BigEndian.PutUint16(pkt[24:], uint16(8+len(payload)))
+	copy(pkt[28:], payload)
+	return pkt
+}
@@ -6,6 +6,7 @@ import (
 	"context"
 	"fmt"
 	"net/netip"
+	"runtime"
 	"strings"
 	"sync"
 	"time"
@@ -52,14 +53,19 @@ type Config struct {
 	MTU             int
 	Stack           string
 	Transport       transport.Transport
-	ServerAddr      string // proxy server address; used to detect the physical outbound interface for bypass dialing
-	TunnelDoHServer string // DoH server URL for tunnel DNS resolver (default: https://dns.google/dns-query)
-	DisableFakeIP   bool   // true = Normal Mode: no FakeIP pool; peer vIPs via ShardedRegistry only
+	ServerAddr      string              // proxy server address; used to detect the physical outbound interface for bypass dialing
+	TunnelDoHServer string              // DoH server URL for tunnel DNS resolver (default: https://dns.google/dns-query)
+	DisableFakeIP   bool                // true = Normal Mode: no FakeIP pool; peer vIPs via ShardedRegistry only
+	RedundantUDP    *RedundantUDPConfig // optional dual-path UDP; its transports get the bypass dialer too
+	DisableOffload  bool                // Linux: open the device without the virtio-net header (no TSO/GRO)
+	Queues          int                 // Linux: device queues, each read by its own goroutine; <= 1 = single queue
+	RouteExclude    []netip.Prefix      // Linux: destinations routed around the TUN through the physical NIC
 }
 
 type TUN struct {
-	device    tun.Device
+	devices   []tun.Device // one per queue
 	stack     *ewpgvisor.Stack
+	bypass    *ewpbypass.BypassDialer // nil when ServerAddr is unset or detection failed
 	handler   *Handler
 	peerReg   *nat.ShardedRegistry // Full Cone NAT registry; always non-nil after New()
 	config    *Config
@@ -97,11 +103,19 @@ func New(cfg *Config) (*TUN, error) {
 		return nil, fmt.Errorf("parse IPv4 address failed: %w", err)
 	}
 
-	tunDevice, err := tun.CreateTUN("ewp-tun", int(mtu))
+	tunDevices, err := tunsetup.CreateTUN("ewp-tun", int(mtu), cfg.Queues, !cfg.DisableOffload)
 	if err != nil {
 		cancel()
 		return nil, fmt.Errorf("create TUN device failed: %w", err)
 	}
+	if len(tunDevices) > 1 {
+		log.Printf("[TUN] Multi-queue: %d queues", len(tunDevices))
+	}
+	if batch := tunDevices[0].BatchSize(); batch > 1 {
+		log.Printf("[TUN] Offloads active: virtio-net header, TSO/GRO, batch %d", batch)
+	} else if !cfg.DisableOffload && runtime.GOOS == "linux" {
+		log.Printf("[TUN] Offloads unavailable, using plain packets")
+	}
 
 	stackConfig := &ewpgvisor.StackConfig{
 		MTU:        int(mtu),
@@ -109,9 +123,9 @@ func New(cfg *Config) (*TUN, error) {
 		UDPHandler: handler.HandleUDP,
 	}
 
-	stack, err := ewpgvisor.NewStack(tunDevice, stackConfig)
+	stack, err := ewpgvisor.NewMultiQueueStack(tunDevices, stackConfig)
 	if err != nil {
-		tunDevice.Close()
+		closeDevices(tunDevices)
 		cancel()
 		return nil, fmt.Errorf("create gvisor stack failed: %w", err)
 	}
@@ -119,7 +133,7 @@ func New(cfg *Config) (*TUN, error) {
 	udpWriter.stack = stack
 
 	return &TUN{
-		device:  tunDevice,
+		devices: tunDevices,
 		stack:   stack,
 		handler: handler,
 		peerReg: reg,
@@ -138,7 +152,7 @@ func New(cfg *Config) (*TUN, error) {
 // routes are added — this ordering is critical to correctly identify the
 // physical outbound interface.
 func (t *TUN) Setup() error {
-	ifName, err := t.device.Name()
+	ifName, err := t.devices[0].Name()
 	if err != nil {
 		return fmt.Errorf("get TUN interface name: %w", err)
 	}
@@ -154,13 +168,38 @@ func (t *TUN) Setup() error {
 		if err != nil {
 			log.Printf("[TUN] Warning: bypass dialer init failed: %v (routing loop risk)", err)
 		} else {
-			t.config.Transport.SetBypassConfig(bd.ToBypassConfig())
+			t.bypass = bd
+			bypassCfg := bd.ToBypassConfig()
+			t.config.Transport.SetBypassConfig(bypassCfg)
+			if r := t.config.RedundantUDP; r != nil {
+				for _, trans := range []transport.Transport{r.Primary, r.Secondary} {
+					if trans != t.config.Transport {
+						trans.SetBypassConfig(bypassCfg)
+					}
+				}
+			}
 			log.Printf("[TUN] Bypass dialer active on interface %s", ifName)
 		}
 	} else {
 		log.Printf("[TUN] Warning: ServerAddr not set — bypass dialer disabled, routing loop possible")
 	}
 
+	// Excluded destinations are routed through the physical NIC in a table
+	// consulted before main, so they win over the TUN default route.
+	if len(t.config.RouteExclude) > 0 {
+		if t.bypass == nil {
+			log.Printf("[TUN] Warning: route_exclude_address ignored without the bypass dialer")
+		} else {
+			start := time.Now()
+			n, err := t.bypass.ExcludeRoutes(t.config.RouteExclude)
+			if err != nil {
+				log.Printf("[TUN] Warning: route exclusion: %v", err)
+			} else {
+				log.Printf("[TUN] Excluded %d prefixes as %d routes in %v", len(t.config.RouteExclude), n, time.Since(start).Round(time.Millisecond))
+			}
+		}
+	}
+
 	// Step 2 — assign IP address and add default routes through the TUN.
 	mtu := t.config.MTU
 	if mtu <= 0 {
@@ -203,9 +242,7 @@ func (t *TUN) Close() error {
 		// Close the underlying TUN device (releases Wintun handle on Windows,
 		// fd on Linux/macOS). Must come after stack.Close() so gVisor stops
 		// reading from the device before we destroy it.
-		if t.device != nil {
-			t.device.Close()
-		}
+		closeDevices(t.devices)
 
 		if t.ifName != "" {
 			if err := tunsetup.TeardownTUN(t.ifName); err != nil {
@@ -213,7 +250,17 @@ func (t *TUN) Close() error {
 			}
 		}
 
+		if t.bypass != nil {
+			t.bypass.Close()
+		}
+
 		log.Printf("[TUN] TUN mode stopped")
 	})
 	return closeErr
 }
+
+func closeDevices(devs []tun.Device) {
+	for _, dev := range devs {
+		dev.Close()
+	}
+}
@@ -0,0 +1,255 @@
+// ewp-gui-bench：GUI 热点路径在 100 / 1k / 10k / 100k 节点下的微基准。
+//
+//   cmake --build build --target ewp-gui-bench
+//   build/bench/ewp-gui-bench                      # 文本输出
+//   build/bench/ewp-gui-bench -o results.csv,csv   # 机器可读（亦支持 xml / junitxml / tap）
+//   build/bench/ewp-gui-bench updateNodeList:10k   # 只跑单个用例的单个规模
+//
+// 程序在独立的 bench/ 目录运行（NodeManager 的 nodes.json 位于可执行文件目录），
+// QSettings 重定向到临时目录，不会改动正在使用的节点和设置。
+
+#include <QApplication>
+#include <QDir>
+#include <QFile>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QSettings>
+#include <QTemporaryDir>
+#include <QtTest>
+
+#include "ConfigGenerator.h"
+#include "CoreProcess.h"
+#include "EWPNode.h"
+#include "MainWindow.h"
+#include "NodeManager.h"
+#include "SettingsDialog.h"
+#include "ShareLink.h"
+
+namespace {
+
+// 覆盖两种应用层协议与全部传输方式，使序列化 / 链接 / 配置生成走到各分支
+QList<EWPNode> makeNodes(int count)
+{
+    static const EWPNode::TransportMode transports[] = {
+        EWPNode::WS, EWPNode::GRPC, EWPNode::XHTTP, EWPNode::H3GRPC, EWPNode::MASQUE
+    };
+    QList<EWPNode> nodes;
+    nodes.reserve(count);
+    for (int i = 0; i < count; ++i) {
+        EWPNode node;
+        node.id = i + 1;
+        node.name = QString("bench-%1 香港 %2").arg(i).arg(i % 97);
+        node.server = QString("s%1.example.com").arg(i);
+        node.serverPort = 443 + i % 7;
+        node.host = QString("cdn%1.example.com").arg(i % 13);
+        node.transportMode = transports[i % 5];
+        if (i % 4 == 3) {
+            node.appProtocol = EWPNode::TROJAN;
+            node.trojanPassword = QString("password-%1").arg(i);
+        } else {
+            node.uuid = QString("%1-0000-4000-8000-000000000000").arg(i, 8, 16, QChar('0'));
+        }
+        node.latency = i % 300;
+        nodes.append(node);
+    }
+    return nodes;
+}
+
+void writeNodesFile(const QList<EWPNode> &nodes)
+{
+    QJsonArray arr;
+    for (const auto &node : nodes) {
+        arr.append(node.toJson());
+    }
+    QJsonObject root;
+    root["nextId"] = nodes.size() + 1;
+    root["nodes"] = arr;
+    QFile file(QCoreApplication::applicationDirPath() + "/nodes.json");
+    if (file.open(QIODevice::WriteOnly)) {
+        file.write(QJsonDocument(root).toJson());
+    }
+}
+
+void addSizes()
+{
+    QTest::addColumn<int>("count");
+    QTest::newRow("100") << 100;
+    QTest::newRow("1k") << 1000;
+    QTest::newRow("10k") << 10000;
+    QTest::newRow("100k") << 100000;
+}
+
+} // namespace
+
+class GuiBench : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void cleanup()
+    {
+        QFile::remove(QCoreApplication::applicationDirPath() + "/nodes.json");
+    }
+
+    void nodeToJson_data() { addSizes(); }
+    void nodeToJson()
+    {
+        QFETCH(int, count);
+        auto nodes = makeNodes(count);
+        QBENCHMARK {
+            QJsonArray arr;
+            for (const auto &node : nodes) {
+                arr.append(node.toJson());
+            }
+        }
+    }
+
+    void nodeFromJson_data() { addSizes(); }
+    void nodeFromJson()
+    {
+        QFETCH(int, count);
+        QJsonArray arr;
+        for (const auto &node : makeNodes(count)) {
+            arr.append(node.toJson());
+        }
+        QBENCHMARK {
+            QList<EWPNode> nodes;
+            nodes.reserve(arr.size());
+            for (const auto &value : arr) {
+                nodes.append(EWPNode::fromJson(value.toObject()));
+            }
+        }
+    }
+
+    void nodeManagerLoad_data() { addSizes(); }
+    void nodeManagerLoad()
+    {
+        QFETCH(int, count);
+        writeNodesFile(makeNodes(count));
+        NodeManager manager;
+        QCOMPARE(manager.getNodeCount(), count);
+        QBENCHMARK {
+            manager.load();
+        }
+    }
+
+    void nodeManagerSave_data() { addSizes(); }
+    void nodeManagerSave()
+    {
+        QFETCH(int, count);
+        writeNodesFile(makeNodes(count));
+        NodeManager manager;
+        QBENCHMARK {
+            manager.save();
+        }
+    }
+
+    void parseLinks_data() { addSizes(); }
+    void parseLinks()
+    {
+        QFETCH(int, count);
+        QStringList links;
+        for (const auto &node : makeNodes(count)) {
+            links.append(ShareLink::generateLink(node));
+        }
+        QString text = links.join('\n');
+        QBENCHMARK {
+            auto parsed = ShareLink::parseLinks(text);
+            Q_UNUSED(parsed)
+        }
+    }
+
+    void generateLink_data() { addSizes(); }
+    void generateLink()
+    {
+        QFETCH(int, count);
+        auto nodes = makeNodes(count);
+        QBENCHMARK {
+            for (const auto &node : nodes) {
+                QString link = ShareLink::generateLink(node);
+                Q_UNUSED(link)
+            }
+        }
+    }
+
+    // 每个节点各生成一次单节点配置（切换节点的路径）
+    void generateClientConfig_data() { addSizes(); }
+    void generateClientConfig()
+    {
+        QFETCH(int, count);
+        auto nodes = makeNodes(count);
+        auto settings = SettingsDialog::loadFromRegistry();
+        QBENCHMARK {
+            for (const auto &node : nodes) {
+                QJsonObject config = ConfigGenerator::generateClientConfig(node, settings);
+                Q_UNUSED(config)
+            }
+        }
+    }
+
+    // 全部节点组成一个出站组（多选启动负载均衡组的路径）
+    void generateGroupConfig_data() { addSizes(); }
+    void generateGroupConfig()
+    {
+        QFETCH(int, count);
+        auto nodes = makeNodes(count);
+        auto settings = SettingsDialog::loadFromRegistry();
+        QBENCHMARK {
+            QJsonObject config = ConfigGenerator::generateGroupConfig(nodes, "balancer", settings);
+            Q_UNUSED(config)
+        }
+    }
+
+    void updateNodeList_data() { addSizes(); }
+    void updateNodeList()
+    {
+        QFETCH(int, count);
+        writeNodesFile(makeNodes(count));
+        MainWindow window;
+        QCOMPARE(window.nodes()->getNodeCount(), count);
+        QBENCHMARK {
+            QMetaObject::invokeMethod(&window, "updateNodeList", Qt::DirectConnection);
+        }
+    }
+
+    // 核心 stdout：count 行日志一次读入，含一行 CONTROL_ADDR
+    void coreStdoutParsing_data() { addSizes(); }
+    void coreStdoutParsing()
+    {
+        QFETCH(int, count);
+        QByteArray data = "CONTROL_ADDR=127.0.0.1:40000\n";
+        for (int i = 0; i < count; ++i) {
+            data += QString("2026/01/01 12:00:00 [INFO] TCP tun 10.0.0.2:%1 -> s%2.example.com:443 via proxy-out\n")
+                .arg(40000 + i % 20000).arg(i).toUtf8();
+        }
+        QStringList lines;
+        ControlEndpoint control;
+        bool addrChanged = false;
+        QBENCHMARK {
+            lines = CoreProcess::parseStdout(data, &control, &addrChanged);
+        }
+        QCOMPARE(lines.size(), count + 1);
+        QVERIFY(addrChanged);
+        QCOMPARE(control.addr, QString("127.0.0.1:40000"));
+    }
+};
+
+int main(int argc, char *argv[])
+{
+    // updateNodeList 需要真实的 MainWindow，默认用 offscreen 平台免显示器运行
+    if (qEnvironmentVariableIsEmpty("QT_QPA_PLATFORM")) {
+        qputenv("QT_QPA_PLATFORM", "offscreen");
+    }
+    QApplication app(argc, argv);
+    app.setOrganizationName("ECH Workers");
+    app.setApplicationName("ECH Workers Bench");
+
+    QTemporaryDir settingsDir;
+    QSettings::setPath(QSettings::NativeFormat, QSettings::UserScope, settingsDir.path());
+    QSettings::setPath(QSettings::IniFormat, QSettings::UserScope, settingsDir.path());
+
+    GuiBench bench;
+    return QTest::qExec(&bench, argc, argv);
+}
+
+#include "GuiBench.moc"
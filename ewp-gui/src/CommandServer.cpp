@@ -0,0 +1,261 @@
+#include "CommandServer.h"
+#include "ControlStream.h"
+#include "CoreProcess.h"
+#include "NodeManager.h"
+#include "NodeTester.h"
+#include "ShareLink.h"
+#include <QCoreApplication>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QPointer>
+#include <memory>
+
+namespace {
+const QStringList kTopics = { "stats", "log", "state" };
+}
+
+CommandServer::CommandServer(CommandTarget *target, QObject *parent)
+    : QObject(parent)
+    , target(target)
+    , server(new QLocalServer(this))
+    , network(new QNetworkAccessManager(this))
+    , statsStream(new ControlStream("/stats", network, this))
+{
+    server->setSocketOptions(QLocalServer::UserAccessOption);
+    connect(server, &QLocalServer::newConnection, this, &CommandServer::onNewConnection);
+
+    CoreProcess *core = target->core();
+    connect(core, &CoreProcess::controlChanged, this, &CommandServer::updateStatsStream);
+    connect(statsStream, &ControlStream::received, this, [this](const QJsonObject &sample) {
+        publish("stats", sample);
+    });
+    connect(core, &CoreProcess::logReceived, this, [this](const QString &line) {
+        publish("log", line);
+    });
+    connect(core, &CoreProcess::started, this, [this]() {
+        publish("state", status());
+    });
+    connect(core, &CoreProcess::stopped, this, [this]() {
+        publish("state", status());
+    });
+}
+
+bool CommandServer::listen(const QString &name)
+{
+    if (server->listen(name)) {
+        return true;
+    }
+    // 上次异常退出可能留下套接字文件；调用方已确认没有实例在运行
+    QLocalServer::removeServer(name);
+    return server->listen(name);
+}
+
+void CommandServer::onNewConnection()
+{
+    while (QLocalSocket *client = server->nextPendingConnection()) {
+        connect(client, &QLocalSocket::readyRead, this, &CommandServer::onReadyRead);
+        connect(client, &QLocalSocket::disconnected, this, &CommandServer::onDisconnected);
+    }
+}
+
+void CommandServer::onDisconnected()
+{
+    auto *client = qobject_cast<QLocalSocket *>(sender());
+    pending.remove(client);
+    for (auto &clients : subscribers) {
+        clients.remove(client);
+    }
+    updateStatsStream();
+    client->deleteLater();
+}
+
+void CommandServer::onReadyRead()
+{
+    auto *client = qobject_cast<QLocalSocket *>(sender());
+    QByteArray &buffer = pending[client];
+    buffer += client->readAll();
+
+    int newline;
+    while ((newline = buffer.indexOf('\n')) >= 0) {
+        QByteArray line = buffer.left(newline).trimmed();
+        buffer.remove(0, newline + 1);
+        if (line.isEmpty()) {
+            continue;
+        }
+        QJsonParseError error;
+        QJsonDocument doc = QJsonDocument::fromJson(line, &error);
+        if (!doc.isObject()) {
+            replyError(client, QJsonValue(), "无效的 JSON: " + error.errorString());
+            continue;
+        }
+        handle(client, doc.object());
+    }
+}
+
+void CommandServer::handle(QLocalSocket *client, const QJsonObject &request)
+{
+    QJsonValue id = request["id"];
+    QString cmd = request["cmd"].toString();
+    NodeManager *nodes = target->nodes();
+
+    if (cmd == "list") {
+        QJsonArray list;
+        int active = target->activeNodeId();
+        for (const auto &node : nodes->getAllNodes()) {
+            QJsonObject obj;
+            obj["id"] = node.id;
+            obj["name"] = node.name;
+            obj["server"] = node.server;
+            obj["server_port"] = node.serverPort;
+            obj["local_port"] = node.localPort;
+            obj["latency"] = node.latency;
+            obj["active"] = node.id == active;
+            list.append(obj);
+        }
+        reply(client, id, list);
+    } else if (cmd == "status") {
+        reply(client, id, status());
+    } else if (cmd == "start" || cmd == "switch") {
+        QString error;
+        if (!request["node"].isDouble()) {
+            replyError(client, id, "缺少 node");
+        } else if (!target->startNode(request["node"].toInt(), &error)) {
+            replyError(client, id, error);
+        } else {
+            reply(client, id, status());
+        }
+    } else if (cmd == "stop") {
+        target->stopCore();
+        reply(client, id, status());
+    } else if (cmd == "quit") {
+        target->stopCore();
+        reply(client, id, true);
+        client->flush();
+        // 排队退出，让本次回复先写出
+        QMetaObject::invokeMethod(QCoreApplication::instance(), &QCoreApplication::quit, Qt::QueuedConnection);
+    } else if (cmd == "test") {
+        QList<int> ids;
+        if (request.contains("node")) {
+            ids.append(request["node"].toInt());
+        } else {
+            for (const auto &node : nodes->getAllNodes()) {
+                ids.append(node.id);
+            }
+        }
+        test(client, id, ids);
+    } else if (cmd == "import") {
+        auto imported = ShareLink::parseLinks(request["links"].toString());
+        if (imported.isEmpty()) {
+            replyError(client, id, "未找到有效的分享链接");
+            return;
+        }
+        QJsonArray ids;
+        for (auto &node : imported) {
+            nodes->addNode(node);
+            ids.append(node.id);
+        }
+        target->nodesUpdated();
+        reply(client, id, ids);
+    } else if (cmd == "subscribe" || cmd == "unsubscribe") {
+        QString topic = request["topic"].toString();
+        if (!kTopics.contains(topic)) {
+            replyError(client, id, "未知的 topic: " + topic);
+            return;
+        }
+        if (cmd == "subscribe") {
+            subscribers[topic].insert(client);
+        } else {
+            subscribers[topic].remove(client);
+        }
+        updateStatsStream();
+        reply(client, id, true);
+    } else {
+        replyError(client, id, "未知命令: " + cmd);
+    }
+}
+
+QJsonObject CommandServer::status() const
+{
+    CoreProcess *core = target->core();
+    QJsonObject obj;
+    obj["running"] = core->isRunning();
+    obj["node"] = target->activeNodeId();
+    obj["listen"] = core->getListenAddr();
+    obj["control"] = core->getControl().addr;     // 令牌不经本地命令接口外泄
+    obj["supervisor"] = core->supervisorStats().toJson();
+    return obj;
+}
+
+void CommandServer::test(QLocalSocket *client, const QJsonValue &id, const QList<int> &nodeIds)
+{
+    // 各节点并行测试，全部返回后一次性回复
+    struct Batch {
+        QJsonObject results;
+        int remaining = 0;
+    };
+    auto batch = std::make_shared<Batch>();
+    batch->remaining = nodeIds.size();
+    if (nodeIds.isEmpty()) {
+        reply(client, id, batch->results);
+        return;
+    }
+
+    QPointer<QLocalSocket> guard(client);
+    for (int nodeId : nodeIds) {
+        NodeTester::testNode(target->nodes()->getNode(nodeId), [this, guard, id, nodeId, batch](int latency) {
+            target->nodes()->updateLatency(nodeId, latency);
+            batch->results[QString::number(nodeId)] = latency;
+            if (--batch->remaining > 0) {
+                return;
+            }
+            target->nodesUpdated();
+            if (guard) {
+                reply(guard, id, batch->results);
+            }
+        });
+    }
+}
+
+void CommandServer::updateStatsStream()
+{
+    // 只在有人订阅时拉取核心 /stats
+    bool wanted = !subscribers.value("stats").isEmpty();
+    statsStream->setControl(wanted ? target->core()->getControl() : ControlEndpoint());
+}
+
+void CommandServer::reply(QLocalSocket *client, const QJsonValue &id, const QJsonValue &result)
+{
+    QJsonObject obj;
+    obj["id"] = id;
+    obj["ok"] = true;
+    obj["result"] = result;
+    send(client, obj);
+}
+
+void CommandServer::replyError(QLocalSocket *client, const QJsonValue &id, const QString &error)
+{
+    QJsonObject obj;
+    obj["id"] = id;
+    obj["ok"] = false;
+    obj["error"] = error;
+    send(client, obj);
+}
+
+void CommandServer::publish(const QString &topic, const QJsonValue &data)
+{
+    auto it = subscribers.constFind(topic);
+    if (it == subscribers.constEnd() || it->isEmpty()) {
+        return;
+    }
+    QJsonObject obj;
+    obj["event"] = topic;
+    obj["data"] = data;
+    for (QLocalSocket *client : *it) {
+        send(client, obj);
+    }
+}
+
+void CommandServer::send(QLocalSocket *client, const QJsonObject &obj)
+{
+    client->write(QJsonDocument(obj).toJson(QJsonDocument::Compact) + '\n');
+}
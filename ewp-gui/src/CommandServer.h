@@ -0,0 +1,78 @@
+#pragma once
+
+#include <QObject>
+#include <QHash>
+#include <QJsonObject>
+#include <QLocalServer>
+#include <QLocalSocket>
+#include <QNetworkAccessManager>
+#include <QSet>
+
+class NodeManager;
+class CoreProcess;
+class ControlStream;
+
+// 由桌面窗口（MainWindow）或无界面守护进程（HeadlessDaemon）实现，
+// 负责“启动 / 切换 / 停止”这些与界面状态（系统代理、TUN 开关等）相关的动作
+class CommandTarget
+{
+public:
+    virtual ~CommandTarget() = default;
+
+    virtual NodeManager *nodes() const = 0;
+    virtual CoreProcess *core() const = 0;
+    // 启动指定节点；已在运行时先停止再切换。失败时返回 false 并写入 error
+    virtual bool startNode(int nodeId, QString *error) = 0;
+    virtual void stopCore() = 0;
+    virtual int activeNodeId() const = 0;      // 未运行或以出站组运行时为 -1
+    virtual void nodesUpdated() {}             // 导入 / 测速后刷新界面
+};
+
+// 本地命令接口：监听单实例 QLocalServer（仅当前用户可连接），每行一个 JSON 请求，
+// 回复一行 JSON，请求中的 id 原样带回：
+//   {"id":1,"cmd":"list"}                        → {"id":1,"ok":true,"result":[节点...]}
+//   {"id":2,"cmd":"status"}                      → 运行状态、当前节点、监听 / 控制地址、监护统计
+//   {"id":3,"cmd":"start","node":5}              已在运行时等同 switch
+//   {"id":4,"cmd":"switch","node":5}
+//   {"id":5,"cmd":"stop"}
+//   {"id":6,"cmd":"test","node":5}               省略 node 则测试全部，全部完成后回复
+//   {"id":7,"cmd":"import","links":"ewp://..."}  多条链接以换行分隔
+//   {"id":8,"cmd":"subscribe","topic":"stats"}   之后推送 {"event":"stats","data":{...}}
+//   {"id":9,"cmd":"unsubscribe","topic":"stats"}
+//   {"id":10,"cmd":"quit"}                       停止核心，回复后退出程序
+// 可订阅的 topic：stats（核心 /stats 每秒样本）、log（日志行）、state（started / stopped）。
+// 失败时回复 {"id":..,"ok":false,"error":"..."}。
+class CommandServer : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit CommandServer(CommandTarget *target, QObject *parent = nullptr);
+
+    // 监听失败（如残留的套接字文件）时尝试清理后重试一次
+    bool listen(const QString &name);
+    QString errorString() const { return server->errorString(); }
+
+private slots:
+    void onNewConnection();
+    void onReadyRead();
+    void onDisconnected();
+
+private:
+    void handle(QLocalSocket *client, const QJsonObject &request);
+    void reply(QLocalSocket *client, const QJsonValue &id, const QJsonValue &result);
+    void replyError(QLocalSocket *client, const QJsonValue &id, const QString &error);
+    void publish(const QString &topic, const QJsonValue &data);
+    void send(QLocalSocket *client, const QJsonObject &obj);
+    void updateStatsStream();
+
+    QJsonObject status() const;
+    void test(QLocalSocket *client, const QJsonValue &id, const QList<int> &nodeIds);
+
+    CommandTarget *target;
+    QLocalServer *server;
+    QNetworkAccessManager *network;
+    ControlStream *statsStream;
+    QHash<QLocalSocket *, QByteArray> pending;          // 未完整的一行
+    QHash<QString, QSet<QLocalSocket *>> subscribers;   // topic → 客户端
+};
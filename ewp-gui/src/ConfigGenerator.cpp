@@ -2,6 +2,10 @@
 #include <QJsonDocument>
 #include <QJsonArray>
 #include <QFile>
+#include <QDir>
+#include <QStandardPaths>
+#include <QSet>
+#include <QRegularExpression>
 #include <QDebug>
 
 QJsonObject ConfigGenerator::generateClientConfig(const EWPNode &node, const SettingsDialog::AppSettings &settings, bool tunMode)
@@ -19,10 +23,186 @@ QJsonObject ConfigGenerator::generateClientConfig(const EWPNode &node, const Set
     config["outbounds"] = outbounds;
     
     config["route"] = generateRoute();
+    config["cache"] = generateCache();
     
     return config;
 }
 
+QJsonObject ConfigGenerator::generateGroupConfig(const QList<EWPNode> &nodes, const QString &groupType,
+                                                 const SettingsDialog::AppSettings &settings, bool tunMode,
+                                                 const QString &strategy)
+{
+    QJsonObject config;
+    
+    config["log"] = generateLog();
+    
+    // 入站的 DNS 模式等节点相关选项取自第一个节点
+    QJsonArray inbounds;
+    inbounds.append(generateInbound(nodes.first(), settings, tunMode));
+    config["inbounds"] = inbounds;
+    
+    // 组必须是第一个出站（核心以 outbounds[0] 为主出站）
+    QJsonObject group;
+    group["type"] = groupType;
+    group["tag"] = "proxy-out";
+    group["url"] = "http://www.gstatic.com/generate_204";
+    group["interval"] = "30s";
+    if (groupType == "urltest") {
+        group["tolerance"] = 50;
+    } else if (groupType == "balancer") {
+        group["strategy"] = strategy.isEmpty() ? QString("least-conn") : strategy;
+    }
+    
+    QJsonArray members;
+    for (const auto &node : nodes) {
+        members.append(QString("node-%1").arg(node.id));
+    }
+    group["outbounds"] = members;
+    
+    QJsonArray outbounds;
+    outbounds.append(group);
+    for (const auto &node : nodes) {
+        outbounds.append(generateOutbound(node, QString("node-%1").arg(node.id)));
+    }
+    config["outbounds"] = outbounds;
+    
+    config["route"] = generateRoute();
+    config["cache"] = generateCache();
+    
+    return config;
+}
+
+void ConfigGenerator::addPortInbounds(QJsonObject &config, const QList<EWPNode> &portNodes,
+                                      const SettingsDialog::AppSettings &settings)
+{
+    int sep = settings.listenAddr.lastIndexOf(':');
+    QString listenHost = sep > 0 ? settings.listenAddr.left(sep) : QString("127.0.0.1");
+    int mainPort = sep > 0 ? settings.listenAddr.mid(sep + 1).toInt() : 0;
+    
+    QJsonArray inbounds = config["inbounds"].toArray();
+    QJsonArray outbounds = config["outbounds"].toArray();
+    QJsonObject route = config["route"].toObject();
+    QJsonArray rules = route["rules"].toArray();
+    
+    QSet<int> usedPorts{mainPort};
+    for (const auto &node : portNodes) {
+        if (node.localPort <= 0) {
+            continue;
+        }
+        if (usedPorts.contains(node.localPort)) {
+            qWarning() << "Skipping duplicate local port" << node.localPort << "for node" << node.name;
+            continue;
+        }
+        usedPorts.insert(node.localPort);
+        
+        QString outboundTag = nodeOutboundTag(outbounds, node);
+        
+        QString inboundTag = QString("port-%1").arg(node.localPort);
+        QJsonObject inbound;
+        inbound["type"] = "mixed";
+        inbound["tag"] = inboundTag;
+        inbound["listen"] = QString("%1:%2").arg(listenHost).arg(node.localPort);
+        inbound["udp"] = true;
+        inbounds.append(inbound);
+        
+        QJsonObject rule;
+        rule["inbound"] = QJsonArray{inboundTag};
+        rule["outbound"] = outboundTag;
+        rules.append(rule);
+    }
+    
+    route["rules"] = rules;
+    config["inbounds"] = inbounds;
+    config["outbounds"] = outbounds;
+    config["route"] = route;
+}
+
+void ConfigGenerator::addRedundantUDP(QJsonObject &config, const EWPNode &primary, const EWPNode &secondary,
+                                      const QString &ports)
+{
+    QJsonArray inbounds = config["inbounds"].toArray();
+    if (inbounds.isEmpty()) {
+        return;
+    }
+    QJsonObject tunInbound = inbounds[0].toObject();
+    if (tunInbound["type"].toString() != "tun") {
+        return;
+    }
+    
+    // 服务端按序号合并两路副本，两个节点须连到同一服务端（host，留空则 server）；
+    // MASQUE 的 UDP 不经服务端 UDP 处理器，无法合并
+    const QString primaryExit = primary.host.isEmpty() ? primary.server : primary.host;
+    const QString secondaryExit = secondary.host.isEmpty() ? secondary.server : secondary.host;
+    if (primaryExit.compare(secondaryExit, Qt::CaseInsensitive) != 0) {
+        qWarning() << "Redundant UDP nodes must use the same server, skipping:" << primaryExit << secondaryExit;
+        return;
+    }
+    if (primary.transportMode == EWPNode::MASQUE || secondary.transportMode == EWPNode::MASQUE) {
+        qWarning() << "Redundant UDP does not support MASQUE nodes, skipping";
+        return;
+    }
+    
+    QJsonArray outbounds = config["outbounds"].toArray();
+    QString primaryTag = nodeOutboundTag(outbounds, primary);
+    QString secondaryTag = nodeOutboundTag(outbounds, secondary);
+    if (primaryTag == secondaryTag) {
+        qWarning() << "Redundant UDP needs two distinct nodes, skipping";
+        return;
+    }
+    QJsonObject redundant;
+    redundant["primary"] = primaryTag;
+    redundant["secondary"] = secondaryTag;
+    
+    // "3478, 27000-27100" → port: [3478], port_range: ["27000:27100"]
+    QJsonArray portList;
+    QJsonArray rangeList;
+    for (const QString &part : ports.split(QRegularExpression("[,\\s]+"), Qt::SkipEmptyParts)) {
+        QStringList bounds = part.split('-');
+        bool okFrom = false, okTo = false;
+        int from = bounds.first().toInt(&okFrom);
+        int to = bounds.size() == 2 ? bounds.last().toInt(&okTo) : from;
+        if (!okFrom || (bounds.size() == 2 && !okTo) || bounds.size() > 2
+            || from <= 0 || to > 65535 || from > to) {
+            qWarning() << "Ignoring invalid redundant UDP port:" << part;
+            continue;
+        }
+        if (from == to) {
+            portList.append(from);
+        } else {
+            rangeList.append(QString("%1:%2").arg(from).arg(to));
+        }
+    }
+    if (!portList.isEmpty()) {
+        redundant["port"] = portList;
+    }
+    if (!rangeList.isEmpty()) {
+        redundant["port_range"] = rangeList;
+    }
+    
+    tunInbound["redundant_udp"] = redundant;
+    inbounds[0] = tunInbound;
+    config["inbounds"] = inbounds;
+    config["outbounds"] = outbounds;
+}
+
+QString ConfigGenerator::nodeOutboundTag(QJsonArray &outbounds, const EWPNode &node)
+{
+    // 节点已是主出站或出站组成员时复用其出站（共享连接池与会话缓存）
+    QJsonObject nodeOutbound = generateOutbound(node);
+    QString tag = QString("node-%1").arg(node.id);
+    for (const auto &value : outbounds) {
+        QJsonObject outbound = value.toObject();
+        if (outbound["tag"].toString() == "proxy-out" && outbound == nodeOutbound) {
+            return "proxy-out";
+        }
+        if (outbound["tag"].toString() == tag) {
+            return tag;
+        }
+    }
+    outbounds.append(generateOutbound(node, tag));
+    return tag;
+}
+
 QString ConfigGenerator::generateConfigFile(const EWPNode &node, const SettingsDialog::AppSettings &settings, bool tunMode)
 {
     QJsonObject config = generateClientConfig(node, settings, tunMode);
@@ -45,6 +225,41 @@ bool ConfigGenerator::saveConfig(const QJsonObject &config, const QString &fileP
     return true;
 }
 
+namespace {
+
+QJsonValue redactValue(const QJsonValue &value)
+{
+    if (value.isArray()) {
+        QJsonArray array;
+        for (const auto &item : value.toArray()) {
+            array.append(redactValue(item));
+        }
+        return array;
+    }
+    if (!value.isObject()) {
+        return value;
+    }
+    QJsonObject obj = value.toObject();
+    for (auto it = obj.begin(); it != obj.end(); ++it) {
+        QString text = it.value().toString();
+        if (it.key() == "uuid") {
+            it.value() = text.left(8) + "...";
+        } else if (it.key() == "password") {
+            it.value() = text.length() <= 4 ? QString("****") : text.left(2) + "****" + text.right(2);
+        } else {
+            it.value() = redactValue(it.value());
+        }
+    }
+    return obj;
+}
+
+} // namespace
+
+QJsonObject ConfigGenerator::redactConfig(const QJsonObject &config)
+{
+    return redactValue(config).toObject();
+}
+
 QJsonObject ConfigGenerator::generateLog()
 {
     QJsonObject log;
@@ -53,6 +268,18 @@ QJsonObject ConfigGenerator::generateLog()
     return log;
 }
 
+QJsonObject ConfigGenerator::generateCache()
+{
+    // TLS 会话票据持久化：核心重启（切换节点、崩溃重连）后可直接恢复会话，省去一次完整握手。
+    // 文件由核心加密，密钥见 CoreProcess 传入的 EWP_TLS_SESSION_KEY
+    QString dataDir = QStandardPaths::writableLocation(QStandardPaths::AppLocalDataLocation);
+    QDir().mkpath(dataDir);
+
+    QJsonObject cache;
+    cache["tls_session_file"] = QDir::toNativeSeparators(dataDir + "/tls-sessions.bin");
+    return cache;
+}
+
 QJsonObject ConfigGenerator::generateInbound(const EWPNode &node, const SettingsDialog::AppSettings &settings, bool tunMode)
 {
     QJsonObject inbound;
@@ -65,6 +292,9 @@ QJsonObject ConfigGenerator::generateInbound(const EWPNode &node, const Settings
         inbound["auto_route"] = settings.tunAutoRoute;
         inbound["strict_route"] = settings.tunStrictRoute;
         inbound["stack"] = settings.tunStack;
+        if (settings.tunQueues > 1) {
+            inbound["queues"] = settings.tunQueues;
+        }
         
         if (!settings.tunnelDNS.isEmpty()) {
             inbound["dns"] = settings.tunnelDNS.trimmed();
@@ -88,12 +318,12 @@ QJsonObject ConfigGenerator::generateInbound(const EWPNode &node, const Settings
     return inbound;
 }
 
-QJsonObject ConfigGenerator::generateOutbound(const EWPNode &node)
+QJsonObject ConfigGenerator::generateOutbound(const EWPNode &node, const QString &tag)
 {
     QJsonObject outbound;
     
     outbound["type"] = (node.appProtocol == EWPNode::TROJAN) ? "trojan" : "ewp";
-    outbound["tag"] = "proxy-out";
+    outbound["tag"] = tag;
     outbound["server"] = node.server;
     outbound["server_port"] = node.serverPort;
 
@@ -108,11 +338,26 @@ QJsonObject ConfigGenerator::generateOutbound(const EWPNode &node)
     }
     
     outbound["transport"] = generateTransport(node);
+
+    // TCP Fast Open 仅对基于 TCP 的传输有效
+    if (node.tcpFastOpen && (node.transportMode == EWPNode::WS
+        || node.transportMode == EWPNode::GRPC || node.transportMode == EWPNode::XHTTP)) {
+        outbound["tcp_fast_open"] = true;
+    }
     outbound["tls"] = generateTLS(node);
     
     if (node.appProtocol == EWPNode::EWP && node.enableFlow) {
         outbound["flow"] = generateFlow(node);
     }
+
+    // Trojan smux 多路复用（MASQUE 不支持）
+    if (node.appProtocol == EWPNode::TROJAN && node.enableMux
+        && node.transportMode != EWPNode::MASQUE) {
+        QJsonObject multiplex;
+        multiplex["enabled"] = true;
+        multiplex["concurrency"] = node.muxConcurrency;
+        outbound["multiplex"] = multiplex;
+    }
     
     return outbound;
 }
@@ -125,6 +370,9 @@ QJsonObject ConfigGenerator::generateTransport(const EWPNode &node)
         case EWPNode::WS:
             transport["type"] = "ws";
             transport["path"] = node.wsPath;
+            if (node.wsEarlyData > 0) {
+                transport["max_early_data"] = node.wsEarlyData;
+            }
             break;
             
         case EWPNode::GRPC:
@@ -1,7 +1,9 @@
 #pragma once
 
 #include <QString>
+#include <QList>
 #include <QJsonObject>
+#include <QJsonArray>
 #include "EWPNode.h"
 #include "SettingsDialog.h"
 
@@ -10,16 +12,37 @@ class ConfigGenerator
 public:
     static QJsonObject generateClientConfig(const EWPNode &node, const SettingsDialog::AppSettings &settings, bool tunMode = false);
     
+    // 多节点出站组：proxy-out 为 urltest / fallback / balancer 组，成员为各节点出站
+    // strategy 仅用于 balancer：least-conn（默认）、round-robin、consistent-hash
+    static QJsonObject generateGroupConfig(const QList<EWPNode> &nodes, const QString &groupType,
+                                           const SettingsDialog::AppSettings &settings, bool tunMode = false,
+                                           const QString &strategy = QString());
+    
+    // 为设置了独立端口的节点追加 mixed 入站，并用仅含 inbound 的 route.rules 绑定到各自出站，
+    // 所有端口由同一核心进程服务
+    static void addPortInbounds(QJsonObject &config, const QList<EWPNode> &portNodes,
+                                const SettingsDialog::AppSettings &settings);
+    
+    // TUN 模式：为首个入站设置 redundant_udp，ports 形如 "3478, 27000-27100"（空 = 全部 UDP）
+    // 两个节点须连到同一服务端且均非 MASQUE，否则不设置
+    static void addRedundantUDP(QJsonObject &config, const EWPNode &primary, const EWPNode &secondary,
+                                const QString &ports);
+    
     static QString generateConfigFile(const EWPNode &node, const SettingsDialog::AppSettings &settings, bool tunMode = false);
     
     static bool saveConfig(const QJsonObject &config, const QString &filePath);
+    
+    // 诊断用：按 EWPNode::displayAuth 的方式遮盖各出站的 uuid / password
+    static QJsonObject redactConfig(const QJsonObject &config);
 
 private:
     static QJsonObject generateInbound(const EWPNode &node, const SettingsDialog::AppSettings &settings, bool tunMode);
-    static QJsonObject generateOutbound(const EWPNode &node);
+    static QJsonObject generateOutbound(const EWPNode &node, const QString &tag = "proxy-out");
+    static QString nodeOutboundTag(QJsonArray &outbounds, const EWPNode &node);
     static QJsonObject generateTransport(const EWPNode &node);
     static QJsonObject generateTLS(const EWPNode &node);
     static QJsonObject generateFlow(const EWPNode &node);
     static QJsonObject generateRoute();
     static QJsonObject generateLog();
+    static QJsonObject generateCache();
 };
@@ -0,0 +1,197 @@
+#include "ConnectionsModel.h"
+#include <QJsonArray>
+#include <QRegularExpression>
+#include <algorithm>
+#include <functional>
+
+ConnectionsModel::ConnectionsModel(QObject *parent)
+    : QAbstractTableModel(parent)
+{
+}
+
+int ConnectionsModel::rowCount(const QModelIndex &parent) const
+{
+    return parent.isValid() ? 0 : flows.size();
+}
+
+int ConnectionsModel::columnCount(const QModelIndex &parent) const
+{
+    return parent.isValid() ? 0 : ColumnCount;
+}
+
+QString ConnectionsModel::formatBytes(qint64 bytes)
+{
+    if (bytes < 1024) {
+        return QString("%1 B").arg(bytes);
+    }
+    if (bytes < 1024 * 1024) {
+        return QString("%1 KB").arg(bytes / 1024.0, 0, 'f', 1);
+    }
+    if (bytes < 1024LL * 1024 * 1024) {
+        return QString("%1 MB").arg(bytes / (1024.0 * 1024), 0, 'f', 1);
+    }
+    return QString("%1 GB").arg(bytes / (1024.0 * 1024 * 1024), 0, 'f', 2);
+}
+
+QVariant ConnectionsModel::data(const QModelIndex &index, int role) const
+{
+    if (!index.isValid() || index.row() >= flows.size()) {
+        return QVariant();
+    }
+    const Flow &f = flows.at(index.row());
+
+    if (role == Qt::TextAlignmentRole && index.column() >= ColDuration) {
+        return int(Qt::AlignRight | Qt::AlignVCenter);
+    }
+    if (role != Qt::DisplayRole && role != Qt::UserRole) {
+        return QVariant();
+    }
+    bool display = role == Qt::DisplayRole;
+
+    switch (index.column()) {
+    case ColTarget:
+        return f.target;
+    case ColNetwork:
+        return f.network.toUpper();
+    case ColInbound:
+        return f.inbound;
+    case ColSource:
+        return f.source;
+    case ColTransport:
+        return f.transport;
+    case ColDuration: {
+        qint64 secs = f.start.secsTo(QDateTime::currentDateTimeUtc());
+        if (!display) {
+            return secs;
+        }
+        return secs < 3600
+            ? QString("%1:%2").arg(secs / 60).arg(secs % 60, 2, 10, QChar('0'))
+            : QString("%1:%2:%3").arg(secs / 3600).arg(secs / 60 % 60, 2, 10, QChar('0'))
+                  .arg(secs % 60, 2, 10, QChar('0'));
+    }
+    case ColUpload:
+        return display ? QVariant(formatBytes(f.upload)) : QVariant(f.upload);
+    case ColDownload:
+        return display ? QVariant(formatBytes(f.download)) : QVariant(f.download);
+    case ColUpRate:
+        return display ? QVariant(f.upRate > 0 ? formatBytes(f.upRate) + "/s" : QString()) : QVariant(f.upRate);
+    case ColDownRate:
+        return display ? QVariant(f.downRate > 0 ? formatBytes(f.downRate) + "/s" : QString()) : QVariant(f.downRate);
+    }
+    return QVariant();
+}
+
+QVariant ConnectionsModel::headerData(int section, Qt::Orientation orientation, int role) const
+{
+    if (orientation != Qt::Horizontal || role != Qt::DisplayRole) {
+        return QVariant();
+    }
+    static const char *headers[ColumnCount] = {
+        "目标", "类型", "入站", "来源", "出站", "时长", "上传", "下载", "上行速率", "下行速率"
+    };
+    return section >= 0 && section < ColumnCount ? QString(headers[section]) : QVariant();
+}
+
+ConnectionsModel::Flow ConnectionsModel::parseFlow(const QJsonObject &obj)
+{
+    Flow f;
+    f.id = static_cast<quint64>(obj["id"].toDouble());
+    f.network = obj["network"].toString();
+    f.inbound = obj["inbound"].toString();
+    f.source = obj["source"].toString();
+    f.target = obj["target"].toString();
+    f.transport = obj["transport"].toString();
+    // Go 以 RFC 3339 纳秒精度输出时间，截到毫秒再解析
+    QString start = obj["start"].toString();
+    start.replace(QRegularExpression("(\\.\\d{3})\\d+"), "\\1");
+    f.start = QDateTime::fromString(start, Qt::ISODateWithMs).toUTC();
+    f.upload = static_cast<qint64>(obj["upload"].toDouble());
+    f.download = static_cast<qint64>(obj["download"].toDouble());
+    return f;
+}
+
+void ConnectionsModel::applyDiff(const QJsonObject &diff)
+{
+    // 删除：从后往前逐行移除，保持 rowById 与 flows 一致
+    QJsonArray removed = diff["removed"].toArray();
+    if (!removed.isEmpty()) {
+        QVector<int> rows;
+        for (const auto &value : removed) {
+            auto it = rowById.constFind(static_cast<quint64>(value.toDouble()));
+            if (it != rowById.constEnd()) {
+                rows.append(it.value());
+            }
+        }
+        std::sort(rows.begin(), rows.end(), std::greater<int>());
+        for (int row : rows) {
+            beginRemoveRows(QModelIndex(), row, row);
+            flows.removeAt(row);
+            endRemoveRows();
+        }
+        rowById.clear();
+        for (int i = 0; i < flows.size(); ++i) {
+            rowById.insert(flows[i].id, i);
+        }
+    }
+
+    QJsonArray added = diff["added"].toArray();
+    if (!added.isEmpty()) {
+        beginInsertRows(QModelIndex(), flows.size(), flows.size() + added.size() - 1);
+        for (const auto &value : added) {
+            Flow f = parseFlow(value.toObject());
+            rowById.insert(f.id, flows.size());
+            flows.append(f);
+        }
+        endInsertRows();
+    }
+
+    for (const auto &value : diff["updated"].toArray()) {
+        QJsonObject obj = value.toObject();
+        auto it = rowById.constFind(static_cast<quint64>(obj["id"].toDouble()));
+        if (it == rowById.constEnd()) {
+            continue;
+        }
+        Flow &f = flows[it.value()];
+        f.upload = static_cast<qint64>(obj["upload"].toDouble());
+        f.download = static_cast<qint64>(obj["download"].toDouble());
+        f.upRate = static_cast<qint64>(obj["up_rate"].toDouble());
+        f.downRate = static_cast<qint64>(obj["down_rate"].toDouble());
+    }
+
+    if (!flows.isEmpty()) {
+        emit dataChanged(index(0, ColUpload), index(flows.size() - 1, ColDownRate));
+    }
+}
+
+void ConnectionsModel::refreshDurations()
+{
+    if (!flows.isEmpty()) {
+        emit dataChanged(index(0, ColDuration), index(flows.size() - 1, ColDuration));
+    }
+}
+
+void ConnectionsModel::clear()
+{
+    beginResetModel();
+    flows.clear();
+    rowById.clear();
+    endResetModel();
+}
+
+qint64 ConnectionsModel::totalUpRate() const
+{
+    qint64 total = 0;
+    for (const auto &f : flows) {
+        total += f.upRate;
+    }
+    return total;
+}
+
+qint64 ConnectionsModel::totalDownRate() const
+{
+    qint64 total = 0;
+    for (const auto &f : flows) {
+        total += f.downRate;
+    }
+    return total;
+}
@@ -0,0 +1,66 @@
+#pragma once
+
+#include <QAbstractTableModel>
+#include <QDateTime>
+#include <QHash>
+#include <QJsonObject>
+#include <QVector>
+
+// 核心实时连接表：按控制接口 /connections 推送的增量（added / updated / removed）维护。
+// Qt::DisplayRole 为格式化文本，Qt::UserRole 为排序用的原始值。
+class ConnectionsModel : public QAbstractTableModel
+{
+    Q_OBJECT
+
+public:
+    enum Column {
+        ColTarget,
+        ColNetwork,
+        ColInbound,
+        ColSource,
+        ColTransport,
+        ColDuration,
+        ColUpload,
+        ColDownload,
+        ColUpRate,
+        ColDownRate,
+        ColumnCount
+    };
+
+    struct Flow {
+        quint64 id = 0;
+        QString network;
+        QString inbound;
+        QString source;
+        QString target;
+        QString transport;
+        QDateTime start;
+        qint64 upload = 0;
+        qint64 download = 0;
+        qint64 upRate = 0;
+        qint64 downRate = 0;
+    };
+
+    explicit ConnectionsModel(QObject *parent = nullptr);
+
+    int rowCount(const QModelIndex &parent = QModelIndex()) const override;
+    int columnCount(const QModelIndex &parent = QModelIndex()) const override;
+    QVariant data(const QModelIndex &index, int role = Qt::DisplayRole) const override;
+    QVariant headerData(int section, Qt::Orientation orientation, int role = Qt::DisplayRole) const override;
+
+    void applyDiff(const QJsonObject &diff);
+    void clear();
+    void refreshDurations();   // 核心只在流量变化时推送，时长列由视图定时刷新
+
+    quint64 flowId(int row) const { return flows.at(row).id; }
+    qint64 totalUpRate() const;
+    qint64 totalDownRate() const;
+
+    static QString formatBytes(qint64 bytes);
+
+private:
+    static Flow parseFlow(const QJsonObject &obj);
+
+    QVector<Flow> flows;
+    QHash<quint64, int> rowById;
+};
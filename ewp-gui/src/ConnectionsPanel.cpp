@@ -0,0 +1,125 @@
+#include "ConnectionsPanel.h"
+#include "ConnectionsModel.h"
+#include "ControlStream.h"
+#include <QHBoxLayout>
+#include <QHeaderView>
+#include <QLabel>
+#include <QLineEdit>
+#include <QMenu>
+#include <QNetworkReply>
+#include <QPushButton>
+#include <QSortFilterProxyModel>
+#include <QTableView>
+#include <QVBoxLayout>
+
+ConnectionsPanel::ConnectionsPanel(QWidget *parent)
+    : QWidget(parent)
+    , network(new QNetworkAccessManager(this))
+    , stream(new ControlStream("/connections", network, this))
+    , tickTimer(new QTimer(this))
+    , model(new ConnectionsModel(this))
+    , proxy(new QSortFilterProxyModel(this))
+{
+    proxy->setSourceModel(model);
+    proxy->setSortRole(Qt::UserRole);
+    proxy->setFilterCaseSensitivity(Qt::CaseInsensitive);
+    proxy->setFilterKeyColumn(-1);  // 任意列匹配
+
+    view = new QTableView(this);
+    view->setModel(proxy);
+    view->setSortingEnabled(true);
+    view->sortByColumn(ConnectionsModel::ColDownRate, Qt::DescendingOrder);
+    view->setSelectionBehavior(QAbstractItemView::SelectRows);
+    view->setSelectionMode(QAbstractItemView::ExtendedSelection);
+    view->setEditTriggers(QAbstractItemView::NoEditTriggers);
+    view->setAlternatingRowColors(true);
+    view->setContextMenuPolicy(Qt::CustomContextMenu);
+    view->verticalHeader()->setVisible(false);
+    view->horizontalHeader()->setSectionResizeMode(ConnectionsModel::ColTarget, QHeaderView::Stretch);
+
+    filterEdit = new QLineEdit(this);
+    filterEdit->setPlaceholderText("过滤目标 / 来源 / 入站...");
+    filterEdit->setClearButtonEnabled(true);
+
+    closeButton = new QPushButton("关闭连接", this);
+    closeButton->setEnabled(false);
+
+    summaryLabel = new QLabel(this);
+
+    auto *toolbar = new QHBoxLayout;
+    toolbar->addWidget(filterEdit, 1);
+    toolbar->addWidget(summaryLabel);
+    toolbar->addWidget(closeButton);
+
+    auto *layout = new QVBoxLayout(this);
+    layout->setContentsMargins(0, 0, 0, 0);
+    layout->addLayout(toolbar);
+    layout->addWidget(view);
+
+    connect(filterEdit, &QLineEdit::textChanged, proxy, &QSortFilterProxyModel::setFilterFixedString);
+    connect(closeButton, &QPushButton::clicked, this, &ConnectionsPanel::onCloseSelected);
+    connect(view->selectionModel(), &QItemSelectionModel::selectionChanged, this, [this]() {
+        closeButton->setEnabled(view->selectionModel()->hasSelection());
+    });
+    connect(view, &QTableView::customContextMenuRequested, this, [this](const QPoint &pos) {
+        if (!view->indexAt(pos).isValid()) {
+            return;
+        }
+        QMenu menu(this);
+        menu.addAction("关闭连接", this, &ConnectionsPanel::onCloseSelected);
+        menu.exec(view->viewport()->mapToGlobal(pos));
+    });
+
+    // 每次（重新）建立流，核心都会先推送完整列表（全部为 added）
+    connect(stream, &ControlStream::opened, this, [this]() {
+        model->clear();
+        tickTimer->start();
+        updateSummary();
+    });
+    connect(stream, &ControlStream::received, this, [this](const QJsonObject &diff) {
+        model->applyDiff(diff);
+        updateSummary();
+    });
+    connect(stream, &ControlStream::closed, this, [this]() {
+        tickTimer->stop();
+        model->clear();
+        updateSummary();
+    });
+
+    tickTimer->setInterval(1000);
+    connect(tickTimer, &QTimer::timeout, model, &ConnectionsModel::refreshDurations);
+
+    updateSummary();
+}
+
+void ConnectionsPanel::setControl(const ControlEndpoint &endpoint)
+{
+    stream->setControl(endpoint);
+}
+
+void ConnectionsPanel::onCloseSelected()
+{
+    ControlEndpoint control = stream->control();
+    if (control.isEmpty()) {
+        return;
+    }
+    for (const QModelIndex &index : view->selectionModel()->selectedRows()) {
+        quint64 id = model->flowId(proxy->mapToSource(index).row());
+        QNetworkRequest request = control.request(QString("/connections/%1").arg(id));
+        QNetworkReply *reply = network->deleteResource(request);
+        connect(reply, &QNetworkReply::finished, reply, &QNetworkReply::deleteLater);
+    }
+    // 行由下一次 removed 增量移除
+}
+
+void ConnectionsPanel::updateSummary()
+{
+    if (stream->control().isEmpty()) {
+        summaryLabel->setText("核心未运行");
+        return;
+    }
+    summaryLabel->setText(QString("%1 个连接 | ↑ %2/s ↓ %3/s")
+        .arg(model->rowCount())
+        .arg(ConnectionsModel::formatBytes(model->totalUpRate()))
+        .arg(ConnectionsModel::formatBytes(model->totalDownRate())));
+}
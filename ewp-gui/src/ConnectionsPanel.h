@@ -0,0 +1,43 @@
+#pragma once
+
+#include <QWidget>
+#include <QNetworkAccessManager>
+#include <QTimer>
+#include "ControlEndpoint.h"
+
+class QLabel;
+class QLineEdit;
+class QPushButton;
+class QSortFilterProxyModel;
+class QTableView;
+class ConnectionsModel;
+class ControlStream;
+
+// 连接面板：订阅核心控制接口 GET /connections 的 NDJSON 增量流，
+// 支持按列排序、按目标 / 来源过滤，以及 DELETE /connections/{id} 关闭选中连接
+class ConnectionsPanel : public QWidget
+{
+    Q_OBJECT
+
+public:
+    explicit ConnectionsPanel(QWidget *parent = nullptr);
+
+    // 核心启动后传入控制地址；空字符串表示核心已停止
+    void setControl(const ControlEndpoint &endpoint);
+
+private slots:
+    void onCloseSelected();
+    void updateSummary();
+
+private:
+    QNetworkAccessManager *network;
+    ControlStream *stream;
+    QTimer *tickTimer;
+
+    ConnectionsModel *model;
+    QSortFilterProxyModel *proxy;
+    QTableView *view;
+    QLineEdit *filterEdit;
+    QPushButton *closeButton;
+    QLabel *summaryLabel;
+};
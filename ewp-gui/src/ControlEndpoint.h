@@ -0,0 +1,26 @@
+#pragma once
+
+#include <QByteArray>
+#include <QNetworkRequest>
+#include <QString>
+#include <QUrl>
+
+// 核心控制接口：地址与核心每次启动随机生成的令牌。核心在标准输出先打印 CONTROL_TOKEN=，
+// 再打印 CONTROL_ADDR=；每个请求都须带 "Authorization: Bearer <令牌>"，否则返回 401。
+struct ControlEndpoint
+{
+    QString addr;                   // host:port，为空表示核心未运行或没有控制接口
+    QByteArray token;
+
+    bool isEmpty() const { return addr.isEmpty(); }
+    bool operator==(const ControlEndpoint &other) const { return addr == other.addr && token == other.token; }
+    bool operator!=(const ControlEndpoint &other) const { return !(*this == other); }
+
+    // pathAndQuery 以 "/" 开头，如 "/edges"、"/debug/pprof/heap?gc=1"
+    QNetworkRequest request(const QString &pathAndQuery) const
+    {
+        QNetworkRequest req(QUrl(QString("http://%1%2").arg(addr, pathAndQuery)));
+        req.setRawHeader("Authorization", "Bearer " + token);
+        return req;
+    }
+};
@@ -0,0 +1,88 @@
+#include "ControlStream.h"
+#include <QJsonDocument>
+#include <QNetworkRequest>
+
+ControlStream::ControlStream(const QString &path, QNetworkAccessManager *network, QObject *parent)
+    : QObject(parent)
+    , path(path)
+    , network(network)
+    , retryTimer(new QTimer(this))
+{
+    retryTimer->setSingleShot(true);
+    retryTimer->setInterval(2000);
+    connect(retryTimer, &QTimer::timeout, this, &ControlStream::open);
+}
+
+ControlStream::~ControlStream()
+{
+    abort();
+}
+
+void ControlStream::setControl(const ControlEndpoint &newEndpoint)
+{
+    if (newEndpoint == endpoint) {
+        return;
+    }
+    endpoint = newEndpoint;
+    abort();
+    if (endpoint.isEmpty()) {
+        emit closed();
+    } else {
+        open();
+    }
+}
+
+void ControlStream::open()
+{
+    if (endpoint.isEmpty() || reply) {
+        return;
+    }
+    pending.clear();
+    emit opened();
+
+    QNetworkRequest request = endpoint.request(path);
+    request.setAttribute(QNetworkRequest::CacheLoadControlAttribute, QNetworkRequest::AlwaysNetwork);
+    reply = network->get(request);
+    connect(reply, &QNetworkReply::readyRead, this, &ControlStream::onReadyRead);
+    connect(reply, &QNetworkReply::finished, this, &ControlStream::onFinished);
+}
+
+void ControlStream::abort()
+{
+    retryTimer->stop();
+    if (reply) {
+        QNetworkReply *r = reply;
+        reply = nullptr;
+        r->disconnect(this);
+        r->abort();
+        r->deleteLater();
+    }
+}
+
+void ControlStream::onReadyRead()
+{
+    if (!reply) {
+        return;
+    }
+    pending += reply->readAll();
+    int newline;
+    while ((newline = pending.indexOf('\n')) >= 0) {
+        QJsonDocument doc = QJsonDocument::fromJson(pending.left(newline));
+        pending.remove(0, newline + 1);
+        if (doc.isObject()) {
+            emit received(doc.object());
+        }
+    }
+}
+
+void ControlStream::onFinished()
+{
+    if (reply) {
+        reply->deleteLater();
+        reply = nullptr;
+    }
+    // 核心重启、网络抖动后自动重连
+    if (!endpoint.isEmpty()) {
+        retryTimer->start();
+    }
+}
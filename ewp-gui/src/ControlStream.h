@@ -0,0 +1,43 @@
+#pragma once
+
+#include <QObject>
+#include <QJsonObject>
+#include <QNetworkAccessManager>
+#include <QNetworkReply>
+#include <QPointer>
+#include <QTimer>
+#include "ControlEndpoint.h"
+
+// 订阅核心控制接口上的 NDJSON 流（/connections、/stats）：每行解析为一个 JSON 对象，
+// 流断开后 2 秒自动重连。控制地址为空时停止。
+class ControlStream : public QObject
+{
+    Q_OBJECT
+
+public:
+    ControlStream(const QString &path, QNetworkAccessManager *network, QObject *parent = nullptr);
+    ~ControlStream();
+
+    void setControl(const ControlEndpoint &endpoint);
+    ControlEndpoint control() const { return endpoint; }
+
+signals:
+    void opened();                          // 新流开始，此前的状态应清空
+    void received(const QJsonObject &obj);
+    void closed();                          // 控制地址被清空（核心已停止）
+
+private slots:
+    void onReadyRead();
+    void onFinished();
+
+private:
+    void open();
+    void abort();
+
+    QString path;
+    ControlEndpoint endpoint;
+    QNetworkAccessManager *network;
+    QPointer<QNetworkReply> reply;
+    QByteArray pending;                     // 未完整的一行
+    QTimer *retryTimer;
+};
@@ -11,6 +11,9 @@
 #include <QJsonDocument>
 #include <QJsonObject>
 #include <QFile>
+#include <QProcessEnvironment>
+#include <QRandomGenerator>
+#include <QSettings>
 
 #ifdef Q_OS_WIN
 #include <Windows.h>
@@ -18,14 +21,69 @@
 #include <shlobj.h>
 #endif
 
+namespace {
+
+constexpr int kSessionKeySize = 32;
+
+// TLS 会话缓存文件的加密密钥：首次使用时随机生成并保存在 QSettings（与
+// AppLocalData 下的缓存文件分开存放），启动核心时经环境变量传入
+QString sessionCacheKey()
+{
+    QSettings settings("EWP", "EWP-GUI");
+    QByteArray key = QByteArray::fromHex(settings.value("tlsSessionKey").toByteArray());
+    if (key.size() != kSessionKeySize) {
+        key.resize(kSessionKeySize);
+        QRandomGenerator::system()->fillRange(reinterpret_cast<quint32 *>(key.data()),
+                                              kSessionKeySize / sizeof(quint32));
+        settings.setValue("tlsSessionKey", QString::fromLatin1(key.toHex()));
+    }
+    return QString::fromLatin1(key.toHex());
+}
+
+} // namespace
+
 CoreProcess::CoreProcess(QObject *parent)
     : QObject(parent)
 {
     coreExecutable = findCoreExecutable();
     networkManager = new QNetworkAccessManager(this);
-    retryTimer = new QTimer(this);
-    retryTimer->setSingleShot(true);
-    connect(retryTimer, &QTimer::timeout, this, &CoreProcess::attemptReconnect);
+    supervisor = new CoreSupervisor(this);
+    
+    connect(supervisor, &CoreSupervisor::restartRequested, this, &CoreProcess::attemptReconnect);
+    connect(supervisor, &CoreSupervisor::restartScheduled, this,
+            [this](int attempt, int delayMs, const QString &reason) {
+        int delaySec = (delayMs + 999) / 1000;
+        emit reconnecting(attempt, delaySec);
+        emit logReceived(QString("⚠️ %1，%2 秒后进行第 %3 次重启...").arg(reason).arg(delaySec).arg(attempt));
+    });
+    connect(supervisor, &CoreSupervisor::breakerOpened, this, [this](int failures, int cooldownMs) {
+        emit logReceived(QString("⛔ 连续 %1 次重启未恢复，暂停自动重启 %2 分钟")
+                             .arg(failures).arg(cooldownMs / 60000));
+        emit circuitOpened(cooldownMs / 1000);
+    });
+    connect(supervisor, &CoreSupervisor::recovered, this, [this](qint64 downtimeMs) {
+        const CoreSupervisor::Stats &st = supervisor->stats();
+        emit logReceived(QString("✅ 核心已恢复，中断 %1 秒（共 %2 次故障，平均恢复 %3 秒）")
+                             .arg(downtimeMs / 1000.0, 0, 'f', 1)
+                             .arg(st.outages)
+                             .arg(st.meanRecoveryMs() / 1000.0, 0, 'f', 1));
+        emit recovered(downtimeMs);
+    });
+    connect(supervisor, &CoreSupervisor::gaveUp, this, [this](const QString &reason) {
+        // 仍在运行的核心（不自动重启的提权核心挂起时）一并结束
+        if (isRunning()) {
+            stop();
+        }
+        lastError = reason;
+        if (!lastOutputLine.isEmpty()) {
+            lastError += "\n" + lastOutputLine;
+        }
+        emit logReceived("⛔ " + reason + "，已停止自动重启");
+        emit errorOccurred(lastError);
+    });
+    connect(supervisor, &CoreSupervisor::uplinkDown, this, [this](const QString &detail) {
+        emit logReceived(QString("🌐 隧道与直连均不通，本机网络可能已断开，暂不重启核心（%1）").arg(detail));
+    });
 }
 
 CoreProcess::~CoreProcess()
@@ -67,12 +125,19 @@ QString CoreProcess::findCoreExecutable()
 
 bool CoreProcess::start(const EWPNode &node, bool tunMode)
 {
-    retryCount = 0;
-    retryTimer->stop();
-    return startCore(node, tunMode);
+    supervisor->reset();
+    return startCore({node}, QString(), tunMode, QString());
+}
+
+bool CoreProcess::startGroup(const QList<EWPNode> &nodes, const QString &groupType, bool tunMode,
+                             const QString &strategy)
+{
+    supervisor->reset();
+    return startCore(nodes, groupType, tunMode, strategy);
 }
 
-bool CoreProcess::startCore(const EWPNode &node, bool tunMode)
+bool CoreProcess::startCore(const QList<EWPNode> &nodes, const QString &groupType, bool tunMode,
+                            const QString &strategy)
 {
     if (isRunning()) {
         lastError = "进程已在运行";
@@ -85,16 +150,25 @@ bool CoreProcess::startCore(const EWPNode &node, bool tunMode)
         return false;
     }
     
-    if (!node.isValid()) {
-        lastError = "节点配置无效";
+    if (nodes.isEmpty()) {
+        lastError = "未选择节点";
         emit errorOccurred(lastError);
         return false;
     }
+    for (const auto &node : nodes) {
+        if (!node.isValid()) {
+            lastError = "节点配置无效: " + node.name;
+            emit errorOccurred(lastError);
+            return false;
+        }
+    }
     
-    lastNode = node;
+    lastNodes = nodes;
+    lastGroupType = groupType;
+    lastGroupStrategy = strategy;
     lastTunMode = tunMode;
     
-    configFilePath = generateConfigFile(node, tunMode);
+    configFilePath = generateConfigFile(nodes, groupType, tunMode, strategy);
     if (configFilePath.isEmpty()) {
         lastError = "生成配置文件失败";
         emit errorOccurred(lastError);
@@ -103,6 +177,7 @@ bool CoreProcess::startCore(const EWPNode &node, bool tunMode)
     
     QStringList args;
     args << "-c" << configFilePath;
+    lastOutputLine.clear();
 
 #ifdef Q_OS_WIN
     if (tunMode && !IsUserAnAdmin()) {
@@ -121,6 +196,10 @@ bool CoreProcess::startCore(const EWPNode &node, bool tunMode)
     connect(process, &QProcess::readyReadStandardError, 
             this, &CoreProcess::onReadyReadStandardError);
     
+    QProcessEnvironment env = QProcessEnvironment::systemEnvironment();
+    env.insert("EWP_TLS_SESSION_KEY", sessionCacheKey());
+    process->setProcessEnvironment(env);
+    
     qDebug() << "启动核心:" << coreExecutable << args;
     
     process->start(coreExecutable, args);
@@ -138,10 +217,8 @@ bool CoreProcess::startCore(const EWPNode &node, bool tunMode)
 
 void CoreProcess::stop()
 {
-    if (!isRunning() && !retryTimer->isActive()) return;
-
-    retryCount = 0;
-    retryTimer->stop();
+    // 用户主动停止：同时取消等待中的自动重启
+    supervisor->reset();
 
     if (!isRunning()) return;
 
@@ -155,7 +232,7 @@ void CoreProcess::stop()
     gracefulStop = true;
 
     // 尝试通过控制服务器优雅退出
-    if (!controlAddr.isEmpty()) {
+    if (!control.isEmpty()) {
         sendQuitRequest();
         // 等待短时间，如果没有退出则强制终止
         if (process->waitForFinished(500)) {
@@ -189,10 +266,9 @@ void CoreProcess::stop()
 
 void CoreProcess::sendQuitRequest()
 {
-    if (controlAddr.isEmpty()) return;
+    if (control.isEmpty()) return;
     
-    QUrl url(QString("http://%1/quit").arg(controlAddr));
-    QNetworkRequest request(url);
+    QNetworkRequest request = control.request("/quit");
     request.setHeader(QNetworkRequest::ContentTypeHeader, "application/json");
     request.setTransferTimeout(500);  // 500ms 超时
     
@@ -212,11 +288,20 @@ bool CoreProcess::isRunning() const
     return process && process->state() == QProcess::Running;
 }
 
-QString CoreProcess::generateConfigFile(const EWPNode &node, bool tunMode)
+QString CoreProcess::generateConfigFile(const QList<EWPNode> &nodes, const QString &groupType, bool tunMode,
+                                        const QString &strategy)
 {
     SettingsDialog::AppSettings settings = SettingsDialog::loadFromRegistry();
     listenAddr = settings.listenAddr;
-    QJsonObject config = ConfigGenerator::generateClientConfig(node, settings, tunMode);
+    QJsonObject config = groupType.isEmpty()
+        ? ConfigGenerator::generateClientConfig(nodes.first(), settings, tunMode)
+        : ConfigGenerator::generateGroupConfig(nodes, groupType, settings, tunMode, strategy);
+    if (!tunMode) {
+        ConfigGenerator::addPortInbounds(config, portNodes, settings);
+    } else if (settings.redundantUDP && redundantNodes.size() == 2) {
+        ConfigGenerator::addRedundantUDP(config, redundantNodes[0], redundantNodes[1], settings.redundantPorts);
+    }
+    lastConfig = config;
     
     QString tempDir = QStandardPaths::writableLocation(QStandardPaths::TempLocation);
     QString configPath = tempDir + QString("/ewp-gui-config-%1.json").arg(QCoreApplication::applicationPid());
@@ -232,48 +317,53 @@ QString CoreProcess::generateConfigFile(const EWPNode &node, bool tunMode)
 
 void CoreProcess::onProcessStarted()
 {
+    supervisor->watch(listenAddr, lastTunMode);
     emit started();
 }
 
 void CoreProcess::onProcessFinished(int exitCode, QProcess::ExitStatus exitStatus)
 {
-    Q_UNUSED(exitCode)
-    
-    bool crashed = (exitStatus == QProcess::CrashExit && !gracefulStop);
+    // 非主动停止的崩溃或非零退出都视为故障；是否重启由监护按退出码与运行时长决定
+    bool failed = !gracefulStop && (exitStatus == QProcess::CrashExit || exitCode != 0);
     
     gracefulStop = false;
-    controlAddr.clear();
+    control = ControlEndpoint();
+    supervisor->setControl(control);
+    supervisor->unwatch();
+    emit controlChanged(control);
     emit stopped();
     
-    if (crashed) {
-        scheduleReconnect();
+    if (failed) {
+        if (exitStatus == QProcess::CrashExit) {
+            supervisor->reportExit(-1, "核心进程崩溃");
+        } else {
+            supervisor->reportExit(exitCode, QString("核心进程异常退出 (code=%1)").arg(exitCode));
+        }
     }
 }
 
-void CoreProcess::scheduleReconnect()
+void CoreProcess::attemptReconnect(const QString &reason)
 {
-    if (retryCount >= kMaxRetries) {
-        emit reconnectFailed();
-        retryCount = 0;
-        return;
-    }
-    
-    int delaySec = 2 << retryCount;
-    retryCount++;
-    
-    emit reconnecting(retryCount, kMaxRetries);
-    emit logReceived(QString("⚠️ 核心进程崩溃，%1 秒后尝试第 %2/%3 次重连...")
-                         .arg(delaySec).arg(retryCount).arg(kMaxRetries));
+    emit logReceived(QString("🔄 正在重启核心（%1）...").arg(reason));
     
-    retryTimer->start(delaySec * 1000);
-}
-
-void CoreProcess::attemptReconnect()
-{
-    emit logReceived(QString("🔄 正在尝试重连 (%1/%2)...").arg(retryCount).arg(kMaxRetries));
+    // 挂起的核心进程仍在运行：先强制结束
+    if (isRunning()) {
+#ifdef Q_OS_WIN
+        if (usingElevation) {
+            stopElevatedCore();
+        } else
+#endif
+        {
+            gracefulStop = true;
+            process->kill();
+            process->waitForFinished(1000);
+            delete process;
+            process = nullptr;
+        }
+    }
     
-    if (!startCore(lastNode, lastTunMode)) {
-        scheduleReconnect();
+    if (!startCore(lastNodes, lastGroupType, lastTunMode, lastGroupStrategy)) {
+        supervisor->reportFailure("启动失败: " + lastError);
     }
 }
 
@@ -308,18 +398,45 @@ void CoreProcess::onReadyReadStandardOutput()
 {
     if (!process) return;
     
-    QByteArray data = process->readAllStandardOutput();
+    processStdout(process->readAllStandardOutput());
+}
+
+QStringList CoreProcess::parseStdout(const QByteArray &data, ControlEndpoint *endpoint, bool *addrChanged)
+{
+    QStringList lines;
     QString text = QString::fromUtf8(data).trimmed();
-    
-    if (!text.isEmpty()) {
-        for (const auto &line : text.split('\n')) {
-            QString trimmedLine = line.trimmed();
-            // 解析控制服务器地址
-            if (trimmedLine.startsWith("CONTROL_ADDR=")) {
-                controlAddr = trimmedLine.mid(13);
-            }
-            emit logReceived(trimmedLine);
+    if (text.isEmpty()) {
+        return lines;
+    }
+    for (const auto &line : text.split('\n')) {
+        QString trimmedLine = line.trimmed();
+        // 控制接口令牌先于地址输出；令牌不进日志
+        if (trimmedLine.startsWith("CONTROL_TOKEN=")) {
+            endpoint->token = trimmedLine.mid(14).toUtf8();
+            continue;
+        }
+        if (trimmedLine.startsWith("CONTROL_ADDR=")) {
+            endpoint->addr = trimmedLine.mid(13);
+            *addrChanged = true;
+        }
+        lines.append(trimmedLine);
+    }
+    return lines;
+}
+
+void CoreProcess::processStdout(const QByteArray &data)
+{
+    bool addrChanged = false;
+    const QStringList lines = parseStdout(data, &control, &addrChanged);
+    if (addrChanged) {
+        supervisor->setControl(control);
+        emit controlChanged(control);
+    }
+    for (const auto &line : lines) {
+        if (!line.isEmpty() && !line.startsWith("CONTROL_ADDR=")) {
+            lastOutputLine = line;
         }
+        emit logReceived(line);
     }
 }
 
@@ -332,7 +449,8 @@ void CoreProcess::onReadyReadStandardError()
     
     if (!text.isEmpty()) {
         for (const auto &line : text.split('\n')) {
-            emit logReceived("[ERR] " + line.trimmed());
+            lastOutputLine = line.trimmed();
+            emit logReceived("[ERR] " + lastOutputLine);
         }
     }
 }
@@ -350,6 +468,7 @@ bool CoreProcess::startElevatedCore(const QStringList &args)
     }
     QString params = quotedArgs.join(" ");
 
+    // runas 启动的核心不继承本进程的环境变量，拿不到会话缓存密钥，票据只存内存
     SHELLEXECUTEINFOW sei = {};
     sei.cbSize = sizeof(sei);
     sei.fMask = SEE_MASK_NOCLOSEPROCESS | SEE_MASK_NO_CONSOLE;
@@ -382,6 +501,8 @@ bool CoreProcess::startElevatedCore(const QStringList &args)
     }
     exitPollTimer->start(1000);
 
+    // 每次重启都会弹出 UAC 确认，提权核心出故障时不自动重启
+    supervisor->watch(listenAddr, lastTunMode, false);
     emit started();
     emit logReceived("[TUN] 已以管理员权限启动 (实时日志不可用)");
     return true;
@@ -407,8 +528,9 @@ void CoreProcess::pollElevatedExit()
 
     emit stopped();
 
+    supervisor->unwatch();
     if (!gracefulStop && exitCode != 0) {
-        scheduleReconnect();
+        supervisor->reportExit(static_cast<int>(exitCode), QString("核心进程异常退出 (code=%1)").arg(exitCode));
     }
     gracefulStop = false;
 }
@@ -420,7 +542,7 @@ void CoreProcess::stopElevatedCore()
     if (exitPollTimer) exitPollTimer->stop();
     gracefulStop = true;
 
-    if (!controlAddr.isEmpty()) {
+    if (!control.isEmpty()) {
         sendQuitRequest();
         Sleep(500);
     }
@@ -6,7 +6,9 @@
 #include <QNetworkAccessManager>
 #include <QNetworkReply>
 #include <QTimer>
+#include <QJsonObject>
 #include "EWPNode.h"
+#include "CoreSupervisor.h"
 
 class CoreProcess : public QObject
 {
@@ -17,21 +19,40 @@ public:
     ~CoreProcess();
 
     bool start(const EWPNode &node, bool tunMode = false);
+    // 以出站组启动：groupType 为 "urltest"（按延迟自动选择）、"fallback"（按顺序故障转移）
+    // 或 "balancer"（按 strategy 把连接分散到全部成员）
+    bool startGroup(const QList<EWPNode> &nodes, const QString &groupType, bool tunMode = false,
+                    const QString &strategy = QString());
+    // 设置了独立端口的节点：下次启动（含自动重连）时在同一核心内额外开放各自的本地端口
+    void setPortNodes(const QList<EWPNode> &nodes) { portNodes = nodes; }
+    // TUN 模式冗余 UDP 的主 / 副路径节点（为空则不启用）
+    void setRedundantNodes(const QList<EWPNode> &nodes) { redundantNodes = nodes; }
     void stop();
     bool isRunning() const;
     
     QString getListenAddr() const { return listenAddr; }
     QString getLastError() const { return lastError; }
-
-    static constexpr int kMaxRetries = 3;
+    // 核心控制接口（退出、实时连接表），核心未输出 CONTROL_ADDR 时为空
+    ControlEndpoint getControl() const { return control; }
+    // 解析一段核心 stdout：CONTROL_TOKEN / CONTROL_ADDR 写入 endpoint（地址变化时置 addrChanged），
+    // 返回要转发的日志行（令牌行不进日志）
+    static QStringList parseStdout(const QByteArray &data, ControlEndpoint *endpoint, bool *addrChanged);
+    // 核心进程 PID，未运行或经 UAC 提权启动（拿不到 QProcess）时为 0
+    qint64 getProcessId() const { return process ? process->processId() : 0; }
+    // 最近一次启动生成的核心配置（含凭据，导出前需脱敏）
+    QJsonObject getLastConfig() const { return lastConfig; }
+    // 监护统计：故障次数、重启次数与 MTTR
+    const CoreSupervisor::Stats &supervisorStats() const { return supervisor->stats(); }
 
 signals:
     void started();
     void stopped();
     void errorOccurred(const QString &error);
     void logReceived(const QString &message);
-    void reconnecting(int attempt, int maxAttempts);
-    void reconnectFailed();
+    void reconnecting(int attempt, int delaySec);
+    void circuitOpened(int cooldownSec);    // 连续重启无效，暂停自动重启
+    void recovered(qint64 downtimeMs);
+    void controlChanged(const ControlEndpoint &control);
 
 private slots:
     void onProcessStarted();
@@ -39,27 +60,33 @@ private slots:
     void onProcessError(QProcess::ProcessError error);
     void onReadyReadStandardOutput();
     void onReadyReadStandardError();
-    void attemptReconnect();
+    void attemptReconnect(const QString &reason);
 
 private:
-    bool startCore(const EWPNode &node, bool tunMode);
-    QString generateConfigFile(const EWPNode &node, bool tunMode);
+    bool startCore(const QList<EWPNode> &nodes, const QString &groupType, bool tunMode, const QString &strategy);
+    QString generateConfigFile(const QList<EWPNode> &nodes, const QString &groupType, bool tunMode,
+                               const QString &strategy);
     QString findCoreExecutable();
     void sendQuitRequest();
-    void scheduleReconnect();
+    void processStdout(const QByteArray &data);   // parseStdout 后更新控制接口并逐行转发日志
 
     QProcess *process = nullptr;
     QNetworkAccessManager *networkManager = nullptr;
-    QTimer *retryTimer = nullptr;
+    CoreSupervisor *supervisor = nullptr;
     QString coreExecutable;
     QString listenAddr = "127.0.0.1:1080";
-    QString controlAddr;
+    ControlEndpoint control;
     QString lastError;
+    QString lastOutputLine;            // 核心最后一行输出，放弃重启时附在错误信息后
     QString configFilePath;
+    QJsonObject lastConfig;
     bool gracefulStop = false;
-    int retryCount = 0;
-    EWPNode lastNode;
+    QList<EWPNode> lastNodes;
+    QString lastGroupType;             // 空 = 单节点
+    QString lastGroupStrategy;
     bool lastTunMode = false;
+    QList<EWPNode> portNodes;
+    QList<EWPNode> redundantNodes;
 
 #ifdef Q_OS_WIN
     bool startElevatedCore(const QStringList &args);
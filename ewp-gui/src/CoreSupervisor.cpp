@@ -0,0 +1,269 @@
+#include "CoreSupervisor.h"
+#include <QNetworkProxy>
+#include <QNetworkReply>
+#include <QNetworkRequest>
+#include <QRandomGenerator>
+#include <QUrlQuery>
+#include <algorithm>
+
+namespace {
+const char *kCanaryUrl = "http://www.gstatic.com/generate_204";
+}
+
+QJsonObject CoreSupervisor::Stats::toJson() const
+{
+    QJsonObject obj;
+    obj["outages"] = outages;
+    obj["restarts"] = restarts;
+    obj["recoveries"] = recoveries;
+    obj["mttr_ms"] = meanRecoveryMs();
+    obj["last_recovery_ms"] = lastRecoveryMs;
+    obj["max_recovery_ms"] = maxRecoveryMs;
+    return obj;
+}
+
+CoreSupervisor::CoreSupervisor(QObject *parent)
+    : QObject(parent)
+    , controlNetwork(new QNetworkAccessManager(this))
+    , canaryNetwork(new QNetworkAccessManager(this))
+    , heartbeatTimer(new QTimer(this))
+    , canaryTimer(new QTimer(this))
+    , restartTimer(new QTimer(this))
+{
+    // 心跳直连回环地址，不受系统代理影响
+    controlNetwork->setProxy(QNetworkProxy::NoProxy);
+
+    heartbeatTimer->setInterval(kHeartbeatMs);
+    canaryTimer->setInterval(kCanaryMs);
+    restartTimer->setSingleShot(true);
+    connect(heartbeatTimer, &QTimer::timeout, this, &CoreSupervisor::heartbeat);
+    connect(canaryTimer, &QTimer::timeout, this, &CoreSupervisor::canary);
+    connect(restartTimer, &QTimer::timeout, this, [this]() {
+        statistics.restarts++;
+        emit restartRequested(pendingReason);
+    });
+}
+
+void CoreSupervisor::watch(const QString &listenAddr, bool tunMode, bool autoRestart)
+{
+    unwatch();
+    this->autoRestart = autoRestart;
+
+    // 与 QualityMonitor 相同：TUN 模式下本机流量本就经过隧道，否则走本地 mixed 入站
+    QNetworkProxy proxy(QNetworkProxy::NoProxy);
+    int sep = listenAddr.lastIndexOf(':');
+    if (!tunMode && sep > 0) {
+        QString host = listenAddr.left(sep);
+        if (host == "0.0.0.0" || host == "::" || host == "[::]") {
+            host = "127.0.0.1";
+        }
+        proxy = QNetworkProxy(QNetworkProxy::Socks5Proxy, host, listenAddr.mid(sep + 1).toUShort());
+    }
+    canaryNetwork->setProxy(proxy);
+
+    canaryTimer->start();
+    // 核心刚启动时给它一点时间建立连接；故障恢复中则尽快确认
+    QTimer::singleShot(inOutage() ? 1000 : 3000, this, [this, gen = generation]() {
+        if (gen == generation) {
+            canary();
+        }
+    });
+}
+
+void CoreSupervisor::setControl(const ControlEndpoint &endpoint)
+{
+    control = endpoint;
+    missedHeartbeats = 0;
+    if (control.isEmpty()) {
+        heartbeatTimer->stop();
+    } else {
+        heartbeatTimer->start();
+    }
+}
+
+void CoreSupervisor::unwatch()
+{
+    generation++;
+    heartbeatTimer->stop();
+    canaryTimer->stop();
+    heartbeatInFlight = false;
+    canaryInFlight = false;
+    missedHeartbeats = 0;
+    failedCanaries = 0;
+}
+
+void CoreSupervisor::reset()
+{
+    unwatch();
+    restartTimer->stop();
+    consecutiveFailures = 0;
+    breakerIsOpen = false;
+    outageClock.invalidate();
+}
+
+void CoreSupervisor::reportFailure(const QString &reason)
+{
+    unwatch();
+    fail(reason);
+}
+
+void CoreSupervisor::reportExit(int exitCode, const QString &reason)
+{
+    // 配置错误重启只会得到同样的结果；其余（包括刚启动就退出，如端口或 TUN 设备
+    // 尚未被上一个核心释放）照常退避重启，反复失败由熔断兜底
+    if (exitCode == kConfigExitCode) {
+        reset();
+        emit gaveUp(reason + "，配置错误或权限不足");
+        return;
+    }
+    reportFailure(reason);
+}
+
+void CoreSupervisor::heartbeat()
+{
+    if (control.isEmpty() || heartbeatInFlight) {
+        return;
+    }
+    heartbeatInFlight = true;
+
+    QNetworkRequest request = control.request("/health");
+    request.setTransferTimeout(kHeartbeatTimeoutMs);
+    QNetworkReply *reply = controlNetwork->get(request);
+    connect(reply, &QNetworkReply::finished, this, [this, reply, gen = generation]() {
+        reply->deleteLater();
+        if (gen != generation) {
+            return;
+        }
+        heartbeatInFlight = false;
+        if (reply->error() == QNetworkReply::NoError) {
+            missedHeartbeats = 0;
+            return;
+        }
+        if (++missedHeartbeats >= kMissedHeartbeats) {
+            unwatch();
+            fail(QString("控制接口连续 %1 次无心跳").arg(kMissedHeartbeats));
+        }
+    });
+}
+
+void CoreSupervisor::canary()
+{
+    if (canaryInFlight) {
+        return;
+    }
+    canaryInFlight = true;
+
+    QNetworkRequest request{QUrl(kCanaryUrl)};
+    request.setTransferTimeout(kCanaryTimeoutMs);
+    request.setAttribute(QNetworkRequest::CacheLoadControlAttribute, QNetworkRequest::AlwaysNetwork);
+    QNetworkReply *reply = canaryNetwork->head(request);
+    connect(reply, &QNetworkReply::finished, this, [this, reply, gen = generation]() {
+        reply->deleteLater();
+        if (gen != generation) {
+            return;
+        }
+        if (reply->error() == QNetworkReply::NoError) {
+            canaryInFlight = false;
+            failedCanaries = 0;
+            uplinkIsDown = false;
+            markHealthy();
+            return;
+        }
+        if (++failedCanaries < kCanaryFailures) {
+            canaryInFlight = false;
+            return;
+        }
+        // 直连探测完成前不发起新的金丝雀
+        checkDirect(QString("端到端探测连续 %1 次失败: %2").arg(failedCanaries).arg(reply->errorString()));
+    });
+}
+
+// 隧道不通时让核心绕过隧道直连金丝雀主机（TUN 模式下本进程的流量都会进隧道，只能由核心代劳）。
+// 直连返回 502 说明本机上行网络中断，重启核心无济于事；控制接口无响应或直连正常才重启
+void CoreSupervisor::checkDirect(const QString &reason)
+{
+    if (control.isEmpty()) {
+        unwatch();
+        fail(reason);
+        return;
+    }
+
+    QUrl canaryUrl(kCanaryUrl);
+    QUrlQuery query;
+    query.addQueryItem("addr", QString("%1:%2").arg(canaryUrl.host()).arg(canaryUrl.port(80)));
+    QNetworkRequest request = control.request("/probe/direct?" + query.toString(QUrl::FullyEncoded));
+    request.setTransferTimeout(kCanaryTimeoutMs);
+    QNetworkReply *reply = controlNetwork->get(request);
+    connect(reply, &QNetworkReply::finished, this, [this, reply, reason, gen = generation]() {
+        reply->deleteLater();
+        if (gen != generation) {
+            return;
+        }
+        canaryInFlight = false;
+        if (reply->attribute(QNetworkRequest::HttpStatusCodeAttribute).toInt() == 502) {
+            if (!uplinkIsDown) {
+                uplinkIsDown = true;
+                emit uplinkDown(QString::fromUtf8(reply->readAll()).trimmed());
+            }
+            return;
+        }
+        unwatch();
+        fail(reason);
+    });
+}
+
+void CoreSupervisor::fail(const QString &reason)
+{
+    if (restartTimer->isActive()) {
+        return;     // 已在等待重启
+    }
+    if (!autoRestart) {
+        // 重启需要用户交互（UAC 提权），无人值守时反复弹窗不可接受
+        reset();
+        emit gaveUp(reason + "，自动重启需要管理员授权");
+        return;
+    }
+    if (!inOutage()) {
+        outageClock.start();
+        statistics.outages++;
+    }
+    consecutiveFailures++;
+    pendingReason = reason;
+
+    if (consecutiveFailures > kBreakerThreshold) {
+        // 熔断：反复重启无效（多半是节点或网络本身的问题），暂停后再试探一次
+        breakerIsOpen = true;
+        consecutiveFailures = kBreakerThreshold;
+        emit breakerOpened(kBreakerThreshold, kBreakerCooldownMs);
+        restartTimer->start(kBreakerCooldownMs);
+        return;
+    }
+
+    int delay = backoffMs(consecutiveFailures);
+    emit restartScheduled(consecutiveFailures, delay, reason);
+    restartTimer->start(delay);
+}
+
+void CoreSupervisor::markHealthy()
+{
+    consecutiveFailures = 0;
+    breakerIsOpen = false;
+    if (!inOutage()) {
+        return;
+    }
+    qint64 downtime = outageClock.elapsed();
+    outageClock.invalidate();
+    statistics.recoveries++;
+    statistics.lastRecoveryMs = downtime;
+    statistics.maxRecoveryMs = std::max(statistics.maxRecoveryMs, downtime);
+    statistics.totalRecoveryMs += downtime;
+    emit recovered(downtime);
+}
+
+// 指数退避加“等量抖动”：取 [d/2, d) 间的随机值，避免多实例同时重连
+int CoreSupervisor::backoffMs(int attempt) const
+{
+    int exp = std::min(attempt - 1, 16);
+    int delay = static_cast<int>(std::min<qint64>(kMaxBackoffMs, qint64(kBaseBackoffMs) << exp));
+    return delay / 2 + QRandomGenerator::global()->bounded(delay / 2);
+}
@@ -0,0 +1,109 @@
+#pragma once
+
+#include <QObject>
+#include <QElapsedTimer>
+#include <QJsonObject>
+#include <QNetworkAccessManager>
+#include <QTimer>
+#include "ControlEndpoint.h"
+
+// 核心监护：不仅处理进程崩溃，也发现“进程还在但已卡死”的核心。
+//   - 心跳：每 2 秒 GET 控制接口 /health，连续 3 次无响应判定核心挂起
+//   - 金丝雀：每 15 秒经本地入站（TUN 模式直连）请求 generate_204，连续 3 次失败后
+//     再经控制接口 /probe/direct 绕过隧道直连同一主机：直连也不通是本机网络中断，
+//     重启无济于事，只上报 uplinkDown 并继续观察；直连正常才判定传输卡死
+//   - 重启：带抖动的指数退避（1 秒起，上限 60 秒）
+//   - 熔断：连续 5 次重启都没恢复则暂停 5 分钟，之后再试探一次
+//   - 放弃：配置错误（退出码 78）重启也无济于事；需要用户交互才能重启的核心
+//     （Windows 上经 UAC 提权）不自动重启。二者都上报 gaveUp
+// 从首次故障到金丝雀重新成功的时间计为一次恢复，用于统计 MTTR。
+class CoreSupervisor : public QObject
+{
+    Q_OBJECT
+
+public:
+    static constexpr int kHeartbeatMs = 2000;
+    static constexpr int kHeartbeatTimeoutMs = 1500;
+    static constexpr int kMissedHeartbeats = 3;
+    static constexpr int kCanaryMs = 15000;
+    static constexpr int kCanaryTimeoutMs = 8000;
+    static constexpr int kCanaryFailures = 3;
+    static constexpr int kBaseBackoffMs = 1000;
+    static constexpr int kMaxBackoffMs = 60000;
+    static constexpr int kBreakerThreshold = 5;
+    static constexpr int kBreakerCooldownMs = 5 * 60 * 1000;
+    static constexpr int kConfigExitCode = 78;   // 与核心的 exitConfig 一致
+
+    struct Stats {
+        int outages = 0;            // 故障次数（一次故障可能包含多次重启）
+        int restarts = 0;
+        int recoveries = 0;
+        qint64 lastRecoveryMs = -1;
+        qint64 maxRecoveryMs = 0;
+        qint64 totalRecoveryMs = 0;
+
+        qint64 meanRecoveryMs() const { return recoveries > 0 ? totalRecoveryMs / recoveries : -1; }
+        QJsonObject toJson() const;
+    };
+
+    explicit CoreSupervisor(QObject *parent = nullptr);
+
+    // 核心进程已启动：开始金丝雀探测。autoRestart 为 false 时故障不重启，只上报 gaveUp
+    void watch(const QString &listenAddr, bool tunMode, bool autoRestart = true);
+    // 控制接口就绪：开始心跳
+    void setControl(const ControlEndpoint &endpoint);
+    // 核心进程已退出（任何原因）：停止探测，保留故障 / 退避状态
+    void unwatch();
+    // 崩溃、启动失败等由调用方发现的故障
+    void reportFailure(const QString &reason);
+    // 核心进程非正常退出：配置错误（退出码 78）时放弃重启，否则同 reportFailure
+    void reportExit(int exitCode, const QString &reason);
+    // 用户主动停止：取消待执行的重启并结束当前故障
+    void reset();
+
+    bool inOutage() const { return outageClock.isValid(); }
+    bool breakerOpen() const { return breakerIsOpen; }
+    const Stats &stats() const { return statistics; }
+
+signals:
+    // 需要重启核心（此前已按退避 / 熔断等待）
+    void restartRequested(const QString &reason);
+    void restartScheduled(int attempt, int delayMs, const QString &reason);
+    void breakerOpened(int failures, int cooldownMs);
+    void recovered(qint64 downtimeMs);
+    // 重启无法解决的故障，已停止自动重启，需要用户处理
+    void gaveUp(const QString &reason);
+    // 隧道与直连同时不通：本机网络中断，暂不重启
+    void uplinkDown(const QString &reason);
+
+private slots:
+    void heartbeat();
+    void canary();
+
+private:
+    void checkDirect(const QString &reason);
+    void fail(const QString &reason);
+    void markHealthy();
+    int backoffMs(int attempt) const;
+
+    QNetworkAccessManager *controlNetwork;
+    QNetworkAccessManager *canaryNetwork;
+    QTimer *heartbeatTimer;
+    QTimer *canaryTimer;
+    QTimer *restartTimer;
+    ControlEndpoint control;
+    QString pendingReason;
+
+    int generation = 0;             // 每次 watch / unwatch 递增，丢弃过期回复
+    bool heartbeatInFlight = false;
+    bool canaryInFlight = false;
+    int missedHeartbeats = 0;
+    int failedCanaries = 0;
+    bool uplinkIsDown = false;
+    bool autoRestart = true;
+
+    int consecutiveFailures = 0;    // 自上次恢复以来的重启次数
+    bool breakerIsOpen = false;
+    QElapsedTimer outageClock;      // 无效表示当前健康
+    Stats statistics;
+};
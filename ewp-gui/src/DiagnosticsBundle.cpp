@@ -0,0 +1,116 @@
+#include "DiagnosticsBundle.h"
+#include <QFile>
+#include <QNetworkReply>
+#include <QNetworkRequest>
+#include <QUrl>
+
+namespace {
+
+// 写入一个 ustar 文件头（512 字节）与按 512 对齐的数据
+void appendTarEntry(QByteArray &tar, const QString &name, const QByteArray &data, qint64 mtime)
+{
+    QByteArray header(512, '\0');
+    auto put = [&header](int offset, int length, const QByteArray &value) {
+        header.replace(offset, qMin(value.size(), length), value.left(length));
+    };
+    auto octal = [](qint64 value, int width) {
+        return QByteArray::number(value, 8).rightJustified(width - 1, '0');
+    };
+
+    put(0, 100, name.toUtf8());
+    put(100, 8, octal(0644, 8));
+    put(108, 8, octal(0, 8));
+    put(116, 8, octal(0, 8));
+    put(124, 12, octal(data.size(), 12));
+    put(136, 12, octal(mtime, 12));
+    put(148, 8, QByteArray(8, ' '));    // 计算校验和时视为空格
+    header[156] = '0';
+    put(257, 6, QByteArray("ustar", 6));
+    put(263, 2, "00");
+
+    unsigned int sum = 0;
+    for (char c : header) {
+        sum += static_cast<unsigned char>(c);
+    }
+    put(148, 8, octal(sum, 7) + QByteArray("\0 ", 2));
+
+    tar += header;
+    tar += data;
+    if (data.size() % 512) {
+        tar += QByteArray(512 - data.size() % 512, '\0');
+    }
+}
+
+} // namespace
+
+DiagnosticsBundle::DiagnosticsBundle(QObject *parent)
+    : QObject(parent)
+    , network(new QNetworkAccessManager(this))
+    , createdAt(QDateTime::currentDateTime())
+{
+}
+
+void DiagnosticsBundle::addFile(const QString &name, const QByteArray &data)
+{
+    files.append({ name, data });
+}
+
+void DiagnosticsBundle::capture(const ControlEndpoint &control, int seconds, const QString &path)
+{
+    outputPath = path;
+    if (control.isEmpty()) {
+        addFile("profiles.error.txt", "核心未运行，未采集 profile\n");
+        writeArchive();
+        return;
+    }
+
+    // 带 seconds 的采集在服务端阻塞 N 秒，超时留出余量
+    int timeoutMs = (seconds + 30) * 1000;
+    QString window = QString("seconds=%1").arg(seconds);
+    fetch(control, "/debug/pprof/profile?" + window, "cpu.pprof", timeoutMs);
+    fetch(control, "/debug/pprof/trace?" + window, "trace.out", timeoutMs);
+    fetch(control, "/debug/pprof/mutex?" + window, "mutex.pprof", timeoutMs);
+    fetch(control, "/debug/pprof/heap?gc=1", "heap.pprof", 30000);
+    fetch(control, "/debug/pprof/goroutine?debug=2", "goroutines.txt", 30000);
+    fetch(control, "/runtime", "runtime.json", 30000);
+    fetch(control, "/edges", "edges.json", 30000);
+}
+
+void DiagnosticsBundle::fetch(const ControlEndpoint &control, const QString &query, const QString &name, int timeoutMs)
+{
+    QNetworkRequest request = control.request(query);
+    request.setTransferTimeout(timeoutMs);
+    QNetworkReply *reply = network->get(request);
+    ++outstanding;
+
+    connect(reply, &QNetworkReply::finished, this, [this, reply, name]() {
+        reply->deleteLater();
+        if (reply->error() == QNetworkReply::NoError) {
+            addFile(name, reply->readAll());
+        } else {
+            addFile(name + ".error.txt", reply->errorString().toUtf8() + "\n" + reply->readAll());
+        }
+        if (--outstanding == 0) {
+            writeArchive();
+        }
+    });
+}
+
+void DiagnosticsBundle::writeArchive()
+{
+    QString dir = "ewp-diagnostics-" + createdAt.toString("yyyyMMdd-HHmmss") + "/";
+    qint64 mtime = createdAt.toSecsSinceEpoch();
+
+    QByteArray tar;
+    for (const auto &file : files) {
+        appendTarEntry(tar, dir + file.first, file.second, mtime);
+    }
+    tar += QByteArray(1024, '\0');      // 归档结束：两个空块
+
+    QFile out(outputPath);
+    if (!out.open(QIODevice::WriteOnly) || out.write(tar) != tar.size()) {
+        emit finished(false, QString("无法写入 %1: %2").arg(outputPath, out.errorString()));
+        return;
+    }
+    emit finished(true, outputPath);
+}
@@ -0,0 +1,37 @@
+#pragma once
+
+#include <QObject>
+#include <QDateTime>
+#include <QList>
+#include <QNetworkAccessManager>
+#include <QPair>
+#include "ControlEndpoint.h"
+
+// 诊断包：从运行中的核心控制接口采集 N 秒的 CPU / mutex profile 与执行 trace，
+// 以及 heap、goroutine 快照与服务器 IP 排名，连同调用方添加的配置、日志、统计数据写成一个 tar 文件。
+// 各项采集并行进行，单项失败时写入 <名称>.error.txt，不影响其他内容。
+class DiagnosticsBundle : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit DiagnosticsBundle(QObject *parent = nullptr);
+
+    void addFile(const QString &name, const QByteArray &data);
+
+    // control 为空（核心未运行）时只打包已添加的文件
+    void capture(const ControlEndpoint &control, int seconds, const QString &path);
+
+signals:
+    void finished(bool ok, const QString &message);
+
+private:
+    void fetch(const ControlEndpoint &control, const QString &query, const QString &name, int timeoutMs);
+    void writeArchive();
+
+    QNetworkAccessManager *network;
+    QList<QPair<QString, QByteArray>> files;
+    QString outputPath;
+    QDateTime createdAt;
+    int outstanding = 0;
+};
@@ -27,12 +27,20 @@ struct EWPNode {
     // Trojan 认证
     QString trojanPassword;
 
+    // Trojan 多路复用（smux）：多个连接共享一条隧道，省去重复的 TLS/传输握手
+    bool enableMux = false;
+    int muxConcurrency = 8;            // 每条隧道承载的最大流数
+
     // 传输协议: 0=WebSocket, 1=gRPC, 2=XHTTP, 3=H3gRPC, 4=MASQUE
     enum TransportMode { WS = 0, GRPC = 1, XHTTP = 2, H3GRPC = 3, MASQUE = 4 };
     TransportMode transportMode = WS;
 
+    // TCP Fast Open（仅 WS / gRPC / XHTTP）：TLS ClientHello 随 SYN 发送
+    bool tcpFastOpen = false;
+
     // WebSocket 配置
     QString wsPath = "/";
+    int wsEarlyData = 0;               // 早期数据上限（字节），0=关闭；首个请求随升级请求发送
 
     // gRPC / H3gRPC 配置
     QString grpcServiceName = "ProxyService";
@@ -68,6 +76,10 @@ struct EWPNode {
     // true  = Normal 模式：DNS 查询透传隧道；Full Cone NAT 仅依赖 PeerRegistry vIP。
     bool disableFakeIP = false;
 
+    // 独立本地端口：>0 时核心额外开放一个 mixed 入站，经此端口的流量固定走本节点
+    // （与当前运行的节点 / 出站组共用同一核心进程）。仅本地使用，不写入分享链接
+    int localPort = 0;
+
     // 测试结果
     int latency = 0;  // ms, -1=失败, 0=未测试
 
@@ -82,8 +94,12 @@ struct EWPNode {
         obj["appProtocol"] = static_cast<int>(appProtocol);
         obj["uuid"] = uuid;
         obj["trojanPassword"] = trojanPassword;
+        obj["enableMux"] = enableMux;
+        obj["muxConcurrency"] = muxConcurrency;
         obj["transportMode"] = static_cast<int>(transportMode);
+        obj["tcpFastOpen"] = tcpFastOpen;
         obj["wsPath"] = wsPath;
+        obj["wsEarlyData"] = wsEarlyData;
         obj["grpcServiceName"] = grpcServiceName;
         obj["userAgent"] = userAgent;
         obj["contentType"] = contentType;
@@ -100,6 +116,7 @@ struct EWPNode {
         obj["enableFlow"] = enableFlow;
         obj["useMozillaCA"] = useMozillaCA;
         obj["disableFakeIP"] = disableFakeIP;
+        obj["localPort"] = localPort;
         return obj;
     }
 
@@ -111,8 +128,12 @@ struct EWPNode {
         node.appProtocol = static_cast<AppProtocol>(obj["appProtocol"].toInt(0));
         node.uuid = obj["uuid"].toString();
         node.trojanPassword = obj["trojanPassword"].toString();
+        node.enableMux = obj["enableMux"].toBool(false);
+        node.muxConcurrency = obj["muxConcurrency"].toInt(8);
         node.transportMode = static_cast<TransportMode>(obj["transportMode"].toInt(0));
+        node.tcpFastOpen = obj["tcpFastOpen"].toBool(false);
         node.wsPath = obj["wsPath"].toString("/");
+        node.wsEarlyData = obj["wsEarlyData"].toInt(0);
         node.grpcServiceName = obj["grpcServiceName"].toString("ProxyService");
         node.userAgent = obj["userAgent"].toString();
         node.contentType = obj["contentType"].toString();
@@ -129,6 +150,7 @@ struct EWPNode {
         node.enableFlow = obj["enableFlow"].toBool(true);
         node.useMozillaCA = obj["useMozillaCA"].toBool(true);
         node.disableFakeIP = obj["disableFakeIP"].toBool(false);
+        node.localPort = obj["localPort"].toInt(0);
 
         // 新版 JSON 键：server / host
         // 兼容旧版 nodes.json：旧版 serverIP=连接目标, serverAddress=Host
@@ -0,0 +1,96 @@
+#include "EdgeMonitor.h"
+#include <QHash>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QNetworkRequest>
+
+EdgeMonitor::EdgeMonitor(QNetworkAccessManager *network, QObject *parent)
+    : QObject(parent)
+    , network(network)
+    , timer(new QTimer(this))
+{
+    timer->setInterval(kIntervalMs);
+    connect(timer, &QTimer::timeout, this, &EdgeMonitor::onTimeout);
+}
+
+void EdgeMonitor::setControl(const ControlEndpoint &endpoint)
+{
+    control = endpoint;
+    if (control.isEmpty()) {
+        timer->stop();
+        abortReply();
+        if (!current.isEmpty()) {
+            current.clear();
+            emit updated(current);
+        }
+    } else {
+        timer->start();
+        onTimeout();
+    }
+}
+
+void EdgeMonitor::abortReply()
+{
+    if (reply) {
+        QNetworkReply *r = reply;
+        reply = nullptr;
+        r->disconnect(this);
+        r->abort();
+        r->deleteLater();
+    }
+}
+
+void EdgeMonitor::onTimeout()
+{
+    if (reply || control.isEmpty()) {
+        return;
+    }
+    QNetworkRequest request = control.request("/edges");
+    request.setTransferTimeout(kIntervalMs / 2);
+    reply = network->get(request);
+    connect(reply, &QNetworkReply::finished, this, &EdgeMonitor::onFinished);
+}
+
+void EdgeMonitor::onFinished()
+{
+    QNetworkReply *r = reply;
+    reply = nullptr;
+    if (!r) {
+        return;
+    }
+    r->deleteLater();
+    if (r->error() != QNetworkReply::NoError) {
+        return;
+    }
+
+    QHash<QString, QString> before;     // host -> 此前选用的 IP
+    for (const Edge &e : current) {
+        if (e.selected) {
+            before[e.host] = e.ip;
+        }
+    }
+
+    QVector<Edge> edges;
+    for (const QJsonValue &v : QJsonDocument::fromJson(r->readAll()).array()) {
+        QJsonObject obj = v.toObject();
+        Edge e;
+        e.host = obj["host"].toString();
+        e.ip = obj["ip"].toString();
+        e.rttMs = obj["rtt_ms"].toDouble();
+        e.successes = static_cast<qint64>(obj["successes"].toDouble());
+        e.failures = static_cast<qint64>(obj["failures"].toDouble());
+        e.demoted = obj["demoted"].toBool();
+        e.selected = obj["selected"].toBool();
+        edges.append(e);
+    }
+    current = edges;
+
+    for (const Edge &e : current) {
+        QString from = before.value(e.host);
+        if (e.selected && !from.isEmpty() && from != e.ip) {
+            emit switched(e.host, from, e.ip);
+        }
+    }
+    emit updated(current);
+}
@@ -0,0 +1,52 @@
+#pragma once
+
+#include <QObject>
+#include <QNetworkAccessManager>
+#include <QNetworkReply>
+#include <QPointer>
+#include <QTimer>
+#include <QVector>
+#include "ControlEndpoint.h"
+
+// TUN 模式下核心旁路解析器对服务器各 IP（CDN 边缘）的排名：每 10 秒拉取控制接口 GET /edges，
+// 得到每个 IP 的 RTT 滚动均值、成功 / 失败次数、是否已降级、是否为新连接当前所用。
+// 非 TUN 模式核心返回空列表；控制地址为空时停止并清空。
+class EdgeMonitor : public QObject
+{
+    Q_OBJECT
+
+public:
+    struct Edge {
+        QString host;               // host:port
+        QString ip;
+        double rttMs = 0;           // 0 = 尚未测量
+        qint64 successes = 0;
+        qint64 failures = 0;
+        bool demoted = false;       // 连续失败，暂不选用
+        bool selected = false;
+    };
+
+    static constexpr int kIntervalMs = 10000;
+
+    explicit EdgeMonitor(QNetworkAccessManager *network, QObject *parent = nullptr);
+
+    void setControl(const ControlEndpoint &endpoint);
+    const QVector<Edge> &edges() const { return current; }
+
+signals:
+    void updated(const QVector<EdgeMonitor::Edge> &edges);
+    void switched(const QString &host, const QString &fromIp, const QString &toIp);
+
+private slots:
+    void onTimeout();
+    void onFinished();
+
+private:
+    void abortReply();
+
+    QNetworkAccessManager *network;
+    QPointer<QNetworkReply> reply;
+    QTimer *timer;
+    ControlEndpoint control;
+    QVector<Edge> current;
+};
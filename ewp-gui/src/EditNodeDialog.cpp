@@ -21,6 +21,8 @@ EditNodeDialog::EditNodeDialog(QWidget *parent)
             this, &EditNodeDialog::onEnableTLSToggled);
     connect(ui->btnGenerateUUID, &QPushButton::clicked,
             this, &EditNodeDialog::onGenerateUUID);
+    connect(ui->checkEnableMux, &QCheckBox::toggled,
+            ui->spinMuxConcurrency, &QSpinBox::setEnabled);
 
     updateVisibility();
 }
@@ -37,16 +39,21 @@ void EditNodeDialog::setNode(const EWPNode &node)
     ui->editName->setText(node.name);
     ui->editAddress->setText(node.server);
     ui->spinPort->setValue(node.serverPort);
+    ui->spinLocalPort->setValue(node.localPort);
 
     ui->comboProtocol->setCurrentIndex(static_cast<int>(node.appProtocol));
 
     ui->editUUID->setText(node.uuid);
     ui->editTrojanPassword->setText(node.trojanPassword);
+    ui->checkEnableMux->setChecked(node.enableMux);
+    ui->spinMuxConcurrency->setValue(node.muxConcurrency);
 
     ui->comboTransport->setCurrentIndex(static_cast<int>(node.transportMode));
     ui->editHost->setText(node.host);
+    ui->checkTcpFastOpen->setChecked(node.tcpFastOpen);
 
     ui->editWsPath->setText(node.wsPath);
+    ui->spinWsEarlyData->setValue(node.wsEarlyData);
 
     ui->editGrpcService->setText(node.grpcServiceName);
     ui->editUserAgent->setText(node.userAgent);
@@ -85,17 +92,22 @@ EWPNode EditNodeDialog::getNode() const
     node.name = ui->editName->text().trimmed();
     node.server = ui->editAddress->text().trimmed();
     node.serverPort = ui->spinPort->value();
+    node.localPort = ui->spinLocalPort->value();
     node.host = ui->editHost->text().trimmed();
 
     node.appProtocol = static_cast<EWPNode::AppProtocol>(ui->comboProtocol->currentIndex());
 
     node.uuid = ui->editUUID->text().trimmed();
     node.trojanPassword = ui->editTrojanPassword->text().trimmed();
+    node.enableMux = ui->checkEnableMux->isChecked();
+    node.muxConcurrency = ui->spinMuxConcurrency->value();
 
     node.transportMode = static_cast<EWPNode::TransportMode>(ui->comboTransport->currentIndex());
+    node.tcpFastOpen = ui->checkTcpFastOpen->isChecked();
 
     node.wsPath = ui->editWsPath->text().trimmed();
     if (node.wsPath.isEmpty()) node.wsPath = "/";
+    node.wsEarlyData = ui->spinWsEarlyData->value();
 
     node.grpcServiceName = ui->editGrpcService->text().trimmed();
     if (node.grpcServiceName.isEmpty()) node.grpcServiceName = "ProxyService";
@@ -186,6 +198,12 @@ void EditNodeDialog::updateVisibility()
     ui->editTrojanPassword->setVisible(isTrojan);
 
     ui->advancedGroup->setVisible(!isTrojan);
+    ui->trojanGroup->setVisible(isTrojan && mode != EWPNode::MASQUE);
+    ui->spinMuxConcurrency->setEnabled(ui->checkEnableMux->isChecked());
+
+    bool isTcpTransport = (mode == EWPNode::WS || mode == EWPNode::GRPC || mode == EWPNode::XHTTP);
+    ui->labelTcpFastOpen->setVisible(isTcpTransport);
+    ui->checkTcpFastOpen->setVisible(isTcpTransport);
 
     ui->wsGroup->setVisible(mode == EWPNode::WS);
     ui->grpcGroup->setVisible(mode == EWPNode::GRPC || mode == EWPNode::H3GRPC);
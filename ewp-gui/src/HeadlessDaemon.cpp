@@ -0,0 +1,128 @@
+#include "HeadlessDaemon.h"
+#include "CoreProcess.h"
+#include "NodeManager.h"
+#include "SettingsDialog.h"
+#include <QCoreApplication>
+#include <QTextStream>
+
+#ifdef Q_OS_UNIX
+#include <QSocketNotifier>
+#include <csignal>
+#include <sys/socket.h>
+#include <unistd.h>
+#elif defined(Q_OS_WIN)
+#include <Windows.h>
+#endif
+
+namespace {
+
+#ifdef Q_OS_UNIX
+// 自管道：信号处理函数只能调用 async-signal-safe 的 write，
+// 由 QSocketNotifier 在事件循环中读出后再退出
+int signalFds[2] = { -1, -1 };
+
+void onTerminationSignal(int)
+{
+    const char byte = 1;
+    (void)::write(signalFds[0], &byte, 1);
+}
+#elif defined(Q_OS_WIN)
+// 控制台处理函数运行在系统创建的线程中，排队回到主线程处理
+HeadlessDaemon *consoleDaemon = nullptr;
+
+BOOL WINAPI onConsoleCtrl(DWORD type)
+{
+    if (type != CTRL_C_EVENT && type != CTRL_BREAK_EVENT) {
+        return FALSE;
+    }
+    QMetaObject::invokeMethod(consoleDaemon, "terminate", Qt::QueuedConnection);
+    return TRUE;
+}
+#endif
+
+} // namespace
+
+HeadlessDaemon::HeadlessDaemon(bool tunMode, QObject *parent)
+    : QObject(parent)
+    , nodeManager(new NodeManager(this))
+    , coreProcess(new CoreProcess(this))
+    , tunMode(tunMode)
+{
+    connect(coreProcess, &CoreProcess::logReceived, this, [](const QString &line) {
+        QTextStream(stdout) << line << Qt::endl;
+    });
+    connect(coreProcess, &CoreProcess::errorOccurred, this, [](const QString &error) {
+        QTextStream(stderr) << "错误: " << error << Qt::endl;
+    });
+}
+
+HeadlessDaemon::~HeadlessDaemon()
+{
+    coreProcess->stop();
+}
+
+bool HeadlessDaemon::startNode(int nodeId, QString *error)
+{
+    EWPNode node = nodeManager->getNode(nodeId);
+    if (!node.isValid()) {
+        *error = QString("节点 %1 不存在或配置无效").arg(nodeId);
+        return false;
+    }
+    if (coreProcess->isRunning()) {
+        coreProcess->stop();
+    }
+
+    // 与桌面版一致：独立端口节点与冗余 UDP 设置同样生效
+    auto settings = SettingsDialog::loadFromRegistry();
+    coreProcess->setPortNodes(nodeManager->portMappedNodes());
+    coreProcess->setRedundantNodes(settings.redundantUDP
+        ? nodeManager->nodePair(settings.redundantPrimaryId, settings.redundantSecondaryId)
+        : QList<EWPNode>());
+
+    currentNodeId = nodeId;
+    if (!coreProcess->start(node, tunMode)) {
+        *error = coreProcess->getLastError();
+        return false;
+    }
+    return true;
+}
+
+void HeadlessDaemon::stopCore()
+{
+    coreProcess->stop();
+}
+
+bool HeadlessDaemon::watchTerminationSignals()
+{
+#ifdef Q_OS_UNIX
+    if (::socketpair(AF_UNIX, SOCK_STREAM, 0, signalFds) != 0) {
+        return false;
+    }
+    auto *notifier = new QSocketNotifier(signalFds[1], QSocketNotifier::Read, this);
+    connect(notifier, &QSocketNotifier::activated, this, [this, notifier]() {
+        notifier->setEnabled(false);
+        char byte;
+        (void)::read(signalFds[1], &byte, 1);
+        terminate();
+    });
+
+    struct sigaction action = {};
+    action.sa_handler = onTerminationSignal;
+    sigemptyset(&action.sa_mask);
+    action.sa_flags = SA_RESTART;
+    return ::sigaction(SIGTERM, &action, nullptr) == 0 && ::sigaction(SIGINT, &action, nullptr) == 0;
+#elif defined(Q_OS_WIN)
+    consoleDaemon = this;
+    return SetConsoleCtrlHandler(onConsoleCtrl, TRUE);
+#else
+    return false;
+#endif
+}
+
+void HeadlessDaemon::terminate()
+{
+    // 先在事件循环内停止核心（TUN 模式需恢复路由），再退出
+    QTextStream(stdout) << "收到终止信号，正在退出..." << Qt::endl;
+    stopCore();
+    QCoreApplication::quit();
+}
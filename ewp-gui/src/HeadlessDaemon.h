@@ -0,0 +1,37 @@
+#pragma once
+
+#include <QObject>
+#include "CommandServer.h"
+
+class NodeManager;
+class CoreProcess;
+
+// 无界面守护模式（EWP-GUI --headless）：运行在 QCoreApplication 上，不创建任何窗口，
+// 复用 NodeManager / CoreProcess，通过 CommandServer 的本地命令接口控制。
+// 日志直接写到标准输出；SIGTERM / SIGINT（Windows 为 Ctrl+C）时停止核心并退出事件循环。
+class HeadlessDaemon : public QObject, public CommandTarget
+{
+    Q_OBJECT
+
+public:
+    explicit HeadlessDaemon(bool tunMode, QObject *parent = nullptr);
+    ~HeadlessDaemon();
+
+    NodeManager *nodes() const override { return nodeManager; }
+    CoreProcess *core() const override { return coreProcess; }
+    bool startNode(int nodeId, QString *error) override;
+    void stopCore() override;
+    int activeNodeId() const override { return coreProcess->isRunning() ? currentNodeId : -1; }
+
+    // 安装终止信号处理，须在进入事件循环前调用；失败时返回 false
+    bool watchTerminationSignals();
+
+private slots:
+    void terminate();
+
+private:
+    NodeManager *nodeManager;
+    CoreProcess *coreProcess;
+    bool tunMode;
+    int currentNodeId = -1;
+};
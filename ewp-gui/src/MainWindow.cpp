@@ -3,17 +3,32 @@
 
 #include <QMessageBox>
 #include <QInputDialog>
+#include <QFileDialog>
+#include <QJsonDocument>
+#include <QStandardPaths>
 #include <QClipboard>
 #include <QCloseEvent>
 #include <QSettings>
 #include <QUuid>
 #include <QMenuBar>
 #include <QAction>
+#include <QDockWidget>
+#include <algorithm>
 
 #include "ShareLink.h"
 #include "NodeTester.h"
 #include "EditNodeDialog.h"
 #include "SettingsDialog.h"
+#include "QualityMonitor.h"
+#include "ConnectionsPanel.h"
+#include "ControlStream.h"
+#include "TrafficStore.h"
+#include "TrafficChart.h"
+#include "ConnectionsModel.h"
+#include "ResourceMonitor.h"
+#include "EdgeMonitor.h"
+#include "DiagnosticsBundle.h"
+#include "ConfigGenerator.h"
 
 MainWindow::MainWindow(QWidget *parent)
     : QMainWindow(parent)
@@ -22,15 +37,22 @@ MainWindow::MainWindow(QWidget *parent)
     ui->setupUi(this);
     
     setWindowTitle("EWP GUI");
+    // 日志保留最近 5000 行，诊断包导出这部分
+    ui->logBrowser->document()->setMaximumBlockCount(5000);
     
     // 初始化管理器
     coreProcess = new CoreProcess(this);
     nodeManager = new NodeManager(this);
     systemProxy = new SystemProxy(this);
+    qualityMonitor = new QualityMonitor(nodeManager, this);
     
     setupConnections();
     setupSystemTray();
     setupNodeTable();
+    setupConnectionsPanel();
+    setupTrafficPanel();
+    setupResourceMonitor();
+    setupEdgeMonitor();
     setupMenu();
     loadSettings();
     
@@ -55,9 +77,11 @@ void MainWindow::setupConnections()
         isRunning = true;
         appendLog("✅ 代理已启动");
         updateStatusBar();
+        startQualityMonitor();
     });
     
     connect(coreProcess, &CoreProcess::stopped, this, [this]() {
+        qualityMonitor->stop();
         isRunning = false;
         appendLog("⏹️ 代理已停止");
         updateStatusBar();
@@ -70,16 +94,38 @@ void MainWindow::setupConnections()
     
     connect(coreProcess, &CoreProcess::logReceived, this, &MainWindow::appendLog);
     
-    connect(coreProcess, &CoreProcess::reconnecting, this, [this](int attempt, int maxAttempts) {
-        ui->labelStatus->setText(QString("重连中... (%1/%2)").arg(attempt).arg(maxAttempts));
+    // 节点质量监控：测速结果刷新延迟列，持续劣化时提示并（按设置）自动切换
+    connect(qualityMonitor, &QualityMonitor::nodeMeasured, this, &MainWindow::updateNodeList);
+    connect(qualityMonitor, &QualityMonitor::degraded, this, [this](int nodeId, double score) {
+        appendLog(QString("⚠️ 节点质量下降: %1（端到端延迟 %2ms）")
+            .arg(nodeManager->getNode(nodeId).name)
+            .arg(qRound(score)));
+    });
+    connect(qualityMonitor, &QualityMonitor::switchRequested, this,
+            [this](int fromId, int toId, const QString &reason) {
+        if (!isRunning || fromId != currentNodeId || !groupNodeIds.isEmpty()) {
+            return;
+        }
+        QString from = nodeManager->getNode(fromId).name;
+        QString to = nodeManager->getNode(toId).name;
+        appendLog(QString("🔀 自动切换节点: %1 → %2（%3）").arg(from, to, reason));
+        if (trayIcon && trayIcon->isVisible()) {
+            trayIcon->showMessage("EWP GUI", QString("已自动切换到 %1\n%2").arg(to, reason),
+                                  QSystemTrayIcon::Information, 5000);
+        }
+        switchToNode(toId);
     });
     
-    connect(coreProcess, &CoreProcess::reconnectFailed, this, [this]() {
-        appendLog("❌ 自动重连失败，已达最大重试次数");
-        QMessageBox::warning(this, "重连失败", 
-            QString("核心进程已崩溃，自动重连 %1 次均失败，请检查节点配置后手动重启。")
-                .arg(CoreProcess::kMaxRetries));
-        updateStatusBar();
+    connect(coreProcess, &CoreProcess::reconnecting, this, [this](int attempt, int delaySec) {
+        ui->labelStatus->setText(QString("重启中... (第 %1 次，%2 秒后)").arg(attempt).arg(delaySec));
+    });
+    
+    connect(coreProcess, &CoreProcess::circuitOpened, this, [this](int cooldownSec) {
+        ui->labelStatus->setText(QString("自动重启已暂停 %1 分钟").arg(cooldownSec / 60));
+        if (trayIcon && trayIcon->isVisible()) {
+            trayIcon->showMessage("EWP GUI", "核心多次重启仍未恢复，已暂停自动重启，请检查节点或网络",
+                                  QSystemTrayIcon::Warning, 5000);
+        }
         updateNodeList();
     });
     
@@ -157,13 +203,149 @@ void MainWindow::setupNodeTable()
     ui->nodeTable->setColumnCount(5);
     ui->nodeTable->setHorizontalHeaderLabels({"类型", "地址", "名称", "延迟", "状态"});
     ui->nodeTable->setSelectionBehavior(QAbstractItemView::SelectRows);
-    ui->nodeTable->setSelectionMode(QAbstractItemView::SingleSelection);
+    // 多选用于以出站组（自动选择 / 故障转移）启动
+    ui->nodeTable->setSelectionMode(QAbstractItemView::ExtendedSelection);
     ui->nodeTable->setEditTriggers(QAbstractItemView::NoEditTriggers);
     ui->nodeTable->setAlternatingRowColors(true);
     ui->nodeTable->horizontalHeader()->setStretchLastSection(true);
     ui->nodeTable->verticalHeader()->setVisible(false);
 }
 
+void MainWindow::setupConnectionsPanel()
+{
+    // 实时连接表，默认隐藏，从「视图 > 连接」打开
+    connectionsPanel = new ConnectionsPanel(this);
+    connectionsDock = new QDockWidget("连接", this);
+    connectionsDock->setObjectName("connectionsDock");
+    connectionsDock->setWidget(connectionsPanel);
+    addDockWidget(Qt::BottomDockWidgetArea, connectionsDock);
+    connectionsDock->hide();
+    
+    connect(coreProcess, &CoreProcess::controlChanged,
+            connectionsPanel, &ConnectionsPanel::setControl);
+}
+
+void MainWindow::setupTrafficPanel()
+{
+    // 实时流量图，数据来自 GET /stats；样本常驻环形存储，托盘提示同步显示当前速率
+    trafficStore = new TrafficStore(this);
+    statsStream = new ControlStream("/stats", new QNetworkAccessManager(this), this);
+    
+    trafficDock = new QDockWidget("流量", this);
+    trafficDock->setObjectName("trafficDock");
+    trafficDock->setWidget(new TrafficChart(trafficStore, trafficDock));
+    addDockWidget(Qt::BottomDockWidgetArea, trafficDock);
+    tabifyDockWidget(trafficDock, connectionsDock);
+    trafficDock->raise();
+    
+    connect(coreProcess, &CoreProcess::controlChanged,
+            statsStream, &ControlStream::setControl);
+    connect(statsStream, &ControlStream::received, this, [this](const QJsonObject &obj) {
+        TrafficStore::Sample sample;
+        sample.time = static_cast<qint64>(obj["time"].toDouble());
+        sample.upRate = obj["up_rate"].toDouble();
+        sample.downRate = obj["down_rate"].toDouble();
+        sample.active = obj["active"].toDouble();
+        sample.setupMs = obj["setup_ms"].toDouble();
+        trafficStore->append(sample);
+        trayIcon->setToolTip(QString("EWP GUI\n↑ %1/s  ↓ %2/s")
+            .arg(ConnectionsModel::formatBytes(static_cast<qint64>(sample.upRate)))
+            .arg(ConnectionsModel::formatBytes(static_cast<qint64>(sample.downRate))));
+    });
+    connect(statsStream, &ControlStream::closed, this, [this]() {
+        trayIcon->setToolTip("EWP GUI");
+    });
+}
+
+void MainWindow::setupResourceMonitor()
+{
+    // 核心进程资源：状态栏显示最新样本，持续增长（疑似泄漏）时写日志并托盘提示
+    resourceMonitor = new ResourceMonitor(new QNetworkAccessManager(this), this);
+    
+    connect(coreProcess, &CoreProcess::started, this, [this]() {
+        resourceMonitor->setProcessId(coreProcess->getProcessId());
+    });
+    connect(coreProcess, &CoreProcess::stopped, this, [this]() {
+        resourceMonitor->setProcessId(0);
+        ui->labelResources->clear();
+        ui->labelResources->setToolTip(QString());
+    });
+    connect(coreProcess, &CoreProcess::controlChanged,
+            resourceMonitor, &ResourceMonitor::setControl);
+    
+    connect(resourceMonitor, &ResourceMonitor::sampled, this, [this](const ResourceMonitor::Sample &s) {
+        QStringList parts;
+        if (s.cpuPercent >= 0) {
+            parts << QString("CPU %1%").arg(s.cpuPercent, 0, 'f', 1);
+        }
+        if (s.rss >= 0) {
+            parts << QString("内存 %1").arg(ConnectionsModel::formatBytes(s.rss));
+        }
+        if (s.goroutines >= 0) {
+            parts << QString("协程 %1").arg(s.goroutines);
+        }
+        if (s.fds >= 0) {
+            parts << QString("fd %1").arg(s.fds);
+        }
+        ui->labelResources->setText(parts.join(" | "));
+        
+        QStringList details;
+        if (s.heapAlloc >= 0) {
+            details << QString("Go 堆: %1").arg(ConnectionsModel::formatBytes(s.heapAlloc));
+        }
+        if (s.lastPauseMs >= 0) {
+            details << QString("最近 GC 停顿: %1 ms").arg(s.lastPauseMs, 0, 'f', 2);
+        }
+        ui->labelResources->setToolTip(details.join("\n"));
+    });
+    connect(resourceMonitor, &ResourceMonitor::growthDetected, this,
+            [this](const QString &metric, const QString &detail) {
+        appendLog(QString("⚠️ 核心 %1 持续增长，疑似泄漏：%2").arg(metric, detail));
+        if (trayIcon && trayIcon->isVisible()) {
+            trayIcon->showMessage("EWP GUI", QString("核心 %1 持续增长\n%2").arg(metric, detail),
+                                  QSystemTrayIcon::Warning, 5000);
+        }
+    });
+}
+
+void MainWindow::setupEdgeMonitor()
+{
+    // TUN 模式下服务器各 IP 的排名：状态栏显示新连接所用的 IP 与 RTT，提示中列出全部 IP
+    edgeMonitor = new EdgeMonitor(new QNetworkAccessManager(this), this);
+    connect(coreProcess, &CoreProcess::controlChanged,
+            edgeMonitor, &EdgeMonitor::setControl);
+    
+    connect(edgeMonitor, &EdgeMonitor::updated, this, [this](const QVector<EdgeMonitor::Edge> &edges) {
+        QStringList parts;
+        QStringList details;
+        QString host;
+        for (const EdgeMonitor::Edge &e : edges) {
+            QString rtt = e.rttMs > 0 ? QString("%1 ms").arg(e.rttMs, 0, 'f', 0) : QString("未测");
+            if (e.selected) {
+                parts << QString("边缘 %1 %2").arg(e.ip, rtt);
+            }
+            if (e.host != host) {
+                host = e.host;
+                details << host;
+            }
+            QString line = QString("  %1  %2  成功 %3 / 失败 %4").arg(e.ip, rtt).arg(e.successes).arg(e.failures);
+            if (e.selected) {
+                line += "  [当前]";
+            }
+            if (e.demoted) {
+                line += "  [已降级]";
+            }
+            details << line;
+        }
+        ui->labelEdges->setText(parts.join(" | "));
+        ui->labelEdges->setToolTip(details.join("\n"));
+    });
+    connect(edgeMonitor, &EdgeMonitor::switched, this,
+            [this](const QString &host, const QString &fromIp, const QString &toIp) {
+        appendLog(QString("🔀 %1 切换边缘节点: %2 → %3").arg(host, fromIp, toIp));
+    });
+}
+
 void MainWindow::setupMenu()
 {
     QMenuBar *menuBar = new QMenuBar(this);
@@ -184,9 +366,25 @@ void MainWindow::setupMenu()
     connect(quitAction, &QAction::triggered, this, &QMainWindow::close);
     fileMenu->addAction(quitAction);
     
+    // 视图菜单
+    QMenu *viewMenu = menuBar->addMenu("视图(&V)");
+    QAction *connectionsAction = connectionsDock->toggleViewAction();
+    connectionsAction->setText("连接(&C)");
+    connectionsAction->setShortcut(QKeySequence("Ctrl+L"));
+    viewMenu->addAction(connectionsAction);
+    QAction *trafficAction = trafficDock->toggleViewAction();
+    trafficAction->setText("流量(&T)");
+    trafficAction->setShortcut(QKeySequence("Ctrl+T"));
+    viewMenu->addAction(trafficAction);
+    
     // 帮助菜单
     QMenu *helpMenu = menuBar->addMenu("帮助(&H)");
     
+    diagnosticsAction = new QAction("导出诊断包(&D)...", this);
+    connect(diagnosticsAction, &QAction::triggered, this, &MainWindow::onExportDiagnostics);
+    helpMenu->addAction(diagnosticsAction);
+    helpMenu->addSeparator();
+    
     QAction *aboutAction = new QAction("关于(&A)...", this);
     connect(aboutAction, &QAction::triggered, this, [this]() {
         QMessageBox::about(this, "关于 EWP GUI", 
@@ -195,9 +393,61 @@ void MainWindow::setupMenu()
     helpMenu->addAction(aboutAction);
 }
 
+void MainWindow::onExportDiagnostics()
+{
+    ControlEndpoint control = coreProcess->getControl();
+    int seconds = 0;
+    if (!control.isEmpty()) {
+        bool ok = false;
+        seconds = QInputDialog::getInt(this, "导出诊断包",
+            "采集 CPU / mutex profile 与执行 trace 的时长（秒）：", 10, 1, 120, 1, &ok);
+        if (!ok) {
+            return;
+        }
+    }
+    
+    QString defaultPath = QStandardPaths::writableLocation(QStandardPaths::DesktopLocation)
+        + QString("/ewp-diagnostics-%1.tar").arg(QDateTime::currentDateTime().toString("yyyyMMdd-HHmmss"));
+    QString path = QFileDialog::getSaveFileName(this, "导出诊断包", defaultPath, "tar 归档 (*.tar)");
+    if (path.isEmpty()) {
+        return;
+    }
+    
+    // 配置脱敏；日志、流量与资源样本在采集开始时快照
+    auto *bundle = new DiagnosticsBundle(this);
+    QJsonObject config = coreProcess->getLastConfig();
+    if (!config.isEmpty()) {
+        bundle->addFile("config.json", QJsonDocument(ConfigGenerator::redactConfig(config)).toJson());
+    }
+    bundle->addFile("gui.log", ui->logBrowser->toPlainText().toUtf8());
+    bundle->addFile("stats-1s.csv", trafficStore->toCsv(TrafficStore::Seconds));
+    bundle->addFile("stats-10s.csv", trafficStore->toCsv(TrafficStore::TenSeconds));
+    bundle->addFile("stats-1m.csv", trafficStore->toCsv(TrafficStore::Minutes));
+    bundle->addFile("resources.csv", resourceMonitor->toCsv());
+    bundle->addFile("supervisor.json", QJsonDocument(coreProcess->supervisorStats().toJson()).toJson());
+    
+    diagnosticsAction->setEnabled(false);
+    connect(bundle, &DiagnosticsBundle::finished, this, [this, bundle](bool ok, const QString &message) {
+        diagnosticsAction->setEnabled(true);
+        bundle->deleteLater();
+        if (ok) {
+            appendLog("🩺 诊断包已导出: " + message);
+        } else {
+            appendLog("❌ 诊断包导出失败: " + message);
+            QMessageBox::warning(this, "导出诊断包", message);
+        }
+    });
+    
+    if (!control.isEmpty()) {
+        appendLog(QString("🩺 正在采集诊断信息（%1 秒）...").arg(seconds));
+    }
+    bundle->capture(control, seconds, path);
+}
+
 void MainWindow::onShowSettings()
 {
     SettingsDialog dialog(this);
+    dialog.setNodes(nodeManager->getAllNodes());
     if (dialog.exec() == QDialog::Accepted) {
         appendLog("⚙️ 设置已保存");
         // 重新加载CoreProcess配置
@@ -219,14 +469,19 @@ void MainWindow::updateNodeList()
         ui->nodeTable->setItem(i, 2, new QTableWidgetItem(node.name));
         ui->nodeTable->setItem(i, 3, new QTableWidgetItem(node.displayLatency()));
         
-        QString status = (node.id == currentNodeId && isRunning) ? "运行中" : "";
+        bool active = isRunning && isActiveNode(node.id);
+        QString status = active ? (groupNodeIds.isEmpty() ? "运行中" : "组成员") : "";
+        if (isRunning && node.localPort > 0 && !ui->checkTunMode->isChecked()) {
+            QString port = QString("端口 %1").arg(node.localPort);
+            status = status.isEmpty() ? port : status + " · " + port;
+        }
         ui->nodeTable->setItem(i, 4, new QTableWidgetItem(status));
         
         // 存储节点 ID
         ui->nodeTable->item(i, 0)->setData(Qt::UserRole, node.id);
         
         // 高亮当前运行的节点
-        if (node.id == currentNodeId && isRunning) {
+        if (active) {
             for (int j = 0; j < 5; ++j) {
                 ui->nodeTable->item(i, j)->setBackground(QColor(200, 255, 200));
             }
@@ -239,9 +494,14 @@ void MainWindow::updateNodeList()
 void MainWindow::updateStatusBar()
 {
     if (isRunning) {
-        auto node = nodeManager->getNode(currentNodeId);
+        QString name = nodeManager->getNode(currentNodeId).name;
+        if (!groupNodeIds.isEmpty()) {
+            name = QString("%1 (%2 个节点)")
+                .arg(groupDisplayName())
+                .arg(groupNodeIds.size());
+        }
         ui->labelStatus->setText(QString("运行中: %1 | 监听: %2")
-            .arg(node.name)
+            .arg(name)
             .arg(coreProcess->getListenAddr()));
         ui->btnStartStop->setText("停止");
     } else {
@@ -418,8 +678,11 @@ void MainWindow::onStartStop()
         }
         
         currentNodeId = nodeId;
+        groupNodeIds.clear();
         bool tunMode = ui->checkTunMode->isChecked();
         
+        coreProcess->setPortNodes(nodeManager->portMappedNodes());
+        coreProcess->setRedundantNodes(redundantUDPNodes());
         if (coreProcess->start(node, tunMode)) {
             if (ui->checkSystemProxy->isChecked() && !tunMode) {
                 systemProxy->enable(coreProcess->getListenAddr());
@@ -430,6 +693,32 @@ void MainWindow::onStartStop()
     updateNodeList();
 }
 
+bool MainWindow::startNode(int nodeId, QString *error)
+{
+    if (!nodeManager->getNode(nodeId).isValid()) {
+        *error = QString("节点 %1 不存在或配置无效").arg(nodeId);
+        return false;
+    }
+    switchToNode(nodeId);
+    if (!coreProcess->isRunning()) {
+        *error = coreProcess->getLastError();
+        return false;
+    }
+    return true;
+}
+
+void MainWindow::stopCore()
+{
+    if (isRunning) {
+        onStartStop();
+    }
+}
+
+int MainWindow::activeNodeId() const
+{
+    return isRunning && groupNodeIds.isEmpty() ? currentNodeId : -1;
+}
+
 void MainWindow::onNodeDoubleClicked(int row, int column)
 {
     Q_UNUSED(column)
@@ -437,11 +726,16 @@ void MainWindow::onNodeDoubleClicked(int row, int column)
     int nodeId = ui->nodeTable->item(row, 0)->data(Qt::UserRole).toInt();
     
     // 如果双击的是当前运行的节点，则停止
-    if (isRunning && nodeId == currentNodeId) {
+    if (isRunning && nodeId == currentNodeId && groupNodeIds.isEmpty()) {
         onStartStop();
         return;
     }
     
+    switchToNode(nodeId);
+}
+
+void MainWindow::switchToNode(int nodeId)
+{
     // 如果正在运行其他节点，先停止再切换（isRunning 由 stopped 信号更新）
     if (isRunning) {
         appendLog("🔄 切换节点...");
@@ -453,6 +747,7 @@ void MainWindow::onNodeDoubleClicked(int row, int column)
     
     // 启动新节点
     currentNodeId = nodeId;
+    groupNodeIds.clear();
     auto node = nodeManager->getNode(nodeId);
     
     if (!node.isValid()) {
@@ -462,6 +757,8 @@ void MainWindow::onNodeDoubleClicked(int row, int column)
     
     bool tunMode = ui->checkTunMode->isChecked();
     
+    coreProcess->setPortNodes(nodeManager->portMappedNodes());
+    coreProcess->setRedundantNodes(redundantUDPNodes());
     if (coreProcess->start(node, tunMode)) {
         if (ui->checkSystemProxy->isChecked() && !tunMode) {
             systemProxy->enable(coreProcess->getListenAddr());
@@ -471,6 +768,115 @@ void MainWindow::onNodeDoubleClicked(int row, int column)
     updateNodeList();
 }
 
+void MainWindow::onStartGroup(const QString &type, const QString &strategy)
+{
+    QList<int> ids = selectedNodeIds();
+    if (ids.size() < 2) {
+        QMessageBox::warning(this, "启动失败", "请至少选择两个节点");
+        return;
+    }
+    
+    QList<EWPNode> nodes;
+    for (int id : ids) {
+        auto node = nodeManager->getNode(id);
+        if (!node.isValid()) {
+            QMessageBox::warning(this, "启动失败", QString("节点配置无效: %1").arg(node.name));
+            return;
+        }
+        nodes.append(node);
+    }
+    
+    if (isRunning) {
+        appendLog("🔄 切换到出站组...");
+        coreProcess->stop();
+        if (ui->checkSystemProxy->isChecked()) {
+            systemProxy->disable();
+        }
+    }
+    
+    // 核心在后台探测各成员，故障时数秒内自动切换，无需 GUI 介入
+    currentNodeId = ids.first();
+    groupNodeIds = ids;
+    groupType = type;
+    groupStrategy = strategy;
+    bool tunMode = ui->checkTunMode->isChecked();
+    
+    coreProcess->setPortNodes(nodeManager->portMappedNodes());
+    coreProcess->setRedundantNodes(redundantUDPNodes());
+    if (coreProcess->startGroup(nodes, type, tunMode, strategy)) {
+        appendLog(QString("✅ 以%1启动，共 %2 个节点")
+            .arg(groupDisplayName())
+            .arg(nodes.size()));
+        if (ui->checkSystemProxy->isChecked() && !tunMode) {
+            systemProxy->enable(coreProcess->getListenAddr());
+        }
+    }
+    
+    updateNodeList();
+}
+
+void MainWindow::startQualityMonitor()
+{
+    // 出站组由核心自行探测切换，这里只监控单节点运行
+    auto settings = SettingsDialog::loadFromRegistry();
+    if (!settings.monitorEnabled || !groupNodeIds.isEmpty() || currentNodeId < 0) {
+        return;
+    }
+    QualityMonitor::Thresholds thresholds;
+    thresholds.intervalSec = settings.monitorInterval;
+    thresholds.latencyMs = settings.monitorLatency;
+    thresholds.badSamples = settings.monitorBadSamples;
+    thresholds.autoSwitch = settings.monitorAutoSwitch;
+    qualityMonitor->start(currentNodeId, coreProcess->getListenAddr(), ui->checkTunMode->isChecked(), thresholds);
+}
+
+QList<EWPNode> MainWindow::redundantUDPNodes() const
+{
+    auto settings = SettingsDialog::loadFromRegistry();
+    if (!settings.redundantUDP) {
+        return {};
+    }
+    return nodeManager->nodePair(settings.redundantPrimaryId, settings.redundantSecondaryId);
+}
+
+QString MainWindow::groupDisplayName() const
+{
+    if (groupType == "fallback") {
+        return "故障转移组";
+    }
+    if (groupType == "balancer") {
+        if (groupStrategy == "round-robin") {
+            return "负载均衡组（加权轮询）";
+        }
+        if (groupStrategy == "consistent-hash") {
+            return "负载均衡组（按目标保持）";
+        }
+        return "负载均衡组（最少连接）";
+    }
+    return "自动选择组";
+}
+
+QList<int> MainWindow::selectedNodeIds() const
+{
+    // 按表格顺序返回，fallback 组按此顺序决定优先级
+    QList<int> rows;
+    for (const auto &index : ui->nodeTable->selectionModel()->selectedRows()) {
+        rows.append(index.row());
+    }
+    std::sort(rows.begin(), rows.end());
+    
+    QList<int> ids;
+    for (int row : rows) {
+        ids.append(ui->nodeTable->item(row, 0)->data(Qt::UserRole).toInt());
+    }
+    return ids;
+}
+
+bool MainWindow::isActiveNode(int nodeId) const
+{
+    return groupNodeIds.isEmpty() ? nodeId == currentNodeId : groupNodeIds.contains(nodeId);
+}
+
 void MainWindow::onSystemProxyToggled(bool checked)
 {
     if (isRunning && !ui->checkTunMode->isChecked()) {
@@ -506,6 +912,18 @@ void MainWindow::showNodeContextMenu(const QPoint &pos)
     
     menu.addAction("添加节点", this, &MainWindow::onAddNode);
     
+    if (ui->nodeTable->selectionModel()->selectedRows().size() >= 2) {
+        menu.addAction("以自动选择组启动（按延迟）", this, [this]() { onStartGroup("urltest"); });
+        menu.addAction("以故障转移组启动（按顺序）", this, [this]() { onStartGroup("fallback"); });
+        QMenu *balancerMenu = menu.addMenu("以负载均衡组启动");
+        balancerMenu->addAction("最少连接（多线程下载）", this, [this]() { onStartGroup("balancer", "least-conn"); });
+        balancerMenu->addAction("加权轮询", this, [this]() { onStartGroup("balancer", "round-robin"); });
+        balancerMenu->addAction("按目标保持（同一站点固定节点）", this, [this]() {
+            onStartGroup("balancer", "consistent-hash");
+        });
+        menu.addSeparator();
+    }
+    
     if (ui->nodeTable->currentRow() >= 0) {
         menu.addAction("编辑节点", this, &MainWindow::onEditNode);
         menu.addAction("删除节点", this, &MainWindow::onDeleteNode);
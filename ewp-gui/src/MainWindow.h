@@ -13,12 +13,21 @@
 #include "CoreProcess.h"
 #include "NodeManager.h"
 #include "SystemProxy.h"
+#include "CommandServer.h"
+
+class QualityMonitor;
+class ConnectionsPanel;
+class ControlStream;
+class TrafficStore;
+class ResourceMonitor;
+class EdgeMonitor;
+class QDockWidget;
 
 QT_BEGIN_NAMESPACE
 namespace Ui { class MainWindow; }
 QT_END_NAMESPACE
 
-class MainWindow : public QMainWindow
+class MainWindow : public QMainWindow, public CommandTarget
 {
     Q_OBJECT
 
@@ -26,6 +35,14 @@ public:
     MainWindow(QWidget *parent = nullptr);
     ~MainWindow();
 
+    // CommandTarget：本地命令接口与界面操作走同一路径
+    NodeManager *nodes() const override { return nodeManager; }
+    CoreProcess *core() const override { return coreProcess; }
+    bool startNode(int nodeId, QString *error) override;
+    void stopCore() override;
+    int activeNodeId() const override;
+    void nodesUpdated() override { updateNodeList(); }
+
 private slots:
     void onAddNode();
     void onEditNode();
@@ -40,11 +57,13 @@ private slots:
     
     void onStartStop();
     void onNodeDoubleClicked(int row, int column);
+    void onStartGroup(const QString &type, const QString &strategy = QString());
     
     void onSystemProxyToggled(bool checked);
     void onTunModeToggled(bool checked);
     
     void onShowSettings();
+    void onExportDiagnostics();
     
     void updateNodeList();
     void updateStatusBar();
@@ -61,18 +80,40 @@ private:
     void setupSystemTray();
     void setupNodeTable();
     void setupMenu();
+    void setupConnectionsPanel();
+    void setupTrafficPanel();
+    void setupResourceMonitor();
+    void setupEdgeMonitor();
     void loadSettings();
     void saveSettings();
+    QList<int> selectedNodeIds() const;
+    bool isActiveNode(int nodeId) const;
+    QString groupDisplayName() const;
+    QList<EWPNode> redundantUDPNodes() const;
+    void switchToNode(int nodeId);
+    void startQualityMonitor();
     
     Ui::MainWindow *ui;
     
     CoreProcess *coreProcess;
     NodeManager *nodeManager;
     SystemProxy *systemProxy;
+    QualityMonitor *qualityMonitor;
+    ConnectionsPanel *connectionsPanel;
+    QDockWidget *connectionsDock;
+    ControlStream *statsStream;
+    TrafficStore *trafficStore;
+    QDockWidget *trafficDock;
+    ResourceMonitor *resourceMonitor;
+    EdgeMonitor *edgeMonitor;
+    QAction *diagnosticsAction;
     
     QSystemTrayIcon *trayIcon;
     QMenu *trayMenu;
     
     int currentNodeId = -1;
+    QList<int> groupNodeIds;           // 以出站组运行时的成员节点，空 = 单节点
+    QString groupType;
+    QString groupStrategy;             // balancer 策略
     bool isRunning = false;
 };
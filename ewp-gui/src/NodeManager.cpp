@@ -72,6 +72,30 @@ EWPNode NodeManager::getNode(int id) const
     return EWPNode();
 }
 
+QList<EWPNode> NodeManager::portMappedNodes() const
+{
+    QList<EWPNode> result;
+    for (const auto &node : nodes) {
+        if (node.localPort > 0 && node.isValid()) {
+            result.append(node);
+        }
+    }
+    return result;
+}
+
+QList<EWPNode> NodeManager::nodePair(int primaryId, int secondaryId) const
+{
+    if (primaryId == secondaryId) {
+        return {};
+    }
+    EWPNode primary = getNode(primaryId);
+    EWPNode secondary = getNode(secondaryId);
+    if (!primary.isValid() || !secondary.isValid()) {
+        return {};
+    }
+    return {primary, secondary};
+}
+
 void NodeManager::save()
 {
     QJsonArray arr;
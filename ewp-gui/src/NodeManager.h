@@ -20,6 +20,10 @@ public:
     EWPNode getNode(int id) const;
     QList<EWPNode> getAllNodes() const { return nodes; }
     int getNodeCount() const { return nodes.size(); }
+    // 设置了独立本地端口的有效节点（随主节点在同一核心内开放）
+    QList<EWPNode> portMappedNodes() const;
+    // 冗余 UDP 主 / 副节点；两者相同或任一无效时为空
+    QList<EWPNode> nodePair(int primaryId, int secondaryId) const;
     
     void save();
     void load();
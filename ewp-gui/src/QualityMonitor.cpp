@@ -0,0 +1,211 @@
+#include "QualityMonitor.h"
+#include "NodeTester.h"
+#include <QNetworkProxy>
+#include <QNetworkReply>
+#include <QNetworkRequest>
+#include <QPointer>
+#include <algorithm>
+#include <memory>
+
+namespace {
+constexpr double kAlpha = 0.3;  // EWMA 权重：约 3 个样本后跟上变化
+const char *kProbeUrl = "http://www.gstatic.com/generate_204";
+}
+
+void QualityMonitor::Rolling::add(int latency, int badThreshold)
+{
+    lastFailed = latency < 0;
+    double sample = lastFailed ? kFailPenaltyMs : latency;
+    ewma = ewma < 0 ? sample : kAlpha * sample + (1 - kAlpha) * ewma;
+    if (latency < 0 || latency > badThreshold) {
+        consecutiveBad++;
+    } else {
+        consecutiveBad = 0;
+    }
+}
+
+QualityMonitor::QualityMonitor(NodeManager *nodeManager, QObject *parent)
+    : QObject(parent)
+    , nodeManager(nodeManager)
+    , network(new QNetworkAccessManager(this))
+    , timer(new QTimer(this))
+{
+    connect(timer, &QTimer::timeout, this, &QualityMonitor::probe);
+}
+
+void QualityMonitor::start(int nodeId, const QString &proxyAddr, bool tunMode, const Thresholds &thresholds)
+{
+    stop();
+    activeNodeId = nodeId;
+    this->proxyAddr = proxyAddr;
+    this->tunMode = tunMode;
+    this->thresholds = thresholds;
+
+    // TUN 模式下本机流量本就经过隧道；否则经本地 mixed 入站的 SOCKS5 发出
+    QNetworkProxy proxy(QNetworkProxy::NoProxy);
+    int sep = proxyAddr.lastIndexOf(':');
+    if (!tunMode && sep > 0) {
+        QString host = proxyAddr.left(sep);
+        if (host == "0.0.0.0" || host == "::" || host == "[::]") {
+            host = "127.0.0.1";
+        }
+        proxy = QNetworkProxy(QNetworkProxy::Socks5Proxy, host, proxyAddr.mid(sep + 1).toUShort());
+    }
+    network->setProxy(proxy);
+
+    timer->start(std::max(5, thresholds.intervalSec) * 1000);
+    // 核心刚启动时给它一点时间建立连接池
+    QTimer::singleShot(3000, this, [this, gen = generation]() {
+        if (gen == generation) {
+            probe();
+        }
+    });
+}
+
+void QualityMonitor::stop()
+{
+    timer->stop();
+    generation++;
+    activeNodeId = -1;
+    tunnelInFlight = false;
+    tunnel = Rolling();
+    reportedDegraded = false;
+}
+
+double QualityMonitor::score(int nodeId) const
+{
+    auto it = direct.constFind(nodeId);
+    return it == direct.constEnd() ? -1 : it->ewma;
+}
+
+void QualityMonitor::probe()
+{
+    if (activeNodeId < 0) {
+        return;
+    }
+    probeTunnel();
+    probeDirect(activeNodeId);
+    for (int id : shortlist()) {
+        probeDirect(id);
+    }
+}
+
+void QualityMonitor::probeTunnel()
+{
+    if (tunnelInFlight) {
+        return;
+    }
+    tunnelInFlight = true;
+
+    QNetworkRequest request{QUrl(kProbeUrl)};
+    request.setTransferTimeout(kFailPenaltyMs);
+    request.setAttribute(QNetworkRequest::CacheLoadControlAttribute, QNetworkRequest::AlwaysNetwork);
+
+    auto elapsed = std::make_shared<QElapsedTimer>();
+    elapsed->start();
+    QNetworkReply *reply = network->head(request);
+    connect(reply, &QNetworkReply::finished, this, [this, reply, elapsed, gen = generation]() {
+        reply->deleteLater();
+        if (gen != generation) {
+            return;
+        }
+        tunnelInFlight = false;
+
+        int status = reply->attribute(QNetworkRequest::HttpStatusCodeAttribute).toInt();
+        int latency = reply->error() == QNetworkReply::NoError && status > 0 && status < 400
+            ? static_cast<int>(elapsed->elapsed()) : -1;
+        tunnel.add(latency, thresholds.latencyMs);
+        emit tunnelSampled(activeNodeId, latency, tunnel.ewma);
+        evaluate();
+    });
+}
+
+void QualityMonitor::probeDirect(int nodeId)
+{
+    EWPNode node = nodeManager->getNode(nodeId);
+    if (!node.isValid()) {
+        return;
+    }
+    QPointer<QualityMonitor> self(this);
+    NodeTester::testNode(node, [self, nodeId, gen = generation](int latency) {
+        if (!self || gen != self->generation) {
+            return;
+        }
+        // 隧道外测速与端到端延迟不可比，不套用 latencyMs：只有失败才算劣化
+        self->direct[nodeId].add(latency, kFailPenaltyMs);
+        self->nodeManager->updateLatency(nodeId, latency);
+        emit self->nodeMeasured(nodeId, latency);
+    });
+}
+
+QList<int> QualityMonitor::shortlist() const
+{
+    // 按已知评分（无评分时按上次测速）排序，取前 candidates 个
+    QList<EWPNode> nodes;
+    for (const auto &node : nodeManager->getAllNodes()) {
+        if (node.id != activeNodeId && node.isValid()) {
+            nodes.append(node);
+        }
+    }
+    auto rank = [this](const EWPNode &node) {
+        double s = score(node.id);
+        if (s < 0) {
+            s = node.latency > 0 ? node.latency : kFailPenaltyMs;
+        }
+        return s;
+    };
+    std::stable_sort(nodes.begin(), nodes.end(), [&](const EWPNode &a, const EWPNode &b) {
+        return rank(a) < rank(b);
+    });
+
+    QList<int> ids;
+    for (int i = 0; i < nodes.size() && i < thresholds.candidates; i++) {
+        ids.append(nodes[i].id);
+    }
+    return ids;
+}
+
+void QualityMonitor::evaluate()
+{
+    // 滞回：连续 badSamples 次劣化才进入劣化状态，EWMA 回落到阈值的 (1 - margin) 以下才退出
+    if (!reportedDegraded) {
+        if (tunnel.consecutiveBad < thresholds.badSamples) {
+            return;
+        }
+        reportedDegraded = true;
+        emit degraded(activeNodeId, tunnel.ewma);
+    } else if (tunnel.consecutiveBad == 0 && tunnel.ewma < thresholds.latencyMs * (1 - thresholds.margin)) {
+        reportedDegraded = false;
+        return;
+    }
+    if (!thresholds.autoSwitch) {
+        return;
+    }
+    if (sinceSwitch.isValid() && sinceSwitch.elapsed() < thresholds.cooldownSec * 1000LL) {
+        return;
+    }
+
+    // 劣化只由当前节点的端到端延迟判定；备选节点只在彼此之间按隧道外测速评分比较，
+    // 须已测过且最近一次测速成功
+    int best = -1;
+    double bestScore = 0;
+    for (int id : shortlist()) {
+        double s = score(id);
+        if (s < 0 || direct.value(id).consecutiveBad > 0) {
+            continue;
+        }
+        if (best < 0 || s < bestScore) {
+            best = id;
+            bestScore = s;
+        }
+    }
+    if (best < 0) {
+        return;
+    }
+
+    QString reason = tunnel.lastFailed
+        ? QString("连续 %1 次探测失败").arg(tunnel.consecutiveBad)
+        : QString("端到端延迟 %1ms 持续超过 %2ms").arg(qRound(tunnel.ewma)).arg(thresholds.latencyMs);
+    sinceSwitch.start();
+    emit switchRequested(activeNodeId, best, reason);
+}
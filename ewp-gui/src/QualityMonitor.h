@@ -0,0 +1,83 @@
+#pragma once
+
+#include <QObject>
+#include <QHash>
+#include <QElapsedTimer>
+#include <QTimer>
+#include <QNetworkAccessManager>
+#include "NodeManager.h"
+
+// 运行期间持续测量当前节点质量：
+// - 经本地代理（TUN 模式下直接经 TUN）请求探测 URL，得到端到端延迟，用于判断是否劣化
+// - 对当前节点及若干备选节点做 TCP 连接测速（隧道外），用于排序和刷新节点列表的延迟
+// 各项样本按 EWMA 滚动成评分，失败记为 kFailPenaltyMs。
+// 端到端延迟连续 badSamples 次超过阈值（或失败）即进入劣化状态，回落到阈值的 (1 - margin)
+// 以下才恢复；劣化期间在最近一次测速成功的备选节点中选 TCP 评分最低者发出 switchRequested
+// （两种延迟口径不同，阈值只用于当前节点），切换后 cooldownSec 内不再切换，避免来回抖动。
+class QualityMonitor : public QObject
+{
+    Q_OBJECT
+
+public:
+    struct Thresholds {
+        int intervalSec = 30;
+        int latencyMs = 800;        // 当前节点端到端延迟超过此值视为劣化
+        int badSamples = 3;         // 连续劣化次数
+        int cooldownSec = 300;      // 两次切换的最短间隔
+        double margin = 0.3;        // 恢复滞回：EWMA 须回落到 latencyMs * (1 - margin) 以下
+        int candidates = 3;         // 备选节点数
+        bool autoSwitch = false;    // false = 仅记录劣化，不切换
+    };
+
+    static constexpr int kFailPenaltyMs = 5000;
+
+    explicit QualityMonitor(NodeManager *nodeManager, QObject *parent = nullptr);
+
+    // proxyAddr 为本地 mixed 入站（host:port），tunMode 下忽略
+    void start(int nodeId, const QString &proxyAddr, bool tunMode, const Thresholds &thresholds);
+    void stop();
+    bool isActive() const { return activeNodeId >= 0; }
+
+    // 节点的滚动评分（EWMA 延迟，毫秒），未测量时为 -1
+    double score(int nodeId) const;
+    double tunnelScore() const { return tunnel.ewma; }
+
+signals:
+    void nodeMeasured(int nodeId, int latency);   // 隧道外测速，已写回 NodeManager
+    void tunnelSampled(int nodeId, int latency, double score);
+    void degraded(int nodeId, double score);
+    void switchRequested(int fromId, int toId, const QString &reason);
+
+private slots:
+    void probe();
+
+private:
+    struct Rolling {
+        double ewma = -1;
+        int consecutiveBad = 0;
+        bool lastFailed = false;
+
+        void add(int latency, int badThreshold);
+    };
+
+    void probeTunnel();
+    void probeDirect(int nodeId);
+    QList<int> shortlist() const;
+    void evaluate();
+
+    NodeManager *nodeManager;
+    QNetworkAccessManager *network;
+    QTimer *timer;
+    Thresholds thresholds;
+
+    int activeNodeId = -1;
+    QString proxyAddr;
+    bool tunMode = false;
+    quint64 generation = 0;         // 丢弃 stop()/重启之前发出的探测结果
+    bool tunnelInFlight = false;
+
+    Rolling tunnel;                 // 当前节点端到端
+    QHash<int, Rolling> direct;     // 各节点 TCP 连接（隧道外）
+    QElapsedTimer sinceSwitch;      // 跨 start() 保留，实现切换冷却
+    bool reportedDegraded = false;
+};
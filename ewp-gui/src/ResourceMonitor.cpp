@@ -0,0 +1,219 @@
+#include "ResourceMonitor.h"
+#include <QDateTime>
+#include <QDir>
+#include <QFile>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QLocale>
+#include <QNetworkRequest>
+
+#ifdef Q_OS_LINUX
+#include <unistd.h>
+#endif
+
+ResourceMonitor::ResourceMonitor(QNetworkAccessManager *network, QObject *parent)
+    : QObject(parent)
+    , network(network)
+    , timer(new QTimer(this))
+    , ring(kCapacity)
+{
+    timer->setInterval(kIntervalMs);
+    connect(timer, &QTimer::timeout, this, &ResourceMonitor::onTimeout);
+}
+
+void ResourceMonitor::setProcessId(qint64 newPid)
+{
+    if (newPid == pid) {
+        return;
+    }
+    pid = newPid;
+    lastCpuSeconds = -1;
+    updateTimer();
+}
+
+void ResourceMonitor::setControl(const ControlEndpoint &endpoint)
+{
+    control = endpoint;
+    updateTimer();
+}
+
+void ResourceMonitor::updateTimer()
+{
+    if (pid == 0 && control.isEmpty()) {
+        timer->stop();
+        abortRuntime();
+        head = count = 0;
+        rssAlerted = goroutineAlerted = false;
+    } else if (!timer->isActive()) {
+        timer->start();
+    }
+}
+
+void ResourceMonitor::abortRuntime()
+{
+    if (runtimeReply) {
+        QNetworkReply *reply = runtimeReply;
+        runtimeReply = nullptr;
+        reply->disconnect(this);
+        reply->abort();
+        reply->deleteLater();
+    }
+}
+
+void ResourceMonitor::onTimeout()
+{
+    // 上一次 /runtime 还未返回：放弃它，先提交 /proc 部分
+    if (runtimeReply) {
+        abortRuntime();
+        commit(pending);
+    }
+
+    pending = Sample();
+    pending.time = QDateTime::currentMSecsSinceEpoch();
+    readProc(pending);
+
+    if (control.isEmpty()) {
+        commit(pending);
+        return;
+    }
+    QNetworkRequest request = control.request("/runtime");
+    request.setTransferTimeout(kIntervalMs / 2);
+    runtimeReply = network->get(request);
+    connect(runtimeReply, &QNetworkReply::finished, this, &ResourceMonitor::onRuntimeFinished);
+}
+
+void ResourceMonitor::onRuntimeFinished()
+{
+    QNetworkReply *reply = runtimeReply;
+    runtimeReply = nullptr;
+    if (!reply) {
+        return;
+    }
+    reply->deleteLater();
+
+    if (reply->error() == QNetworkReply::NoError) {
+        QJsonObject obj = QJsonDocument::fromJson(reply->readAll()).object();
+        pending.goroutines = obj["goroutines"].toInt(-1);
+        pending.heapAlloc = static_cast<qint64>(obj["heap_alloc"].toDouble(-1));
+        pending.lastPauseMs = obj["last_pause_ms"].toDouble(-1);
+    }
+    commit(pending);
+}
+
+void ResourceMonitor::readProc(Sample &sample)
+{
+#ifdef Q_OS_LINUX
+    if (pid == 0) {
+        return;
+    }
+    QString base = QString("/proc/%1/").arg(pid);
+
+    // /proc/<pid>/stat：comm 可能含空格，从最后一个 ')' 之后按空格切分，
+    // 第 14、15 个字段（切分后下标 11、12）为 utime、stime，单位 clock tick
+    QFile stat(base + "stat");
+    if (stat.open(QIODevice::ReadOnly)) {
+        QByteArray line = stat.readAll();
+        QList<QByteArray> fields = line.mid(line.lastIndexOf(')') + 2).split(' ');
+        if (fields.size() > 12) {
+            double cpuSeconds = (fields[11].toLongLong() + fields[12].toLongLong())
+                / double(sysconf(_SC_CLK_TCK));
+            if (lastCpuSeconds >= 0 && cpuClock.isValid() && cpuClock.elapsed() > 0) {
+                sample.cpuPercent = (cpuSeconds - lastCpuSeconds) * 100000.0 / cpuClock.elapsed();
+            }
+            lastCpuSeconds = cpuSeconds;
+            cpuClock.restart();
+        }
+    }
+
+    QFile status(base + "status");
+    if (status.open(QIODevice::ReadOnly)) {
+        for (const QByteArray &line : status.readAll().split('\n')) {
+            if (line.startsWith("VmRSS:")) {
+                sample.rss = line.mid(6).trimmed().split(' ').value(0).toLongLong() * 1024;
+                break;
+            }
+        }
+    }
+
+    // 以 root 运行的核心（TUN 模式）普通用户读不到 fd 目录，此时保持 -1
+    QDir fdDir(base + "fd");
+    if (fdDir.isReadable()) {
+        sample.fds = fdDir.entryList(QDir::AllEntries | QDir::System | QDir::Hidden | QDir::NoDotAndDotDot).size();
+    }
+#else
+    Q_UNUSED(sample)
+#endif
+}
+
+void ResourceMonitor::commit(const Sample &sample)
+{
+    if (count < kCapacity) {
+        ring[(head + count) % kCapacity] = sample;
+        ++count;
+    } else {
+        ring[head] = sample;
+        head = (head + 1) % kCapacity;
+    }
+    emit sampled(sample);
+
+    checkGrowth("内存 (RSS)", rssAlerted, [](const Sample &s) { return double(s.rss); },
+                [](double v) { return QLocale().formattedDataSize(qint64(v)); });
+    checkGrowth("goroutine", goroutineAlerted, [](const Sample &s) { return double(s.goroutines); },
+                [](double v) { return QString::number(v, 'f', 0); });
+}
+
+// 把最近 kGrowthWindow 个样本分成 kGrowthSegments 段取平均（平滑 GC 抖动），
+// 各段严格递增且总增幅达到 kGrowthRatio 时视为持续增长。告警一次，条件解除后重新布防。
+void ResourceMonitor::checkGrowth(const QString &metric, bool &alerted,
+                                  const std::function<double(const Sample &)> &value,
+                                  const std::function<QString(double)> &format)
+{
+    if (count < kGrowthWindow) {
+        return;
+    }
+    const int perSegment = kGrowthWindow / kGrowthSegments;
+    QVector<double> averages;
+    for (int seg = 0; seg < kGrowthSegments; ++seg) {
+        double sum = 0;
+        for (int i = 0; i < perSegment; ++i) {
+            double v = value(at(count - kGrowthWindow + seg * perSegment + i));
+            if (v < 0) {
+                return;     // 指标不可用
+            }
+            sum += v;
+        }
+        averages.append(sum / perSegment);
+    }
+
+    bool growing = averages.first() > 0 && averages.last() >= averages.first() * kGrowthRatio;
+    for (int i = 1; growing && i < averages.size(); ++i) {
+        growing = averages[i] > averages[i - 1];
+    }
+
+    if (growing && !alerted) {
+        alerted = true;
+        emit growthDetected(metric, QString("%1 分钟内由 %2 增长到 %3")
+            .arg(kGrowthWindow * kIntervalMs / 60000)
+            .arg(format(averages.first()), format(averages.last())));
+    } else if (!growing) {
+        alerted = false;
+    }
+}
+
+QByteArray ResourceMonitor::toCsv() const
+{
+    QByteArray csv = "time_ms,cpu_percent,rss,fds,goroutines,heap_alloc,last_pause_ms\n";
+    for (int i = 0; i < count; ++i) {
+        const Sample &s = at(i);
+        csv += QString("%1,%2,%3,%4,%5,%6,%7\n")
+            .arg(s.time)
+            .arg(s.cpuPercent, 0, 'f', 1)
+            .arg(s.rss)
+            .arg(s.fds)
+            .arg(s.goroutines)
+            .arg(s.heapAlloc)
+            .arg(s.lastPauseMs, 0, 'f', 2)
+            .toUtf8();
+    }
+    return csv;
+}
@@ -0,0 +1,81 @@
+#pragma once
+
+#include <QObject>
+#include <QElapsedTimer>
+#include <QNetworkAccessManager>
+#include <QNetworkReply>
+#include <QPointer>
+#include <QTimer>
+#include <QVector>
+#include <functional>
+#include "ControlEndpoint.h"
+
+// 核心进程资源监控：每 5 秒采样一次
+//   - Linux 下读 /proc/<pid>：CPU 时间、RSS、打开的 fd 数
+//   - 控制接口 GET /runtime：goroutine 数、堆大小、GC 停顿
+// 样本保存在固定大小的环中；RSS 或 goroutine 数在最近 5 分钟内持续单调增长时发出告警，
+// 以便在系统杀掉核心之前发现 UDP 会话、读循环等泄漏。
+class ResourceMonitor : public QObject
+{
+    Q_OBJECT
+
+public:
+    // 不可用的字段为 -1
+    struct Sample {
+        qint64 time = 0;            // 毫秒时间戳
+        double cpuPercent = -1;     // 占单核的百分比
+        qint64 rss = -1;            // 字节
+        int fds = -1;
+        int goroutines = -1;
+        qint64 heapAlloc = -1;      // 字节
+        double lastPauseMs = -1;
+    };
+
+    static constexpr int kIntervalMs = 5000;
+    static constexpr int kCapacity = 360;       // 30 分钟
+    static constexpr int kGrowthWindow = 60;    // 5 分钟
+    static constexpr int kGrowthSegments = 6;
+    static constexpr double kGrowthRatio = 1.2; // 窗口内至少增长 20% 才告警
+
+    explicit ResourceMonitor(QNetworkAccessManager *network, QObject *parent = nullptr);
+
+    // pid 为 0 / 地址为空表示不可用；两者都不可用时停止采样并清空历史
+    void setProcessId(qint64 pid);
+    void setControl(const ControlEndpoint &endpoint);
+
+    int size() const { return count; }
+    const Sample &at(int i) const { return ring[(head + i) % kCapacity]; }  // 0 为最旧
+    QByteArray toCsv() const;           // 诊断包导出
+
+signals:
+    void sampled(const ResourceMonitor::Sample &sample);
+    void growthDetected(const QString &metric, const QString &detail);
+
+private slots:
+    void onTimeout();
+    void onRuntimeFinished();
+
+private:
+    void updateTimer();
+    void abortRuntime();
+    void readProc(Sample &sample);
+    void commit(const Sample &sample);
+    void checkGrowth(const QString &metric, bool &alerted, const std::function<double(const Sample &)> &value,
+                     const std::function<QString(double)> &format);
+
+    QNetworkAccessManager *network;
+    QPointer<QNetworkReply> runtimeReply;
+    QTimer *timer;
+    qint64 pid = 0;
+    ControlEndpoint control;
+    Sample pending;                     // 等待 /runtime 返回的样本
+
+    double lastCpuSeconds = -1;         // 上次采样时的 utime + stime
+    QElapsedTimer cpuClock;
+
+    QVector<Sample> ring;
+    int head = 0;
+    int count = 0;
+    bool rssAlerted = false;
+    bool goroutineAlerted = false;
+};
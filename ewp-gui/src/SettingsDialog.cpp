@@ -1,5 +1,6 @@
 #include "SettingsDialog.h"
 #include "ui_Settings.h"
+#include "EWPNode.h"
 
 SettingsDialog::SettingsDialog(QWidget *parent)
     : QDialog(parent)
@@ -28,6 +29,12 @@ SettingsDialog::AppSettings SettingsDialog::getSettings() const
     settings.autoStart = ui->checkAutoStart->isChecked();
     settings.minimizeToTray = ui->checkMinimizeToTray->isChecked();
     
+    settings.monitorEnabled = ui->checkMonitorEnabled->isChecked();
+    settings.monitorAutoSwitch = ui->checkMonitorAutoSwitch->isChecked();
+    settings.monitorInterval = ui->spinMonitorInterval->value();
+    settings.monitorLatency = ui->spinMonitorLatency->value();
+    settings.monitorBadSamples = ui->spinMonitorBadSamples->value();
+    
     settings.tunnelDNS = ui->editTunnelDNS->text();
     settings.tunnelDNSv6 = ui->editTunnelDNSv6->text();
     settings.tunnelDoHServer = ui->editTunnelDoHServer->text();
@@ -35,9 +42,17 @@ SettingsDialog::AppSettings SettingsDialog::getSettings() const
     settings.tunIP = ui->editTunIP->text();
     settings.tunMTU = ui->spinTunMTU->value();
     settings.tunStack = ui->comboTunStack->currentText();
+    settings.tunQueues = ui->spinTunQueues->value();
     settings.tunAutoRoute = ui->checkTunAutoRoute->isChecked();
     settings.tunStrictRoute = ui->checkTunStrictRoute->isChecked();
     
+    settings.redundantUDP = ui->checkRedundantUDP->isChecked();
+    settings.redundantPrimaryId = ui->comboRedundantPrimary->count() > 0
+        ? ui->comboRedundantPrimary->currentData().toInt() : redundantPrimaryId;
+    settings.redundantSecondaryId = ui->comboRedundantSecondary->count() > 0
+        ? ui->comboRedundantSecondary->currentData().toInt() : redundantSecondaryId;
+    settings.redundantPorts = ui->editRedundantPorts->text().trimmed();
+    
     return settings;
 }
 
@@ -47,6 +62,12 @@ void SettingsDialog::setSettings(const AppSettings &settings)
     ui->checkAutoStart->setChecked(settings.autoStart);
     ui->checkMinimizeToTray->setChecked(settings.minimizeToTray);
     
+    ui->checkMonitorEnabled->setChecked(settings.monitorEnabled);
+    ui->checkMonitorAutoSwitch->setChecked(settings.monitorAutoSwitch);
+    ui->spinMonitorInterval->setValue(settings.monitorInterval);
+    ui->spinMonitorLatency->setValue(settings.monitorLatency);
+    ui->spinMonitorBadSamples->setValue(settings.monitorBadSamples);
+    
     ui->editTunnelDNS->setText(settings.tunnelDNS);
     ui->editTunnelDNSv6->setText(settings.tunnelDNSv6);
     ui->editTunnelDoHServer->setText(settings.tunnelDoHServer);
@@ -58,9 +79,29 @@ void SettingsDialog::setSettings(const AppSettings &settings)
     if (stackIndex >= 0) {
         ui->comboTunStack->setCurrentIndex(stackIndex);
     }
+    ui->spinTunQueues->setValue(settings.tunQueues);
     
     ui->checkTunAutoRoute->setChecked(settings.tunAutoRoute);
     ui->checkTunStrictRoute->setChecked(settings.tunStrictRoute);
+    
+    ui->checkRedundantUDP->setChecked(settings.redundantUDP);
+    ui->editRedundantPorts->setText(settings.redundantPorts);
+    redundantPrimaryId = settings.redundantPrimaryId;
+    redundantSecondaryId = settings.redundantSecondaryId;
+    ui->comboRedundantPrimary->setCurrentIndex(ui->comboRedundantPrimary->findData(redundantPrimaryId));
+    ui->comboRedundantSecondary->setCurrentIndex(ui->comboRedundantSecondary->findData(redundantSecondaryId));
+}
+
+void SettingsDialog::setNodes(const QList<EWPNode> &nodes)
+{
+    ui->comboRedundantPrimary->clear();
+    ui->comboRedundantSecondary->clear();
+    for (const auto &node : nodes) {
+        ui->comboRedundantPrimary->addItem(node.name, node.id);
+        ui->comboRedundantSecondary->addItem(node.name, node.id);
+    }
+    ui->comboRedundantPrimary->setCurrentIndex(ui->comboRedundantPrimary->findData(redundantPrimaryId));
+    ui->comboRedundantSecondary->setCurrentIndex(ui->comboRedundantSecondary->findData(redundantSecondaryId));
 }
 
 void SettingsDialog::accept()
@@ -79,6 +120,12 @@ SettingsDialog::AppSettings SettingsDialog::loadFromRegistry()
     appSettings.autoStart = settings.value("app/autoStart", false).toBool();
     appSettings.minimizeToTray = settings.value("app/minimizeToTray", true).toBool();
     
+    appSettings.monitorEnabled = settings.value("monitor/enabled", true).toBool();
+    appSettings.monitorAutoSwitch = settings.value("monitor/autoSwitch", false).toBool();
+    appSettings.monitorInterval = settings.value("monitor/interval", 30).toInt();
+    appSettings.monitorLatency = settings.value("monitor/latency", 800).toInt();
+    appSettings.monitorBadSamples = settings.value("monitor/badSamples", 3).toInt();
+    
     appSettings.tunnelDNS = settings.value("tun/dns", "8.8.8.8").toString();
     appSettings.tunnelDNSv6 = settings.value("tun/ipv6_dns", "2001:4860:4860::8888").toString();
     appSettings.tunnelDoHServer = settings.value("tun/doh_server", "").toString();
@@ -86,9 +133,15 @@ SettingsDialog::AppSettings SettingsDialog::loadFromRegistry()
     appSettings.tunIP = settings.value("tun/ip", "10.0.85.2/24").toString();
     appSettings.tunMTU = settings.value("tun/mtu", 1380).toInt();
     appSettings.tunStack = settings.value("tun/stack", "mixed").toString();
+    appSettings.tunQueues = settings.value("tun/queues", 1).toInt();
     appSettings.tunAutoRoute = settings.value("tun/autoRoute", true).toBool();
     appSettings.tunStrictRoute = settings.value("tun/strictRoute", false).toBool();
     
+    appSettings.redundantUDP = settings.value("tun/redundantUDP", false).toBool();
+    appSettings.redundantPrimaryId = settings.value("tun/redundantPrimary", -1).toInt();
+    appSettings.redundantSecondaryId = settings.value("tun/redundantSecondary", -1).toInt();
+    appSettings.redundantPorts = settings.value("tun/redundantPorts", "").toString();
+    
     return appSettings;
 }
 
@@ -100,6 +153,12 @@ void SettingsDialog::saveToRegistry(const AppSettings &settings)
     qSettings.setValue("app/autoStart", settings.autoStart);
     qSettings.setValue("app/minimizeToTray", settings.minimizeToTray);
     
+    qSettings.setValue("monitor/enabled", settings.monitorEnabled);
+    qSettings.setValue("monitor/autoSwitch", settings.monitorAutoSwitch);
+    qSettings.setValue("monitor/interval", settings.monitorInterval);
+    qSettings.setValue("monitor/latency", settings.monitorLatency);
+    qSettings.setValue("monitor/badSamples", settings.monitorBadSamples);
+    
     qSettings.setValue("tun/dns", settings.tunnelDNS);
     qSettings.setValue("tun/ipv6_dns", settings.tunnelDNSv6);
     qSettings.setValue("tun/doh_server", settings.tunnelDoHServer);
@@ -107,8 +166,14 @@ void SettingsDialog::saveToRegistry(const AppSettings &settings)
     qSettings.setValue("tun/ip", settings.tunIP);
     qSettings.setValue("tun/mtu", settings.tunMTU);
     qSettings.setValue("tun/stack", settings.tunStack);
+    qSettings.setValue("tun/queues", settings.tunQueues);
     qSettings.setValue("tun/autoRoute", settings.tunAutoRoute);
     qSettings.setValue("tun/strictRoute", settings.tunStrictRoute);
+    
+    qSettings.setValue("tun/redundantUDP", settings.redundantUDP);
+    qSettings.setValue("tun/redundantPrimary", settings.redundantPrimaryId);
+    qSettings.setValue("tun/redundantSecondary", settings.redundantSecondaryId);
+    qSettings.setValue("tun/redundantPorts", settings.redundantPorts);
 }
 
 SettingsDialog::AppSettings SettingsDialog::defaultSettings()
@@ -118,6 +183,12 @@ SettingsDialog::AppSettings SettingsDialog::defaultSettings()
     settings.autoStart = false;
     settings.minimizeToTray = true;
     
+    settings.monitorEnabled = true;
+    settings.monitorAutoSwitch = false;
+    settings.monitorInterval = 30;
+    settings.monitorLatency = 800;
+    settings.monitorBadSamples = 3;
+    
     settings.tunnelDNS = "8.8.8.8";
     settings.tunnelDNSv6 = "2001:4860:4860::8888";
     settings.tunnelDoHServer = "";
@@ -125,8 +196,14 @@ SettingsDialog::AppSettings SettingsDialog::defaultSettings()
     settings.tunIP = "10.0.85.2/24";
     settings.tunMTU = 1380;
     settings.tunStack = "mixed";
+    settings.tunQueues = 1;
     settings.tunAutoRoute = true;
     settings.tunStrictRoute = false;
     
+    settings.redundantUDP = false;
+    settings.redundantPrimaryId = -1;
+    settings.redundantSecondaryId = -1;
+    settings.redundantPorts = "";
+    
     return settings;
 }
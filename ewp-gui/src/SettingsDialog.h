@@ -2,6 +2,9 @@
 
 #include <QDialog>
 #include <QSettings>
+#include <QList>
+
+struct EWPNode;
 
 namespace Ui {
 class Settings;
@@ -20,6 +23,13 @@ public:
         bool autoStart;
         bool minimizeToTray;
         
+        // 节点质量监控（仅单节点运行时）
+        bool monitorEnabled;
+        bool monitorAutoSwitch;
+        int monitorInterval;     // 秒
+        int monitorLatency;      // 端到端延迟劣化阈值（ms）
+        int monitorBadSamples;   // 连续劣化次数
+        
         // TUN DNS settings
         QString tunnelDNS;
         QString tunnelDNSv6;
@@ -29,8 +39,15 @@ public:
         QString tunIP;
         int tunMTU;
         QString tunStack;
+        int tunQueues;           // Linux 多队列 TUN 的队列数，1 = 单队列
         bool tunAutoRoute;
         bool tunStrictRoute;
+        
+        // 冗余双路 UDP（仅 TUN）：匹配端口的 UDP 流同时经两个节点发送
+        bool redundantUDP;
+        int redundantPrimaryId;
+        int redundantSecondaryId;
+        QString redundantPorts;  // "3478, 27000-27100"，空 = 全部 UDP
     };
     
     AppSettings getSettings() const;
@@ -39,6 +56,9 @@ public:
     static AppSettings loadFromRegistry();
     static void saveToRegistry(const AppSettings &settings);
     static AppSettings defaultSettings();
+    
+    // 填充冗余 UDP 的节点下拉框（item data 为节点 id）
+    void setNodes(const QList<EWPNode> &nodes);
 
 private slots:
     void accept() override;
@@ -46,4 +66,7 @@ private slots:
 private:
     Ui::Settings *ui;
     void loadSettings();
+    
+    int redundantPrimaryId = -1;
+    int redundantSecondaryId = -1;
 };
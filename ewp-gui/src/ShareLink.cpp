@@ -58,6 +58,12 @@ EWPNode ShareLink::parseLink(const QString &link)
     if (protocol == "trojan") {
         node.appProtocol = EWPNode::TROJAN;
         node.trojanPassword = credential;
+        node.enableMux = query.queryItemValue("mux") == "1";
+        bool ok = false;
+        int muxConcurrency = query.queryItemValue("muxConcurrency").toInt(&ok);
+        if (ok && muxConcurrency > 0) {
+            node.muxConcurrency = muxConcurrency;
+        }
     } else {
         node.appProtocol = EWPNode::EWP;
         node.uuid = credential;
@@ -76,12 +82,14 @@ EWPNode ShareLink::parseLink(const QString &link)
     } else {
         node.transportMode = EWPNode::WS;
     }
+    node.tcpFastOpen = query.queryItemValue("tfo") == "1";
     
     // WebSocket 路径
     QString wsPath = query.queryItemValue("wsPath");
     if (!wsPath.isEmpty()) {
         node.wsPath = wsPath;
     }
+    node.wsEarlyData = qBound(0, query.queryItemValue("ed").toInt(), 8192);
 
     // MASQUE 路径模板
     QString masquePath = query.queryItemValue("masquePath");
@@ -154,6 +162,12 @@ QString ShareLink::generateLink(const EWPNode &node)
     // 应用层协议（非 EWP 时需要标注）
     if (node.appProtocol == EWPNode::TROJAN) {
         query.addQueryItem("protocol", "trojan");
+        if (node.enableMux) {
+            query.addQueryItem("mux", "1");
+            if (node.muxConcurrency != 8) {
+                query.addQueryItem("muxConcurrency", QString::number(node.muxConcurrency));
+            }
+        }
     }
     
     // 传输模式
@@ -184,9 +198,16 @@ QString ShareLink::generateLink(const EWPNode &node)
             if (node.wsPath != "/") {
                 query.addQueryItem("wsPath", node.wsPath);
             }
+            if (node.wsEarlyData > 0) {
+                query.addQueryItem("ed", QString::number(node.wsEarlyData));
+            }
             break;
     }
     
+    if (node.tcpFastOpen) {
+        query.addQueryItem("tfo", "1");
+    }
+
     // Host 头（非空且不同于连接目标时才写入）
     if (!node.host.isEmpty()) {
         query.addQueryItem("host", node.host);
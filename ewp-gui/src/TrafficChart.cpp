@@ -0,0 +1,220 @@
+#include "TrafficChart.h"
+#include "ConnectionsModel.h"
+#include <QComboBox>
+#include <QDateTime>
+#include <QHBoxLayout>
+#include <QLabel>
+#include <QPainter>
+#include <QPainterPath>
+#include <QVBoxLayout>
+#include <algorithm>
+#include <cmath>
+#include <functional>
+
+namespace {
+
+const QColor upColor(0xe6, 0x7e, 0x22);
+const QColor downColor(0x34, 0x98, 0xdb);
+const QColor activeColor(0x7f, 0x8c, 0x8d);
+const QColor setupColor(0x8e, 0x44, 0xad);
+
+// 向上取整到 1 / 2 / 5 × 10^n，作为纵轴上限
+double niceCeil(double value)
+{
+    if (value <= 0) {
+        return 1;
+    }
+    double base = std::pow(10.0, std::floor(std::log10(value)));
+    for (double step : { 1.0, 2.0, 5.0, 10.0 }) {
+        if (value <= step * base) {
+            return step * base;
+        }
+    }
+    return 10 * base;
+}
+
+QString formatRate(double rate)
+{
+    return ConnectionsModel::formatBytes(static_cast<qint64>(rate)) + "/s";
+}
+
+} // namespace
+
+TrafficChart::TrafficChart(TrafficStore *store, QWidget *parent)
+    : QWidget(parent)
+    , store(store)
+{
+    rangeCombo = new QComboBox(this);
+    rangeCombo->addItem("10 分钟", TrafficStore::Seconds);
+    rangeCombo->addItem("1 小时", TrafficStore::TenSeconds);
+    rangeCombo->addItem("24 小时", TrafficStore::Minutes);
+    rangeCombo->setCurrentIndex(1);
+
+    legendLabel = new QLabel(this);
+
+    auto *toolbar = new QHBoxLayout;
+    toolbar->addWidget(legendLabel, 1);
+    toolbar->addWidget(rangeCombo);
+
+    auto *layout = new QVBoxLayout(this);
+    layout->addLayout(toolbar);
+    layout->addStretch(1);   // 其余区域由 paintEvent 绘制
+
+    setMinimumHeight(160);
+
+    connect(rangeCombo, QOverload<int>::of(&QComboBox::currentIndexChanged), this, [this]() {
+        update();
+    });
+    connect(store, &TrafficStore::appended, this, &TrafficChart::onAppended);
+
+    updateLegend();
+}
+
+TrafficStore::Tier TrafficChart::tier() const
+{
+    return TrafficStore::Tier(rangeCombo->currentData().toInt());
+}
+
+void TrafficChart::onAppended(int appendedTier)
+{
+    if (!isVisible()) {
+        return;
+    }
+    if (appendedTier == TrafficStore::Seconds) {
+        updateLegend();
+    }
+    if (appendedTier == tier()) {
+        update();
+    }
+}
+
+void TrafficChart::showEvent(QShowEvent *event)
+{
+    QWidget::showEvent(event);
+    updateLegend();
+}
+
+void TrafficChart::updateLegend()
+{
+    int n = store->size(TrafficStore::Seconds);
+    TrafficStore::Sample cur = n > 0 ? store->at(TrafficStore::Seconds, n - 1) : TrafficStore::Sample();
+    auto swatch = [](const QColor &color) {
+        return QString("<span style='color:%1'>■</span>").arg(color.name());
+    };
+    QString text = QString("%1 上行 %2 &nbsp; %3 下行 %4 &nbsp; %5 连接 %6")
+        .arg(swatch(upColor), formatRate(cur.upRate))
+        .arg(swatch(downColor), formatRate(cur.downRate))
+        .arg(swatch(activeColor)).arg(static_cast<int>(cur.active));
+    if (cur.setupMs > 0) {
+        text += QString(" &nbsp; %1 建连 %2 ms").arg(swatch(setupColor)).arg(cur.setupMs, 0, 'f', 0);
+    }
+    legendLabel->setText(text);
+}
+
+void TrafficChart::paintEvent(QPaintEvent *)
+{
+    QPainter p(this);
+    p.setRenderHint(QPainter::Antialiasing);
+
+    QFontMetrics fm = fontMetrics();
+    int left = fm.horizontalAdvance("999.9 MB/s") + 12;
+    int right = fm.horizontalAdvance("9999 ms") + 12;
+    int top = rangeCombo->geometry().bottom() + 8;
+    int bottom = height() - fm.height() - 8;
+    if (bottom - top < 60 || width() - left - right < 60) {
+        return;
+    }
+
+    // 上 70% 为速率，下 30% 为连接数 / 建连耗时
+    int split = top + (bottom - top) * 7 / 10;
+    QRect rateRect(left, top, width() - left - right, split - top - 6);
+    QRect connRect(left, split + 6, rateRect.width(), bottom - split - 6);
+
+    TrafficStore::Tier t = tier();
+    int span = TrafficStore::span(t);
+    qint64 window = qint64(span) * TrafficStore::capacity(t);
+    qint64 now = QDateTime::currentSecsSinceEpoch();
+    int n = store->size(t);
+
+    // 只取窗口内的样本并求各轴上限
+    int first = 0;
+    while (first < n && store->at(t, first).time < now - window) {
+        ++first;
+    }
+    double maxRate = 0, maxActive = 0, maxSetup = 0;
+    for (int i = first; i < n; ++i) {
+        const TrafficStore::Sample &s = store->at(t, i);
+        maxRate = std::max({ maxRate, s.upRate, s.downRate });
+        maxActive = std::max(maxActive, s.active);
+        maxSetup = std::max(maxSetup, s.setupMs);
+    }
+    maxRate = niceCeil(maxRate);
+    maxActive = niceCeil(maxActive);
+    maxSetup = niceCeil(maxSetup);
+
+    auto xAt = [&](qint64 time) {
+        return rateRect.right() - double(now - time) / window * rateRect.width();
+    };
+
+    // 网格与刻度
+    QColor gridColor = palette().color(QPalette::Mid);
+    gridColor.setAlpha(80);
+    p.setPen(gridColor);
+    for (int i = 0; i <= 4; ++i) {
+        int y = rateRect.top() + rateRect.height() * i / 4;
+        p.drawLine(rateRect.left(), y, rateRect.right(), y);
+    }
+    p.drawRect(connRect);
+
+    p.setPen(palette().color(QPalette::Text));
+    p.drawText(QRect(0, rateRect.top() - fm.height() / 2, left - 6, fm.height()),
+               Qt::AlignRight | Qt::AlignVCenter, formatRate(maxRate));
+    p.drawText(QRect(0, rateRect.center().y() - fm.height() / 2, left - 6, fm.height()),
+               Qt::AlignRight | Qt::AlignVCenter, formatRate(maxRate / 2));
+    p.setPen(activeColor);
+    p.drawText(QRect(0, connRect.top(), left - 6, fm.height()),
+               Qt::AlignRight | Qt::AlignTop, QString::number(maxActive, 'f', 0));
+    p.setPen(setupColor);
+    p.drawText(QRect(connRect.right() + 6, connRect.top(), right - 6, fm.height()),
+               Qt::AlignLeft | Qt::AlignTop, QString("%1 ms").arg(maxSetup, 0, 'f', 0));
+    p.setPen(palette().color(QPalette::Text));
+    p.drawText(QRect(rateRect.left(), bottom + 4, rateRect.width(), fm.height()),
+               Qt::AlignLeft, rangeCombo->currentText() + "前");
+    p.drawText(QRect(rateRect.left(), bottom + 4, rateRect.width(), fm.height()),
+               Qt::AlignRight, "现在");
+
+    // 相邻样本间隔超过两个桶（核心停止期间）时断开折线
+    auto series = [&](const QRect &area, double maxValue, std::function<double(const TrafficStore::Sample &)> value,
+                      bool skipZero) {
+        QPainterPath path;
+        qint64 prevTime = 0;
+        bool open = false;
+        for (int i = first; i < n; ++i) {
+            const TrafficStore::Sample &s = store->at(t, i);
+            double v = value(s);
+            if (skipZero && v <= 0) {
+                open = false;
+                continue;
+            }
+            QPointF pt(xAt(s.time), area.bottom() - std::min(v / maxValue, 1.0) * area.height());
+            if (open && s.time - prevTime <= 2 * span) {
+                path.lineTo(pt);
+            } else {
+                path.moveTo(pt);
+            }
+            prevTime = s.time;
+            open = true;
+        }
+        return path;
+    };
+
+    p.setClipRect(rateRect.united(connRect));
+    p.setPen(QPen(downColor, 1.5));
+    p.drawPath(series(rateRect, maxRate, [](const TrafficStore::Sample &s) { return s.downRate; }, false));
+    p.setPen(QPen(upColor, 1.5));
+    p.drawPath(series(rateRect, maxRate, [](const TrafficStore::Sample &s) { return s.upRate; }, false));
+    p.setPen(QPen(activeColor, 1));
+    p.drawPath(series(connRect, maxActive, [](const TrafficStore::Sample &s) { return s.active; }, false));
+    p.setPen(QPen(setupColor, 1, Qt::DashLine));
+    p.drawPath(series(connRect, maxSetup, [](const TrafficStore::Sample &s) { return s.setupMs; }, true));
+}
@@ -0,0 +1,34 @@
+#pragma once
+
+#include <QWidget>
+#include "TrafficStore.h"
+
+class QComboBox;
+class QLabel;
+
+// 实时流量图：上半部分为上 / 下行速率，下半部分为活动连接数与建连耗时。
+// 只在可见且当前层级新增了桶时重绘，窗口隐藏到托盘时不做任何绘制。
+class TrafficChart : public QWidget
+{
+    Q_OBJECT
+
+public:
+    explicit TrafficChart(TrafficStore *store, QWidget *parent = nullptr);
+
+    QSize sizeHint() const override { return QSize(480, 220); }
+
+protected:
+    void paintEvent(QPaintEvent *event) override;
+    void showEvent(QShowEvent *event) override;
+
+private slots:
+    void onAppended(int tier);
+
+private:
+    TrafficStore::Tier tier() const;
+    void updateLegend();
+
+    TrafficStore *store;
+    QComboBox *rangeCombo;
+    QLabel *legendLabel;
+};
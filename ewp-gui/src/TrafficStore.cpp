@@ -0,0 +1,97 @@
+#include "TrafficStore.h"
+
+TrafficStore::TrafficStore(QObject *parent)
+    : QObject(parent)
+{
+    for (int t = 0; t < TierCount; ++t) {
+        rings[t].buf.resize(capacity(Tier(t)));
+    }
+}
+
+int TrafficStore::span(Tier tier)
+{
+    static const int spans[TierCount] = { 1, 10, 60 };
+    return spans[tier];
+}
+
+int TrafficStore::capacity(Tier tier)
+{
+    static const int capacities[TierCount] = { 600, 360, 1440 };
+    return capacities[tier];
+}
+
+void TrafficStore::Ring::push(const Sample &sample)
+{
+    if (count < buf.size()) {
+        buf[(head + count) % buf.size()] = sample;
+        ++count;
+    } else {
+        buf[head] = sample;
+        head = (head + 1) % buf.size();
+    }
+}
+
+const TrafficStore::Sample &TrafficStore::at(Tier tier, int i) const
+{
+    const Ring &ring = rings[tier];
+    return ring.buf[(ring.head + i) % ring.buf.size()];
+}
+
+void TrafficStore::append(const Sample &sample)
+{
+    rings[Seconds].push(sample);
+    emit appended(Seconds);
+
+    for (int t = TenSeconds; t < TierCount; ++t) {
+        Bucket &b = buckets[t];
+        qint64 key = sample.time / span(Tier(t));
+
+        // 进入新的时间桶时，把上一个桶的平均值写入环
+        if (b.n > 0 && key != b.key) {
+            Sample avg;
+            avg.time = b.key * span(Tier(t));
+            avg.upRate = b.up / b.n;
+            avg.downRate = b.down / b.n;
+            avg.active = b.active / b.n;
+            avg.setupMs = b.setupN > 0 ? b.setup / b.setupN : 0;
+            rings[t].push(avg);
+            b = Bucket();
+            emit appended(t);
+        }
+
+        b.key = key;
+        ++b.n;
+        b.up += sample.upRate;
+        b.down += sample.downRate;
+        b.active += sample.active;
+        if (sample.setupMs > 0) {
+            b.setup += sample.setupMs;
+            ++b.setupN;
+        }
+    }
+}
+
+void TrafficStore::clear()
+{
+    for (int t = 0; t < TierCount; ++t) {
+        rings[t].head = 0;
+        rings[t].count = 0;
+        buckets[t] = Bucket();
+    }
+}
+
+QByteArray TrafficStore::toCsv(Tier tier) const
+{
+    QByteArray csv = "time,up_rate,down_rate,active,setup_ms\n";
+    for (int i = 0; i < size(tier); ++i) {
+        const Sample &s = at(tier, i);
+        csv += QString("%1,%2,%3,%4,%5\n")
+            .arg(s.time)
+            .arg(s.upRate, 0, 'f', 0)
+            .arg(s.downRate, 0, 'f', 0)
+            .arg(s.active, 0, 'f', 1)
+            .arg(s.setupMs, 0, 'f', 1)
+            .toUtf8();
+    }
+    return csv;
+}
@@ -0,0 +1,61 @@
+#pragma once
+
+#include <QObject>
+#include <QVector>
+
+// 固定内存的分级环形时序存储，数据来自核心控制接口 GET /stats 的每秒样本：
+//   1 秒  × 600  = 10 分钟
+//   10 秒 × 360  = 1 小时
+//   1 分钟 × 1440 = 24 小时
+// 高层级由 1 秒样本按桶求平均得到，运行多久内存都不增长。
+class TrafficStore : public QObject
+{
+    Q_OBJECT
+
+public:
+    enum Tier { Seconds, TenSeconds, Minutes, TierCount };
+
+    struct Sample {
+        qint64 time = 0;        // 桶起始时间（unix 秒）
+        double upRate = 0;      // 字节/秒
+        double downRate = 0;
+        double active = 0;      // 活动连接数
+        double setupMs = 0;     // 新建连接的平均建连耗时，0 表示该时段无新连接
+    };
+
+    explicit TrafficStore(QObject *parent = nullptr);
+
+    void append(const Sample &sample);      // 追加一个 1 秒样本
+    void clear();
+
+    static int span(Tier tier);             // 每个桶的秒数
+    static int capacity(Tier tier);
+    int size(Tier tier) const { return rings[tier].count; }
+    const Sample &at(Tier tier, int i) const;   // 0 为最旧
+    QByteArray toCsv(Tier tier) const;          // 诊断包导出
+
+signals:
+    void appended(int tier);                // 该层级新增了一个完整的桶
+
+private:
+    struct Ring {
+        QVector<Sample> buf;
+        int head = 0;
+        int count = 0;
+        void push(const Sample &sample);
+    };
+
+    // 高层级正在累积的桶
+    struct Bucket {
+        qint64 key = -1;
+        int n = 0;
+        double up = 0;
+        double down = 0;
+        double active = 0;
+        double setup = 0;
+        int setupN = 0;
+    };
+
+    Ring rings[TierCount];
+    Bucket buckets[TierCount];
+};
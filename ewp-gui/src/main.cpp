@@ -1,45 +1,114 @@
 #include <QApplication>
+#include <QCommandLineParser>
+#include <QCoreApplication>
 #include <QTranslator>
 #include <QLocale>
 #include <QLocalSocket>
 #include <QLocalServer>
 #include <QMessageBox>
 #include <QIcon>
+#include <QTextStream>
+#include <cstring>
 #include "MainWindow.h"
+#include "HeadlessDaemon.h"
+#include "CommandServer.h"
+
+namespace {
+
+const QString kSocketName = "ECHWorkersGUI_SingleInstance";
+
+bool instanceRunning()
+{
+    QLocalSocket socket;
+    socket.connectToServer(kSocketName);
+    return socket.waitForConnected(500);
+}
+
+void setApplicationInfo()
+{
+    QCoreApplication::setApplicationName("ECH Workers");
+    QCoreApplication::setApplicationVersion("1.0.0");
+    QCoreApplication::setOrganizationName("ECH Workers");
+}
+
+// 无界面模式：QCoreApplication，不加载任何窗口部件
+int runHeadless(int argc, char *argv[])
+{
+    QCoreApplication app(argc, argv);
+    setApplicationInfo();
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription("EWP GUI 无界面守护模式，通过本地套接字 " + kSocketName
+                                     + " 接收 JSON 行命令");
+    parser.addHelpOption();
+    parser.addOption({ "headless", "无界面运行" });
+    parser.addOption({ "tun", "以 TUN 模式启动核心" });
+    parser.addOption({ "node", "启动后立即运行的节点 ID", "id" });
+    parser.process(app);
+
+    QTextStream err(stderr);
+    if (instanceRunning()) {
+        err << "已有实例在运行，请通过本地套接字 " << kSocketName << " 发送命令" << Qt::endl;
+        return 1;
+    }
+
+    HeadlessDaemon daemon(parser.isSet("tun"));
+    if (!daemon.watchTerminationSignals()) {
+        err << "无法安装终止信号处理，SIGTERM 将直接结束进程" << Qt::endl;
+    }
+    CommandServer commands(&daemon);
+    if (!commands.listen(kSocketName)) {
+        err << "无法启动命令接口: " << commands.errorString() << Qt::endl;
+        return 1;
+    }
+
+    if (parser.isSet("node")) {
+        QString error;
+        if (!daemon.startNode(parser.value("node").toInt(), &error)) {
+            err << "启动失败: " << error << Qt::endl;
+            return 1;
+        }
+    }
+
+    return app.exec();
+}
+
+} // namespace
 
 int main(int argc, char *argv[])
 {
+    // 必须在创建 QApplication 之前决定，无界面模式不初始化 GUI
+    for (int i = 1; i < argc; ++i) {
+        if (std::strcmp(argv[i], "--headless") == 0) {
+            return runHeadless(argc, argv);
+        }
+    }
+
     QApplication app(argc, argv);
-    
-    app.setApplicationName("ECH Workers");
-    app.setApplicationVersion("1.0.0");
-    app.setOrganizationName("ECH Workers");
-    
+    setApplicationInfo();
+
     // 设置应用程序图标
     app.setWindowIcon(QIcon(":/icons/logo.ico"));
-    
+
     // 防止重复开启
-    QString socketName = "ECHWorkersGUI_SingleInstance";
-    QLocalSocket socket;
-    socket.connectToServer(socketName);
-    
-    if (socket.waitForConnected(500)) {
+    if (instanceRunning()) {
         // 已经有实例在运行，发送消息并退出
-        QMessageBox::information(nullptr, "ECH Workers", 
+        QMessageBox::information(nullptr, "ECH Workers",
             "程序已经在运行中，请检查系统托盘。");
         return 0;
     }
-    
-    // 创建本地服务器防止重复启动
-    QLocalServer server;
-    if (!server.listen(socketName)) {
-        QMessageBox::critical(nullptr, "错误", 
-            "无法启动单实例服务器: " + server.errorString());
+
+    MainWindow window;
+
+    // 单实例套接字同时作为本地命令接口，脚本可直接切换节点
+    CommandServer commands(&window);
+    if (!commands.listen(kSocketName)) {
+        QMessageBox::critical(nullptr, "错误",
+            "无法启动单实例服务器: " + commands.errorString());
         return 1;
     }
-    
-    MainWindow window;
+
     window.show();
-    
+
     return app.exec();
 }